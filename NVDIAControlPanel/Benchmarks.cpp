@@ -0,0 +1,2363 @@
+#include "targetver.h"
+
+// Before anything that includes Windows.h, which would bring in the old winsock.h
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#include "nvapi.h"
+#include "NvApiDriverSettings.h"
+#include "Benchmarks.h"
+#include "DrsSession.h"
+#include "DrsSnapshot.h"
+#include "DrsRecords.h"
+#include "SettingRegistry.h"
+#include "DrsCache.h"
+#include "DrsAppResolver.h"
+#include "DrsPlan.h"
+#include "TelemetrySampler.h"
+#include "TelemetryRing.h"
+#include "TelemetryDelta.h"
+#include "TelemetryFrames.h"
+#include "TelemetryStore.h"
+#include "TelemetryRollup.h"
+#include "TelemetryExporter.h"
+#include "TelemetryAdaptive.h"
+#include "TelemetryAlerts.h"
+#include "TelemetryUtilization.h"
+#include "TelemetryThrottle.h"
+#include "TelemetryEcc.h"
+#include "TelemetryTrace.h"
+#include "NvApiStats.h"
+#include "SimulatedTelemetrySource.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <Windows.h>
+#include <Psapi.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#pragma comment(lib, "psapi.lib")
+
+using namespace ControlPanel;
+
+namespace
+{
+	class Stopwatch
+	{
+	public:
+		Stopwatch()
+		{
+			QueryPerformanceFrequency(&frequency);
+			QueryPerformanceCounter(&start);
+		}
+
+		double ElapsedMs() const
+		{
+			LARGE_INTEGER now;
+			QueryPerformanceCounter(&now);
+			return (double)(now.QuadPart - start.QuadPart) * 1000.0 / (double)frequency.QuadPart;
+		}
+
+	private:
+		LARGE_INTEGER frequency;
+		LARGE_INTEGER start;
+	};
+
+	void PrintResult(const char *name, NvU32 operations, double elapsedMs)
+	{
+		printf("%-32s %8u ops %12.3f ms %12.3f us/op\n", name, operations, elapsedMs,
+			operations ? elapsedMs * 1000.0 / operations : 0.0);
+	}
+
+	// User plus kernel time of the whole process
+	double ProcessCpuMs()
+	{
+		FILETIME creation, exit, kernel, user;
+		if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+			return 0.0;
+
+		unsigned long long ticks = ((unsigned long long)kernel.dwHighDateTime << 32 | kernel.dwLowDateTime) +
+			((unsigned long long)user.dwHighDateTime << 32 | user.dwLowDateTime);
+		return ticks / 10000.0;
+	}
+
+	class SampleCounter : public TelemetrySubscriber
+	{
+	public:
+		SampleCounter() : samples(0) {}
+
+		void OnSamples(const TelemetrySample *, NvU32 count) { samples += count; }
+
+		unsigned long long samples;
+	};
+
+	/*
+	Skew and latency of the single-thread sampler for comparison: the spread
+	between the first reads of each GPU in a tick, and the time from the first
+	read to delivery.
+	*/
+	class BatchSkewMeter : public TelemetrySubscriber
+	{
+	public:
+		BatchSkewMeter() : batches(0), totalSkew(0), maxSkew(0), totalLatency(0), maxLatency(0) {}
+
+		void OnSamples(const TelemetrySample *samples, NvU32 count)
+		{
+			NvU64 now = TelemetryNow();
+			NvU64 first = samples[0].timestamp;
+			NvU64 last = samples[0].timestamp;
+			for (NvU32 i = 1; i < count; i++)
+			{
+				// Reads of one GPU are consecutive; its first sample starts its reads
+				if (samples[i].gpu == samples[i - 1].gpu)
+					continue;
+				if (samples[i].timestamp < first)
+					first = samples[i].timestamp;
+				if (samples[i].timestamp > last)
+					last = samples[i].timestamp;
+			}
+
+			batches++;
+			totalSkew += last - first;
+			if (last - first > maxSkew)
+				maxSkew = last - first;
+			totalLatency += now - first;
+			if (now - first > maxLatency)
+				maxLatency = now - first;
+		}
+
+		unsigned long long batches;
+		unsigned long long totalSkew;
+		unsigned long long maxSkew;
+		unsigned long long totalLatency;
+		unsigned long long maxLatency;
+	};
+
+	const NvU32 RING_BATCH = 32;
+
+	void FillSamples(TelemetrySample *samples, NvU32 count, NvU32 producer)
+	{
+		memset(samples, 0, count * sizeof(TelemetrySample));
+		for (NvU32 i = 0; i < count; i++)
+		{
+			samples[i].gpu = (NvU16)producer;
+			samples[i].metric = (NvU8)(i % TELEMETRY_METRIC_COUNT);
+			samples[i].value = i;
+		}
+	}
+
+	template <typename Ring>
+	void ConsumeAll(Ring &ring, unsigned long long total)
+	{
+		TelemetrySample samples[256];
+		unsigned long long received = 0;
+		while (received < total)
+		{
+			NvU32 count = ring.Pop(samples, 256);
+			received += count;
+			if (count == 0)
+				std::this_thread::yield();
+		}
+	}
+
+	// A consumer that only looks every millisecond, like one stuck behind console output
+	void ConsumeSlowly(TelemetrySpscRing *ring, std::atomic<bool> *done, unsigned long long *received)
+	{
+		TelemetrySample samples[256];
+		while (!*done)
+		{
+			*received += ring->Pop(samples, 256);
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		while (NvU32 count = ring->Pop(samples, 256))
+			*received += count;
+	}
+
+	void ProduceSpsc(TelemetrySpscRing *ring, NvU32 count)
+	{
+		TelemetrySample samples[RING_BATCH];
+		FillSamples(samples, RING_BATCH, 0);
+		for (NvU32 sent = 0; sent < count;)
+		{
+			NvU32 batch = count - sent < RING_BATCH ? count - sent : RING_BATCH;
+			NvU32 pushed = ring->TryPush(samples, batch);
+			sent += pushed;
+			if (pushed == 0)
+				std::this_thread::yield();
+		}
+	}
+
+	void ProduceMpsc(TelemetryMpscRing *ring, NvU32 count, NvU32 producer)
+	{
+		TelemetrySample samples[RING_BATCH];
+		FillSamples(samples, RING_BATCH, producer);
+		for (NvU32 sent = 0; sent < count; sent++)
+		{
+			while (!ring->TryPush(samples[sent % RING_BATCH]))
+				std::this_thread::yield();
+		}
+	}
+
+	// Bytes the console would print for the same samples, one line each
+	class TextSizeCounter : public TelemetrySubscriber
+	{
+	public:
+		TextSizeCounter() : bytes(0) {}
+
+		void OnSamples(const TelemetrySample *samples, NvU32 count)
+		{
+			char line[96];
+			for (NvU32 i = 0; i < count; i++)
+			{
+				int length = snprintf(line, sizeof(line), "GPU %u: Current frequency of graphics domain: %d (MHz)\n",
+					samples[i].gpu, (int)(samples[i].value / 1000));
+				bytes += length > 0 ? length : 0;
+			}
+		}
+
+		unsigned long long bytes;
+	};
+
+	// Removes what a store benchmark wrote
+	void DeleteStore(const std::string &directory)
+	{
+		const char *patterns[] = { "\\*.seg", "\\*.rlp" };
+		for (int i = 0; i < 2; i++)
+		{
+			WIN32_FIND_DATAA found;
+			HANDLE search = FindFirstFileA((directory + patterns[i]).c_str(), &found);
+			if (search != INVALID_HANDLE_VALUE)
+			{
+				do
+				{
+					DeleteFileA((directory + "\\" + found.cFileName).c_str());
+				} while (FindNextFileA(search, &found));
+				FindClose(search);
+			}
+		}
+		RemoveDirectoryA(directory.c_str());
+	}
+
+	// Synthetic history starts 2026-01-01 UTC and advances in 500 ms steps
+	const NvU64 HISTORY_START = 1767225600000000ULL;
+	const NvU64 HISTORY_STEP_MICROSECONDS = 500000;
+
+	std::string BenchmarkDirectory(const char *name)
+	{
+		char temporary[MAX_PATH + 1] = { 0 };
+		DWORD length = GetTempPathA(MAX_PATH + 1, temporary);
+		return std::string(length > 0 && length <= MAX_PATH ? temporary : "") + name;
+	}
+
+	// Every metric at its console period, read on the timer wheel: due on whole milliseconds, stamped
+	// when the read starts a few hundred microseconds later
+	void ReadHistoryStep(SimulatedTelemetrySource &source, NvU32 simulatedGpus, NvU64 step, std::vector<TelemetrySample> &batch)
+	{
+		TelemetrySample samples[TELEMETRY_MAX_CHANNELS];
+		NvU64 due = step * HISTORY_STEP_MICROSECONDS;
+		batch.clear();
+		for (NvU32 gpu = 0; gpu < simulatedGpus; gpu++)
+		{
+			for (int metric = 0; metric < TELEMETRY_METRIC_COUNT; metric++)
+			{
+				if (due / 1000 % DefaultTelemetryPeriodMs((TelemetryMetric)metric) != 0)
+					continue;
+
+				NvU32 count = 0;
+				source.ReadAt(gpu, (TelemetryMetric)metric, due, samples, &count);
+				NvU64 jitter = 50 + (due / 1000 * 2654435761ULL + gpu * 97 + metric * 31) % 250;
+				for (NvU32 i = 0; i < count; i++)
+				{
+					samples[i].timestamp = HISTORY_START + due + jitter;
+					samples[i].gpu = (NvU16)gpu;
+					samples[i].metric = (NvU8)metric;
+					samples[i].tick = 0;
+					samples[i].reserved[0] = 0;
+					samples[i].reserved[1] = 0;
+					batch.push_back(samples[i]);
+				}
+			}
+		}
+	}
+
+	// The channel values of one (GPU, metric) in effect at any time since the start of a trace
+	class TraceSignal
+	{
+	public:
+		virtual ~TraceSignal() {}
+
+		virtual NvU32 ValuesAt(NvU32 gpu, TelemetryMetric metric, NvU64 time, TelemetrySample *samples) const = 0;
+	};
+
+	class SimulatedTrace : public TraceSignal
+	{
+	public:
+		explicit SimulatedTrace(const SimulatedTelemetrySource &source) : source(source) {}
+
+		NvU32 ValuesAt(NvU32 gpu, TelemetryMetric metric, NvU64 time, TelemetrySample *samples) const
+		{
+			NvU32 count = 0;
+			source.ReadAt(gpu, metric, time, samples, &count);
+			return count;
+		}
+
+	private:
+		const SimulatedTelemetrySource &source;
+	};
+
+	// Every series of a store, each value held until the next one was recorded
+	class RecordedTrace : public TraceSignal
+	{
+	public:
+		RecordedTrace() : start(0), duration(0) {}
+
+		bool Load(const char *directory)
+		{
+			TelemetryStoreReader reader;
+			if (!reader.Open(directory))
+				return false;
+
+			std::vector<NvU32> keys;
+			reader.Series(keys);
+			NvU64 end = 0;
+			start = ~0ULL;
+			for (size_t i = 0; i < keys.size(); i++)
+			{
+				series.push_back(std::vector<TelemetrySample>());
+				reader.Query(keys[i], 0, ~0ULL, series.back());
+				if (series.back().empty())
+				{
+					series.pop_back();
+					continue;
+				}
+				start = series.back().front().timestamp < start ? series.back().front().timestamp : start;
+				end = series.back().back().timestamp > end ? series.back().back().timestamp : end;
+			}
+			duration = series.empty() ? 0 : end - start;
+			return !series.empty();
+		}
+
+		// Every (GPU, metric) with at least one series, as gpu << 8 | metric
+		void Readings(std::vector<NvU32> &readings) const
+		{
+			for (size_t i = 0; i < series.size(); i++)
+			{
+				NvU32 reading = (NvU32)series[i][0].gpu << 8 | series[i][0].metric;
+				if (std::find(readings.begin(), readings.end(), reading) == readings.end())
+					readings.push_back(reading);
+			}
+		}
+
+		NvU64 Duration() const { return duration; }
+
+		NvU32 ValuesAt(NvU32 gpu, TelemetryMetric metric, NvU64 time, TelemetrySample *samples) const
+		{
+			NvU32 count = 0;
+			for (size_t i = 0; i < series.size() && count < TELEMETRY_MAX_CHANNELS; i++)
+			{
+				const std::vector<TelemetrySample> &values = series[i];
+				if (values[0].gpu != gpu || values[0].metric != metric)
+					continue;
+
+				size_t low = 0;
+				size_t high = values.size();
+				while (low < high)
+				{
+					size_t middle = (low + high) / 2;
+					if (values[middle].timestamp <= start + time)
+						low = middle + 1;
+					else
+						high = middle;
+				}
+				if (low > 0)
+					samples[count++] = values[low - 1];
+			}
+			return count;
+		}
+
+	private:
+		std::vector<std::vector<TelemetrySample> > series;
+		NvU64 start;
+		NvU64 duration;
+	};
+
+	struct SamplingOutcome
+	{
+		unsigned long long reads;
+		unsigned long long points;
+		double totalError;
+		double maxError;
+	};
+
+	// Reads the trace every periodMs, or at the periods an adaptive rate picks when config is not NULL, and compares
+	// what the reads hold (each value until the next read) with the trace every stepMicroseconds
+	void ReplaySampling(const TraceSignal &trace, NvU32 gpu, TelemetryMetric metric, NvU64 duration, NvU64 stepMicroseconds,
+		NvU32 periodMs, const TelemetryAdaptiveConfig *config, SamplingOutcome &outcome)
+	{
+		TelemetryAdaptiveRate rate(config != NULL ? *config : DefaultTelemetryAdaptiveConfig(metric));
+		TelemetrySample held[TELEMETRY_MAX_CHANNELS];
+		TelemetrySample truth[TELEMETRY_MAX_CHANNELS];
+		NvU32 heldCount = 0;
+		NvU64 nextRead = 0;
+		for (NvU64 time = 0; time < duration; time += stepMicroseconds)
+		{
+			while (nextRead <= time)
+			{
+				heldCount = trace.ValuesAt(gpu, metric, nextRead, held);
+				outcome.reads++;
+				nextRead += config != NULL ? rate.Update(held, heldCount, nextRead) : (NvU64)periodMs * 1000;
+			}
+
+			NvU32 truthCount = trace.ValuesAt(gpu, metric, time, truth);
+			for (NvU32 i = 0; i < truthCount && i < heldCount; i++)
+			{
+				double error = (double)(truth[i].value > held[i].value ? truth[i].value - held[i].value : held[i].value - truth[i].value);
+				outcome.totalError += error;
+				outcome.maxError = error > outcome.maxError ? error : outcome.maxError;
+				outcome.points++;
+			}
+		}
+	}
+
+	// Folds every alert into one number, so two evaluators can be checked for the same events in the same order
+	class AlertDigest : public TelemetryAlertSink
+	{
+	public:
+		AlertDigest() : digest(14695981039346656037ULL) {}
+
+		void OnAlert(const TelemetryAlertRule &, const TelemetryAlertEvent &event)
+		{
+			NvU64 fields[] = { event.timestamp, event.rule, event.series, event.raised ? 1ULL : 0ULL };
+			for (int i = 0; i < 4; i++)
+				digest = (digest ^ fields[i]) * 1099511628211ULL;
+		}
+
+		NvU64 Digest() const { return digest; }
+
+	private:
+		NvU64 digest;
+	};
+
+	void CallErrorMessage(NvU32 calls)
+	{
+		NvAPI_ShortString text;
+		for (NvU32 i = 0; i < calls; i++)
+			NvApiCall(NVAPI_CALL_GET_ERROR_MESSAGE, NvAPI_GetErrorMessage, NVAPI_ERROR, text);
+	}
+
+	unsigned long long NvApiCallCount(NvApiFunction function)
+	{
+		std::vector<NvApiCallStats> stats;
+		CollectNvApiStats(stats);
+		for (size_t i = 0; i < stats.size(); i++)
+		{
+			if (stats[i].function == function)
+				return stats[i].calls;
+		}
+		return 0;
+	}
+
+	// Encodes every closed window as a report and remembers the exact means, to check the decoded ones against
+	class UtilizationReports : public TelemetryUtilizationSink
+	{
+	public:
+		UtilizationReports() : reports(0), encodeMs(0.0) {}
+
+		void OnUtilization(NvU64 windowMicroseconds, const TelemetryUtilizationWindow *windows, NvU32 count)
+		{
+			Stopwatch encoding;
+			EncodeTelemetryUtilization(windowMicroseconds, windows, count, bytes);
+			encodeMs += encoding.ElapsedMs();
+
+			reports++;
+			for (NvU32 i = 0; i < count; i++)
+				means.push_back(windows[i].Mean());
+		}
+
+		std::vector<NvU8> bytes;
+		std::vector<double> means;
+		unsigned long long reports;
+		double encodeMs;
+	};
+
+	struct EccOutcome
+	{
+		unsigned long long reads;
+		unsigned long long changes;
+		unsigned long long delayed;
+		double totalDelayMs;
+		double maxDelayMs;
+		double monitorMs;
+		bool matched;
+	};
+
+	// Delay from the first error of each change to the read that reported it; the counters only count up,
+	// so the first error is found by bisecting the window to the millisecond
+	class EccDelays : public TelemetryEccSink
+	{
+	public:
+		EccDelays(const SimulatedTelemetrySource &source, EccOutcome &outcome) : source(source), outcome(outcome) {}
+
+		void OnEcc(const TelemetryEccEvent *events, NvU32 count)
+		{
+			for (NvU32 i = 0; i < count; i++)
+			{
+				const TelemetryEccEvent &event = events[i];
+				if (event.reset || (event.counter != TELEMETRY_ECC_SINGLE_BIT && event.counter != TELEMETRY_ECC_DOUBLE_BIT))
+					continue;
+
+				NvU64 low = event.timestamp - event.window;
+				NvU64 high = event.timestamp;
+				while (high - low > 1000)
+				{
+					NvU64 middle = low + (high - low) / 2;
+					TelemetrySample samples[TELEMETRY_MAX_CHANNELS];
+					NvU32 samplesRead = 0;
+					source.ReadAt(event.gpu, TELEMETRY_ECC, middle, samples, &samplesRead);
+					if ((NvU64)samples[event.counter].value > event.total - event.errors)
+						high = middle;
+					else
+						low = middle;
+				}
+
+				double delayMs = (event.timestamp - high) / 1000.0;
+				outcome.delayed++;
+				outcome.totalDelayMs += delayMs;
+				outcome.maxDelayMs = delayMs > outcome.maxDelayMs ? delayMs : outcome.maxDelayMs;
+			}
+		}
+
+	private:
+		EccDelays &operator=(const EccDelays &);
+
+		const SimulatedTelemetrySource &source;
+		EccOutcome &outcome;
+	};
+
+	// Reads the ECC counters of every GPU every periodMs, or at the periods an adaptive rate picks when config
+	// is not NULL, through an ECC monitor; checks the errors it reports add up to what the counters gained
+	void ReplayEcc(const SimulatedTelemetrySource &source, NvU64 duration, NvU32 periodMs, const TelemetryAdaptiveConfig *config, EccOutcome &outcome)
+	{
+		memset(&outcome, 0, sizeof(outcome));
+		TelemetryEccMonitor monitor;
+		EccDelays delays(source, outcome);
+		monitor.Subscribe(&delays);
+		for (NvU32 gpu = 0; gpu < source.GpuCount(); gpu++)
+		{
+			TelemetryAdaptiveRate rate(config != NULL ? *config : DefaultTelemetryAdaptiveConfig(TELEMETRY_ECC));
+			TelemetrySample samples[TELEMETRY_MAX_CHANNELS];
+			for (NvU64 time = 0; time < duration; )
+			{
+				NvU32 count = 0;
+				source.ReadAt(gpu, TELEMETRY_ECC, time, samples, &count);
+				for (NvU32 i = 0; i < count; i++)
+				{
+					samples[i].timestamp = time;
+					samples[i].gpu = (NvU16)gpu;
+					samples[i].metric = TELEMETRY_ECC;
+					samples[i].tick = 0;
+					samples[i].reserved[0] = 0;
+					samples[i].reserved[1] = 0;
+				}
+
+				Stopwatch monitoring;
+				monitor.OnSamples(samples, count);
+				outcome.monitorMs += monitoring.ElapsedMs();
+				time += config != NULL ? rate.Update(samples, count, time) : (NvU64)periodMs * 1000;
+			}
+		}
+
+		outcome.reads = monitor.ReadCount();
+		outcome.changes = monitor.EventCount();
+		outcome.matched = monitor.GpuCount() == source.GpuCount();
+		for (NvU32 gpu = 0; gpu < monitor.GpuCount(); gpu++)
+		{
+			for (NvU32 counter = 0; counter < TELEMETRY_ECC_COUNTERS; counter++)
+				outcome.matched = outcome.matched && monitor.Gained(gpu, counter) == monitor.Counter(gpu, counter) - monitor.Baseline(gpu, counter);
+		}
+	}
+
+	void PrintMemory(const char *name)
+	{
+		PROCESS_MEMORY_COUNTERS counters = { 0 };
+		counters.cb = sizeof(counters);
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		{
+			printf("%-32s working set %10.1f KB, peak %10.1f KB\n", name,
+				counters.WorkingSetSize / 1024.0, counters.PeakWorkingSetSize / 1024.0);
+		}
+	}
+}
+
+namespace Benchmarks
+{
+	NvAPI_Status DrsSessionCommit(NvU32 changeCount)
+	{
+		NvAPI_Status status;
+
+		// Remember how VSYNCMODE is stored on the base profile so it can be put back
+		DrsSession original;
+		status = original.Load();
+		if (status != NVAPI_OK)
+		{
+			return status;
+		}
+
+		NvDRSProfileHandle baseProfile = NULL;
+		status = original.FindProfile(NULL, &baseProfile);
+		if (status != NVAPI_OK)
+		{
+			return status;
+		}
+
+		NVDRS_SETTING *setting = new NVDRS_SETTING;
+		memset(setting, 0, sizeof(NVDRS_SETTING));
+		setting->version = NVDRS_SETTING_VER;
+		NvAPI_Status lookup = Drs().GetSetting(original.Handle(), baseProfile, ESetting::VSYNCMODE_ID, setting);
+		if (lookup != NVAPI_OK || setting->settingLocation != NVDRS_CURRENT_PROFILE_LOCATION)
+			original.StageDeleteSetting(NULL, ESetting::VSYNCMODE_ID);
+		else if (setting->isCurrentPredefined)
+			original.StageRestoreSetting(NULL, ESetting::VSYNCMODE_ID);
+		else
+			original.StageSetDword(NULL, ESetting::VSYNCMODE_ID, setting->u32CurrentValue);
+		delete setting;
+
+		printf("DRS commit benchmark, %u changes to VSYNCMODE on the base profile\n", changeCount);
+
+		// One full Create/Load/Set/Save/Destroy round-trip per change
+		Stopwatch perChange;
+		for (NvU32 i = 0; i < changeCount; i++)
+		{
+			DrsSession session;
+			session.StageSetDword(NULL, ESetting::VSYNCMODE_ID, (i & 1) ? VSYNCMODE_FORCEON : VSYNCMODE_FORCEOFF);
+			status = session.Commit();
+			if (status != NVAPI_OK)
+			{
+				original.Commit();
+				return status;
+			}
+		}
+		PrintResult("session per change", changeCount, perChange.ElapsedMs());
+
+		// All changes staged and committed with one Load and one Save
+		Stopwatch batched;
+		DrsSession session;
+		for (NvU32 i = 0; i < changeCount; i++)
+		{
+			session.StageSetDword(NULL, ESetting::VSYNCMODE_ID, (i & 1) ? VSYNCMODE_FORCEON : VSYNCMODE_FORCEOFF);
+		}
+		status = session.Commit();
+		PrintResult("batched commit", changeCount, batched.ElapsedMs());
+
+		NvAPI_Status restore = original.Commit();
+		return status != NVAPI_OK ? status : restore;
+	}
+
+	NvAPI_Status DrsSnapshotQuery(NvU32 queryCount)
+	{
+		NvAPI_Status status;
+
+		DrsSession session;
+		status = session.Load();
+		if (status != NVAPI_OK)
+		{
+			return status;
+		}
+
+		DrsSnapshot snapshot;
+		Stopwatch load;
+		status = snapshot.Load(session);
+		if (status != NVAPI_OK)
+		{
+			return status;
+		}
+		double loadMs = load.ElapsedMs();
+
+		printf("DRS snapshot: %u profiles, %u applications, %u setting rows\n",
+			snapshot.ProfileCount(), snapshot.ApplicationCount(), snapshot.SettingCount());
+		PrintResult("snapshot load", 1, loadMs);
+
+		// In-memory: the setting ID index gives the overriding rows directly
+		NvU32 matches = 0;
+		Stopwatch indexed;
+		for (NvU32 i = 0; i < queryCount; i++)
+		{
+			const NvU32 *rows = NULL;
+			matches += snapshot.FindSettingRows(ESetting::VSYNCMODE_ID, &rows);
+		}
+		PrintResult("snapshot query", queryCount, indexed.ElapsedMs());
+
+		// Driver: one GetSetting per profile for a single answer
+		NvU32 driverMatches = 0;
+		NvU32 driverCalls = 0;
+		NVDRS_SETTING *setting = new NVDRS_SETTING;
+		Stopwatch driver;
+		NvDRSProfileHandle profile = NULL;
+		for (NvU32 i = 0; Drs().EnumProfiles(session.Handle(), i, &profile) == NVAPI_OK; i++)
+		{
+			memset(setting, 0, sizeof(NVDRS_SETTING));
+			setting->version = NVDRS_SETTING_VER;
+			if (Drs().GetSetting(session.Handle(), profile, ESetting::VSYNCMODE_ID, setting) == NVAPI_OK &&
+				setting->settingLocation == NVDRS_CURRENT_PROFILE_LOCATION)
+			{
+				driverMatches++;
+			}
+			driverCalls += 2;
+		}
+		PrintResult("driver query", 1, driver.ElapsedMs());
+		delete setting;
+
+		printf("matches: snapshot %u, driver %u (%u driver calls)\n",
+			queryCount ? matches / queryCount : 0, driverMatches, driverCalls);
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status DrsDumpMemory()
+	{
+		NvAPI_Status status;
+
+		PrintMemory("before load");
+
+		DrsSession session;
+		status = session.Load();
+		if (status != NVAPI_OK)
+		{
+			return status;
+		}
+		PrintMemory("after LoadSettings");
+
+		DrsScratchArena scratch;
+		DrsRecordBuffer profileRecords;
+		size_t recordBytes = 0;
+		size_t fixedBytes = 0;
+		NvU32 profileCount = 0;
+		NvU32 recordCount = 0;
+
+		Stopwatch dump;
+		NvDRSProfileHandle profile = NULL;
+		while ((status = Drs().EnumProfiles(session.Handle(), profileCount, &profile)) == NVAPI_OK)
+		{
+			NVDRS_PROFILE profileInfo = { 0 };
+			profileInfo.version = NVDRS_PROFILE_VER;
+			status = Drs().GetProfileInfo(session.Handle(), profile, &profileInfo);
+			if (status != NVAPI_OK)
+			{
+				return status;
+			}
+
+			profileRecords.Clear();
+			NvU32 settingCount = profileInfo.numOfSettings;
+			if (settingCount > 0)
+			{
+				NVDRS_SETTING *settings = scratch.Settings(settingCount);
+				if (settings == NULL)
+				{
+					return NVAPI_OUT_OF_MEMORY;
+				}
+
+				status = Drs().EnumSettings(session.Handle(), profile, 0, &settingCount, settings);
+				if (status != NVAPI_OK)
+				{
+					return status;
+				}
+
+				for (NvU32 i = 0; i < settingCount; i++)
+				{
+					if (settings[i].settingLocation == NVDRS_CURRENT_PROFILE_LOCATION)
+						profileRecords.Append(settings[i]);
+				}
+			}
+
+			// What the old per-profile new[] allocated (and leaked) against the compact form
+			fixedBytes += (size_t)profileInfo.numOfSettings * sizeof(NVDRS_SETTING);
+			recordBytes += profileRecords.Bytes();
+			recordCount += profileRecords.Count();
+			profileCount++;
+		}
+
+		if (status != NVAPI_END_ENUMERATION)
+		{
+			return status;
+		}
+
+		PrintResult("full dump", profileCount, dump.ElapsedMs());
+		printf("%u profiles, %u stored settings\n", profileCount, recordCount);
+		printf("scratch arena high-water:        %10.1f KB\n", scratch.Capacity() / 1024.0);
+		printf("fixed NVDRS_SETTING arrays:      %10.1f KB\n", fixedBytes / 1024.0);
+		printf("compact records:                 %10.1f KB (%.1f bytes/setting)\n", recordBytes / 1024.0,
+			recordCount ? (double)recordBytes / recordCount : 0.0);
+		PrintMemory("after dump");
+
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status SettingRegistryLookup(NvU32 queryCount)
+	{
+		std::vector<NvU32> settingIds;
+		for (NvU32 slot = 0; slot < SETTING_ID_SLOTS; slot++)
+		{
+			if (settingRegistry[slot].name != NULL)
+				settingIds.push_back(settingRegistry[slot].settingId);
+		}
+
+		// Registry: ID -> name -> ID and a value check, all table probes
+		NvU32 resolved = 0;
+		Stopwatch registry;
+		for (NvU32 i = 0; i < queryCount; i++)
+		{
+			const SettingInfo *info = FindSettingInfo(settingIds[i % settingIds.size()]);
+			if (info != NULL && FindSettingInfoByName(info->name) == info && IsLegalSettingValue(*info, info->defaultValue))
+				resolved++;
+		}
+		PrintResult("registry lookup", queryCount, registry.ElapsedMs());
+
+		// Driver: the same three questions, once per documented setting
+		NvU32 driverResolved = 0;
+		NVDRS_SETTING_VALUES *values = new NVDRS_SETTING_VALUES;
+		Stopwatch driver;
+		for (size_t i = 0; i < settingIds.size(); i++)
+		{
+			NvAPI_UnicodeString name;
+			NvU32 settingId = 0;
+			NvU32 valueCount = NVAPI_SETTING_MAX_VALUES;
+			memset(values, 0, sizeof(NVDRS_SETTING_VALUES));
+			values->version = NVDRS_SETTING_VALUES_VER;
+
+			if (NvApiCall(NVAPI_CALL_DRS_GET_SETTING_NAME_FROM_ID, NvAPI_DRS_GetSettingNameFromId, settingIds[i], &name) == NVAPI_OK &&
+				NvApiCall(NVAPI_CALL_DRS_GET_SETTING_ID_FROM_NAME, NvAPI_DRS_GetSettingIdFromName, name, &settingId) == NVAPI_OK &&
+				NvApiCall(NVAPI_CALL_DRS_ENUM_AVAILABLE_SETTING_VALUES, NvAPI_DRS_EnumAvailableSettingValues, settingIds[i], &valueCount, values) == NVAPI_OK)
+			{
+				driverResolved++;
+			}
+		}
+		PrintResult("driver lookup", (NvU32)settingIds.size(), driver.ElapsedMs());
+		delete values;
+
+		printf("resolved: registry %u of %u, driver %u of %u\n", resolved, queryCount, driverResolved, (NvU32)settingIds.size());
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status DrsCacheStartup(const char *cachePath)
+	{
+		NvAPI_Status status;
+		const NvU32 openCount = 20;
+
+		// Cold path: everything a query paid for before the cache existed
+		DrsSession session;
+		DrsSnapshot snapshot;
+		Stopwatch cold;
+		status = snapshot.Load(session);
+		if (status != NVAPI_OK)
+		{
+			return status;
+		}
+
+		std::wstring appName = L"game.exe";
+		if (snapshot.ApplicationCount() > 0)
+			appName = snapshot.String(snapshot.Applications().appName[0]);
+
+		std::vector<NvU32> applications;
+		NvU32 coldRow = DrsSnapshot::npos;
+		if (snapshot.FindApplications(appName.c_str(), applications) > 0)
+			coldRow = snapshot.FindSetting(snapshot.Applications().profile[applications[0]], ESetting::VSYNCMODE_ID);
+		PrintResult("load + snapshot + query", 1, cold.ElapsedMs());
+
+		DrsCacheKey key;
+		status = GetDrsCacheKey(key);
+		if (status != NVAPI_OK)
+		{
+			return status;
+		}
+
+		Stopwatch write;
+		status = WriteDrsCache(snapshot, key, cachePath);
+		if (status != NVAPI_OK)
+		{
+			return status;
+		}
+		PrintResult("cache write", 1, write.ElapsedMs());
+
+		// Warm path: key check, mapping and the same query, no LoadSettings
+		NvU32 rebuilds = 0;
+		NvU32 cachedRow = DrsSnapshot::npos;
+		Stopwatch warm;
+		for (NvU32 i = 0; i < openCount; i++)
+		{
+			DrsSnapshotCache cache;
+			status = cache.Open(cachePath);
+			if (status != NVAPI_OK)
+			{
+				return status;
+			}
+			if (cache.WasRebuilt())
+				rebuilds++;
+
+			if (cache.FindApplications(appName.c_str(), applications) > 0)
+				cachedRow = cache.FindSetting(cache.Tables().applicationProfile[applications[0]], ESetting::VSYNCMODE_ID);
+		}
+		PrintResult("cache open + query", openCount, warm.ElapsedMs());
+
+		wprintf(L"query %s: snapshot row %d, cache row %d, %u rebuilds\n", appName.c_str(), (int)coldRow, (int)cachedRow, rebuilds);
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status AppResolverThroughput(NvU32 pathCount)
+	{
+		NvAPI_Status status;
+		const NvU32 driverPathLimit = 2000;
+
+		DrsSession session;
+		DrsSnapshot snapshot;
+		status = snapshot.Load(session);
+		if (status != NVAPI_OK)
+		{
+			return status;
+		}
+
+		DrsAppResolver resolver;
+		Stopwatch build;
+		resolver.Build(snapshot);
+		PrintResult("resolver build", snapshot.ApplicationCount(), build.ElapsedMs());
+		printf("%u applications, %u trie nodes\n", resolver.EntryCount(), resolver.NodeCount());
+
+		// Half the paths end in a known executable, the other half in nothing the driver knows
+		std::vector<std::wstring> paths(pathCount);
+		wchar_t prefix[64];
+		for (NvU32 i = 0; i < pathCount; i++)
+		{
+			swprintf(prefix, sizeof(prefix) / sizeof(prefix[0]), L"C:\\Games\\Title%u\\", i);
+			paths[i] = prefix;
+			if (i % 2 == 0 && snapshot.ApplicationCount() > 0)
+				paths[i] += snapshot.String(snapshot.Applications().appName[(i / 2) % snapshot.ApplicationCount()]);
+			else
+				paths[i] += L"unlisted.exe";
+		}
+
+		// Synthetic paths do not exist, fileInFolder cannot be checked on disk
+		resolver.SetCheckFolderFiles(false);
+		std::vector<DrsResolution> results;
+		Stopwatch bulk;
+		resolver.ResolveAll(paths, results);
+		double bulkMs = bulk.ElapsedMs();
+		PrintResult("bulk resolve", pathCount, bulkMs);
+
+		NvU32 resolved = 0;
+		for (NvU32 i = 0; i < pathCount; i++)
+		{
+			if (results[i].profile != DrsSnapshot::npos)
+				resolved++;
+		}
+
+		// Driver: one call per path, and on a sample only, it is orders of magnitude slower
+		NvU32 driverCount = pathCount < driverPathLimit ? pathCount : driverPathLimit;
+		NvU32 driverResolved = 0;
+		NvU32 agreed = 0;
+		NVDRS_APPLICATION *application = new NVDRS_APPLICATION;
+		NvAPI_UnicodeString name;
+		Stopwatch driver;
+		for (NvU32 i = 0; i < driverCount; i++)
+		{
+			memset(application, 0, sizeof(NVDRS_APPLICATION));
+			application->version = NVDRS_APPLICATION_VER;
+			memset(name, 0, sizeof(name));
+			for (size_t c = 0; c < paths[i].size() && c < NVAPI_UNICODE_STRING_MAX - 1; c++)
+				name[c] = (NvU16)paths[i][c];
+
+			NvDRSProfileHandle profile = NULL;
+			if (Drs().FindApplicationByName(session.Handle(), name, &profile, application) == NVAPI_OK)
+			{
+				driverResolved++;
+				if (results[i].profile != DrsSnapshot::npos && snapshot.Profiles().handle[results[i].profile] == profile)
+					agreed++;
+			}
+		}
+		double driverMs = driver.ElapsedMs();
+		PrintResult("driver resolve", driverCount, driverMs);
+		delete application;
+
+		printf("throughput: bulk %.0f paths/s, driver %.0f paths/s\n",
+			bulkMs > 0 ? pathCount * 1000.0 / bulkMs : 0.0, driverMs > 0 ? driverCount * 1000.0 / driverMs : 0.0);
+		printf("resolved: bulk %u of %u, driver %u of %u (%u agree)\n", resolved, pathCount, driverResolved, driverCount, agreed);
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status ProfileProvisioning(NvU32 profileCount)
+	{
+		NvAPI_Status status;
+
+		// Two executables and two settings per profile, as a manifest would list them
+		DesiredState state;
+		state.profiles.resize(profileCount);
+		wchar_t name[64];
+		for (NvU32 i = 0; i < profileCount; i++)
+		{
+			DesiredProfile &profile = state.profiles[i];
+			swprintf(name, sizeof(name) / sizeof(name[0]), L"NVDIAControlPanel provisioning %u", i);
+			profile.name = name;
+			swprintf(name, sizeof(name) / sizeof(name[0]), L"nvcpprovision%u.exe", i);
+			profile.applications.push_back(name);
+			swprintf(name, sizeof(name) / sizeof(name[0]), L"nvcpprovision%u_launcher.exe", i);
+			profile.applications.push_back(name);
+			profile.line = 0;
+
+			DesiredSetting setting;
+			setting.settingType = NVDRS_DWORD_TYPE;
+			setting.restoreDefault = false;
+			setting.line = 0;
+			setting.settingId = ESetting::VSYNCMODE_ID;
+			setting.u32Value = EValues_VSYNCMODE::VSYNCMODE_FORCEOFF;
+			profile.settings.push_back(setting);
+			setting.settingId = ESetting::PRERENDERLIMIT_ID;
+			setting.u32Value = 1;
+			profile.settings.push_back(setting);
+			if (profile.settings[0].settingId > profile.settings[1].settingId)
+				std::swap(profile.settings[0], profile.settings[1]);
+		}
+
+		DrsSession session;
+		DrsSnapshot snapshot;
+		DrsPlan plan;
+		Stopwatch planning;
+		status = snapshot.Load(session);
+		if (status != NVAPI_OK)
+		{
+			return status;
+		}
+		BuildDrsPlan(state, snapshot, plan, true);
+		PrintResult("load + plan", profileCount, planning.ElapsedMs());
+
+		// Never touch profiles that were there before the run
+		if (plan.createdProfiles != profileCount || plan.conflicts != 0)
+		{
+			printf("%u of %u benchmark profiles already exist, %u conflicts; not provisioning\n",
+				profileCount - plan.createdProfiles, profileCount, plan.conflicts);
+			return NVAPI_ERROR;
+		}
+
+		Stopwatch apply;
+		status = ApplyDrsPlan(state, plan, session);
+		double applyMs = apply.ElapsedMs();
+		if (status != NVAPI_OK)
+		{
+			return status;
+		}
+		PrintResult("create + save", profileCount, applyMs);
+		printf("%u changes, %.0f profiles/s\n", (NvU32)plan.changes.size(), applyMs > 0 ? profileCount * 1000.0 / applyMs : 0.0);
+
+		// Idempotence: the same manifest against the result plans nothing
+		Stopwatch replanning;
+		status = session.Load();
+		if (status == NVAPI_OK)
+			status = snapshot.Load(session);
+		if (status == NVAPI_OK)
+		{
+			BuildDrsPlan(state, snapshot, plan, true);
+			PrintResult("reload + replan", profileCount, replanning.ElapsedMs());
+			printf("replan: %u changes, %u settings and %u applications unchanged\n",
+				(NvU32)plan.changes.size(), plan.unchangedSettings, plan.unchangedApplications);
+		}
+
+		for (NvU32 i = 0; i < profileCount; i++)
+			session.StageDeleteProfile(state.profiles[i].name.c_str());
+
+		Stopwatch cleanup;
+		NvAPI_Status removed = session.Commit();
+		PrintResult("delete + save", profileCount, cleanup.ElapsedMs());
+		return status != NVAPI_OK ? status : removed;
+	}
+
+	NvAPI_Status TelemetrySampling(NvU32 seconds, NvU32 simulatedGpus)
+	{
+		NvAPI_Status status;
+
+		// Simulated reads cost about what a thermal or clock query costs the driver
+		const NvU32 SIMULATED_READ_MICROSECONDS = 50;
+
+		NvApiTelemetrySource driver;
+		SimulatedTelemetrySource simulated(simulatedGpus, SIMULATED_READ_MICROSECONDS);
+		TelemetrySource *source = &simulated;
+		if (simulatedGpus == 0)
+		{
+			status = driver.Open();
+			if (status != NVAPI_OK)
+			{
+				return status;
+			}
+			source = &driver;
+		}
+		printf("%u %s GPUs, %u s per run\n", source->GpuCount(), simulatedGpus ? "simulated" : "physical", seconds);
+
+		// What ShowCurrentTemperature and ShowCoolerSettings did: read back to back until Enter
+		TelemetrySample samples[TELEMETRY_MAX_CHANNELS];
+		NvU32 sampleCount = 0;
+		NvU32 busyReads = 0;
+		double cpuStart = ProcessCpuMs();
+		Stopwatch busy;
+		while (busy.ElapsedMs() < seconds * 1000.0)
+		{
+			for (NvU32 gpu = 0; gpu < source->GpuCount(); gpu++)
+			{
+				source->Read(gpu, TELEMETRY_TEMPERATURE, samples, &sampleCount);
+				source->Read(gpu, TELEMETRY_TACH, samples, &sampleCount);
+				busyReads += 2;
+			}
+		}
+		PrintResult("busy-wait polling (CPU)", busyReads, ProcessCpuMs() - cpuStart);
+
+		// Every metric at its console period, on one thread
+		TelemetrySampler sampler(*source);
+		for (int metric = 0; metric < TELEMETRY_METRIC_COUNT; metric++)
+			sampler.ScheduleAll((TelemetryMetric)metric, DefaultTelemetryPeriodMs((TelemetryMetric)metric));
+
+		SampleCounter counter;
+		sampler.Subscribe(&counter);
+		cpuStart = ProcessCpuMs();
+		sampler.Start();
+		Sleep(seconds * 1000);
+		sampler.Stop();
+		double samplerCpuMs = ProcessCpuMs() - cpuStart;
+
+		NvU32 samplerReads = 0;
+		unsigned long long readMicroseconds = 0;
+		for (int metric = 0; metric < TELEMETRY_METRIC_COUNT; metric++)
+		{
+			const TelemetryMetricStats &stats = sampler.Stats((TelemetryMetric)metric);
+			printf("%-12s every %4u ms: %6llu reads, %7llu samples, %llu errors, %llu missed, %8.1f us/read\n",
+				TelemetryMetricName((TelemetryMetric)metric), DefaultTelemetryPeriodMs((TelemetryMetric)metric),
+				stats.reads, stats.samples, stats.errors, stats.missed,
+				stats.reads ? (double)stats.readMicroseconds / stats.reads : 0.0);
+			samplerReads += (NvU32)stats.reads;
+			readMicroseconds += stats.readMicroseconds;
+		}
+		PrintResult("timer-wheel sampler (CPU)", samplerReads, samplerCpuMs);
+
+		// What the sampler costs on top of the reads themselves
+		double overheadMs = samplerCpuMs - readMicroseconds / 1000.0;
+		printf("%llu wakeups, %llu samples delivered, scheduling overhead %.3f us/read\n",
+			sampler.WakeCount(), counter.samples, samplerReads && overheadMs > 0 ? overheadMs * 1000.0 / samplerReads : 0.0);
+		return sampler.LastError();
+	}
+
+	NvAPI_Status TelemetryRingThroughput(NvU32 sampleCount, NvU32 producerCount)
+	{
+		if (producerCount == 0)
+			producerCount = 1;
+		sampleCount -= sampleCount % producerCount;
+
+		// Producers wait for space here, so every sample is delivered and the rate is sustained
+		{
+			TelemetrySpscRing ring(1 << 16);
+			Stopwatch spsc;
+			std::thread producer(ProduceSpsc, &ring, sampleCount);
+			ConsumeAll(ring, sampleCount);
+			producer.join();
+			double ms = spsc.ElapsedMs();
+			PrintResult("SPSC ring", sampleCount, ms);
+			printf("%.1f M samples/s\n", ms > 0 ? sampleCount / ms / 1000.0 : 0.0);
+		}
+
+		{
+			TelemetryMpscRing ring(1 << 16);
+			std::vector<std::thread> producers;
+			Stopwatch mpsc;
+			for (NvU32 i = 0; i < producerCount; i++)
+				producers.push_back(std::thread(ProduceMpsc, &ring, sampleCount / producerCount, i));
+			ConsumeAll(ring, sampleCount);
+			for (NvU32 i = 0; i < producerCount; i++)
+				producers[i].join();
+			double ms = mpsc.ElapsedMs();
+			printf("MPSC ring, %u producers\n", producerCount);
+			PrintResult("MPSC ring", sampleCount, ms);
+			printf("%.1f M samples/s\n", ms > 0 ? sampleCount / ms / 1000.0 : 0.0);
+		}
+
+		// The sampler's mode: publish never waits, a consumer that naps like a busy console loses samples
+		{
+			TelemetrySpscRing ring(1 << 12);
+			TelemetrySample samples[RING_BATCH];
+			FillSamples(samples, RING_BATCH, 0);
+
+			std::atomic<bool> done(false);
+			unsigned long long received = 0;
+			std::thread consumer(ConsumeSlowly, &ring, &done, &received);
+
+			Stopwatch lossy;
+			for (NvU32 sent = 0; sent < sampleCount; sent += RING_BATCH)
+				ring.Publish(samples, sampleCount - sent < RING_BATCH ? sampleCount - sent : RING_BATCH);
+			double ms = lossy.ElapsedMs();
+			done = true;
+			consumer.join();
+
+			PrintResult("SPSC publish, slow consumer", sampleCount, ms);
+			printf("%llu delivered, %llu dropped (%llu accounted of %u)\n",
+				received, ring.Dropped(), received + ring.Dropped(), sampleCount);
+		}
+
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status ClockDeltaCapture(NvU32 seconds, NvU32 simulatedGpus)
+	{
+		// Current clocks at 100 Hz to make the difference visible; base and boost at their usual period
+		SimulatedTelemetrySource source(simulatedGpus);
+		TelemetrySampler sampler(source);
+		sampler.ScheduleAll(TELEMETRY_CLOCKS, 10);
+		sampler.ScheduleAll(TELEMETRY_BASE_CLOCKS, DefaultTelemetryPeriodMs(TELEMETRY_BASE_CLOCKS));
+		sampler.ScheduleAll(TELEMETRY_BOOST_CLOCKS, DefaultTelemetryPeriodMs(TELEMETRY_BOOST_CLOCKS));
+
+		FILE *file = OpenTemporaryFile();
+		if (file == NULL)
+		{
+			return NVAPI_ERROR;
+		}
+
+		TextSizeCounter text;
+		TelemetryDeltaFilter changes;
+		unsigned long long captureBytes = 0;
+		unsigned long long captured = 0;
+		{
+			BufferedWriter writer(file);
+			TelemetryDeltaWriter deltas(writer);
+			sampler.Subscribe(&text);
+			sampler.Subscribe(&changes);
+			changes.Subscribe(&deltas);
+
+			sampler.Start();
+			Sleep(seconds * 1000);
+			sampler.Stop();
+
+			writer.Flush();
+			captureBytes = writer.BytesWritten();
+			captured = deltas.SampleCount();
+		}
+
+		unsigned long long samples = changes.SeenCount();
+		printf("%u simulated GPUs, %u s: %llu clock samples, %llu changes\n", simulatedGpus, seconds, samples, changes.ChangedCount());
+		printf("%-32s %12llu bytes %8.2f bytes/sample\n", "console text", text.bytes, samples ? (double)text.bytes / samples : 0.0);
+		printf("%-32s %12llu bytes %8.2f bytes/sample\n", "raw sample records", samples * sizeof(TelemetrySample), (double)sizeof(TelemetrySample));
+		printf("%-32s %12llu bytes %8.2f bytes/sample\n", "delta capture", captureBytes, samples ? (double)captureBytes / samples : 0.0);
+
+		// The capture decodes back to exactly the changes
+		std::vector<NvU8> data((size_t)captureBytes);
+		rewind(file);
+		bool decoded = !data.empty() && fread(&data[0], 1, data.size(), file) == data.size();
+		std::vector<TelemetrySample> replayed;
+		Stopwatch decoding;
+		decoded = decoded && DecodeTelemetryDeltas(&data[0], data.size(), replayed);
+		PrintResult("decode", (NvU32)replayed.size(), decoding.ElapsedMs());
+		fclose(file);
+
+		if (!decoded || replayed.size() != captured)
+		{
+			printf("capture did not decode: %u of %llu samples\n", (NvU32)replayed.size(), captured);
+			return NVAPI_ERROR;
+		}
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status TelemetryFrameLatency(NvU32 seconds, NvU32 maxGpus, bool pin)
+	{
+		// A few hundred microseconds per read, about what a thermal or clock query costs on a loaded node
+		const NvU32 SIMULATED_READ_MICROSECONDS = 250;
+		const NvU32 RATES[] = { 1, 10, 100 };
+		const TelemetryMetric METRICS[] = { TELEMETRY_TEMPERATURE, TELEMETRY_TACH, TELEMETRY_CLOCKS, TELEMETRY_PSTATE };
+
+		printf("%u reads per GPU and frame, %u us each, %u cores%s\n", (NvU32)(sizeof(METRICS) / sizeof(METRICS[0])),
+			SIMULATED_READ_MICROSECONDS, std::thread::hardware_concurrency(), pin ? ", workers pinned" : "");
+		printf("%4s %4s | %7s %5s %10s %10s %10s %10s | %10s %10s %10s\n", "GPUs", "Hz", "frames", "late",
+			"lat mean", "lat max", "skew mean", "skew max", "1t lat", "1t skew", "1t max");
+
+		NvAPI_Status status = NVAPI_OK;
+		for (NvU32 gpus = 1; gpus <= maxGpus; gpus *= 2)
+		{
+			for (NvU32 r = 0; r < sizeof(RATES) / sizeof(RATES[0]); r++)
+			{
+				// At least three frames at the slow rates
+				NvU32 hz = RATES[r];
+				NvU32 runMs = seconds * 1000 > 3000 / hz ? seconds * 1000 : 3000 / hz;
+				SimulatedTelemetrySource source(gpus, SIMULATED_READ_MICROSECONDS);
+
+				TelemetryFrameSampler frames(source, hz);
+				for (NvU32 i = 0; i < sizeof(METRICS) / sizeof(METRICS[0]); i++)
+					frames.Schedule(METRICS[i], 0);
+				if (pin)
+					frames.PinWorkers(0);
+				frames.Start();
+				Sleep(runMs);
+				frames.Stop();
+
+				TelemetrySampler sampler(source);
+				for (NvU32 i = 0; i < sizeof(METRICS) / sizeof(METRICS[0]); i++)
+					sampler.ScheduleAll(METRICS[i], 1000 / hz);
+				BatchSkewMeter serial;
+				sampler.Subscribe(&serial);
+				sampler.Start();
+				Sleep(runMs);
+				sampler.Stop();
+
+				const TelemetryFrameStats &stats = frames.Stats();
+				printf("%4u %4u | %7llu %5llu %8.1fus %8lluus %8.1fus %8lluus | %8.1fus %8.1fus %8lluus\n", gpus, hz,
+					stats.frames, stats.incompleteFrames,
+					stats.frames ? (double)stats.totalLatencyMicroseconds / stats.frames : 0.0, stats.maxLatencyMicroseconds,
+					stats.frames ? (double)stats.totalSkewMicroseconds / stats.frames : 0.0, stats.maxSkewMicroseconds,
+					serial.batches ? (double)serial.totalLatency / serial.batches : 0.0,
+					serial.batches ? (double)serial.totalSkew / serial.batches : 0.0, serial.maxSkew);
+
+				if (stats.lateSamples + stats.skippedTicks + stats.missedTicks > 0)
+					printf("          %llu late samples dropped, %llu ticks skipped by busy workers, %llu missed by the coordinator\n",
+						stats.lateSamples, stats.skippedTicks, stats.missedTicks);
+				if (frames.LastError() != NVAPI_OK)
+					status = frames.LastError();
+			}
+		}
+		return status;
+	}
+
+	NvAPI_Status TelemetryStoreHistory(NvU32 days, NvU32 simulatedGpus)
+	{
+		NvU64 steps = (NvU64)days * 24 * 3600 * 1000000 / HISTORY_STEP_MICROSECONDS;
+		std::string directory = BenchmarkDirectory("NVDIAControlPanel.store-bench");
+		DeleteStore(directory);
+
+		SimulatedTelemetrySource source(simulatedGpus);
+		unsigned long long textBytes = 0;
+		NvS64 checksum = 0;
+		unsigned long long written = 0;
+		unsigned long long storeBytes = 0;
+		{
+			TelemetryStoreWriter writer(directory.c_str());
+			std::vector<TelemetrySample> batch;
+			char line[96];
+
+			Stopwatch writing;
+			for (NvU64 step = 0; step < steps; step++)
+			{
+				ReadHistoryStep(source, simulatedGpus, step, batch);
+				for (size_t i = 0; i < batch.size(); i++)
+				{
+					const TelemetrySample &sample = batch[i];
+					checksum += sample.value;
+
+					// What a timestamped text log of the same samples would hold
+					int printed = snprintf(line, sizeof(line), "%llu GPU %u: %s %u: %lld\n", (unsigned long long)sample.timestamp,
+						sample.gpu, TelemetryMetricName((TelemetryMetric)sample.metric), sample.channel, (long long)sample.value);
+					textBytes += printed > 0 ? printed : 0;
+				}
+				if (!batch.empty())
+					writer.Append(&batch[0], (NvU32)batch.size());
+			}
+			writer.Seal();
+			double ms = writing.ElapsedMs();
+
+			if (writer.Failed())
+			{
+				printf("could not write the store in %s\n", directory.c_str());
+				DeleteStore(directory);
+				return NVAPI_ERROR;
+			}
+
+			written = writer.SampleCount();
+			storeBytes = writer.BytesWritten();
+			printf("%u days, %u simulated GPUs: %llu samples in %u segments\n", days, simulatedGpus, written, writer.SegmentCount());
+			printf("%-32s %8.1f M samples/s (generation and text sizing included)\n", "append", ms > 0 ? written / ms / 1000.0 : 0.0);
+		}
+
+		printf("%-32s %14llu bytes %8.2f bytes/sample\n", "text log", textBytes, written ? (double)textBytes / written : 0.0);
+		printf("%-32s %14llu bytes %8.2f bytes/sample\n", "raw sample records", written * sizeof(TelemetrySample), (double)sizeof(TelemetrySample));
+		printf("%-32s %14llu bytes %8.2f bytes/sample\n", "segment store", storeBytes, written ? (double)storeBytes / written : 0.0);
+
+		TelemetryStoreReader reader;
+		Stopwatch opening;
+		bool opened = reader.Open(directory.c_str());
+		printf("%-32s %8u segments %8u blocks %12.3f ms\n", "open (map + merge indexes)", (NvU32)reader.SegmentCount(), (NvU32)reader.BlockCount(), opening.ElapsedMs());
+		if (!opened || reader.SampleCount() != written)
+		{
+			printf("store did not reopen: %llu of %llu samples, %u corrupt segments\n", reader.SampleCount(), written, reader.CorruptSegments());
+			DeleteStore(directory);
+			return NVAPI_ERROR;
+		}
+
+		std::vector<NvU32> series;
+		reader.Series(series);
+		std::vector<TelemetrySample> result;
+		result.reserve(1 << 20);
+
+		// One hour of one series, anywhere in the history
+		const NvU32 QUERY_COUNT = 10000;
+		const NvU64 HOUR = 3600ULL * 1000000;
+		NvU64 span = steps * HISTORY_STEP_MICROSECONDS;
+		unsigned long long queried = 0;
+		unsigned long long decodedBefore = reader.BlocksDecoded();
+		NvU64 random = 88172645463325252ULL;
+		Stopwatch ranges;
+		for (NvU32 i = 0; i < QUERY_COUNT; i++)
+		{
+			random ^= random << 13;
+			random ^= random >> 7;
+			random ^= random << 17;
+			NvU64 from = HISTORY_START + (span > HOUR ? random % (span - HOUR) : 0);
+			result.clear();
+			queried += reader.Query(series[(size_t)(random >> 40) % series.size()], from, from + HOUR, result);
+		}
+		double rangeMs = ranges.ElapsedMs();
+		PrintResult("1-hour range queries", QUERY_COUNT, rangeMs);
+		printf("%llu samples, %.1f blocks decoded per query, %.1f M samples/s\n", queried,
+			(double)(reader.BlocksDecoded() - decodedBefore) / QUERY_COUNT, rangeMs > 0 ? queried / rangeMs / 1000.0 : 0.0);
+
+		// Everything, which must come back exactly as written
+		NvS64 scanned = 0;
+		unsigned long long scannedCount = 0;
+		Stopwatch scanning;
+		for (size_t i = 0; i < series.size(); i++)
+		{
+			result.clear();
+			scannedCount += reader.Query(series[i], 0, ~0ULL, result);
+			for (size_t j = 0; j < result.size(); j++)
+				scanned += result[j].value;
+		}
+		double scanMs = scanning.ElapsedMs();
+		PrintResult("full scan, every series", (NvU32)series.size(), scanMs);
+		printf("%.1f M samples/s\n", scanMs > 0 ? scannedCount / scanMs / 1000.0 : 0.0);
+
+		reader.Close();
+		DeleteStore(directory);
+		if (scannedCount != written || scanned != checksum)
+		{
+			printf("scan does not match what was written: %llu of %llu samples\n", scannedCount, written);
+			return NVAPI_ERROR;
+		}
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status TelemetryRollups(NvU32 days, NvU32 simulatedGpus)
+	{
+		NvU64 steps = (NvU64)days * 24 * 3600 * 1000000 / HISTORY_STEP_MICROSECONDS;
+		NvU64 span = steps * HISTORY_STEP_MICROSECONDS;
+		std::string directory = BenchmarkDirectory("NVDIAControlPanel.rollup-bench");
+		DeleteStore(directory);
+
+		SimulatedTelemetrySource source(simulatedGpus);
+		unsigned long long written = 0;
+		unsigned long long storeBytes = 0;
+		unsigned long long rollupRecords[TELEMETRY_ROLLUP_TIER_COUNT] = { 0 };
+		unsigned long long rollupBytes[TELEMETRY_ROLLUP_TIER_COUNT] = { 0 };
+		unsigned long long windows[TELEMETRY_ROLLUP_TIER_COUNT] = { 0 };
+		{
+			TelemetryStoreWriter store(directory.c_str());
+			TelemetryRollupWriter rollupWriter(directory.c_str());
+			TelemetryRollupEngine engine;
+			engine.Subscribe(&rollupWriter);
+			std::vector<TelemetrySample> batch;
+
+			double rollupMs = 0.0;
+			for (NvU64 step = 0; step < steps; step++)
+			{
+				ReadHistoryStep(source, simulatedGpus, step, batch);
+				if (batch.empty())
+					continue;
+
+				store.Append(&batch[0], (NvU32)batch.size());
+				Stopwatch rolling;
+				engine.Append(&batch[0], (NvU32)batch.size());
+				rollupMs += rolling.ElapsedMs();
+			}
+			Stopwatch flushing;
+			engine.Flush();
+			rollupWriter.Seal();
+			rollupMs += flushing.ElapsedMs();
+			store.Seal();
+
+			if (store.Failed() || rollupWriter.Failed())
+			{
+				printf("could not write the store in %s\n", directory.c_str());
+				DeleteStore(directory);
+				return NVAPI_ERROR;
+			}
+
+			written = store.SampleCount();
+			storeBytes = store.BytesWritten();
+			for (int tier = 0; tier < TELEMETRY_ROLLUP_TIER_COUNT; tier++)
+			{
+				rollupRecords[tier] = rollupWriter.RecordCount((TelemetryRollupTier)tier);
+				rollupBytes[tier] = rollupWriter.BytesWritten((TelemetryRollupTier)tier);
+				windows[tier] = engine.WindowCount((TelemetryRollupTier)tier);
+			}
+			printf("%u days, %u simulated GPUs: %llu samples\n", days, simulatedGpus, written);
+			printf("%-32s %8.1f M samples/s, %.1f ns/sample\n", "rollup engine (sealing included)",
+				rollupMs > 0 ? written / rollupMs / 1000.0 : 0.0, written ? rollupMs * 1000000.0 / written : 0.0);
+		}
+
+		printf("%-32s %14llu bytes %10llu samples\n", "raw segments", storeBytes, written);
+		for (int tier = 0; tier < TELEMETRY_ROLLUP_TIER_COUNT; tier++)
+		{
+			char name[32];
+			snprintf(name, sizeof(name), "%s rollups", TelemetryRollupTierName((TelemetryRollupTier)tier));
+			if (rollupRecords[tier] == 0)
+				printf("%-32s %14s %10llu windows, kept in memory only\n", name, "-", windows[tier]);
+			else
+				printf("%-32s %14llu bytes %10llu windows %8.1f bytes/window\n", name, rollupBytes[tier], rollupRecords[tier],
+					(double)rollupBytes[tier] / rollupRecords[tier]);
+		}
+
+		TelemetryStoreReader raw;
+		TelemetryRollupReader rollups;
+		if (!raw.Open(directory.c_str()) || !rollups.Open(directory.c_str()) || rollups.CorruptSegments() > 0)
+		{
+			printf("store did not reopen from %s\n", directory.c_str());
+			DeleteStore(directory);
+			return NVAPI_ERROR;
+		}
+
+		// The first temperature sensor of GPU 0, over everything and over a range that cuts through hours and seconds
+		TelemetrySample key;
+		memset(&key, 0, sizeof(key));
+		key.metric = TELEMETRY_TEMPERATURE;
+		NvU32 series = TelemetrySeriesKey(key);
+		const NvU64 ranges[][2] =
+		{
+			{ HISTORY_START, HISTORY_START + span },
+			{ HISTORY_START + 1043500000ULL, HISTORY_START + span - 2467000000ULL },
+		};
+		const char *rangeNames[] = { "whole history", "unaligned range" };
+
+		const NvU32 QUERY_COUNT = 100;
+		bool matched = true;
+		std::vector<TelemetrySample> samples;
+		std::vector<NvS64> values;
+		for (int r = 0; r < 2; r++)
+		{
+			NvU64 from = ranges[r][0];
+			NvU64 to = ranges[r][1];
+
+			// Exact answer from every raw sample
+			Stopwatch scanning;
+			samples.clear();
+			raw.Query(series, from, to, samples);
+			values.resize(samples.size());
+			NvS64 sum = 0;
+			for (size_t i = 0; i < samples.size(); i++)
+			{
+				values[i] = samples[i].value;
+				sum += values[i];
+			}
+			NvS64 minimum = values.empty() ? 0 : *std::min_element(values.begin(), values.end());
+			NvS64 maximum = values.empty() ? 0 : *std::max_element(values.begin(), values.end());
+			size_t rank = values.empty() ? 0 : (size_t)(0.99 * (values.size() - 1));
+			std::nth_element(values.begin(), values.begin() + rank, values.end());
+			NvS64 exact = values.empty() ? 0 : values[rank];
+			double scanMs = scanning.ElapsedMs();
+
+			TelemetryRollup summary;
+			NvU64 read = 0;
+			Stopwatch summarizing;
+			for (NvU32 i = 0; i < QUERY_COUNT; i++)
+			{
+				summary.Clear();
+				read = SummarizeTelemetry(rollups, &raw, series, from, to, summary);
+			}
+			double summaryMs = summarizing.ElapsedMs() / QUERY_COUNT;
+			double estimate = summary.Quantile(0.99);
+
+			printf("p99 temperature, %s (%.1f days):\n", rangeNames[r], (to - from) / (24.0 * 3600 * 1000000));
+			printf("  %-30s %12.3f ms %10u samples read   p99 %lld\n", "raw samples, exact", scanMs, (NvU32)samples.size(), (long long)exact);
+			printf("  %-30s %12.3f ms %10llu records read   p99 %.0f (%+.2f%%)\n", "rollups", summaryMs, read, estimate,
+				exact != 0 ? (estimate - exact) * 100.0 / exact : 0.0);
+			if (summary.count != samples.size() || summary.minimum != minimum || summary.maximum != maximum || summary.sum != sum)
+			{
+				printf("  rollups disagree: %llu samples, min %lld, max %lld, sum %lld against %u, %lld, %lld, %lld\n", summary.count,
+					(long long)summary.minimum, (long long)summary.maximum, (long long)summary.sum, (NvU32)samples.size(),
+					(long long)minimum, (long long)maximum, (long long)sum);
+				matched = false;
+			}
+		}
+
+		raw.Close();
+		rollups.Close();
+		DeleteStore(directory);
+		return matched ? NVAPI_OK : NVAPI_ERROR;
+	}
+
+	NvAPI_Status TelemetryExporterScrapes(NvU32 connections, NvU32 scrapesPerConnection, NvU32 simulatedGpus)
+	{
+		if (connections > TELEMETRY_EXPORTER_MAX_CONNECTIONS)
+			connections = TELEMETRY_EXPORTER_MAX_CONNECTIONS;
+
+		// Every metric ten times a second, so responses are re-rendered while they are being scraped
+		SimulatedTelemetrySource source(simulatedGpus);
+		TelemetrySampler sampler(source);
+		for (int metric = 0; metric < TELEMETRY_METRIC_COUNT; metric++)
+			sampler.ScheduleAll((TelemetryMetric)metric, 100);
+
+		TelemetryExporter exporter("127.0.0.1", 0);
+		TelemetryDrain drain(exporter);
+		sampler.Subscribe(&drain);
+		if (!exporter.Start(simulatedGpus))
+		{
+			printf("could not listen on the loopback interface\n");
+			return NVAPI_ERROR;
+		}
+		drain.Start();
+		sampler.Start();
+		Sleep(300);
+
+		WSADATA data;
+		WSAStartup(MAKEWORD(2, 2), &data);
+
+		struct Client
+		{
+			SOCKET socket;
+			bool connected;
+			NvU32 scrapes;
+			NvU64 requested;
+			char header[512];
+			NvU32 headerSize;
+			long long bodyRemaining;        // -1 until the header is complete
+		};
+
+		const char REQUEST[] = "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n";
+		std::vector<Client> clients(connections);
+		std::vector<WSAPOLLFD> polls(connections);
+		std::vector<NvU32> latencies;
+		latencies.reserve((size_t)connections * scrapesPerConnection);
+		std::vector<char> scratch(1 << 16);
+		unsigned long long failures = 0;
+		unsigned long long responseBytes = 0;
+
+		sockaddr_in endpoint;
+		memset(&endpoint, 0, sizeof(endpoint));
+		endpoint.sin_family = AF_INET;
+		endpoint.sin_port = htons(exporter.Port());
+		inet_pton(AF_INET, "127.0.0.1", &endpoint.sin_addr);
+
+		// Every connection opens at once and keeps one scrape in flight until it has done its share
+		Stopwatch running;
+		for (NvU32 i = 0; i < connections; i++)
+		{
+			Client &client = clients[i];
+			client.socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+			client.connected = false;
+			client.scrapes = 0;
+			client.headerSize = 0;
+			client.bodyRemaining = -1;
+
+			u_long nonBlocking = 1;
+			ioctlsocket(client.socket, FIONBIO, &nonBlocking);
+			if (connect(client.socket, (const sockaddr *)&endpoint, sizeof(endpoint)) != 0 && WSAGetLastError() != WSAEWOULDBLOCK)
+			{
+				closesocket(client.socket);
+				client.socket = INVALID_SOCKET;
+				failures++;
+			}
+		}
+
+		NvU32 open = connections - (NvU32)failures;
+		while (open > 0 && running.ElapsedMs() < 60000.0)
+		{
+			NvU32 count = 0;
+			for (NvU32 i = 0; i < connections; i++)
+			{
+				if (clients[i].socket == INVALID_SOCKET)
+					continue;
+				polls[count].fd = clients[i].socket;
+				polls[count].events = clients[i].connected ? POLLRDNORM : POLLWRNORM;
+				polls[count].revents = 0;
+				count++;
+			}
+			if (WSAPoll(&polls[0], count, 1000) <= 0)
+				continue;
+
+			for (NvU32 i = 0, k = 0; i < connections; i++)
+			{
+				Client &client = clients[i];
+				if (client.socket == INVALID_SOCKET)
+					continue;
+				short revents = polls[k++].revents;
+				if (revents == 0)
+					continue;
+
+				bool failed = (revents & (POLLERR | POLLHUP | POLLNVAL)) != 0 && (revents & POLLRDNORM) == 0;
+				bool finished = false;
+				if (!failed && !client.connected)
+				{
+					client.connected = true;
+					client.requested = TelemetryNow();
+					failed = send(client.socket, REQUEST, sizeof(REQUEST) - 1, 0) != (int)sizeof(REQUEST) - 1;
+				}
+				else if (!failed)
+				{
+					int received = recv(client.socket, &scratch[0], (int)scratch.size(), 0);
+					failed = received <= 0 && !(received == SOCKET_ERROR && WSAGetLastError() == WSAEWOULDBLOCK);
+					if (received > 0)
+					{
+						responseBytes += received;
+						long long body = received;
+						if (client.bodyRemaining < 0)
+						{
+							// Enough of the header to find Content-Length; the rest of what arrived is body
+							NvU32 copied = (NvU32)received < sizeof(client.header) - 1 - client.headerSize ? (NvU32)received : (NvU32)sizeof(client.header) - 1 - client.headerSize;
+							memcpy(client.header + client.headerSize, &scratch[0], copied);
+							client.headerSize += copied;
+							client.header[client.headerSize] = '\0';
+							const char *headerEnd = strstr(client.header, "\r\n\r\n");
+							const char *length = strstr(client.header, "Content-Length: ");
+							if (headerEnd != NULL && length != NULL && strncmp(client.header, "HTTP/1.1 200", 12) == 0)
+							{
+								NvU32 headerBytes = (NvU32)(headerEnd + 4 - client.header);
+								client.bodyRemaining = atoll(length + 16);
+								body = received - (long long)(headerBytes - (client.headerSize - copied));
+							}
+							else if (headerEnd != NULL || client.headerSize == sizeof(client.header) - 1)
+								failed = true;
+							else
+								body = 0;
+						}
+
+						if (!failed && client.bodyRemaining >= 0)
+						{
+							client.bodyRemaining -= body;
+							if (client.bodyRemaining < 0)
+								failed = true;
+							else if (client.bodyRemaining == 0)
+							{
+								latencies.push_back((NvU32)(TelemetryNow() - client.requested));
+								client.headerSize = 0;
+								client.bodyRemaining = -1;
+								if (++client.scrapes == scrapesPerConnection)
+									finished = true;
+								else
+								{
+									client.requested = TelemetryNow();
+									failed = send(client.socket, REQUEST, sizeof(REQUEST) - 1, 0) != (int)sizeof(REQUEST) - 1;
+								}
+							}
+						}
+					}
+				}
+
+				if (failed || finished)
+				{
+					failures += failed ? 1 : 0;
+					closesocket(client.socket);
+					client.socket = INVALID_SOCKET;
+					open--;
+				}
+			}
+		}
+		double runMs = running.ElapsedMs();
+
+		for (NvU32 i = 0; i < connections; i++)
+		{
+			if (clients[i].socket != INVALID_SOCKET)
+			{
+				closesocket(clients[i].socket);
+				failures++;
+			}
+		}
+		WSACleanup();
+
+		sampler.Stop();
+		drain.Stop();
+		exporter.Stop();
+
+		std::sort(latencies.begin(), latencies.end());
+		size_t scrapes = latencies.size();
+		const TelemetryExporterStats &stats = exporter.Stats();
+		printf("%u connections x %u scrapes, %u simulated GPUs, %llu bytes per response\n", connections, scrapesPerConnection,
+			simulatedGpus, scrapes ? responseBytes / scrapes : 0);
+		PrintResult("scrapes (wall clock)", (NvU32)scrapes, runMs);
+		printf("%-32s p50 %8.1f us   p99 %8.1f us   max %8.1f us\n", "scrape latency",
+			scrapes ? (double)latencies[scrapes / 2] : 0.0, scrapes ? (double)latencies[(size_t)((scrapes - 1) * 0.99)] : 0.0,
+			scrapes ? (double)latencies[scrapes - 1] : 0.0);
+		printf("%-32s %llu renders, %llu skipped while sending, %.1f us per render\n", "pre-rendering", stats.renders, stats.skippedRenders,
+			stats.renders ? (double)stats.renderMicroseconds / stats.renders : 0.0);
+		printf("%-32s %llu served, %llu needed more than one send, %llu connections\n", "server", stats.scrapes, stats.partialSends, stats.connections);
+		if (failures > 0)
+			printf("%llu connections failed\n", failures);
+		return failures == 0 && scrapes == (size_t)connections * scrapesPerConnection ? NVAPI_OK : NVAPI_ERROR;
+	}
+
+	NvAPI_Status AdaptiveSampling(NvU32 minutes, NvU32 simulatedGpus, const char *storeDirectory)
+	{
+		// A recorded store is compared at the fastest adaptive period, the simulation finer than any of them
+		SimulatedTelemetrySource source(simulatedGpus);
+		SimulatedTrace simulated(source);
+		RecordedTrace recorded;
+		std::vector<NvU32> readings;
+		NvU64 duration = (NvU64)minutes * 60 * 1000000;
+		NvU64 step = 50000;
+		const TraceSignal *trace = &simulated;
+		if (storeDirectory != NULL)
+		{
+			if (!recorded.Load(storeDirectory))
+			{
+				printf("No telemetry recorded in %s\n", storeDirectory);
+				return NVAPI_ERROR;
+			}
+			recorded.Readings(readings);
+			duration = recorded.Duration();
+			step = 250000;
+			trace = &recorded;
+			printf("%.1f minutes recorded in %s\n", duration / 60000000.0, storeDirectory);
+		}
+		else
+		{
+			for (NvU32 gpu = 0; gpu < simulatedGpus; gpu++)
+			{
+				for (int metric = 0; metric < TELEMETRY_METRIC_COUNT; metric++)
+					readings.push_back(gpu << 8 | metric);
+			}
+			printf("%u minutes of %u simulated GPUs\n", minutes, simulatedGpus);
+		}
+
+		printf("%-14s %-16s %10s %12s %12s\n", "metric", "sampling", "reads", "mean error", "max error");
+		for (int metric = 0; metric < TELEMETRY_METRIC_COUNT; metric++)
+		{
+			if (!IsTelemetryAdaptive((TelemetryMetric)metric))
+				continue;
+
+			TelemetryAdaptiveConfig config = DefaultTelemetryAdaptiveConfig((TelemetryMetric)metric);
+			NvU32 fixedMs = DefaultTelemetryPeriodMs((TelemetryMetric)metric);
+			SamplingOutcome outcomes[3];
+			memset(outcomes, 0, sizeof(outcomes));
+			for (size_t i = 0; i < readings.size(); i++)
+			{
+				if ((int)(readings[i] & 0xFF) != metric)
+					continue;
+
+				NvU32 gpu = readings[i] >> 8;
+				ReplaySampling(*trace, gpu, (TelemetryMetric)metric, duration, step, fixedMs, NULL, outcomes[0]);
+				ReplaySampling(*trace, gpu, (TelemetryMetric)metric, duration, step, config.minPeriodMs, NULL, outcomes[1]);
+				ReplaySampling(*trace, gpu, (TelemetryMetric)metric, duration, step, 0, &config, outcomes[2]);
+			}
+			if (outcomes[0].reads == 0)
+				continue;
+
+			char names[3][32];
+			snprintf(names[0], sizeof(names[0]), "fixed %u ms", fixedMs);
+			snprintf(names[1], sizeof(names[1]), "fixed %u ms", config.minPeriodMs);
+			snprintf(names[2], sizeof(names[2]), "adaptive");
+			for (int i = 0; i < 3; i++)
+			{
+				printf("%-14s %-16s %10llu %12.2f %12.0f\n", i == 0 ? TelemetryMetricName((TelemetryMetric)metric) : "", names[i],
+					outcomes[i].reads, outcomes[i].points ? outcomes[i].totalError / outcomes[i].points : 0.0, outcomes[i].maxError);
+			}
+			printf("%-14s %-16s %9.1f%% of the driver calls of every %u ms, %.1f%% of every %u ms\n", "", "",
+				outcomes[2].reads * 100.0 / outcomes[0].reads, fixedMs,
+				outcomes[2].reads * 100.0 / outcomes[1].reads, config.minPeriodMs);
+		}
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status TelemetryAlerts(NvU32 seriesCount, NvU32 ticks)
+	{
+		// Two temperature sensors, a fan and four clock domains per simulated GPU
+		const NvU32 SERIES_PER_GPU = 7;
+		const NvU32 TICK_MS = 100;
+		const char *ruleTexts[] = { "temperature > 80 for 10s", "temperature rises 10 in 5s", "tach falls 40% in 5s", "clocks < 400000 for 5s" };
+		const TelemetryMetric readMetrics[] = { TELEMETRY_TEMPERATURE, TELEMETRY_TACH, TELEMETRY_CLOCKS };
+		NvU32 gpus = (seriesCount + SERIES_PER_GPU - 1) / SERIES_PER_GPU;
+		SimulatedTelemetrySource source(gpus);
+
+		printf("%u series on %u simulated GPUs, %u ticks of %u ms\n", gpus * SERIES_PER_GPU, gpus, ticks, TICK_MS);
+		for (size_t i = 0; i < sizeof(ruleTexts) / sizeof(ruleTexts[0]); i++)
+			printf("  %s\n", ruleTexts[i]);
+
+		NvU64 digests[2] = { 0, 0 };
+		unsigned long long events[2] = { 0, 0 };
+		double evaluateMs[2] = { 0.0, 0.0 };
+		for (int pass = 0; pass < 2; pass++)
+		{
+			TelemetryAlertEngine engine(TICK_MS);
+			AlertDigest digest;
+			engine.Subscribe(&digest);
+			engine.SetVectorised(pass == 0);
+			for (size_t i = 0; i < sizeof(ruleTexts) / sizeof(ruleTexts[0]); i++)
+			{
+				TelemetryAlertRule rule;
+				ParseTelemetryAlertRule(ruleTexts[i], rule);
+				engine.AddRule(rule);
+			}
+
+			std::vector<TelemetrySample> batch;
+			double updateMs = 0.0;
+			double maxEvaluateMs = 0.0;
+			for (NvU32 tick = 1; tick <= ticks; tick++)
+			{
+				NvU64 time = (NvU64)tick * TICK_MS * 1000;
+				batch.clear();
+				for (NvU32 gpu = 0; gpu < gpus; gpu++)
+				{
+					for (size_t m = 0; m < sizeof(readMetrics) / sizeof(readMetrics[0]); m++)
+					{
+						TelemetrySample samples[TELEMETRY_MAX_CHANNELS];
+						NvU32 count = 0;
+						source.ReadAt(gpu, readMetrics[m], time, samples, &count);
+						for (NvU32 i = 0; i < count; i++)
+						{
+							samples[i].timestamp = time;
+							samples[i].gpu = (NvU16)gpu;
+							samples[i].metric = (NvU8)readMetrics[m];
+							batch.push_back(samples[i]);
+						}
+					}
+				}
+
+				Stopwatch update;
+				engine.Update(&batch[0], (NvU32)batch.size());
+				updateMs += update.ElapsedMs();
+
+				Stopwatch evaluate;
+				engine.Evaluate(time);
+				double elapsedMs = evaluate.ElapsedMs();
+				evaluateMs[pass] += elapsedMs;
+				maxEvaluateMs = elapsedMs > maxEvaluateMs ? elapsedMs : maxEvaluateMs;
+			}
+
+			digests[pass] = digest.Digest();
+			events[pass] = engine.RaisedCount() + engine.ClearedCount();
+			printf("%-10s %u lanes: evaluate %.2f us/tick (max %.1f us, %.1f ns/lane), update %.2f us/tick; %llu raised, %llu cleared\n",
+				pass == 0 ? "SSE2" : "scalar", engine.LaneCount(), evaluateMs[pass] * 1000.0 / ticks, maxEvaluateMs * 1000.0,
+				evaluateMs[pass] * 1000000.0 / ticks / (engine.LaneCount() ? engine.LaneCount() : 1), updateMs * 1000.0 / ticks,
+				engine.RaisedCount(), engine.ClearedCount());
+		}
+
+		bool same = digests[0] == digests[1] && events[0] == events[1];
+		printf("SSE2 evaluation %.1fx the scalar loop, %s events\n", evaluateMs[0] > 0.0 ? evaluateMs[1] / evaluateMs[0] : 0.0,
+			same ? "same" : "DIFFERENT");
+		return same ? NVAPI_OK : NVAPI_ERROR;
+	}
+
+	NvAPI_Status NvApiCallOverhead(NvU32 calls, NvU32 threadCount)
+	{
+		// The cheapest NVAPI call there is, so the instrumentation is as large a share of it as it can be
+		unsigned long long before = NvApiCallCount(NVAPI_CALL_GET_ERROR_MESSAGE);
+		NvAPI_ShortString text;
+		Stopwatch direct;
+		for (NvU32 i = 0; i < calls; i++)
+			NvAPI_GetErrorMessage(NVAPI_ERROR, text);
+		double directMs = direct.ElapsedMs();
+		PrintResult("NvAPI_GetErrorMessage", calls, directMs);
+
+		Stopwatch instrumented;
+		CallErrorMessage(calls);
+		double instrumentedMs = instrumented.ElapsedMs();
+		PrintResult("NvApiCall(NvAPI_GetErrorMessage)", calls, instrumentedMs);
+
+		// Every thread counts into its own table, so more threads cost no more per call
+		std::vector<std::thread> threads;
+		Stopwatch threaded;
+		for (NvU32 i = 0; i < threadCount; i++)
+			threads.push_back(std::thread(CallErrorMessage, calls));
+		for (size_t i = 0; i < threads.size(); i++)
+			threads[i].join();
+		double threadedMs = threaded.ElapsedMs();
+
+		char name[64];
+		snprintf(name, sizeof(name), "... on %u threads", threadCount);
+		PrintResult(name, calls * threadCount, threadedMs);
+		printf("Instrumentation: %.1f ns per call\n\n", (instrumentedMs - directMs) * 1000000.0 / (calls ? calls : 1));
+
+		unsigned long long counted = NvApiCallCount(NVAPI_CALL_GET_ERROR_MESSAGE) - before;
+		PrintNvApiStats();
+		return counted == (unsigned long long)calls * (threadCount + 1) ? NVAPI_OK : NVAPI_ERROR;
+	}
+
+	NvAPI_Status UtilizationHistograms(NvU32 hours, NvU32 simulatedGpus)
+	{
+		const NvU32 WINDOW_SECONDS[] = { 1, 60 };
+		const NvU32 WINDOW_LENGTHS = sizeof(WINDOW_SECONDS) / sizeof(WINDOW_SECONDS[0]);
+		NvU64 seconds = (NvU64)hours * 3600;
+
+		SimulatedTelemetrySource source(simulatedGpus);
+		UtilizationReports reports[WINDOW_LENGTHS];
+		TelemetryUtilizationHistograms perSecond(WINDOW_SECONDS[0]);
+		TelemetryUtilizationHistograms perMinute(WINDOW_SECONDS[1]);
+		TelemetryUtilizationHistograms *histograms[WINDOW_LENGTHS] = { &perSecond, &perMinute };
+		for (NvU32 w = 0; w < WINDOW_LENGTHS; w++)
+			histograms[w]->Subscribe(&reports[w]);
+		TelemetryRollupEngine rollups;
+
+		// Every domain of every GPU once a second, as --monitor utilization reads them
+		unsigned long long sampleCount = 0;
+		double histogramMs[WINDOW_LENGTHS] = { 0.0 };
+		double rollupMs = 0.0;
+		std::vector<TelemetrySample> batch;
+		TelemetrySample samples[TELEMETRY_MAX_CHANNELS];
+		for (NvU64 second = 0; second < seconds; second++)
+		{
+			batch.clear();
+			for (NvU32 gpu = 0; gpu < simulatedGpus; gpu++)
+			{
+				NvU32 count = 0;
+				source.ReadAt(gpu, TELEMETRY_UTILIZATION, second * 1000000, samples, &count);
+				for (NvU32 i = 0; i < count; i++)
+				{
+					samples[i].timestamp = HISTORY_START + second * 1000000 + 50 + gpu * 20;
+					samples[i].gpu = (NvU16)gpu;
+					samples[i].metric = TELEMETRY_UTILIZATION;
+					samples[i].tick = 0;
+					samples[i].reserved[0] = 0;
+					samples[i].reserved[1] = 0;
+					batch.push_back(samples[i]);
+				}
+			}
+			sampleCount += batch.size();
+
+			for (NvU32 w = 0; w < WINDOW_LENGTHS; w++)
+			{
+				Stopwatch adding;
+				histograms[w]->Append(&batch[0], (NvU32)batch.size());
+				histogramMs[w] += adding.ElapsedMs();
+			}
+
+			Stopwatch rolling;
+			rollups.Append(&batch[0], (NvU32)batch.size());
+			rollupMs += rolling.ElapsedMs();
+		}
+		for (NvU32 w = 0; w < WINDOW_LENGTHS; w++)
+			histograms[w]->Flush();
+		rollups.Flush();
+
+		printf("%u hours, %u simulated GPUs at 1 Hz: %llu utilization samples\n", hours, simulatedGpus, sampleCount);
+		printf("%-32s %8.1f ns/sample\n", "DDSketch rollups (1 s, 1 m, 1 h)", sampleCount ? rollupMs * 1000000.0 / sampleCount : 0.0);
+
+		bool matched = true;
+		for (NvU32 w = 0; w < WINDOW_LENGTHS; w++)
+		{
+			// Histograms and encoding together, against one second of every GPU
+			UtilizationReports &report = reports[w];
+			double perSecondUs = seconds ? (histogramMs[w] + report.encodeMs) * 1000.0 / seconds : 0.0;
+			char name[48];
+			snprintf(name, sizeof(name), "histograms, %u s windows", WINDOW_SECONDS[w]);
+			printf("%-32s %8.1f ns/sample, %6.2f us to encode a report, %7.1f bytes/report, %6.1f bytes/s, %5.2f us CPU/s\n", name,
+				sampleCount ? histogramMs[w] * 1000000.0 / sampleCount : 0.0, report.reports ? report.encodeMs * 1000.0 / report.reports : 0.0,
+				report.reports ? (double)report.bytes.size() / report.reports : 0.0, seconds ? (double)report.bytes.size() / seconds : 0.0, perSecondUs);
+
+			// Every report decodes, every sample is accounted for and every mean is within the half percent encoded
+			const NvU8 *data = report.bytes.empty() ? NULL : &report.bytes[0];
+			const NvU8 *end = data + report.bytes.size();
+			std::vector<TelemetryUtilizationSummary> summaries;
+			unsigned long long decodedSamples = 0;
+			size_t mean = 0;
+			while (data < end && matched)
+			{
+				NvU64 windowStart, windowMicroseconds;
+				if (!DecodeTelemetryUtilization(data, end, windowStart, windowMicroseconds, summaries))
+				{
+					matched = false;
+					break;
+				}
+
+				for (size_t i = 0; i < summaries.size(); i++, mean++)
+				{
+					float bands = 0.0f;
+					for (NvU32 b = 0; b < TELEMETRY_UTILIZATION_BANDS; b++)
+						bands += summaries[i].bands[b];
+					decodedSamples += summaries[i].count;
+					if (mean >= report.means.size() || summaries[i].mean - report.means[mean] > 0.25 || report.means[mean] - summaries[i].mean > 0.25 ||
+						bands < 0.999f || bands > 1.001f)
+					{
+						matched = false;
+					}
+				}
+			}
+			matched = matched && decodedSamples == sampleCount && mean == report.means.size();
+		}
+
+		printf("%-32s %8.1f bytes/s\n", "raw samples", seconds ? (double)sampleCount * sizeof(TelemetrySample) / seconds : 0.0);
+		printf("Decoded reports %s the histograms\n", matched ? "match" : "DO NOT match");
+		return matched ? NVAPI_OK : NVAPI_ERROR;
+	}
+
+	NvAPI_Status ThrottleEvents(NvU32 hours, NvU32 simulatedGpus)
+	{
+		NvU64 seconds = (NvU64)hours * 3600;
+		FILE *edgeFile = OpenTemporaryFile();
+		FILE *deltaFile = OpenTemporaryFile();
+		if (edgeFile == NULL || deltaFile == NULL)
+		{
+			if (edgeFile != NULL)
+				fclose(edgeFile);
+			if (deltaFile != NULL)
+				fclose(deltaFile);
+			return NVAPI_ERROR;
+		}
+
+		// Every GPU once a second, as --monitor throttle reads it; the masks are kept to check the replay against
+		SimulatedTelemetrySource source(simulatedGpus);
+		TelemetryThrottleTracker tracker;
+		std::vector<NvU32> masks;
+		masks.reserve((size_t)(seconds * simulatedGpus));
+		std::vector<TelemetrySample> batch;
+		unsigned long long edgeBytes = 0;
+		unsigned long long deltaBytes = 0;
+		double trackerMs = 0.0;
+		double deltaMs = 0.0;
+		{
+			BufferedWriter edgeWriter(edgeFile);
+			TelemetryThrottleWriter edges(edgeWriter);
+			tracker.Subscribe(&edges);
+			BufferedWriter deltaWriter(deltaFile);
+			TelemetryDeltaWriter deltas(deltaWriter);
+
+			for (NvU64 second = 0; second < seconds; second++)
+			{
+				batch.clear();
+				for (NvU32 gpu = 0; gpu < simulatedGpus; gpu++)
+				{
+					TelemetrySample sample;
+					NvU32 count = 0;
+					source.ReadAt(gpu, TELEMETRY_THROTTLE, second * 1000000, &sample, &count);
+					sample.timestamp = HISTORY_START + second * 1000000 + 50 + gpu * 20;
+					sample.gpu = (NvU16)gpu;
+					sample.metric = TELEMETRY_THROTTLE;
+					sample.tick = 0;
+					sample.reserved[0] = 0;
+					sample.reserved[1] = 0;
+					batch.push_back(sample);
+					masks.push_back((NvU32)sample.value);
+				}
+
+				Stopwatch tracking;
+				tracker.OnSamples(&batch[0], (NvU32)batch.size());
+				trackerMs += tracking.ElapsedMs();
+
+				Stopwatch delta;
+				deltas.OnSamples(&batch[0], (NvU32)batch.size());
+				deltaMs += delta.ElapsedMs();
+			}
+
+			edgeWriter.Flush();
+			deltaWriter.Flush();
+			edgeBytes = edgeWriter.BytesWritten();
+			deltaBytes = deltaWriter.BytesWritten();
+		}
+		fclose(deltaFile);
+
+		unsigned long long reads = tracker.ReadCount();
+		printf("%u hours, %u simulated GPUs at 1 Hz: %llu throttle reads, %llu edges\n", hours, simulatedGpus, reads, tracker.EventCount());
+		printf("%-32s %16s %12llu bytes %8.3f bytes/read\n", "raw sample records", "", reads * sizeof(TelemetrySample),
+			(double)sizeof(TelemetrySample));
+		printf("%-32s %8.1f ns/read %12llu bytes %8.3f bytes/read\n", "delta capture of every read", reads ? deltaMs * 1000000.0 / reads : 0.0,
+			deltaBytes, reads ? (double)deltaBytes / reads : 0.0);
+		printf("%-32s %8.1f ns/read %12llu bytes %8.3f bytes/read\n", "edge tracker and log", reads ? trackerMs * 1000000.0 / reads : 0.0,
+			edgeBytes, reads ? (double)edgeBytes / reads : 0.0);
+
+		// The log decodes to edges that, replayed from nothing, give back the mask of every read
+		std::vector<NvU8> data((size_t)edgeBytes);
+		rewind(edgeFile);
+		bool matched = !data.empty() && fread(&data[0], 1, data.size(), edgeFile) == data.size();
+		fclose(edgeFile);
+		std::vector<TelemetryThrottleEvent> events;
+		matched = matched && DecodeTelemetryThrottleEvents(&data[0], data.size(), events) && events.size() == tracker.EventCount();
+
+		std::vector<NvU32> replayed(simulatedGpus, 0);
+		std::vector<NvU64> setReads(simulatedGpus * TELEMETRY_THROTTLE_REASONS, 0);
+		size_t next = 0;
+		for (NvU64 second = 0; second < seconds && matched; second++)
+		{
+			for (NvU32 gpu = 0; gpu < simulatedGpus; gpu++)
+			{
+				NvU64 timestamp = HISTORY_START + second * 1000000 + 50 + gpu * 20;
+				for (; next < events.size() && events[next].timestamp == timestamp && events[next].gpu == gpu; next++)
+				{
+					NvU32 bit = 1u << events[next].reason;
+					replayed[gpu] = events[next].set ? replayed[gpu] | bit : replayed[gpu] & ~bit;
+					matched = matched && events[next].window == (second == 0 ? 0 : 1000000);
+				}
+				NvU32 mask = masks[(size_t)(second * simulatedGpus + gpu)];
+				matched = matched && replayed[gpu] == mask;
+
+				// A reason holds from the read that saw it set to the next read
+				for (NvU32 reason = 0; reason < TELEMETRY_THROTTLE_REASONS && second + 1 < seconds; reason++)
+					setReads[gpu * TELEMETRY_THROTTLE_REASONS + reason] += mask >> reason & 1;
+			}
+		}
+		matched = matched && next == events.size();
+
+		// Attribution across GPUs, checked against counting the reads
+		NvU64 observed = 0;
+		for (NvU32 gpu = 0; gpu < tracker.GpuCount(); gpu++)
+			observed += tracker.ObservedMicroseconds(gpu);
+		for (NvU32 reason = 0; reason < TELEMETRY_THROTTLE_REASONS; reason++)
+		{
+			NvU64 throttled = 0;
+			unsigned long long episodes = 0;
+			for (NvU32 gpu = 0; gpu < tracker.GpuCount(); gpu++)
+			{
+				throttled += tracker.ThrottledMicroseconds(gpu, reason);
+				episodes += tracker.Episodes(gpu, reason);
+				matched = matched && tracker.ThrottledMicroseconds(gpu, reason) == setReads[gpu * TELEMETRY_THROTTLE_REASONS + reason] * 1000000;
+			}
+			if (episodes == 0)
+				continue;
+
+			printf("%-18s %10.1f GPU-hours in %8llu episodes, %5.1f%% of observed time\n", TelemetryThrottleReasonName(reason),
+				throttled / 3600000000.0, episodes, observed ? throttled * 100.0 / observed : 0.0);
+		}
+
+		printf("Replayed edges %s every read\n", matched ? "match" : "DO NOT match");
+		return matched ? NVAPI_OK : NVAPI_ERROR;
+	}
+
+	NvAPI_Status EccMonitoring(NvU32 hours, NvU32 simulatedGpus)
+	{
+		const NvU32 FIXED_PERIODS_MS[] = { 1000, 10000, 64000 };
+		const NvU32 FIXED_PERIODS = sizeof(FIXED_PERIODS_MS) / sizeof(FIXED_PERIODS_MS[0]);
+		NvU64 duration = (NvU64)hours * 3600 * 1000000;
+		SimulatedTelemetrySource source(simulatedGpus);
+		TelemetryAdaptiveConfig config = DefaultTelemetryAdaptiveConfig(TELEMETRY_ECC);
+
+		printf("%u hours of %u simulated GPUs, ECC counters\n", hours, simulatedGpus);
+		printf("%-16s %10s %12s %8s %12s %12s %10s\n", "sampling", "reads", "reads/GPU/h", "changes", "mean delay", "max delay", "monitor");
+
+		bool matched = true;
+		EccOutcome outcomes[FIXED_PERIODS + 1];
+		for (NvU32 i = 0; i <= FIXED_PERIODS; i++)
+		{
+			bool adaptive = i == FIXED_PERIODS;
+			EccOutcome &outcome = outcomes[i];
+			ReplayEcc(source, duration, adaptive ? 0 : FIXED_PERIODS_MS[i], adaptive ? &config : NULL, outcome);
+			matched = matched && outcome.matched;
+
+			char name[32];
+			if (adaptive)
+				snprintf(name, sizeof(name), "adaptive");
+			else
+				snprintf(name, sizeof(name), "fixed %u ms", FIXED_PERIODS_MS[i]);
+			printf("%-16s %10llu %12.1f %8llu %10.2f s %10.2f s %7.1f ns\n", name, outcome.reads,
+				hours && simulatedGpus ? (double)outcome.reads / hours / simulatedGpus : 0.0, outcome.changes,
+				outcome.delayed ? outcome.totalDelayMs / outcome.delayed / 1000.0 : 0.0, outcome.maxDelayMs / 1000.0,
+				outcome.reads ? outcome.monitorMs * 1000000.0 / outcome.reads : 0.0);
+		}
+
+		const EccOutcome &adaptive = outcomes[FIXED_PERIODS];
+		printf("Adaptive: %.1f%% of the driver calls of every %u ms, %.1f%% of every %u ms\n",
+			outcomes[0].reads ? adaptive.reads * 100.0 / outcomes[0].reads : 0.0, FIXED_PERIODS_MS[0],
+			outcomes[1].reads ? adaptive.reads * 100.0 / outcomes[1].reads : 0.0, FIXED_PERIODS_MS[1]);
+		printf("Reported errors %s the counters\n", matched ? "add up to" : "DO NOT add up to");
+		return matched ? NVAPI_OK : NVAPI_ERROR;
+	}
+
+	NvAPI_Status TelemetryTraceReplay(NvU32 minutes, NvU32 simulatedGpus)
+	{
+		NvU64 steps = (NvU64)minutes * 60 * 1000000 / HISTORY_STEP_MICROSECONDS;
+		FILE *traceFile = OpenTemporaryFile();
+		FILE *deltaFile = OpenTemporaryFile();
+		if (traceFile == NULL || deltaFile == NULL)
+		{
+			if (traceFile != NULL)
+				fclose(traceFile);
+			if (deltaFile != NULL)
+				fclose(deltaFile);
+			return NVAPI_ERROR;
+		}
+
+		// Every metric at its default period, one sampler tick per step; what was read is kept to check the trace against
+		SimulatedTelemetrySource source(simulatedGpus);
+		std::vector<TelemetrySample> recorded;
+		std::vector<TelemetrySample> batch;
+		unsigned long long traceBytes = 0;
+		unsigned long long deltaBytes = 0;
+		double traceMs = 0.0;
+		{
+			BufferedWriter traceWriter(traceFile);
+			TelemetryTraceWriter trace(traceWriter);
+			BufferedWriter deltaWriter(deltaFile);
+			TelemetryDeltaWriter deltas(deltaWriter);
+			for (NvU64 step = 0; step < steps; step++)
+			{
+				ReadHistoryStep(source, simulatedGpus, step, batch);
+				for (size_t i = 0; i < batch.size(); i++)
+					batch[i].tick = (NvU32)step;
+				if (batch.empty())
+					continue;
+
+				Stopwatch tracing;
+				trace.OnSamples(&batch[0], (NvU32)batch.size());
+				traceMs += tracing.ElapsedMs();
+				deltas.OnSamples(&batch[0], (NvU32)batch.size());
+				recorded.insert(recorded.end(), batch.begin(), batch.end());
+			}
+
+			traceWriter.Flush();
+			deltaWriter.Flush();
+			traceBytes = traceWriter.BytesWritten();
+			deltaBytes = deltaWriter.BytesWritten();
+		}
+		fclose(deltaFile);
+
+		unsigned long long samples = recorded.size();
+		printf("%u minutes of %u simulated GPUs, every metric at its default period: %llu samples\n", minutes, simulatedGpus, samples);
+		printf("%-28s %16s %12llu bytes %8.3f bytes/sample\n", "raw sample records", "", samples * sizeof(TelemetrySample),
+			(double)sizeof(TelemetrySample));
+		printf("%-28s %16s %12llu bytes %8.3f bytes/sample, changes only\n", "delta capture", "", deltaBytes,
+			samples ? (double)deltaBytes / samples : 0.0);
+		printf("%-28s %8.1f ns/sample %12llu bytes %8.3f bytes/sample\n", "trace", samples ? traceMs * 1000000.0 / samples : 0.0,
+			traceBytes, samples ? (double)traceBytes / samples : 0.0);
+
+		// The trace reads back to exactly what was recorded, tick by tick
+		std::vector<NvU8> data((size_t)traceBytes);
+		rewind(traceFile);
+		bool matched = !data.empty() && fread(&data[0], 1, data.size(), traceFile) == data.size();
+		fclose(traceFile);
+		TelemetryTraceReader reader;
+		matched = matched && reader.Open(&data[0], data.size()) && reader.SampleCount() == samples && reader.SkippedCount() == 0 &&
+			reader.GpuCount() == simulatedGpus;
+
+		size_t next = 0;
+		while (matched && reader.Next(batch))
+		{
+			for (size_t i = 0; i < batch.size() && matched; i++, next++)
+			{
+				const TelemetrySample &read = batch[i];
+				const TelemetrySample &expected = recorded[next];
+				matched = next < recorded.size() && read.timestamp == expected.timestamp && read.value == expected.value &&
+					read.gpu == expected.gpu && read.metric == expected.metric && read.channel == expected.channel &&
+					read.tick == expected.tick && read.tick == batch[0].tick;
+			}
+		}
+		matched = matched && next == recorded.size();
+		printf("Trace %s the samples read\n", matched ? "replays exactly" : "DOES NOT replay");
+		if (!matched)
+			return NVAPI_ERROR;
+
+		// As fast as possible through each consumer of --monitor on its own, after the decoding alone
+		TelemetryDeltaFilter filter;
+		TelemetryAlertEngine alerts;
+		TelemetryAlertRule rule;
+		ParseTelemetryAlertRule("temperature > 80 for 10s", rule);
+		alerts.AddRule(rule);
+		TelemetryUtilizationHistograms histograms;
+		TelemetryThrottleTracker throttle;
+		TelemetryEccMonitor ecc;
+		TelemetryRollupEngine rollups;
+
+		const char *names[] = { "decode only", "delta filter", "alert engine", "utilization histograms", "throttle tracker",
+			"ECC monitor", "rollups" };
+		TelemetrySubscriber *stages[] = { NULL, &filter, &alerts, &histograms, &throttle, &ecc, &rollups };
+		printf("%-28s %12s %16s\n", "replayed through", "ns/sample", "samples/s");
+		for (size_t i = 0; i < sizeof(stages) / sizeof(stages[0]); i++)
+		{
+			ControlPanel::TelemetryTraceReplay replay(reader);
+			if (stages[i] != NULL)
+				replay.Subscribe(stages[i]);
+			replay.Run(0.0);
+
+			const TelemetryReplayStats &stats = replay.Stats();
+			matched = matched && stats.samples == samples;
+			printf("%-28s %12.1f %16.0f\n", names[i], stats.samples ? stats.elapsedMicroseconds * 1000.0 / stats.samples : 0.0,
+				stats.elapsedMicroseconds ? stats.samples * 1000000.0 / stats.elapsedMicroseconds : 0.0);
+		}
+		rollups.Flush();
+		printf("%llu changes, %llu alerts raised, %llu throttle edges, %llu ECC events, %llu one-minute rollups\n", filter.ChangedCount(),
+			alerts.RaisedCount(), throttle.EventCount(), ecc.EventCount(), rollups.WindowCount(TELEMETRY_ROLLUP_1M));
+		return matched ? NVAPI_OK : NVAPI_ERROR;
+	}
+};
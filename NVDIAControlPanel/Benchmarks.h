@@ -0,0 +1,80 @@
+#pragma once
+
+#include "nvapi.h"
+
+namespace Benchmarks
+{
+	// Compares one session per setting change against one batched DrsSession commit
+	NvAPI_Status DrsSessionCommit(NvU32 changeCount);
+
+	// Times a snapshot load, then "who overrides VSYNCMODE" answered in memory and by driver calls
+	NvAPI_Status DrsSnapshotQuery(NvU32 queryCount);
+
+	// Full profile dump through the scratch arena into compact records, reporting peak RSS
+	NvAPI_Status DrsDumpMemory();
+
+	// Setting ID/name resolution and value validation: constexpr registry against driver round-trips
+	NvAPI_Status SettingRegistryLookup(NvU32 queryCount);
+
+	// Startup to first answer: LoadSettings and a snapshot against opening the mapped cache file
+	NvAPI_Status DrsCacheStartup(const char *cachePath);
+
+	// Paths/second of the bulk application resolver against one NvAPI_DRS_FindApplicationByName per path
+	NvAPI_Status AppResolverThroughput(NvU32 pathCount);
+
+	// Creates profileCount profiles from a generated manifest in one session, replans it, then deletes them
+	NvAPI_Status ProfileProvisioning(NvU32 profileCount);
+
+	// CPU time and driver reads of the old busy-wait monitor loops against the timer-wheel sampler,
+	// on the real GPUs or on simulatedGpus synthetic ones
+	NvAPI_Status TelemetrySampling(NvU32 seconds, NvU32 simulatedGpus);
+
+	// Samples/second through the SPSC ring, the MPSC ring with producerCount threads, and drops when publishing never waits
+	NvAPI_Status TelemetryRingThroughput(NvU32 sampleCount, NvU32 producerCount);
+
+	// Size of a clock capture on simulated GPUs as console text, raw records and delta encoding, and its decode rate
+	NvAPI_Status ClockDeltaCapture(NvU32 seconds, NvU32 simulatedGpus);
+
+	// Frame latency and cross-GPU skew of the per-GPU workers at 1, 10 and 100 Hz on 1 to maxGpus simulated GPUs,
+	// against the single-thread sampler reading the same GPUs one after another
+	NvAPI_Status TelemetryFrameLatency(NvU32 seconds, NvU32 maxGpus, bool pin);
+
+	// Writes days of synthetic history for simulatedGpus GPUs into a segment store, then reports bytes/sample
+	// against text logs and raw records, and the rate of range queries and full scans through the mapped segments
+	NvAPI_Status TelemetryStoreHistory(NvU32 days, NvU32 simulatedGpus);
+
+	// Writes days of synthetic history with its 1 m and 1 h rollups, then answers p99 temperature over the whole
+	// history and over an unaligned range from the rollups, against an exact pass over the raw samples
+	NvAPI_Status TelemetryRollups(NvU32 days, NvU32 simulatedGpus);
+
+	// Scrape latency of the OpenMetrics exporter with connections concurrent keep-alive clients on the loopback
+	// interface, while the responses are re-rendered ten times a second
+	NvAPI_Status TelemetryExporterScrapes(NvU32 connections, NvU32 scrapesPerConnection, NvU32 simulatedGpus);
+
+	// Driver calls and hold error of adaptive sampling against fixed periods, replayed on minutes of simulated GPUs
+	// or, when storeDirectory is not NULL, on a store recorded with --monitor --record
+	NvAPI_Status AdaptiveSampling(NvU32 minutes, NvU32 simulatedGpus, const char *storeDirectory);
+
+	// Per-tick cost of the alert rules over seriesCount simulated series, SSE2 against the scalar loop,
+	// checking both raise and clear the same alerts
+	NvAPI_Status TelemetryAlerts(NvU32 seriesCount, NvU32 ticks);
+
+	// Cost of counting and timing an NVAPI call, on one thread and on threadCount at once, then the --stats report
+	NvAPI_Status NvApiCallOverhead(NvU32 calls, NvU32 threadCount);
+
+	// Cost per sample and report size of the utilization histograms in 1 s and 60 s windows over hours of
+	// simulated GPUs at 1 Hz, against the DDSketch rollups, checking every report decodes to the histograms
+	NvAPI_Status UtilizationHistograms(NvU32 hours, NvU32 simulatedGpus);
+
+	// Throttle reasons of simulated GPUs read at 1 Hz for hours: cost per read of the edge tracker and size of its log
+	// against raw and delta-coded bitmasks, checking the decoded edges replay to every read and add up to the attribution
+	NvAPI_Status ThrottleEvents(NvU32 hours, NvU32 simulatedGpus);
+
+	// Driver reads and detection delay of the ECC monitor over hours of simulated GPUs, reading adaptively against
+	// fixed periods, checking the errors it reports add up to what the counters gained
+	NvAPI_Status EccMonitoring(NvU32 hours, NvU32 simulatedGpus);
+
+	// Size per sample of a trace of every metric of simulated GPUs against raw records and a delta capture, checking it
+	// reads back exactly, then the cost per sample of replaying it as fast as possible through each --monitor consumer
+	NvAPI_Status TelemetryTraceReplay(NvU32 minutes, NvU32 simulatedGpus);
+};
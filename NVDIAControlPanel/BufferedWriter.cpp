@@ -0,0 +1,216 @@
+#include "targetver.h"
+#include "BufferedWriter.h"
+
+#include <share.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace ControlPanel
+{
+	FILE *OpenFile(const char *path, const char *mode)
+	{
+		return _fsopen(path, mode, _SH_DENYWR);
+	}
+
+	FILE *OpenTemporaryFile()
+	{
+		FILE *file = NULL;
+		return tmpfile_s(&file) == 0 ? file : NULL;
+	}
+
+	BufferedWriter::BufferedWriter(FILE *file, size_t capacity)
+		: file(file)
+		, buffer((char *)malloc(capacity))
+		, capacity(buffer ? capacity : 0)
+		, used(0)
+		, written(0)
+		, failed(buffer == NULL)
+	{
+	}
+
+	BufferedWriter::~BufferedWriter()
+	{
+		Flush();
+		free(buffer);
+	}
+
+	bool BufferedWriter::Flush()
+	{
+		if (used > 0 && !failed && fwrite(buffer, 1, used, file) != used)
+			failed = true;
+		if (!failed && fflush(file) != 0)
+			failed = true;
+
+		// Only what reached the file counts
+		if (!failed)
+			written += used;
+		used = 0;
+
+		return !failed;
+	}
+
+	void BufferedWriter::Write(const void *data, size_t size)
+	{
+		if (failed)
+			return;
+
+		if (used + size > capacity)
+		{
+			if (!Flush())
+				return;
+
+			// Large blocks go straight to the stream
+			if (size >= capacity)
+			{
+				if (fwrite(data, 1, size, file) != size)
+					failed = true;
+				else
+					written += size;
+				return;
+			}
+		}
+
+		memcpy(buffer + used, data, size);
+		used += size;
+	}
+
+	void BufferedWriter::Literal(const char *text)
+	{
+		Write(text, strlen(text));
+	}
+
+	void BufferedWriter::Decimal(NvU32 value)
+	{
+		char digits[10];
+		int count = 0;
+		do
+		{
+			digits[count++] = (char)('0' + value % 10);
+			value /= 10;
+		} while (value != 0);
+
+		while (count > 0)
+			Put(digits[--count]);
+	}
+
+	void BufferedWriter::Hex(NvU32 value)
+	{
+		static const char hexDigits[] = "0123456789ABCDEF";
+
+		char text[10] = { '0', 'x' };
+		for (int i = 0; i < 8; i++)
+			text[9 - i] = hexDigits[(value >> (i * 4)) & 0xF];
+
+		Write(text, sizeof(text));
+	}
+
+	void BufferedWriter::CodePoint(NvU32 codePoint)
+	{
+		if (codePoint < 0x80)
+		{
+			Put((char)codePoint);
+		}
+		else if (codePoint < 0x800)
+		{
+			Put((char)(0xC0 | (codePoint >> 6)));
+			Put((char)(0x80 | (codePoint & 0x3F)));
+		}
+		else if (codePoint < 0x10000)
+		{
+			Put((char)(0xE0 | (codePoint >> 12)));
+			Put((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+			Put((char)(0x80 | (codePoint & 0x3F)));
+		}
+		else
+		{
+			Put((char)(0xF0 | (codePoint >> 18)));
+			Put((char)(0x80 | ((codePoint >> 12) & 0x3F)));
+			Put((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+			Put((char)(0x80 | (codePoint & 0x3F)));
+		}
+	}
+
+	namespace
+	{
+		// Decodes one UTF-16 code point and advances text; unpaired surrogates become U+FFFD
+		NvU32 NextCodePoint(const wchar_t *&text)
+		{
+			NvU32 unit = (NvU16)*text++;
+			if (unit >= 0xD800 && unit <= 0xDBFF)
+			{
+				NvU32 low = (NvU16)*text;
+				if (low >= 0xDC00 && low <= 0xDFFF)
+				{
+					text++;
+					return 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+				}
+				return 0xFFFD;
+			}
+			if (unit >= 0xDC00 && unit <= 0xDFFF)
+				return 0xFFFD;
+
+			return unit;
+		}
+	}
+
+	void BufferedWriter::Utf8(const wchar_t *text)
+	{
+		while (*text)
+		{
+			// Plain ASCII runs are copied without decoding
+			const wchar_t *run = text;
+			while (*run && (NvU16)*run < 0x80)
+				run++;
+
+			for (; text < run; text++)
+				Put((char)*text);
+
+			if (*text)
+				CodePoint(NextCodePoint(text));
+		}
+	}
+
+	void BufferedWriter::JsonString(const wchar_t *text)
+	{
+		static const char hexDigits[] = "0123456789abcdef";
+
+		Put('"');
+		while (*text)
+		{
+			NvU32 codePoint = NextCodePoint(text);
+			switch (codePoint)
+			{
+			case '"': Write("\\\"", 2); break;
+			case '\\': Write("\\\\", 2); break;
+			case '\n': Write("\\n", 2); break;
+			case '\r': Write("\\r", 2); break;
+			case '\t': Write("\\t", 2); break;
+			default:
+				if (codePoint < 0x20)
+				{
+					char escape[6] = { '\\', 'u', '0', '0', hexDigits[codePoint >> 4], hexDigits[codePoint & 0xF] };
+					Write(escape, sizeof(escape));
+				}
+				else
+				{
+					CodePoint(codePoint);
+				}
+				break;
+			}
+		}
+		Put('"');
+	}
+
+	void BufferedWriter::CsvString(const wchar_t *text)
+	{
+		Put('"');
+		while (*text)
+		{
+			NvU32 codePoint = NextCodePoint(text);
+			if (codePoint == '"')
+				Put('"');
+			CodePoint(codePoint);
+		}
+		Put('"');
+	}
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "nvapi.h"
+
+#include <stdio.h>
+
+namespace ControlPanel
+{
+	// NULL when the file cannot be opened. Others may read it while it is open, as the store's readers do with
+	// segments still being written; fopen_s would lock them out.
+	FILE *OpenFile(const char *path, const char *mode);
+
+	// A binary file deleted when closed, NULL when none can be made
+	FILE *OpenTemporaryFile();
+
+	/*
+	Accumulates output in one large block and hands it to the stream with a
+	single fwrite when full. Numbers and strings are encoded in place, so no
+	printf-style formatting happens per field and only narrow (byte) output
+	reaches the stream.
+	*/
+	class BufferedWriter
+	{
+	public:
+		explicit BufferedWriter(FILE *file, size_t capacity = 1 << 20);
+		~BufferedWriter();
+
+		void Write(const void *data, size_t size);
+		void Put(char c)
+		{
+			if (failed || (used == capacity && !Flush()))
+				return;
+			buffer[used++] = c;
+		}
+		void Literal(const char *text);
+
+		void Decimal(NvU32 value);
+		void Hex(NvU32 value);      // 0x-prefixed, 8 digits
+
+		// UTF-16 to UTF-8; the escaping variants quote for JSON and CSV
+		void Utf8(const wchar_t *text);
+		void JsonString(const wchar_t *text);
+		void CsvString(const wchar_t *text);
+
+		bool Flush();
+		bool Failed() const { return failed; }
+
+		// Bytes buffered and bytes that reached the file; none lost to a failed write are counted
+		unsigned long long BytesWritten() const { return written + used; }
+
+	private:
+		BufferedWriter(const BufferedWriter &);
+		BufferedWriter &operator=(const BufferedWriter &);
+
+		void CodePoint(NvU32 codePoint);
+
+		FILE *file;
+		char *buffer;
+		size_t capacity;
+		size_t used;
+		unsigned long long written;
+		bool failed;
+	};
+};
@@ -0,0 +1,230 @@
+#include "targetver.h"
+#include "DrsAppResolver.h"
+
+#include <algorithm>
+#include <map>
+#include <string.h>
+#include <wctype.h>
+#include <Windows.h>
+
+namespace ControlPanel
+{
+	namespace
+	{
+		const size_t MAX_CANDIDATES = 16;
+
+		inline wchar_t FoldPathChar(wchar_t c)
+		{
+			return c == L'/' ? L'\\' : (wchar_t)towlower(c);
+		}
+
+		inline bool IsSeparator(wchar_t c)
+		{
+			return c == L'\\' || c == L'/';
+		}
+
+		bool IsMetroPath(const wchar_t *path)
+		{
+			static const wchar_t marker[] = L"\\windowsapps\\";
+			const size_t markerLength = sizeof(marker) / sizeof(marker[0]) - 1;
+
+			for (const wchar_t *start = path; *start; start++)
+			{
+				size_t i = 0;
+				while (i < markerLength && start[i] && FoldPathChar(start[i]) == marker[i])
+					i++;
+				if (i == markerLength)
+					return true;
+			}
+			return false;
+		}
+
+		struct BuildNode
+		{
+			std::map<wchar_t, NvU32> children;
+			std::vector<NvU32> entries;
+		};
+
+		struct NeedsFolderFiles
+		{
+			const DrsSnapshot *snapshot;
+			bool operator()(NvU32 row) const { return snapshot->String(snapshot->Applications().fileInFolder[row])[0] != 0; }
+		};
+	}
+
+	DrsAppResolver::DrsAppResolver()
+		: snapshot(NULL)
+		, checkFolderFiles(true)
+	{
+	}
+
+	void DrsAppResolver::Build(const DrsSnapshot &source)
+	{
+		snapshot = &source;
+		nodes.clear();
+		labels.clear();
+		entries.clear();
+
+		const DrsSnapshot::ApplicationTable &applications = source.Applications();
+		std::vector<BuildNode> tree(1);
+		for (NvU32 row = 0; row < source.ApplicationCount(); row++)
+		{
+			const wchar_t *name = source.String(applications.appName[row]);
+			size_t length = wcslen(name);
+			if (length == 0)
+				continue;
+
+			NvU32 node = 0;
+			for (size_t i = length; i-- > 0;)
+			{
+				wchar_t label = FoldPathChar(name[i]);
+				std::map<wchar_t, NvU32>::const_iterator child = tree[node].children.find(label);
+				if (child != tree[node].children.end())
+				{
+					node = child->second;
+					continue;
+				}
+
+				NvU32 created = (NvU32)tree.size();
+				tree[node].children[label] = created;
+				tree.push_back(BuildNode());
+				node = created;
+			}
+			tree[node].entries.push_back(row);
+		}
+
+		// Breadth-first, so the children of every node land next to each other
+		std::vector<NvU32> order(1, 0);
+		labels.push_back(0);
+		nodes.reserve(tree.size());
+		NeedsFolderFiles needsFolderFiles = { &source };
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			BuildNode &built = tree[order[i]];
+
+			Node node;
+			node.firstChild = (NvU32)order.size();
+			node.childCount = (NvU32)built.children.size();
+			for (std::map<wchar_t, NvU32>::const_iterator child = built.children.begin(); child != built.children.end(); ++child)
+			{
+				order.push_back(child->second);
+				labels.push_back(child->first);
+			}
+
+			std::stable_partition(built.entries.begin(), built.entries.end(), needsFolderFiles);
+			node.firstEntry = (NvU32)entries.size();
+			node.entryCount = (NvU32)built.entries.size();
+			entries.insert(entries.end(), built.entries.begin(), built.entries.end());
+			nodes.push_back(node);
+		}
+	}
+
+	NvU32 DrsAppResolver::FindChild(const Node &node, wchar_t label) const
+	{
+		const wchar_t *first = &labels[0] + node.firstChild;
+		const wchar_t *last = first + node.childCount;
+		const wchar_t *found = std::lower_bound(first, last, label);
+		if (found == last || *found != label)
+			return DrsSnapshot::npos;
+
+		return (NvU32)(found - &labels[0]);
+	}
+
+	bool DrsAppResolver::Accepts(NvU32 application, const wchar_t *path, size_t folderLength, bool isMetroPath) const
+	{
+		const DrsSnapshot::ApplicationTable &applications = snapshot->Applications();
+		if (applications.isMetro[application] && !isMetroPath)
+			return false;
+
+		const wchar_t *files = snapshot->String(applications.fileInFolder[application]);
+		if (*files == 0 || !checkFolderFiles)
+			return true;
+
+		// Every ':'-separated file must sit in the executable's folder
+		std::wstring candidate(path, folderLength);
+		while (*files)
+		{
+			const wchar_t *end = files;
+			while (*end && *end != L':')
+				end++;
+
+			if (end != files)
+			{
+				candidate.resize(folderLength);
+				candidate.append(files, end);
+				if (GetFileAttributesW(candidate.c_str()) == INVALID_FILE_ATTRIBUTES)
+					return false;
+			}
+			files = *end ? end + 1 : end;
+		}
+		return true;
+	}
+
+	DrsResolution DrsAppResolver::Resolve(const wchar_t *path) const
+	{
+		DrsResolution result = { DrsSnapshot::npos, DrsSnapshot::npos };
+		if (nodes.empty())
+			return result;
+
+		size_t length = wcslen(path);
+		size_t folderLength = length;
+		while (folderLength > 0 && !IsSeparator(path[folderLength - 1]))
+			folderLength--;
+
+		// Nodes holding entries that end on a folder boundary, shallowest first;
+		// past MAX_CANDIDATES the shallowest are dropped, deeper matches win anyway
+		NvU32 candidates[MAX_CANDIDATES];
+		size_t candidateCount = 0;
+
+		NvU32 node = 0;
+		for (size_t i = length; i-- > 0;)
+		{
+			node = FindChild(nodes[node], FoldPathChar(path[i]));
+			if (node == DrsSnapshot::npos)
+				break;
+
+			if (nodes[node].entryCount > 0 && (i == 0 || IsSeparator(path[i - 1])))
+			{
+				if (candidateCount == MAX_CANDIDATES)
+				{
+					memmove(candidates, candidates + 1, (MAX_CANDIDATES - 1) * sizeof(NvU32));
+					candidateCount--;
+				}
+				candidates[candidateCount++] = node;
+			}
+		}
+
+		bool isMetroPath = false;
+		bool metroChecked = false;
+		const DrsSnapshot::ApplicationTable &applications = snapshot->Applications();
+		while (candidateCount > 0)
+		{
+			const Node &match = nodes[candidates[--candidateCount]];
+			for (NvU32 i = 0; i < match.entryCount; i++)
+			{
+				NvU32 application = entries[match.firstEntry + i];
+				if (applications.isMetro[application] && !metroChecked)
+				{
+					isMetroPath = IsMetroPath(path);
+					metroChecked = true;
+				}
+
+				if (Accepts(application, path, folderLength, isMetroPath))
+				{
+					result.profile = applications.profile[application];
+					result.application = application;
+					return result;
+				}
+			}
+		}
+
+		return result;
+	}
+
+	void DrsAppResolver::ResolveAll(const std::vector<std::wstring> &paths, std::vector<DrsResolution> &results) const
+	{
+		results.resize(paths.size());
+		for (size_t i = 0; i < paths.size(); i++)
+			results[i] = Resolve(paths[i].c_str());
+	}
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "nvapi.h"
+#include "DrsSnapshot.h"
+
+#include <string>
+#include <vector>
+
+namespace ControlPanel
+{
+	struct DrsResolution
+	{
+		NvU32 profile;              // snapshot profile row, or DrsSnapshot::npos
+		NvU32 application;          // snapshot application row, or DrsSnapshot::npos
+	};
+
+	/*
+	Resolves executable paths to the profile the driver would pick, many at a
+	time and without NvAPI_DRS_FindApplicationByName. Every application entry
+	of a snapshot goes into a trie keyed by its appName reversed and case-folded,
+	so a path is matched by walking it from the end: an entry matches when its
+	name is a suffix of the path starting at a folder boundary ("game.exe" and
+	"bin\game.exe" both match "C:\Game\bin\Game.exe"). The longest match wins.
+	At equal length, entries that need fileInFolder files come first and only
+	match when those files exist next to the executable; isMetro entries only
+	match paths inside a WindowsApps package folder.
+	*/
+	class DrsAppResolver
+	{
+	public:
+		DrsAppResolver();
+
+		// Indexes every application of the snapshot; it must outlive the resolver
+		void Build(const DrsSnapshot &snapshot);
+
+		// false treats fileInFolder requirements as met, for paths that are not on this machine
+		void SetCheckFolderFiles(bool check) { checkFolderFiles = check; }
+
+		DrsResolution Resolve(const wchar_t *path) const;
+		void ResolveAll(const std::vector<std::wstring> &paths, std::vector<DrsResolution> &results) const;
+
+		NvU32 NodeCount() const { return (NvU32)labels.size(); }
+		NvU32 EntryCount() const { return (NvU32)entries.size(); }
+
+	private:
+		DrsAppResolver(const DrsAppResolver &);
+		DrsAppResolver &operator=(const DrsAppResolver &);
+
+		// Children of a node are contiguous and sorted by label
+		struct Node
+		{
+			NvU32 firstChild;
+			NvU32 childCount;
+			NvU32 firstEntry;
+			NvU32 entryCount;
+		};
+
+		NvU32 FindChild(const Node &node, wchar_t label) const;
+		bool Accepts(NvU32 application, const wchar_t *path, size_t folderLength, bool isMetroPath) const;
+
+		const DrsSnapshot *snapshot;
+		std::vector<Node> nodes;
+		std::vector<wchar_t> labels;
+		std::vector<NvU32> entries;     // application rows, grouped by node
+		bool checkFolderFiles;
+	};
+};
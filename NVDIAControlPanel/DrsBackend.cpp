@@ -0,0 +1,131 @@
+#include "targetver.h"
+#include "DrsBackend.h"
+#include "NvApiStats.h"
+
+namespace ControlPanel
+{
+	namespace
+	{
+		class NvApiDrsBackend : public DrsBackend
+		{
+		public:
+			NvAPI_Status CreateSession(NvDRSSessionHandle *session)
+			{
+				return NvApiCall(NVAPI_CALL_DRS_CREATE_SESSION, NvAPI_DRS_CreateSession, session);
+			}
+
+			NvAPI_Status DestroySession(NvDRSSessionHandle session)
+			{
+				return NvApiCall(NVAPI_CALL_DRS_DESTROY_SESSION, NvAPI_DRS_DestroySession, session);
+			}
+
+			NvAPI_Status LoadSettings(NvDRSSessionHandle session)
+			{
+				return NvApiCall(NVAPI_CALL_DRS_LOAD_SETTINGS, NvAPI_DRS_LoadSettings, session);
+			}
+
+			NvAPI_Status SaveSettings(NvDRSSessionHandle session)
+			{
+				return NvApiCall(NVAPI_CALL_DRS_SAVE_SETTINGS, NvAPI_DRS_SaveSettings, session);
+			}
+
+			NvAPI_Status RestoreAllDefaults(NvDRSSessionHandle session)
+			{
+				return NvApiCall(NVAPI_CALL_DRS_RESTORE_ALL_DEFAULTS, NvAPI_DRS_RestoreAllDefaults, session);
+			}
+
+			NvAPI_Status GetNumProfiles(NvDRSSessionHandle session, NvU32 *numProfiles)
+			{
+				return NvApiCall(NVAPI_CALL_DRS_GET_NUM_PROFILES, NvAPI_DRS_GetNumProfiles, session, numProfiles);
+			}
+
+			NvAPI_Status GetBaseProfile(NvDRSSessionHandle session, NvDRSProfileHandle *profile)
+			{
+				return NvApiCall(NVAPI_CALL_DRS_GET_BASE_PROFILE, NvAPI_DRS_GetBaseProfile, session, profile);
+			}
+
+			NvAPI_Status EnumProfiles(NvDRSSessionHandle session, NvU32 index, NvDRSProfileHandle *profile)
+			{
+				return NvApiCall(NVAPI_CALL_DRS_ENUM_PROFILES, NvAPI_DRS_EnumProfiles, session, index, profile);
+			}
+
+			NvAPI_Status FindProfileByName(NvDRSSessionHandle session, NvAPI_UnicodeString profileName, NvDRSProfileHandle *profile)
+			{
+				return NvApiCall(NVAPI_CALL_DRS_FIND_PROFILE_BY_NAME, NvAPI_DRS_FindProfileByName, session, profileName, profile);
+			}
+
+			NvAPI_Status GetProfileInfo(NvDRSSessionHandle session, NvDRSProfileHandle profile, NVDRS_PROFILE *profileInfo)
+			{
+				return NvApiCall(NVAPI_CALL_DRS_GET_PROFILE_INFO, NvAPI_DRS_GetProfileInfo, session, profile, profileInfo);
+			}
+
+			NvAPI_Status CreateProfile(NvDRSSessionHandle session, NVDRS_PROFILE *profileInfo, NvDRSProfileHandle *profile)
+			{
+				return NvApiCall(NVAPI_CALL_DRS_CREATE_PROFILE, NvAPI_DRS_CreateProfile, session, profileInfo, profile);
+			}
+
+			NvAPI_Status DeleteProfile(NvDRSSessionHandle session, NvDRSProfileHandle profile)
+			{
+				return NvApiCall(NVAPI_CALL_DRS_DELETE_PROFILE, NvAPI_DRS_DeleteProfile, session, profile);
+			}
+
+			NvAPI_Status RestoreProfileDefault(NvDRSSessionHandle session, NvDRSProfileHandle profile)
+			{
+				return NvApiCall(NVAPI_CALL_DRS_RESTORE_PROFILE_DEFAULT, NvAPI_DRS_RestoreProfileDefault, session, profile);
+			}
+
+			NvAPI_Status EnumApplications(NvDRSSessionHandle session, NvDRSProfileHandle profile, NvU32 startIndex, NvU32 *appCount, NVDRS_APPLICATION *applications)
+			{
+				return NvApiCall(NVAPI_CALL_DRS_ENUM_APPLICATIONS, NvAPI_DRS_EnumApplications, session, profile, startIndex, appCount, applications);
+			}
+
+			NvAPI_Status CreateApplication(NvDRSSessionHandle session, NvDRSProfileHandle profile, NVDRS_APPLICATION *application)
+			{
+				return NvApiCall(NVAPI_CALL_DRS_CREATE_APPLICATION, NvAPI_DRS_CreateApplication, session, profile, application);
+			}
+
+			NvAPI_Status FindApplicationByName(NvDRSSessionHandle session, NvAPI_UnicodeString appName, NvDRSProfileHandle *profile, NVDRS_APPLICATION *application)
+			{
+				return NvApiCall(NVAPI_CALL_DRS_FIND_APPLICATION_BY_NAME, NvAPI_DRS_FindApplicationByName, session, appName, profile, application);
+			}
+
+			NvAPI_Status EnumSettings(NvDRSSessionHandle session, NvDRSProfileHandle profile, NvU32 startIndex, NvU32 *settingsCount, NVDRS_SETTING *settings)
+			{
+				return NvApiCall(NVAPI_CALL_DRS_ENUM_SETTINGS, NvAPI_DRS_EnumSettings, session, profile, startIndex, settingsCount, settings);
+			}
+
+			NvAPI_Status GetSetting(NvDRSSessionHandle session, NvDRSProfileHandle profile, NvU32 settingId, NVDRS_SETTING *setting)
+			{
+				return NvApiCall(NVAPI_CALL_DRS_GET_SETTING, NvAPI_DRS_GetSetting, session, profile, settingId, setting);
+			}
+
+			NvAPI_Status SetSetting(NvDRSSessionHandle session, NvDRSProfileHandle profile, NVDRS_SETTING *setting)
+			{
+				return NvApiCall(NVAPI_CALL_DRS_SET_SETTING, NvAPI_DRS_SetSetting, session, profile, setting);
+			}
+
+			NvAPI_Status DeleteProfileSetting(NvDRSSessionHandle session, NvDRSProfileHandle profile, NvU32 settingId)
+			{
+				return NvApiCall(NVAPI_CALL_DRS_DELETE_PROFILE_SETTING, NvAPI_DRS_DeleteProfileSetting, session, profile, settingId);
+			}
+
+			NvAPI_Status RestoreProfileDefaultSetting(NvDRSSessionHandle session, NvDRSProfileHandle profile, NvU32 settingId)
+			{
+				return NvApiCall(NVAPI_CALL_DRS_RESTORE_PROFILE_DEFAULT_SETTING, NvAPI_DRS_RestoreProfileDefaultSetting, session, profile, settingId);
+			}
+		};
+
+		NvApiDrsBackend driverBackend;
+		DrsBackend *currentBackend = &driverBackend;
+	}
+
+	DrsBackend &Drs()
+	{
+		return *currentBackend;
+	}
+
+	void SetDrsBackend(DrsBackend *backend)
+	{
+		currentBackend = backend != NULL ? backend : &driverBackend;
+	}
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "nvapi.h"
+
+namespace ControlPanel
+{
+	/*
+	The NvAPI_DRS_* calls the tool makes, behind one interface, so that
+	DrsSession, DrsSnapshot and everything built on them run unchanged against
+	the driver or against SimulatedDrsStore (no GPU, no driver). Every method
+	has the signature and the return codes of the NvAPI function of the same name.
+	*/
+	class DrsBackend
+	{
+	public:
+		virtual ~DrsBackend() {}
+
+		virtual NvAPI_Status CreateSession(NvDRSSessionHandle *session) = 0;
+		virtual NvAPI_Status DestroySession(NvDRSSessionHandle session) = 0;
+		virtual NvAPI_Status LoadSettings(NvDRSSessionHandle session) = 0;
+		virtual NvAPI_Status SaveSettings(NvDRSSessionHandle session) = 0;
+		virtual NvAPI_Status RestoreAllDefaults(NvDRSSessionHandle session) = 0;
+
+		virtual NvAPI_Status GetNumProfiles(NvDRSSessionHandle session, NvU32 *numProfiles) = 0;
+		virtual NvAPI_Status GetBaseProfile(NvDRSSessionHandle session, NvDRSProfileHandle *profile) = 0;
+		virtual NvAPI_Status EnumProfiles(NvDRSSessionHandle session, NvU32 index, NvDRSProfileHandle *profile) = 0;
+		virtual NvAPI_Status FindProfileByName(NvDRSSessionHandle session, NvAPI_UnicodeString profileName, NvDRSProfileHandle *profile) = 0;
+		virtual NvAPI_Status GetProfileInfo(NvDRSSessionHandle session, NvDRSProfileHandle profile, NVDRS_PROFILE *profileInfo) = 0;
+		virtual NvAPI_Status CreateProfile(NvDRSSessionHandle session, NVDRS_PROFILE *profileInfo, NvDRSProfileHandle *profile) = 0;
+		virtual NvAPI_Status DeleteProfile(NvDRSSessionHandle session, NvDRSProfileHandle profile) = 0;
+		virtual NvAPI_Status RestoreProfileDefault(NvDRSSessionHandle session, NvDRSProfileHandle profile) = 0;
+
+		virtual NvAPI_Status EnumApplications(NvDRSSessionHandle session, NvDRSProfileHandle profile, NvU32 startIndex, NvU32 *appCount, NVDRS_APPLICATION *applications) = 0;
+		virtual NvAPI_Status CreateApplication(NvDRSSessionHandle session, NvDRSProfileHandle profile, NVDRS_APPLICATION *application) = 0;
+		virtual NvAPI_Status FindApplicationByName(NvDRSSessionHandle session, NvAPI_UnicodeString appName, NvDRSProfileHandle *profile, NVDRS_APPLICATION *application) = 0;
+
+		virtual NvAPI_Status EnumSettings(NvDRSSessionHandle session, NvDRSProfileHandle profile, NvU32 startIndex, NvU32 *settingsCount, NVDRS_SETTING *settings) = 0;
+		virtual NvAPI_Status GetSetting(NvDRSSessionHandle session, NvDRSProfileHandle profile, NvU32 settingId, NVDRS_SETTING *setting) = 0;
+		virtual NvAPI_Status SetSetting(NvDRSSessionHandle session, NvDRSProfileHandle profile, NVDRS_SETTING *setting) = 0;
+		virtual NvAPI_Status DeleteProfileSetting(NvDRSSessionHandle session, NvDRSProfileHandle profile, NvU32 settingId) = 0;
+		virtual NvAPI_Status RestoreProfileDefaultSetting(NvDRSSessionHandle session, NvDRSProfileHandle profile, NvU32 settingId) = 0;
+	};
+
+	// The backend every DRS call goes through: the driver unless replaced
+	DrsBackend &Drs();
+
+	// Not owned; NULL goes back to the driver. Switch only while no DrsSession is open.
+	void SetDrsBackend(DrsBackend *backend);
+};
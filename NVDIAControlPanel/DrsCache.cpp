@@ -0,0 +1,372 @@
+#include "targetver.h"
+#include "DrsCache.h"
+#include "BufferedWriter.h"
+#include "NvApiStats.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <wctype.h>
+#include <Windows.h>
+
+namespace ControlPanel
+{
+	namespace
+	{
+		NvU64 Fnv64(NvU64 hash, const void *data, size_t size)
+		{
+			const NvU8 *bytes = (const NvU8 *)data;
+			for (size_t i = 0; i < size; i++)
+				hash = (hash ^ bytes[i]) * 1099511628211ULL;
+			return hash;
+		}
+
+		// The driver rewrites its database files on every SaveSettings, so their
+		// names, sizes and write times change whenever the stored settings do
+		NvU64 FingerprintDrsDatabase()
+		{
+			wchar_t programData[MAX_PATH];
+			DWORD length = GetEnvironmentVariableW(L"ProgramData", programData, MAX_PATH);
+			if (length == 0 || length >= MAX_PATH)
+				return 0;
+
+			std::wstring pattern = std::wstring(programData) + L"\\NVIDIA Corporation\\Drs\\*.bin";
+			WIN32_FIND_DATAW found;
+			HANDLE search = FindFirstFileW(pattern.c_str(), &found);
+			if (search == INVALID_HANDLE_VALUE)
+				return 0;
+
+			NvU64 hash = 14695981039346656037ULL;
+			do
+			{
+				hash = Fnv64(hash, found.cFileName, wcslen(found.cFileName) * sizeof(wchar_t));
+				hash = Fnv64(hash, &found.nFileSizeHigh, sizeof(found.nFileSizeHigh));
+				hash = Fnv64(hash, &found.nFileSizeLow, sizeof(found.nFileSizeLow));
+				hash = Fnv64(hash, &found.ftLastWriteTime, sizeof(found.ftLastWriteTime));
+			} while (FindNextFileW(search, &found));
+			FindClose(search);
+
+			// 0 is reserved for "unknown", which never matches
+			return hash != 0 ? hash : 1;
+		}
+
+		struct FoldedNameLess
+		{
+			const std::vector<std::wstring> *names;
+			bool operator()(NvU32 a, NvU32 b) const { return (*names)[a] < (*names)[b]; }
+		};
+
+		// Rows sorted by the case-folded string their name column points to
+		std::vector<NvU32> SortedByName(const DrsSnapshot &snapshot, const std::vector<NvU32> &nameColumn)
+		{
+			std::vector<std::wstring> folded(nameColumn.size());
+			std::vector<NvU32> order(nameColumn.size());
+			for (size_t i = 0; i < nameColumn.size(); i++)
+			{
+				folded[i] = FoldCase(snapshot.String(nameColumn[i]));
+				order[i] = (NvU32)i;
+			}
+
+			FoldedNameLess less = { &folded };
+			std::stable_sort(order.begin(), order.end(), less);
+			return order;
+		}
+
+		void WritePaddedColumn(BufferedWriter &writer, const std::vector<NvU32> &column)
+		{
+			static const char padding[8] = { 0 };
+
+			size_t bytes = column.size() * sizeof(NvU32);
+			if (bytes > 0)
+				writer.Write(&column[0], bytes);
+			if (bytes % 8)
+				writer.Write(padding, 8 - bytes % 8);
+		}
+
+		// Rows are only valid while first + count stays within the table
+		bool RangeWithin(NvU32 first, NvU32 count, NvU32 rows)
+		{
+			return first <= rows && count <= rows - first;
+		}
+
+		bool RowsWithin(const NvU32 *column, NvU32 count, NvU32 rows)
+		{
+			for (NvU32 i = 0; i < count; i++)
+			{
+				if (column[i] >= rows)
+					return false;
+			}
+			return true;
+		}
+
+		// Every row, string offset and blob range the lookups follow stays inside
+		// the mapping; the pool ends in a terminator, so no string runs off it
+		bool ValidDrsTables(const DrsDumpTables &tables, const NvU32 *profileOrder, const NvU32 *applicationOrder)
+		{
+			const DrsDumpHeader &header = *tables.header;
+			NvU32 strings = header.stringCount;
+			if (strings > 0 && tables.strings[strings - 1] != 0)
+				return false;
+
+			for (NvU32 p = 0; p < header.profileCount; p++)
+			{
+				if (!RangeWithin(tables.profileFirstApplication[p], tables.profileApplicationCount[p], header.applicationCount) ||
+					!RangeWithin(tables.profileFirstSetting[p], tables.profileSettingCount[p], header.settingCount))
+					return false;
+			}
+
+			for (NvU32 s = 0; s < header.settingCount; s++)
+			{
+				switch (tables.settingType[s])
+				{
+				case NVDRS_DWORD_TYPE:
+					break;
+
+				case NVDRS_BINARY_TYPE:
+					if (!RangeWithin(tables.settingValue[s], tables.settingLength[s], header.blobBytes))
+						return false;
+					break;
+
+				default:
+					if (tables.settingValue[s] >= strings)
+						return false;
+					break;
+				}
+			}
+
+			return RowsWithin(tables.profileName, header.profileCount, strings) &&
+				RowsWithin(tables.applicationProfile, header.applicationCount, header.profileCount) &&
+				RowsWithin(tables.applicationAppName, header.applicationCount, strings) &&
+				RowsWithin(tables.applicationUserFriendlyName, header.applicationCount, strings) &&
+				RowsWithin(tables.applicationLauncher, header.applicationCount, strings) &&
+				RowsWithin(tables.applicationFileInFolder, header.applicationCount, strings) &&
+				RowsWithin(tables.settingProfile, header.settingCount, header.profileCount) &&
+				RowsWithin(profileOrder, header.profileCount, header.profileCount) &&
+				RowsWithin(applicationOrder, header.applicationCount, header.applicationCount);
+		}
+
+		// Same ordering as std::wstring comparison of FoldCase() results
+		int CompareFolded(const NvU16 *stored, const std::wstring &folded)
+		{
+			for (size_t i = 0;; i++)
+			{
+				NvU32 a = stored[i] ? (NvU32)(NvU16)towlower(stored[i]) : 0;
+				NvU32 b = i < folded.size() ? (NvU32)folded[i] : 0;
+				if (a != b)
+					return a < b ? -1 : 1;
+				if (a == 0)
+					return 0;
+			}
+		}
+	}
+
+	NvAPI_Status GetDrsCacheKey(DrsCacheKey &key)
+	{
+		memset(&key, 0, sizeof(key));
+
+		NvAPI_ShortString branch = { 0 };
+		NvAPI_Status status = NvApiCall(NVAPI_CALL_SYS_GET_DRIVER_AND_BRANCH_VERSION, NvAPI_SYS_GetDriverAndBranchVersion, &key.driverVersion, branch);
+		if (status != NVAPI_OK)
+			return status;
+
+		key.fingerprint = FingerprintDrsDatabase();
+		return NVAPI_OK;
+	}
+
+	std::string DefaultDrsCachePath()
+	{
+		char directory[MAX_PATH + 1] = { 0 };
+		DWORD length = GetTempPathA(MAX_PATH + 1, directory);
+		if (length == 0 || length > MAX_PATH)
+			return "NVDIAControlPanel.drscache";
+
+		return std::string(directory) + "NVDIAControlPanel.drscache";
+	}
+
+	NvAPI_Status WriteDrsCache(const DrsSnapshot &snapshot, const DrsCacheKey &key, const char *path)
+	{
+		std::string temporary = std::string(path) + ".tmp";
+		FILE *file = OpenFile(temporary.c_str(), "wb");
+		if (file == NULL)
+			return NVAPI_ERROR;
+
+		DrsCacheHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, DRS_CACHE_MAGIC, sizeof(header.magic));
+		header.version = DRS_CACHE_VERSION;
+		header.baseProfile = snapshot.BaseProfile();
+		header.key = key;
+
+		NvAPI_Status status;
+		bool written;
+		{
+			BufferedWriter writer(file);
+			writer.Write(&header, sizeof(header));
+
+			status = WriteDrsDump(snapshot, DRS_DUMP_BINARY, writer);
+			header.dumpBytes = writer.BytesWritten() - sizeof(header);
+
+			WritePaddedColumn(writer, SortedByName(snapshot, snapshot.Profiles().name));
+			WritePaddedColumn(writer, SortedByName(snapshot, snapshot.Applications().appName));
+			written = writer.Flush();
+		}
+
+		// The header goes in last, so a file cut short never carries a valid size
+		written = written && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+		written = fclose(file) == 0 && written;
+
+		if (status == NVAPI_OK && !written)
+			status = NVAPI_ERROR;
+		if (status == NVAPI_OK && !MoveFileExA(temporary.c_str(), path, MOVEFILE_REPLACE_EXISTING))
+			status = NVAPI_ERROR;
+		if (status != NVAPI_OK)
+			DeleteFileA(temporary.c_str());
+
+		return status;
+	}
+
+	DrsSnapshotCache::DrsSnapshotCache()
+		: header(NULL)
+		, profileOrder(NULL)
+		, applicationOrder(NULL)
+		, rebuilt(false)
+	{
+		memset(&tables, 0, sizeof(tables));
+	}
+
+	NvAPI_Status DrsSnapshotCache::Open(const char *path)
+	{
+		rebuilt = false;
+
+		DrsCacheKey key;
+		NvAPI_Status status = GetDrsCacheKey(key);
+		if (status != NVAPI_OK)
+			return status;
+
+		// Without a fingerprint there is no way to tell the file is current
+		if (key.fingerprint != 0 && Map(path, key))
+			return NVAPI_OK;
+
+		// The mapping must be gone before the file can be replaced
+		Close();
+
+		DrsSession session;
+		DrsSnapshot snapshot;
+		status = snapshot.Load(session);
+		if (status != NVAPI_OK)
+			return status;
+
+		status = WriteDrsCache(snapshot, key, path);
+		if (status != NVAPI_OK)
+			return status;
+
+		if (!Map(path, key))
+			return NVAPI_ERROR;
+
+		rebuilt = true;
+		return NVAPI_OK;
+	}
+
+	bool DrsSnapshotCache::Map(const char *path, const DrsCacheKey &key)
+	{
+		Close();
+		if (!file.Open(path))
+			return false;
+
+		const NvU8 *base = (const NvU8 *)file.Data();
+		size_t size = file.Size();
+
+		const DrsCacheHeader *candidate = (const DrsCacheHeader *)base;
+		if (size < sizeof(DrsCacheHeader) ||
+			memcmp(candidate->magic, DRS_CACHE_MAGIC, sizeof(candidate->magic)) != 0 ||
+			candidate->version != DRS_CACHE_VERSION ||
+			candidate->key.driverVersion != key.driverVersion ||
+			candidate->key.fingerprint != key.fingerprint ||
+			candidate->dumpBytes > size - sizeof(DrsCacheHeader) ||
+			MapDrsDump(base + sizeof(DrsCacheHeader), (size_t)candidate->dumpBytes, tables) != candidate->dumpBytes)
+		{
+			Close();
+			return false;
+		}
+
+		size_t offset = sizeof(DrsCacheHeader) + (size_t)candidate->dumpBytes;
+		size_t profileBytes = ((size_t)tables.header->profileCount * sizeof(NvU32) + 7) & ~(size_t)7;
+		size_t applicationBytes = ((size_t)tables.header->applicationCount * sizeof(NvU32) + 7) & ~(size_t)7;
+		if (size - offset < profileBytes + applicationBytes ||
+			(candidate->baseProfile >= tables.header->profileCount && candidate->baseProfile != DrsSnapshot::npos) ||
+			!ValidDrsTables(tables, (const NvU32 *)(base + offset), (const NvU32 *)(base + offset + profileBytes)))
+		{
+			Close();
+			return false;
+		}
+
+		header = candidate;
+		profileOrder = (const NvU32 *)(base + offset);
+		applicationOrder = (const NvU32 *)(base + offset + profileBytes);
+		return true;
+	}
+
+	void DrsSnapshotCache::Close()
+	{
+		file.Close();
+		header = NULL;
+		profileOrder = NULL;
+		applicationOrder = NULL;
+		memset(&tables, 0, sizeof(tables));
+	}
+
+	NvU32 DrsSnapshotCache::EqualRange(const NvU32 *order, NvU32 count, const NvU32 *nameColumn, const std::wstring &name, NvU32 *first) const
+	{
+		NvU32 low = 0;
+		NvU32 high = count;
+		while (low < high)
+		{
+			NvU32 middle = low + (high - low) / 2;
+			if (CompareFolded(String(nameColumn[order[middle]]), name) < 0)
+				low = middle + 1;
+			else
+				high = middle;
+		}
+
+		NvU32 end = low;
+		while (end < count && CompareFolded(String(nameColumn[order[end]]), name) == 0)
+			end++;
+
+		*first = low;
+		return end - low;
+	}
+
+	NvU32 DrsSnapshotCache::FindProfile(const wchar_t *profileName) const
+	{
+		NvU32 first = 0;
+		if (EqualRange(profileOrder, ProfileCount(), tables.profileName, FoldCase(profileName), &first) == 0)
+			return DrsSnapshot::npos;
+
+		return profileOrder[first];
+	}
+
+	size_t DrsSnapshotCache::FindApplications(const wchar_t *appName, std::vector<NvU32> &result) const
+	{
+		result.clear();
+
+		NvU32 first = 0;
+		NvU32 count = EqualRange(applicationOrder, ApplicationCount(), tables.applicationAppName, FoldCase(appName), &first);
+		result.assign(applicationOrder + first, applicationOrder + first + count);
+		return result.size();
+	}
+
+	NvU32 DrsSnapshotCache::FindSetting(NvU32 profile, NvU32 settingId) const
+	{
+		if (profile >= ProfileCount())
+			return DrsSnapshot::npos;
+
+		const NvU32 *begin = tables.settingId + tables.profileFirstSetting[profile];
+		const NvU32 *end = begin + tables.profileSettingCount[profile];
+
+		const NvU32 *row = std::lower_bound(begin, end, settingId);
+		if (row == end || *row != settingId)
+			return DrsSnapshot::npos;
+
+		return (NvU32)(row - tables.settingId);
+	}
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "nvapi.h"
+#include "DrsDump.h"
+#include "DrsSnapshot.h"
+#include "MappedFile.h"
+
+#include <string>
+#include <vector>
+
+namespace ControlPanel
+{
+	// Identifies the driver database a cache file was built from
+	struct DrsCacheKey
+	{
+		NvU32 driverVersion;        // NvAPI_SYS_GetDriverAndBranchVersion
+		NvU32 reserved;
+		NvU64 fingerprint;          // names, sizes and write times of the DRS database files; 0 if unknown
+	};
+
+	/*
+	Cache file layout: DrsCacheHeader, a binary dump (DrsDump.h), then the
+	profile rows sorted by case-folded name and the application rows sorted by
+	case-folded executable name, each column padded to 8 bytes.
+	*/
+	struct DrsCacheHeader
+	{
+		char magic[8];              // "NVDRSCCH"
+		NvU32 version;
+		NvU32 baseProfile;          // profile row, or DrsSnapshot::npos
+		DrsCacheKey key;
+		NvU64 dumpBytes;
+	};
+
+	#define DRS_CACHE_MAGIC         "NVDRSCCH"
+	#define DRS_CACHE_VERSION       1
+
+	NvAPI_Status GetDrsCacheKey(DrsCacheKey &key);
+
+	// %TEMP%\NVDIAControlPanel.drscache
+	std::string DefaultDrsCachePath();
+
+	// Writes the snapshot as a cache file; replaces an existing file only once the new one is complete
+	NvAPI_Status WriteDrsCache(const DrsSnapshot &snapshot, const DrsCacheKey &key, const char *path);
+
+	/*
+	Read-only DRS snapshot served straight from a memory-mapped cache file.
+	Opening a current cache costs one driver version query and a file mapping:
+	no NvAPI_DRS_LoadSettings, no enumeration and no parsing. Lookups binary
+	search the sorted index columns stored in the file.
+	*/
+	class DrsSnapshotCache
+	{
+	public:
+		DrsSnapshotCache();
+
+		// Maps the cache file if it matches the current driver database,
+		// otherwise loads the database, rewrites the file and maps that
+		NvAPI_Status Open(const char *path);
+
+		// Maps the file if it is a valid cache for key, without touching the driver;
+		// rows and offsets that point outside the file reject it
+		bool Map(const char *path, const DrsCacheKey &key);
+		void Close();
+
+		bool IsOpen() const { return file.IsOpen(); }
+		bool WasRebuilt() const { return rebuilt; }
+
+		NvU32 ProfileCount() const { return tables.header->profileCount; }
+		NvU32 ApplicationCount() const { return tables.header->applicationCount; }
+		NvU32 SettingCount() const { return tables.header->settingCount; }
+		NvU32 BaseProfile() const { return header->baseProfile; }
+
+		const DrsDumpTables &Tables() const { return tables; }
+		const NvU16 *String(NvU32 offset) const { return tables.strings + offset; }
+		const NvU8 *Blob(NvU32 offset) const { return tables.blobs + offset; }
+
+		// Case-insensitive; DrsSnapshot::npos when absent
+		NvU32 FindProfile(const wchar_t *profileName) const;
+
+		// Every application row whose executable matches, case-insensitive
+		size_t FindApplications(const wchar_t *appName, std::vector<NvU32> &result) const;
+
+		// Row of settingId in a profile, or DrsSnapshot::npos, also for a profile out of range
+		NvU32 FindSetting(NvU32 profile, NvU32 settingId) const;
+
+	private:
+		DrsSnapshotCache(const DrsSnapshotCache &);
+		DrsSnapshotCache &operator=(const DrsSnapshotCache &);
+
+		// Rows of order[0, count) whose folded name equals name: first row and count
+		NvU32 EqualRange(const NvU32 *order, NvU32 count, const NvU32 *nameColumn, const std::wstring &name, NvU32 *first) const;
+
+		MappedFile file;
+		const DrsCacheHeader *header;
+		DrsDumpTables tables;
+		const NvU32 *profileOrder;
+		const NvU32 *applicationOrder;
+		bool rebuilt;
+	};
+};
@@ -0,0 +1,308 @@
+#include "targetver.h"
+#include "DrsDump.h"
+
+#include <string.h>
+#include <vector>
+
+namespace ControlPanel
+{
+	namespace
+	{
+		const char *SettingTypeName(NvU8 settingType)
+		{
+			switch (settingType)
+			{
+			case NVDRS_DWORD_TYPE: return "dword";
+			case NVDRS_BINARY_TYPE: return "binary";
+			case NVDRS_STRING_TYPE: return "string";
+			default: return "wstring";
+			}
+		}
+
+		void WriteHexBytes(BufferedWriter &writer, const NvU8 *data, NvU32 length)
+		{
+			static const char hexDigits[] = "0123456789ABCDEF";
+			for (NvU32 i = 0; i < length; i++)
+			{
+				writer.Put(hexDigits[data[i] >> 4]);
+				writer.Put(hexDigits[data[i] & 0xF]);
+			}
+		}
+
+		void WriteJsonLines(const DrsSnapshot &snapshot, BufferedWriter &writer)
+		{
+			const DrsSnapshot::ProfileTable &profiles = snapshot.Profiles();
+			const DrsSnapshot::ApplicationTable &apps = snapshot.Applications();
+			const DrsSnapshot::SettingTable &settings = snapshot.Settings();
+
+			for (NvU32 p = 0; p < snapshot.ProfileCount(); p++)
+			{
+				writer.Literal("{\"profile\":");
+				writer.JsonString(snapshot.String(profiles.name[p]));
+				writer.Literal(profiles.isPredefined[p] ? ",\"predefined\":true" : ",\"predefined\":false");
+
+				writer.Literal(",\"applications\":[");
+				NvU32 firstApp = profiles.firstApplication[p];
+				for (NvU32 a = firstApp; a < firstApp + profiles.applicationCount[p]; a++)
+				{
+					if (a != firstApp)
+						writer.Put(',');
+					writer.Literal("{\"appName\":");
+					writer.JsonString(snapshot.String(apps.appName[a]));
+					writer.Literal(",\"userFriendlyName\":");
+					writer.JsonString(snapshot.String(apps.userFriendlyName[a]));
+					writer.Literal(",\"launcher\":");
+					writer.JsonString(snapshot.String(apps.launcher[a]));
+					writer.Literal(",\"fileInFolder\":");
+					writer.JsonString(snapshot.String(apps.fileInFolder[a]));
+					writer.Literal(apps.isPredefined[a] ? ",\"predefined\":true" : ",\"predefined\":false");
+					writer.Literal(apps.isMetro[a] ? ",\"metro\":true}" : ",\"metro\":false}");
+				}
+
+				writer.Literal("],\"settings\":[");
+				NvU32 firstSetting = profiles.firstSetting[p];
+				for (NvU32 s = firstSetting; s < firstSetting + profiles.settingCount[p]; s++)
+				{
+					if (s != firstSetting)
+						writer.Put(',');
+					writer.Literal("{\"id\":\"");
+					writer.Hex(settings.settingId[s]);
+					writer.Literal("\",\"type\":\"");
+					writer.Literal(SettingTypeName(settings.settingType[s]));
+					writer.Literal(settings.isPredefined[s] ? "\",\"predefined\":true,\"value\":" : "\",\"predefined\":false,\"value\":");
+
+					switch (settings.settingType[s])
+					{
+					case NVDRS_DWORD_TYPE:
+						writer.Decimal(settings.value[s]);
+						break;
+
+					case NVDRS_BINARY_TYPE:
+						writer.Put('"');
+						WriteHexBytes(writer, snapshot.Blob(settings.value[s]), settings.length[s]);
+						writer.Put('"');
+						break;
+
+					default:
+						writer.JsonString(snapshot.String(settings.value[s]));
+						break;
+					}
+					writer.Put('}');
+				}
+
+				writer.Literal("]}\n");
+			}
+		}
+
+		void WriteCsv(const DrsSnapshot &snapshot, BufferedWriter &writer)
+		{
+			const DrsSnapshot::ProfileTable &profiles = snapshot.Profiles();
+			const DrsSnapshot::ApplicationTable &apps = snapshot.Applications();
+			const DrsSnapshot::SettingTable &settings = snapshot.Settings();
+
+			writer.Literal("record,profile,key,type,predefined,value\r\n");
+
+			for (NvU32 p = 0; p < snapshot.ProfileCount(); p++)
+			{
+				const wchar_t *profileName = snapshot.String(profiles.name[p]);
+
+				NvU32 firstApp = profiles.firstApplication[p];
+				for (NvU32 a = firstApp; a < firstApp + profiles.applicationCount[p]; a++)
+				{
+					writer.Literal("application,");
+					writer.CsvString(profileName);
+					writer.Put(',');
+					writer.CsvString(snapshot.String(apps.appName[a]));
+					writer.Literal(apps.isMetro[a] ? ",metro," : ",exe,");
+					writer.Put(apps.isPredefined[a] ? '1' : '0');
+					writer.Put(',');
+					writer.CsvString(snapshot.String(apps.userFriendlyName[a]));
+					writer.Literal("\r\n");
+				}
+
+				NvU32 firstSetting = profiles.firstSetting[p];
+				for (NvU32 s = firstSetting; s < firstSetting + profiles.settingCount[p]; s++)
+				{
+					writer.Literal("setting,");
+					writer.CsvString(profileName);
+					writer.Put(',');
+					writer.Hex(settings.settingId[s]);
+					writer.Put(',');
+					writer.Literal(SettingTypeName(settings.settingType[s]));
+					writer.Put(',');
+					writer.Put(settings.isPredefined[s] ? '1' : '0');
+					writer.Put(',');
+
+					switch (settings.settingType[s])
+					{
+					case NVDRS_DWORD_TYPE:
+						writer.Hex(settings.value[s]);
+						break;
+
+					case NVDRS_BINARY_TYPE:
+						WriteHexBytes(writer, snapshot.Blob(settings.value[s]), settings.length[s]);
+						break;
+
+					default:
+						writer.CsvString(snapshot.String(settings.value[s]));
+						break;
+					}
+					writer.Literal("\r\n");
+				}
+			}
+		}
+
+		template <typename T>
+		void WriteColumn(BufferedWriter &writer, const std::vector<T> &column)
+		{
+			static const char padding[8] = { 0 };
+
+			size_t bytes = column.size() * sizeof(T);
+			if (bytes > 0)
+				writer.Write(&column[0], bytes);
+			if (bytes % 8)
+				writer.Write(padding, 8 - bytes % 8);
+		}
+
+		// Counterpart of WriteColumn(); every column, the last one included, is padded
+		template <typename T>
+		bool MapColumn(const NvU8 *base, size_t size, size_t &offset, NvU32 count, const T **column)
+		{
+			if (count > (size - offset) / sizeof(T))
+				return false;
+
+			size_t padded = ((size_t)count * sizeof(T) + 7) & ~(size_t)7;
+			if (padded > size - offset)
+				return false;
+
+			*column = (const T *)(base + offset);
+			offset += padded;
+			return true;
+		}
+
+		void WriteBinary(const DrsSnapshot &snapshot, BufferedWriter &writer)
+		{
+			const DrsSnapshot::ProfileTable &profiles = snapshot.Profiles();
+			const DrsSnapshot::ApplicationTable &apps = snapshot.Applications();
+			const DrsSnapshot::SettingTable &settings = snapshot.Settings();
+
+			DrsDumpHeader header;
+			memset(&header, 0, sizeof(header));
+			memcpy(header.magic, DRS_DUMP_MAGIC, sizeof(header.magic));
+			header.version = DRS_DUMP_VERSION;
+			header.profileCount = snapshot.ProfileCount();
+			header.applicationCount = snapshot.ApplicationCount();
+			header.settingCount = snapshot.SettingCount();
+			header.stringCount = (NvU32)snapshot.StringPool().size();
+			header.blobBytes = (NvU32)snapshot.BlobPool().size();
+			writer.Write(&header, sizeof(header));
+
+			WriteColumn(writer, profiles.name);
+			WriteColumn(writer, profiles.isPredefined);
+			WriteColumn(writer, profiles.firstApplication);
+			WriteColumn(writer, profiles.applicationCount);
+			WriteColumn(writer, profiles.firstSetting);
+			WriteColumn(writer, profiles.settingCount);
+
+			WriteColumn(writer, apps.profile);
+			WriteColumn(writer, apps.appName);
+			WriteColumn(writer, apps.userFriendlyName);
+			WriteColumn(writer, apps.launcher);
+			WriteColumn(writer, apps.fileInFolder);
+			WriteColumn(writer, apps.isPredefined);
+			WriteColumn(writer, apps.isMetro);
+
+			WriteColumn(writer, settings.profile);
+			WriteColumn(writer, settings.settingId);
+			WriteColumn(writer, settings.settingType);
+			WriteColumn(writer, settings.isPredefined);
+			WriteColumn(writer, settings.value);
+			WriteColumn(writer, settings.length);
+
+			if (sizeof(wchar_t) == sizeof(NvU16))
+			{
+				WriteColumn(writer, snapshot.StringPool());
+			}
+			else
+			{
+				std::vector<NvU16> pool(snapshot.StringPool().begin(), snapshot.StringPool().end());
+				WriteColumn(writer, pool);
+			}
+			WriteColumn(writer, snapshot.BlobPool());
+		}
+	}
+
+	bool ParseDrsDumpFormat(const char *name, DrsDumpFormat *format)
+	{
+		if (strcmp(name, "jsonl") == 0 || strcmp(name, "json") == 0)
+			*format = DRS_DUMP_JSONL;
+		else if (strcmp(name, "csv") == 0)
+			*format = DRS_DUMP_CSV;
+		else if (strcmp(name, "bin") == 0 || strcmp(name, "binary") == 0)
+			*format = DRS_DUMP_BINARY;
+		else
+			return false;
+
+		return true;
+	}
+
+	NvAPI_Status WriteDrsDump(const DrsSnapshot &snapshot, DrsDumpFormat format, BufferedWriter &writer)
+	{
+		switch (format)
+		{
+		case DRS_DUMP_JSONL:
+			WriteJsonLines(snapshot, writer);
+			break;
+
+		case DRS_DUMP_CSV:
+			WriteCsv(snapshot, writer);
+			break;
+
+		default:
+			WriteBinary(snapshot, writer);
+			break;
+		}
+
+		return writer.Flush() ? NVAPI_OK : NVAPI_ERROR;
+	}
+
+	size_t MapDrsDump(const void *data, size_t size, DrsDumpTables &tables)
+	{
+		const NvU8 *base = (const NvU8 *)data;
+		if (size < sizeof(DrsDumpHeader))
+			return 0;
+
+		const DrsDumpHeader *header = (const DrsDumpHeader *)base;
+		if (memcmp(header->magic, DRS_DUMP_MAGIC, sizeof(header->magic)) != 0 || header->version != DRS_DUMP_VERSION)
+			return 0;
+
+		tables.header = header;
+		size_t offset = sizeof(DrsDumpHeader);
+
+		// Same order as WriteBinary()
+		bool ok =
+			MapColumn(base, size, offset, header->profileCount, &tables.profileName) &&
+			MapColumn(base, size, offset, header->profileCount, &tables.profileIsPredefined) &&
+			MapColumn(base, size, offset, header->profileCount, &tables.profileFirstApplication) &&
+			MapColumn(base, size, offset, header->profileCount, &tables.profileApplicationCount) &&
+			MapColumn(base, size, offset, header->profileCount, &tables.profileFirstSetting) &&
+			MapColumn(base, size, offset, header->profileCount, &tables.profileSettingCount) &&
+			MapColumn(base, size, offset, header->applicationCount, &tables.applicationProfile) &&
+			MapColumn(base, size, offset, header->applicationCount, &tables.applicationAppName) &&
+			MapColumn(base, size, offset, header->applicationCount, &tables.applicationUserFriendlyName) &&
+			MapColumn(base, size, offset, header->applicationCount, &tables.applicationLauncher) &&
+			MapColumn(base, size, offset, header->applicationCount, &tables.applicationFileInFolder) &&
+			MapColumn(base, size, offset, header->applicationCount, &tables.applicationIsPredefined) &&
+			MapColumn(base, size, offset, header->applicationCount, &tables.applicationIsMetro) &&
+			MapColumn(base, size, offset, header->settingCount, &tables.settingProfile) &&
+			MapColumn(base, size, offset, header->settingCount, &tables.settingId) &&
+			MapColumn(base, size, offset, header->settingCount, &tables.settingType) &&
+			MapColumn(base, size, offset, header->settingCount, &tables.settingIsPredefined) &&
+			MapColumn(base, size, offset, header->settingCount, &tables.settingValue) &&
+			MapColumn(base, size, offset, header->settingCount, &tables.settingLength) &&
+			MapColumn(base, size, offset, header->stringCount, &tables.strings) &&
+			MapColumn(base, size, offset, header->blobBytes, &tables.blobs);
+
+		return ok ? offset : 0;
+	}
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "nvapi.h"
+#include "BufferedWriter.h"
+#include "DrsSnapshot.h"
+
+namespace ControlPanel
+{
+	enum DrsDumpFormat
+	{
+		DRS_DUMP_JSONL,     // one JSON object per profile and line
+		DRS_DUMP_CSV,       // one row per application and stored setting
+		DRS_DUMP_BINARY     // DrsDumpHeader followed by the snapshot columns
+	};
+
+	/*
+	Binary dump layout (little-endian). The header is followed by the
+	snapshot columns in DrsSnapshot declaration order, each padded to 8 bytes:
+	profile columns, application columns, setting columns, the UTF-16 string
+	pool and the binary value pool.
+	*/
+	struct DrsDumpHeader
+	{
+		char magic[8];              // "NVDRSDMP"
+		NvU32 version;
+		NvU32 profileCount;
+		NvU32 applicationCount;
+		NvU32 settingCount;
+		NvU32 stringCount;          // UTF-16 code units in the string pool
+		NvU32 blobBytes;
+	};
+
+	#define DRS_DUMP_MAGIC          "NVDRSDMP"
+	#define DRS_DUMP_VERSION        1
+
+	// Column pointers into a binary dump held in memory, named after DrsSnapshot's tables
+	struct DrsDumpTables
+	{
+		const DrsDumpHeader *header;
+
+		const NvU32 *profileName;
+		const NvU8 *profileIsPredefined;
+		const NvU32 *profileFirstApplication;
+		const NvU32 *profileApplicationCount;
+		const NvU32 *profileFirstSetting;
+		const NvU32 *profileSettingCount;
+
+		const NvU32 *applicationProfile;
+		const NvU32 *applicationAppName;
+		const NvU32 *applicationUserFriendlyName;
+		const NvU32 *applicationLauncher;
+		const NvU32 *applicationFileInFolder;
+		const NvU8 *applicationIsPredefined;
+		const NvU8 *applicationIsMetro;
+
+		const NvU32 *settingProfile;
+		const NvU32 *settingId;
+		const NvU8 *settingType;
+		const NvU8 *settingIsPredefined;
+		const NvU32 *settingValue;
+		const NvU32 *settingLength;
+
+		const NvU16 *strings;
+		const NvU8 *blobs;
+	};
+
+	bool ParseDrsDumpFormat(const char *name, DrsDumpFormat *format);
+
+	// Locates the columns of an 8-byte aligned binary dump without copying it.
+	// Returns the dump size in bytes, or 0 if the data is not a complete dump of this version.
+	size_t MapDrsDump(const void *data, size_t size, DrsDumpTables &tables);
+
+	// Serializes the snapshot; NVAPI_ERROR if the stream could not be written
+	NvAPI_Status WriteDrsDump(const DrsSnapshot &snapshot, DrsDumpFormat format, BufferedWriter &writer);
+};
@@ -0,0 +1,702 @@
+#include "targetver.h"
+#include "DrsPlan.h"
+#include "SettingRegistry.h"
+#include "BufferedWriter.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wctype.h>
+#include <Windows.h>
+
+namespace ControlPanel
+{
+	namespace
+	{
+		std::wstring Trim(const std::wstring &text)
+		{
+			size_t first = 0;
+			while (first < text.size() && iswspace(text[first]))
+				first++;
+
+			size_t last = text.size();
+			while (last > first && iswspace(text[last - 1]))
+				last--;
+
+			return text.substr(first, last - first);
+		}
+
+		bool IsCommentOrEmpty(const std::wstring &rest)
+		{
+			std::wstring trimmed = Trim(rest);
+			return trimmed.empty() || trimmed[0] == L'#' || trimmed[0] == L';';
+		}
+
+		int HexDigit(wchar_t c)
+		{
+			if (c >= L'0' && c <= L'9') return c - L'0';
+			if (c >= L'a' && c <= L'f') return c - L'a' + 10;
+			if (c >= L'A' && c <= L'F') return c - L'A' + 10;
+			return -1;
+		}
+
+		// Decimal, or hex with a 0x prefix; a leading zero does not make it octal
+		bool ParseNumber(const std::wstring &text, NvU32 *value)
+		{
+			// wcstoul would skip leading spaces and wrap a sign into range ("-1" as 0xFFFFFFFF)
+			if (text.empty() || !iswdigit(text[0]))
+				return false;
+
+			bool hex = text.size() > 2 && text[0] == L'0' && (text[1] == L'x' || text[1] == L'X');
+			wchar_t *end = NULL;
+			errno = 0;
+			unsigned long number = wcstoul(text.c_str(), &end, hex ? 16 : 10);
+			if (*end != 0 || errno == ERANGE || number > 0xFFFFFFFFUL)
+				return false;
+
+			*value = (NvU32)number;
+			return true;
+		}
+
+		// Parses the right-hand side of a setting line; returns an error message or NULL
+		const char *ParseSettingValue(const std::wstring &text, DesiredSetting &setting)
+		{
+			setting.restoreDefault = false;
+			setting.u32Value = 0;
+
+			if (!text.empty() && text[0] == L'"')
+			{
+				std::wstring value;
+				size_t i = 1;
+				for (; i < text.size() && text[i] != L'"'; i++)
+				{
+					if (text[i] == L'\\' && i + 1 < text.size())
+						i++;
+					value += text[i];
+				}
+
+				if (i == text.size())
+					return "unterminated string";
+				if (!IsCommentOrEmpty(text.substr(i + 1)))
+					return "unexpected text after string";
+				if (value.size() >= NVAPI_UNICODE_STRING_MAX)
+					return "string value too long";
+
+				setting.settingType = NVDRS_WSTRING_TYPE;
+				setting.wszValue = value;
+				return NULL;
+			}
+
+			size_t end = 0;
+			while (end < text.size() && !iswspace(text[end]) && text[end] != L'#' && text[end] != L';')
+				end++;
+
+			std::wstring token = text.substr(0, end);
+			if (!IsCommentOrEmpty(text.substr(end)))
+				return "unexpected text after value";
+
+			if (token == L"default")
+			{
+				setting.restoreDefault = true;
+				setting.settingType = NVDRS_DWORD_TYPE;
+				return NULL;
+			}
+
+			if (token.compare(0, 6, L"bytes:") == 0)
+			{
+				std::wstring hex = token.substr(6);
+				if (hex.size() % 2 != 0 || hex.size() / 2 > NVAPI_BINARY_DATA_MAX)
+					return "binary value must be whole bytes, at most 4096";
+
+				setting.binaryValue.clear();
+				for (size_t i = 0; i < hex.size(); i += 2)
+				{
+					int high = HexDigit(hex[i]);
+					int low = HexDigit(hex[i + 1]);
+					if (high < 0 || low < 0)
+						return "invalid hex digit in binary value";
+					setting.binaryValue.push_back((NvU8)((high << 4) | low));
+				}
+
+				setting.settingType = NVDRS_BINARY_TYPE;
+				return NULL;
+			}
+
+			NvU32 value;
+			if (!ParseNumber(token, &value))
+				return "expected a number up to 0xFFFFFFFF, \"string\", bytes:HEX or default";
+
+			setting.settingType = NVDRS_DWORD_TYPE;
+			setting.u32Value = value;
+			return NULL;
+		}
+
+		// Quoted, or everything up to a trailing comment
+		bool ParseName(const std::wstring &text, std::wstring &name)
+		{
+			DesiredSetting quoted;
+			if (!text.empty() && text[0] == L'"')
+			{
+				if (ParseSettingValue(text, quoted) != NULL)
+					return false;
+				name = quoted.wszValue;
+			}
+			else
+			{
+				name = Trim(text.substr(0, text.find_first_of(L"#;")));
+			}
+
+			return !name.empty() && name.size() < NVAPI_UNICODE_STRING_MAX;
+		}
+
+		// A numeric ID, or a setting name or symbol known to the setting registry
+		bool ParseSettingId(const std::wstring &key, NvU32 *settingId)
+		{
+			if (ParseNumber(key, settingId))
+				return true;
+
+			const SettingInfo *info = FindSettingInfoByName(key.c_str());
+			if (info == NULL)
+				return false;
+
+			*settingId = info->settingId;
+			return true;
+		}
+
+		struct DesiredSettingLess
+		{
+			bool operator()(const DesiredSetting &a, const DesiredSetting &b) const { return a.settingId < b.settingId; }
+		};
+
+		struct DesiredSettingEqual
+		{
+			bool operator()(const DesiredSetting &a, const DesiredSetting &b) const { return a.settingId == b.settingId; }
+		};
+
+		// Sorted by ID with the last assignment of a repeated setting winning
+		void SortSettings(std::vector<DesiredSetting> &settings)
+		{
+			std::reverse(settings.begin(), settings.end());
+			std::stable_sort(settings.begin(), settings.end(), DesiredSettingLess());
+			settings.erase(std::unique(settings.begin(), settings.end(), DesiredSettingEqual()), settings.end());
+		}
+
+		bool SameValue(const DesiredSetting &desired, const DrsSnapshot &snapshot, NvU32 row)
+		{
+			const DrsSnapshot::SettingTable &settings = snapshot.Settings();
+			if (settings.settingType[row] != desired.settingType)
+				return false;
+
+			switch (desired.settingType)
+			{
+			case NVDRS_DWORD_TYPE:
+				return settings.value[row] == desired.u32Value;
+
+			case NVDRS_BINARY_TYPE:
+				return settings.length[row] == desired.binaryValue.size() &&
+					(desired.binaryValue.empty() || memcmp(snapshot.Blob(settings.value[row]), &desired.binaryValue[0], desired.binaryValue.size()) == 0);
+
+			default:
+				return desired.wszValue == snapshot.String(settings.value[row]);
+			}
+		}
+
+		NvU32 LiveProfile(const DesiredProfile &profile, const DrsSnapshot &snapshot)
+		{
+			return profile.name.empty() ? snapshot.BaseProfile() : snapshot.FindProfile(profile.name.c_str());
+		}
+
+		const wchar_t *DisplayName(const DesiredProfile &profile)
+		{
+			return profile.name.empty() ? L"*" : profile.name.c_str();
+		}
+
+		void PrintSettingId(NvU32 settingId)
+		{
+			const SettingInfo *info = FindSettingInfo(settingId);
+			if (info != NULL)
+				wprintf(L"0x%08X (%s)", settingId, info->name);
+			else
+				printf("0x%08X", settingId);
+		}
+
+		void PrintLiveValue(const DrsSnapshot &snapshot, NvU32 row)
+		{
+			const DrsSnapshot::SettingTable &settings = snapshot.Settings();
+			switch (settings.settingType[row])
+			{
+			case NVDRS_DWORD_TYPE:
+				printf("0x%08X", settings.value[row]);
+				break;
+
+			case NVDRS_BINARY_TYPE:
+				printf("bytes(%u)", settings.length[row]);
+				break;
+
+			default:
+				wprintf(L"\"%s\"", snapshot.String(settings.value[row]));
+				break;
+			}
+		}
+
+		void PrintDesiredValue(const DesiredSetting &setting)
+		{
+			switch (setting.settingType)
+			{
+			case NVDRS_DWORD_TYPE:
+				printf("0x%08X", setting.u32Value);
+				break;
+
+			case NVDRS_BINARY_TYPE:
+				printf("bytes(%u)", (NvU32)setting.binaryValue.size());
+				break;
+
+			default:
+				wprintf(L"\"%s\"", setting.wszValue.c_str());
+				break;
+			}
+		}
+	}
+
+	bool ReadUtf8File(const char *path, std::wstring &text)
+	{
+		FILE *file = OpenFile(path, "rb");
+		if (file == NULL)
+			return false;
+
+		std::string bytes;
+		char block[64 * 1024];
+		size_t read;
+		while ((read = fread(block, 1, sizeof(block), file)) > 0)
+			bytes.append(block, read);
+		fclose(file);
+
+		size_t start = 0;
+		if (bytes.size() >= 3 && (NvU8)bytes[0] == 0xEF && (NvU8)bytes[1] == 0xBB && (NvU8)bytes[2] == 0xBF)
+			start = 3;
+
+		text.clear();
+		if (bytes.size() == start)
+			return true;
+
+		int length = MultiByteToWideChar(CP_UTF8, 0, bytes.c_str() + start, (int)(bytes.size() - start), NULL, 0);
+		if (length <= 0)
+			return false;
+
+		text.resize(length);
+		MultiByteToWideChar(CP_UTF8, 0, bytes.c_str() + start, (int)(bytes.size() - start), &text[0], length);
+		return true;
+	}
+
+	NvAPI_Status LoadDesiredState(const char *path, DesiredState &state)
+	{
+		std::wstring text;
+		if (!ReadUtf8File(path, text))
+		{
+			printf("%s: cannot read file\n", path);
+			return NVAPI_INVALID_ARGUMENT;
+		}
+
+		state.profiles.clear();
+		size_t current = (size_t)-1;
+		std::map<std::wstring, size_t> sections;   // case-folded profile name -> index
+
+		int lineNumber = 0;
+		size_t lineStart = 0;
+		while (lineStart < text.size())
+		{
+			size_t lineEnd = text.find(L'\n', lineStart);
+			if (lineEnd == std::wstring::npos)
+				lineEnd = text.size();
+
+			std::wstring line = Trim(text.substr(lineStart, lineEnd - lineStart));
+			lineStart = lineEnd + 1;
+			lineNumber++;
+
+			if (IsCommentOrEmpty(line))
+				continue;
+
+			if (line[0] == L'[')
+			{
+				size_t close = line.find(L']');
+				if (close == std::wstring::npos || !IsCommentOrEmpty(line.substr(close + 1)))
+				{
+					printf("%s:%d: malformed profile header\n", path, lineNumber);
+					return NVAPI_INVALID_ARGUMENT;
+				}
+
+				std::wstring name = Trim(line.substr(1, close - 1));
+				if (name == L"*")
+					name.clear();
+				else if (name.empty() || name.size() >= NVAPI_UNICODE_STRING_MAX)
+				{
+					printf("%s:%d: invalid profile name\n", path, lineNumber);
+					return NVAPI_INVALID_ARGUMENT;
+				}
+
+				// Repeated sections for one profile are merged
+				std::pair<std::map<std::wstring, size_t>::iterator, bool> section =
+					sections.insert(std::make_pair(FoldCase(name.c_str()), state.profiles.size()));
+				current = section.first->second;
+				if (section.second)
+				{
+					state.profiles.push_back(DesiredProfile());
+					state.profiles[current].name = name;
+					state.profiles[current].line = lineNumber;
+				}
+				continue;
+			}
+
+			size_t equals = line.find(L'=');
+			if (equals == std::wstring::npos)
+			{
+				printf("%s:%d: expected key = value\n", path, lineNumber);
+				return NVAPI_INVALID_ARGUMENT;
+			}
+
+			if (current == (size_t)-1)
+			{
+				printf("%s:%d: entry outside of a [profile] section\n", path, lineNumber);
+				return NVAPI_INVALID_ARGUMENT;
+			}
+
+			std::wstring key = Trim(line.substr(0, equals));
+			std::wstring value = Trim(line.substr(equals + 1));
+
+			if (key == L"app" || key == L"application")
+			{
+				std::wstring name;
+				if (!ParseName(value, name))
+				{
+					printf("%s:%d: invalid application name\n", path, lineNumber);
+					return NVAPI_INVALID_ARGUMENT;
+				}
+
+				state.profiles[current].applications.push_back(name);
+				continue;
+			}
+
+			DesiredSetting setting;
+			setting.line = lineNumber;
+			if (!ParseSettingId(key, &setting.settingId))
+			{
+				printf("%s:%d: unknown setting %ls\n", path, lineNumber, key.c_str());
+				return NVAPI_INVALID_ARGUMENT;
+			}
+
+			const char *error = ParseSettingValue(value, setting);
+			if (error != NULL)
+			{
+				printf("%s:%d: %s\n", path, lineNumber, error);
+				return NVAPI_INVALID_ARGUMENT;
+			}
+
+			// Settings documented by the SDK are checked without asking the driver
+			const SettingInfo *info = FindSettingInfo(setting.settingId);
+			if (info != NULL && !setting.restoreDefault)
+			{
+				if (info->settingType != setting.settingType)
+				{
+					printf("%s:%d: %ls takes a %s value\n", path, lineNumber, info->name,
+						info->settingType == NVDRS_DWORD_TYPE ? "numeric" : "string");
+					return NVAPI_INVALID_ARGUMENT;
+				}
+
+				if (setting.settingType == NVDRS_DWORD_TYPE && !IsLegalSettingValue(*info, setting.u32Value))
+					printf("%s:%d: warning: 0x%08X is not a documented value of %ls\n", path, lineNumber, setting.u32Value, info->name);
+			}
+
+			state.profiles[current].settings.push_back(setting);
+		}
+
+		for (size_t i = 0; i < state.profiles.size(); i++)
+		{
+			DesiredProfile &profile = state.profiles[i];
+			SortSettings(profile.settings);
+
+			std::vector<std::wstring> unique;
+			for (size_t a = 0; a < profile.applications.size(); a++)
+			{
+				bool seen = false;
+				for (size_t u = 0; u < unique.size() && !seen; u++)
+					seen = FoldCase(unique[u].c_str()) == FoldCase(profile.applications[a].c_str());
+				if (!seen)
+					unique.push_back(profile.applications[a]);
+			}
+			profile.applications.swap(unique);
+		}
+
+		return NVAPI_OK;
+	}
+
+	void BuildDrsPlan(const DesiredState &state, const DrsSnapshot &snapshot, DrsPlan &plan, bool createProfiles)
+	{
+		plan.changes.clear();
+		plan.unchangedSettings = 0;
+		plan.unchangedApplications = 0;
+		plan.createdProfiles = 0;
+		plan.missingProfiles = 0;
+		plan.conflicts = 0;
+
+		const DrsSnapshot::ProfileTable &profiles = snapshot.Profiles();
+		const DrsSnapshot::ApplicationTable &applications = snapshot.Applications();
+		const DrsSnapshot::SettingTable &settings = snapshot.Settings();
+		std::vector<NvU32> matches;
+		std::map<std::wstring, NvU32> claimed;     // case-folded executable -> desired profile
+
+		for (NvU32 p = 0; p < (NvU32)state.profiles.size(); p++)
+		{
+			const DesiredProfile &desired = state.profiles[p];
+
+			NvU32 live = LiveProfile(desired, snapshot);
+			if (live == DrsSnapshot::npos)
+			{
+				if (!createProfiles || desired.name.empty())
+				{
+					DrsChange change = { DRS_CHANGE_MISSING_PROFILE, p, 0, DrsSnapshot::npos };
+					plan.changes.push_back(change);
+					plan.missingProfiles++;
+					continue;
+				}
+
+				DrsChange change = { DRS_CHANGE_CREATE_PROFILE, p, 0, DrsSnapshot::npos };
+				plan.changes.push_back(change);
+				plan.createdProfiles++;
+			}
+
+			for (NvU32 a = 0; a < (NvU32)desired.applications.size(); a++)
+			{
+				const std::wstring &appName = desired.applications[a];
+				std::pair<std::map<std::wstring, NvU32>::iterator, bool> claim = claimed.insert(std::make_pair(FoldCase(appName.c_str()), p));
+				if (!claim.second)
+				{
+					// Listed twice under this profile: the first entry already covers it
+					if (claim.first->second == p)
+						continue;
+
+					DrsChange change = { DRS_CHANGE_APPLICATION_CONFLICT, p, a, DrsSnapshot::npos };
+					plan.changes.push_back(change);
+					plan.conflicts++;
+					continue;
+				}
+
+				snapshot.FindApplications(appName.c_str(), matches);
+
+				// The driver refuses a plain executable that another profile already has
+				bool present = false;
+				NvU32 owner = DrsSnapshot::npos;
+				for (size_t m = 0; m < matches.size() && !present; m++)
+				{
+					present = applications.profile[matches[m]] == live;
+					if (!present && *snapshot.String(applications.fileInFolder[matches[m]]) == 0)
+						owner = matches[m];
+				}
+
+				if (present)
+				{
+					plan.unchangedApplications++;
+				}
+				else if (owner != DrsSnapshot::npos)
+				{
+					DrsChange change = { DRS_CHANGE_APPLICATION_CONFLICT, p, a, owner };
+					plan.changes.push_back(change);
+					plan.conflicts++;
+				}
+				else
+				{
+					DrsChange change = { DRS_CHANGE_ADD_APPLICATION, p, a, DrsSnapshot::npos };
+					plan.changes.push_back(change);
+				}
+			}
+
+			// A new profile gets every value; "default" is what it starts with
+			if (live == DrsSnapshot::npos)
+			{
+				for (NvU32 s = 0; s < (NvU32)desired.settings.size(); s++)
+				{
+					if (desired.settings[s].restoreDefault)
+					{
+						plan.unchangedSettings++;
+					}
+					else
+					{
+						DrsChange change = { DRS_CHANGE_SET_SETTING, p, s, DrsSnapshot::npos };
+						plan.changes.push_back(change);
+					}
+				}
+				continue;
+			}
+
+			// Both sides are sorted by setting ID: one merge pass per profile
+			NvU32 row = profiles.firstSetting[live];
+			NvU32 rowEnd = row + profiles.settingCount[live];
+			for (NvU32 s = 0; s < (NvU32)desired.settings.size(); s++)
+			{
+				const DesiredSetting &setting = desired.settings[s];
+				while (row < rowEnd && settings.settingId[row] < setting.settingId)
+					row++;
+
+				NvU32 liveRow = DrsSnapshot::npos;
+				if (row < rowEnd && settings.settingId[row] == setting.settingId)
+					liveRow = row;
+
+				if (setting.restoreDefault)
+				{
+					if (liveRow != DrsSnapshot::npos && !settings.isPredefined[liveRow])
+					{
+						DrsChange change = { DRS_CHANGE_RESTORE_SETTING, p, s, liveRow };
+						plan.changes.push_back(change);
+					}
+					else
+					{
+						plan.unchangedSettings++;
+					}
+				}
+				else if (liveRow != DrsSnapshot::npos && SameValue(setting, snapshot, liveRow))
+				{
+					plan.unchangedSettings++;
+				}
+				else
+				{
+					DrsChange change = { DRS_CHANGE_SET_SETTING, p, s, liveRow };
+					plan.changes.push_back(change);
+				}
+			}
+		}
+	}
+
+	void PrintDrsPlan(const DesiredState &state, const DrsSnapshot &snapshot, const DrsPlan &plan)
+	{
+		for (size_t i = 0; i < plan.changes.size(); i++)
+		{
+			const DrsChange &change = plan.changes[i];
+			const DesiredProfile &profile = state.profiles[change.desiredProfile];
+
+			wprintf(L"[%s] ", DisplayName(profile));
+			switch (change.type)
+			{
+			case DRS_CHANGE_MISSING_PROFILE:
+				printf("! profile not found\n");
+				break;
+
+			case DRS_CHANGE_CREATE_PROFILE:
+				printf("+ profile\n");
+				break;
+
+			case DRS_CHANGE_APPLICATION_CONFLICT:
+				if (change.liveRow != DrsSnapshot::npos)
+				{
+					wprintf(L"! app %s belongs to [%s]\n", profile.applications[change.desiredSetting].c_str(),
+						snapshot.String(snapshot.Profiles().name[snapshot.Applications().profile[change.liveRow]]));
+				}
+				else
+				{
+					wprintf(L"! app %s is listed under another profile\n", profile.applications[change.desiredSetting].c_str());
+				}
+				break;
+
+			case DRS_CHANGE_ADD_APPLICATION:
+				wprintf(L"+ app %s\n", profile.applications[change.desiredSetting].c_str());
+				break;
+
+			case DRS_CHANGE_RESTORE_SETTING:
+				printf("- ");
+				PrintSettingId(profile.settings[change.desiredSetting].settingId);
+				printf(": ");
+				PrintLiveValue(snapshot, change.liveRow);
+				printf(" -> default\n");
+				break;
+
+			case DRS_CHANGE_SET_SETTING:
+				if (change.liveRow == DrsSnapshot::npos)
+				{
+					printf("+ ");
+					PrintSettingId(profile.settings[change.desiredSetting].settingId);
+					printf(" = ");
+				}
+				else
+				{
+					printf("~ ");
+					PrintSettingId(profile.settings[change.desiredSetting].settingId);
+					printf(": ");
+					PrintLiveValue(snapshot, change.liveRow);
+					printf(" -> ");
+				}
+				PrintDesiredValue(profile.settings[change.desiredSetting]);
+				printf("\n");
+				break;
+			}
+		}
+
+		printf("Plan: %u to change, %u settings and %u applications unchanged",
+			(NvU32)plan.changes.size() - plan.missingProfiles - plan.conflicts, plan.unchangedSettings, plan.unchangedApplications);
+		if (plan.createdProfiles)
+			printf(", %u profiles to create", plan.createdProfiles);
+		if (plan.missingProfiles)
+			printf(", %u profiles not found", plan.missingProfiles);
+		if (plan.conflicts)
+			printf(", %u applications owned by other profiles", plan.conflicts);
+		printf("\n");
+	}
+
+	NvAPI_Status ApplyDrsPlan(const DesiredState &state, const DrsPlan &plan, DrsSession &session)
+	{
+		if (plan.missingProfiles > 0)
+			return NVAPI_PROFILE_NOT_FOUND;
+		if (plan.conflicts > 0)
+			return NVAPI_EXECUTABLE_ALREADY_IN_USE;
+
+		session.Rollback();
+		for (size_t i = 0; i < plan.changes.size(); i++)
+		{
+			const DrsChange &change = plan.changes[i];
+			const DesiredProfile &profile = state.profiles[change.desiredProfile];
+			const wchar_t *profileName = profile.name.c_str();
+
+			switch (change.type)
+			{
+			case DRS_CHANGE_CREATE_PROFILE:
+				session.StageCreateProfile(profileName);
+				break;
+
+			case DRS_CHANGE_ADD_APPLICATION:
+				session.StageCreateApplication(profileName, profile.applications[change.desiredSetting].c_str());
+				break;
+
+			case DRS_CHANGE_RESTORE_SETTING:
+				session.StageRestoreSetting(profileName, profile.settings[change.desiredSetting].settingId);
+				break;
+
+			case DRS_CHANGE_SET_SETTING:
+			{
+				const DesiredSetting &setting = profile.settings[change.desiredSetting];
+				switch (setting.settingType)
+				{
+				case NVDRS_DWORD_TYPE:
+					session.StageSetDword(profileName, setting.settingId, setting.u32Value);
+					break;
+
+				case NVDRS_BINARY_TYPE:
+					session.StageSetBinary(profileName, setting.settingId,
+						setting.binaryValue.empty() ? NULL : &setting.binaryValue[0], (NvU32)setting.binaryValue.size());
+					break;
+
+				default:
+					session.StageSetString(profileName, setting.settingId, setting.wszValue.c_str());
+					break;
+				}
+				break;
+			}
+
+			default:
+				break;
+			}
+		}
+
+		// Commit() returns without loading or saving when nothing was staged
+		return session.Commit();
+	}
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "nvapi.h"
+#include "DrsSession.h"
+#include "DrsSnapshot.h"
+
+#include <string>
+#include <vector>
+
+namespace ControlPanel
+{
+	/*
+	Desired-state file, UTF-8 text:
+
+		# comment
+		[Profile name]              ; [*] is the base profile
+		app = game.exe              ; application that must belong to the profile
+		0x1057EB71 = 0x00000000     ; DWORD setting (hex or decimal)
+		0x10A879CF = "text"         ; string setting
+		0x10A879AC = bytes:0A0B0C   ; binary setting
+		0x20FF7493 = default        ; drop the user value, back to the predefined one
+		Vertical Sync = 0x47814940  ; settings known to SettingRegistry.h also by name or SDK symbol
+
+	Only what is listed is managed; anything else in the database is left alone.
+	The same file is a provisioning manifest: --provision creates the profiles
+	that do not exist yet and converges the others in place.
+	*/
+	struct DesiredSetting
+	{
+		NvU32 settingId;
+		NVDRS_SETTING_TYPE settingType;
+		bool restoreDefault;
+		NvU32 u32Value;
+		std::wstring wszValue;
+		std::vector<NvU8> binaryValue;
+		int line;
+	};
+
+	struct DesiredProfile
+	{
+		std::wstring name;                      // empty for the base profile
+		std::vector<std::wstring> applications;
+		std::vector<DesiredSetting> settings;   // sorted by settingId, unique
+		int line;
+	};
+
+	struct DesiredState
+	{
+		std::vector<DesiredProfile> profiles;
+	};
+
+	// Whole UTF-8 file, byte order mark dropped
+	bool ReadUtf8File(const char *path, std::wstring &text);
+
+	// Prints "path:line: message" and returns NVAPI_INVALID_ARGUMENT on a syntax error
+	NvAPI_Status LoadDesiredState(const char *path, DesiredState &state);
+
+	enum DrsChangeType
+	{
+		DRS_CHANGE_SET_SETTING,
+		DRS_CHANGE_RESTORE_SETTING,
+		DRS_CHANGE_ADD_APPLICATION,
+		DRS_CHANGE_CREATE_PROFILE,
+		DRS_CHANGE_MISSING_PROFILE,
+		DRS_CHANGE_APPLICATION_CONFLICT
+	};
+
+	struct DrsChange
+	{
+		DrsChangeType type;
+		NvU32 desiredProfile;       // index into DesiredState::profiles
+		NvU32 desiredSetting;       // index into DesiredProfile::settings / applications
+		NvU32 liveRow;              // current snapshot row (setting, or application holding a conflicting executable), or DrsSnapshot::npos
+	};
+
+	struct DrsPlan
+	{
+		std::vector<DrsChange> changes;
+		NvU32 unchangedSettings;
+		NvU32 unchangedApplications;
+		NvU32 createdProfiles;
+		NvU32 missingProfiles;
+		NvU32 conflicts;            // executables already owned by another profile; the plan cannot be applied
+	};
+
+	// Sort-merges each desired profile's settings against its snapshot rows.
+	// With createProfiles, a profile missing from the snapshot is planned as
+	// created with all of its applications and settings instead of reported.
+	void BuildDrsPlan(const DesiredState &state, const DrsSnapshot &snapshot, DrsPlan &plan, bool createProfiles = false);
+	void PrintDrsPlan(const DesiredState &state, const DrsSnapshot &snapshot, const DrsPlan &plan);
+
+	// Stages only the changed rows and commits them at once, profiles being created
+	// before anything that refers to them; no-op plans do not touch the driver
+	NvAPI_Status ApplyDrsPlan(const DesiredState &state, const DrsPlan &plan, DrsSession &session);
+};
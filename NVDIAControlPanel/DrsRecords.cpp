@@ -0,0 +1,136 @@
+#include "targetver.h"
+#include "DrsRecords.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace ControlPanel
+{
+	DrsScratchArena::DrsScratchArena()
+		: buffer(NULL)
+		, capacity(0)
+	{
+	}
+
+	DrsScratchArena::~DrsScratchArena()
+	{
+		free(buffer);
+	}
+
+	void *DrsScratchArena::Reserve(size_t bytes)
+	{
+		if (bytes > capacity)
+		{
+			// Old contents are never needed, so free instead of realloc to avoid a copy
+			free(buffer);
+			buffer = malloc(bytes);
+			capacity = buffer ? bytes : 0;
+		}
+
+		return buffer;
+	}
+
+	NVDRS_APPLICATION *DrsScratchArena::Applications(NvU32 count)
+	{
+		NVDRS_APPLICATION *apps = (NVDRS_APPLICATION *)Reserve(count * sizeof(NVDRS_APPLICATION));
+		if (apps == NULL)
+			return NULL;
+
+		for (NvU32 i = 0; i < count; i++)
+			apps[i].version = NVDRS_APPLICATION_VER;
+
+		return apps;
+	}
+
+	NVDRS_SETTING *DrsScratchArena::Settings(NvU32 count)
+	{
+		NVDRS_SETTING *settings = (NVDRS_SETTING *)Reserve(count * sizeof(NVDRS_SETTING));
+		if (settings == NULL)
+			return NULL;
+
+		for (NvU32 i = 0; i < count; i++)
+			settings[i].version = NVDRS_SETTING_VER;
+
+		return settings;
+	}
+
+	NvU32 DrsSettingRecord::Dword() const
+	{
+		NvU32 value = 0;
+		memcpy(&value, Value(), valueLength < sizeof(value) ? valueLength : sizeof(value));
+		return value;
+	}
+
+	NvU32 DrsSettingRecord::Size() const
+	{
+		NvU32 size = sizeof(DrsSettingRecord) + nameLength * sizeof(NvU16) + valueLength;
+		return (size + 3) & ~3u;
+	}
+
+	void DrsRecordBuffer::Append(const NVDRS_SETTING &setting)
+	{
+		NvU32 nameLength = 0;
+		while (nameLength < NVAPI_UNICODE_STRING_MAX && setting.settingName[nameLength] != 0)
+			nameLength++;
+
+		const NvU8 *value;
+		NvU32 valueLength;
+		switch (setting.settingType)
+		{
+		case NVDRS_DWORD_TYPE:
+			value = (const NvU8 *)&setting.u32CurrentValue;
+			valueLength = sizeof(NvU32);
+			break;
+
+		case NVDRS_BINARY_TYPE:
+			value = setting.binaryCurrentValue.valueData;
+			valueLength = setting.binaryCurrentValue.valueLength;
+			if (valueLength > NVAPI_BINARY_DATA_MAX)
+				valueLength = NVAPI_BINARY_DATA_MAX;
+			break;
+
+		default:
+			value = (const NvU8 *)setting.wszCurrentValue;
+			valueLength = 0;
+			while (valueLength < NVAPI_UNICODE_STRING_MAX - 1 && setting.wszCurrentValue[valueLength] != 0)
+				valueLength++;
+			// Keep the terminator so the value can be printed in place
+			valueLength = (valueLength + 1) * sizeof(NvU16);
+			break;
+		}
+
+		DrsSettingRecord header;
+		header.settingId = setting.settingId;
+		header.settingType = (NvU8)setting.settingType;
+		header.flags = 0;
+		if (setting.isCurrentPredefined)
+			header.flags |= DRS_RECORD_PREDEFINED;
+		if (setting.settingLocation == NVDRS_CURRENT_PROFILE_LOCATION)
+			header.flags |= DRS_RECORD_CURRENT_PROFILE;
+		header.nameLength = (NvU16)nameLength;
+		header.valueLength = valueLength;
+
+		size_t offset = data.size();
+		data.resize(offset + header.Size(), 0);
+
+		NvU8 *out = &data[offset];
+		memcpy(out, &header, sizeof(header));
+		out += sizeof(header);
+		memcpy(out, setting.settingName, nameLength * sizeof(NvU16));
+		out += nameLength * sizeof(NvU16);
+		memcpy(out, value, valueLength);
+
+		count++;
+	}
+
+	const DrsSettingRecord *DrsRecordBuffer::First() const
+	{
+		return data.empty() ? NULL : (const DrsSettingRecord *)&data[0];
+	}
+
+	const DrsSettingRecord *DrsRecordBuffer::Next(const DrsSettingRecord *record) const
+	{
+		const NvU8 *next = (const NvU8 *)record + record->Size();
+		return next < &data[0] + data.size() ? (const DrsSettingRecord *)next : NULL;
+	}
+};
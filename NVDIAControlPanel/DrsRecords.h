@@ -0,0 +1,80 @@
+#pragma once
+
+#include "nvapi.h"
+
+#include <vector>
+
+namespace ControlPanel
+{
+	/*
+	Reusable buffer for the NvAPI_DRS_Enum* output arrays. It grows to the
+	largest request seen and is never shrunk, so enumerating thousands of
+	profiles costs a handful of allocations. Applications() and Settings()
+	hand out the same memory: a returned array is valid until the next call.
+	*/
+	class DrsScratchArena
+	{
+	public:
+		DrsScratchArena();
+		~DrsScratchArena();
+
+		NVDRS_APPLICATION *Applications(NvU32 count);
+		NVDRS_SETTING *Settings(NvU32 count);
+
+		size_t Capacity() const { return capacity; }
+
+	private:
+		DrsScratchArena(const DrsScratchArena &);
+		DrsScratchArena &operator=(const DrsScratchArena &);
+
+		void *Reserve(size_t bytes);
+
+		void *buffer;
+		size_t capacity;
+	};
+
+	/*
+	Variable-length setting record: a fixed header followed by the setting
+	name and the value, each holding only the bytes actually used. Records
+	are 4-byte aligned and stored back to back in a DrsRecordBuffer.
+	*/
+	struct DrsSettingRecord
+	{
+		NvU32 settingId;
+		NvU8 settingType;           // NVDRS_SETTING_TYPE
+		NvU8 flags;                 // DRS_RECORD_* bits
+		NvU16 nameLength;           // characters, no terminator
+		NvU32 valueLength;          // bytes; DWORD values use 4
+
+		const NvU16 *Name() const { return (const NvU16 *)(this + 1); }
+		const NvU8 *Value() const { return (const NvU8 *)(Name() + nameLength); }
+		NvU32 Dword() const;
+		NvU32 Size() const;
+	};
+
+	enum
+	{
+		DRS_RECORD_PREDEFINED = 0x01,   // isCurrentPredefined
+		DRS_RECORD_CURRENT_PROFILE = 0x02,  // settingLocation == NVDRS_CURRENT_PROFILE_LOCATION
+	};
+
+	class DrsRecordBuffer
+	{
+	public:
+		DrsRecordBuffer() : count(0) {}
+
+		void Clear() { data.clear(); count = 0; }
+		void Append(const NVDRS_SETTING &setting);
+
+		NvU32 Count() const { return count; }
+		size_t Bytes() const { return data.size(); }
+
+		// Iteration: First() returns NULL for an empty buffer, Next() NULL past the last record
+		const DrsSettingRecord *First() const;
+		const DrsSettingRecord *Next(const DrsSettingRecord *record) const;
+
+	private:
+		std::vector<NvU8> data;
+		NvU32 count;
+	};
+};
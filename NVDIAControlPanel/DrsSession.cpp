@@ -0,0 +1,297 @@
+#include "targetver.h"
+#include "DrsSession.h"
+
+#include <string.h>
+
+namespace ControlPanel
+{
+	void CopyUnicodeString(NvAPI_UnicodeString dst, const wchar_t *src)
+	{
+		NvU32 i = 0;
+		if (src != NULL)
+		{
+			for (; i < NVAPI_UNICODE_STRING_MAX - 1 && src[i] != 0; i++)
+				dst[i] = (NvU16)src[i];
+		}
+		dst[i] = 0;
+	}
+
+	DrsSession::DrsSession()
+		: session(NULL)
+		, loaded(false)
+		, scratchSetting(NULL)
+		, scratchApplication(NULL)
+		, scratchProfile(NULL)
+	{
+	}
+
+	DrsSession::~DrsSession()
+	{
+		Close();
+		delete scratchSetting;
+		delete scratchApplication;
+		delete scratchProfile;
+	}
+
+	NvAPI_Status DrsSession::Open()
+	{
+		if (session != NULL)
+			return NVAPI_OK;
+
+		return Drs().CreateSession(&session);
+	}
+
+	NvAPI_Status DrsSession::Load()
+	{
+		NvAPI_Status status = Open();
+		if (status != NVAPI_OK)
+			return status;
+
+		// Profile handles do not survive a reload
+		profileCache.clear();
+		loaded = false;
+
+		status = Drs().LoadSettings(session);
+		if (status != NVAPI_OK)
+			return status;
+
+		loaded = true;
+		return NVAPI_OK;
+	}
+
+	void DrsSession::Close()
+	{
+		if (session != NULL)
+		{
+			Drs().DestroySession(session);
+			session = NULL;
+		}
+
+		loaded = false;
+		profileCache.clear();
+	}
+
+	NvAPI_Status DrsSession::FindProfile(const wchar_t *profileName, NvDRSProfileHandle *profile)
+	{
+		std::wstring key = profileName ? profileName : L"";
+
+		std::map<std::wstring, NvDRSProfileHandle>::const_iterator it = profileCache.find(key);
+		if (it != profileCache.end())
+		{
+			*profile = it->second;
+			return NVAPI_OK;
+		}
+
+		NvAPI_Status status;
+		if (key.empty())
+		{
+			status = Drs().GetBaseProfile(session, profile);
+		}
+		else
+		{
+			NvAPI_UnicodeString name;
+			CopyUnicodeString(name, key.c_str());
+			status = Drs().FindProfileByName(session, name, profile);
+		}
+
+		if (status == NVAPI_OK)
+			profileCache[key] = *profile;
+
+		return status;
+	}
+
+	DrsSession::Operation &DrsSession::Stage(OperationType type, const wchar_t *profileName, NvU32 settingId)
+	{
+		pending.push_back(Operation());
+
+		Operation &op = pending.back();
+		op.type = type;
+		op.profileName = profileName ? profileName : L"";
+		op.settingId = settingId;
+		op.settingType = NVDRS_DWORD_TYPE;
+		op.u32Value = 0;
+		return op;
+	}
+
+	void DrsSession::StageSetDword(const wchar_t *profileName, NvU32 settingId, NvU32 value)
+	{
+		Operation &op = Stage(OP_SET_SETTING, profileName, settingId);
+		op.settingType = NVDRS_DWORD_TYPE;
+		op.u32Value = value;
+	}
+
+	void DrsSession::StageSetString(const wchar_t *profileName, NvU32 settingId, const wchar_t *value)
+	{
+		Operation &op = Stage(OP_SET_SETTING, profileName, settingId);
+		op.settingType = NVDRS_WSTRING_TYPE;
+		op.wszValue = value ? value : L"";
+	}
+
+	void DrsSession::StageSetBinary(const wchar_t *profileName, NvU32 settingId, const NvU8 *data, NvU32 length)
+	{
+		if (length > NVAPI_BINARY_DATA_MAX)
+			length = NVAPI_BINARY_DATA_MAX;
+
+		Operation &op = Stage(OP_SET_SETTING, profileName, settingId);
+		op.settingType = NVDRS_BINARY_TYPE;
+		op.binaryValue.assign(data, data + length);
+	}
+
+	void DrsSession::StageDeleteSetting(const wchar_t *profileName, NvU32 settingId)
+	{
+		Stage(OP_DELETE_SETTING, profileName, settingId);
+	}
+
+	void DrsSession::StageRestoreSetting(const wchar_t *profileName, NvU32 settingId)
+	{
+		Stage(OP_RESTORE_SETTING, profileName, settingId);
+	}
+
+	void DrsSession::StageRestoreProfile(const wchar_t *profileName)
+	{
+		Stage(OP_RESTORE_PROFILE, profileName, 0);
+	}
+
+	void DrsSession::StageRestoreAll()
+	{
+		Stage(OP_RESTORE_ALL, NULL, 0);
+	}
+
+	void DrsSession::StageCreateApplication(const wchar_t *profileName, const wchar_t *appName)
+	{
+		Operation &op = Stage(OP_CREATE_APPLICATION, profileName, 0);
+		op.wszValue = appName ? appName : L"";
+	}
+
+	void DrsSession::StageCreateProfile(const wchar_t *profileName)
+	{
+		Stage(OP_CREATE_PROFILE, profileName, 0);
+	}
+
+	void DrsSession::StageDeleteProfile(const wchar_t *profileName)
+	{
+		Stage(OP_DELETE_PROFILE, profileName, 0);
+	}
+
+	void DrsSession::Rollback()
+	{
+		pending.clear();
+	}
+
+	NvAPI_Status DrsSession::Apply(const Operation &op)
+	{
+		if (op.type == OP_RESTORE_ALL)
+		{
+			// Invalidates every profile handle resolved so far
+			profileCache.clear();
+			return Drs().RestoreAllDefaults(session);
+		}
+
+		if (op.type == OP_CREATE_PROFILE)
+		{
+			if (scratchProfile == NULL)
+				scratchProfile = new NVDRS_PROFILE;
+
+			memset(scratchProfile, 0, sizeof(NVDRS_PROFILE));
+			scratchProfile->version = NVDRS_PROFILE_VER;
+			CopyUnicodeString(scratchProfile->profileName, op.profileName.c_str());
+
+			NvDRSProfileHandle created = NULL;
+			NvAPI_Status status = Drs().CreateProfile(session, scratchProfile, &created);
+			if (status == NVAPI_OK)
+				profileCache[op.profileName] = created;
+			return status;
+		}
+
+		NvDRSProfileHandle profile = NULL;
+		NvAPI_Status status = FindProfile(op.profileName.c_str(), &profile);
+		if (status != NVAPI_OK)
+			return status;
+
+		switch (op.type)
+		{
+		case OP_SET_SETTING:
+			if (scratchSetting == NULL)
+				scratchSetting = new NVDRS_SETTING;
+
+			memset(scratchSetting, 0, sizeof(NVDRS_SETTING));
+			scratchSetting->version = NVDRS_SETTING_VER;
+			scratchSetting->settingId = op.settingId;
+			scratchSetting->settingType = op.settingType;
+
+			switch (op.settingType)
+			{
+			case NVDRS_DWORD_TYPE:
+				scratchSetting->u32CurrentValue = op.u32Value;
+				break;
+
+			case NVDRS_BINARY_TYPE:
+				scratchSetting->binaryCurrentValue.valueLength = (NvU32)op.binaryValue.size();
+				if (!op.binaryValue.empty())
+					memcpy(scratchSetting->binaryCurrentValue.valueData, &op.binaryValue[0], op.binaryValue.size());
+				break;
+
+			default:
+				CopyUnicodeString(scratchSetting->wszCurrentValue, op.wszValue.c_str());
+				break;
+			}
+
+			return Drs().SetSetting(session, profile, scratchSetting);
+
+		case OP_DELETE_SETTING:
+			return Drs().DeleteProfileSetting(session, profile, op.settingId);
+
+		case OP_RESTORE_SETTING:
+			return Drs().RestoreProfileDefaultSetting(session, profile, op.settingId);
+
+		case OP_RESTORE_PROFILE:
+			return Drs().RestoreProfileDefault(session, profile);
+
+		case OP_DELETE_PROFILE:
+			profileCache.erase(op.profileName);
+			return Drs().DeleteProfile(session, profile);
+
+		case OP_CREATE_APPLICATION:
+			if (scratchApplication == NULL)
+				scratchApplication = new NVDRS_APPLICATION;
+
+			memset(scratchApplication, 0, sizeof(NVDRS_APPLICATION));
+			scratchApplication->version = NVDRS_APPLICATION_VER;
+			CopyUnicodeString(scratchApplication->appName, op.wszValue.c_str());
+			return Drs().CreateApplication(session, profile, scratchApplication);
+
+		default:
+			return NVAPI_INVALID_ARGUMENT;
+		}
+	}
+
+	NvAPI_Status DrsSession::Commit()
+	{
+		if (pending.empty())
+			return NVAPI_OK;
+
+		NvAPI_Status status = Load();
+		if (status != NVAPI_OK)
+			return status;
+
+		for (size_t i = 0; i < pending.size(); i++)
+		{
+			status = Apply(pending[i]);
+			if (status != NVAPI_OK)
+			{
+				// The in-memory database is now partially modified; drop it so the
+				// next reader reloads what is actually stored
+				loaded = false;
+				profileCache.clear();
+				return status;
+			}
+		}
+
+		status = Drs().SaveSettings(session);
+		if (status != NVAPI_OK)
+			return status;
+
+		pending.clear();
+		return NVAPI_OK;
+	}
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "nvapi.h"
+#include "DrsBackend.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ControlPanel
+{
+	/*
+	Owns one DRS session handle for its whole lifetime and stages setting
+	changes so that any number of them reach the driver database with a
+	single NvAPI_DRS_LoadSettings and a single NvAPI_DRS_SaveSettings.
+	Profiles are addressed by name; a NULL or empty name means the base profile.
+	*/
+	class DrsSession
+	{
+	public:
+		DrsSession();
+		~DrsSession();
+
+		NvAPI_Status Open();
+		NvAPI_Status Load();
+		void Close();
+
+		bool IsOpen() const { return session != NULL; }
+		bool IsLoaded() const { return loaded; }
+		NvDRSSessionHandle Handle() const { return session; }
+
+		// Resolves a profile of the loaded settings by name (NULL/empty = base profile)
+		NvAPI_Status FindProfile(const wchar_t *profileName, NvDRSProfileHandle *profile);
+
+		void StageSetDword(const wchar_t *profileName, NvU32 settingId, NvU32 value);
+		void StageSetString(const wchar_t *profileName, NvU32 settingId, const wchar_t *value);
+		void StageSetBinary(const wchar_t *profileName, NvU32 settingId, const NvU8 *data, NvU32 length);
+		void StageDeleteSetting(const wchar_t *profileName, NvU32 settingId);
+		void StageRestoreSetting(const wchar_t *profileName, NvU32 settingId);
+		void StageRestoreProfile(const wchar_t *profileName);
+		void StageRestoreAll();
+		void StageCreateApplication(const wchar_t *profileName, const wchar_t *appName);
+
+		// Operations staged after these can address the profile by name
+		void StageCreateProfile(const wchar_t *profileName);
+		void StageDeleteProfile(const wchar_t *profileName);
+
+		size_t PendingCount() const { return pending.size(); }
+		void Rollback();
+
+		// Reloads the database, applies every staged operation in order and saves once.
+		// Nothing is written when no operation is pending.
+		NvAPI_Status Commit();
+
+	private:
+		enum OperationType
+		{
+			OP_SET_SETTING,
+			OP_DELETE_SETTING,
+			OP_RESTORE_SETTING,
+			OP_RESTORE_PROFILE,
+			OP_RESTORE_ALL,
+			OP_CREATE_APPLICATION,
+			OP_CREATE_PROFILE,
+			OP_DELETE_PROFILE
+		};
+
+		struct Operation
+		{
+			OperationType type;
+			std::wstring profileName;
+			NvU32 settingId;
+			NVDRS_SETTING_TYPE settingType;
+			NvU32 u32Value;
+			std::wstring wszValue;          // string value, or application name
+			std::vector<NvU8> binaryValue;
+		};
+
+		DrsSession(const DrsSession &);
+		DrsSession &operator=(const DrsSession &);
+
+		Operation &Stage(OperationType type, const wchar_t *profileName, NvU32 settingId);
+		NvAPI_Status Apply(const Operation &op);
+
+		NvDRSSessionHandle session;
+		bool loaded;
+		std::vector<Operation> pending;
+		std::map<std::wstring, NvDRSProfileHandle> profileCache;
+		NVDRS_SETTING *scratchSetting;
+		NVDRS_APPLICATION *scratchApplication;
+		NVDRS_PROFILE *scratchProfile;
+	};
+
+	// Copies a wide string into a fixed NVAPI unicode buffer, truncating if needed
+	void CopyUnicodeString(NvAPI_UnicodeString dst, const wchar_t *src);
+};
@@ -0,0 +1,289 @@
+#include "targetver.h"
+#include "DrsSnapshot.h"
+#include "DrsRecords.h"
+
+#include <algorithm>
+#include <string.h>
+#include <wctype.h>
+
+namespace ControlPanel
+{
+	std::wstring FoldCase(const wchar_t *value)
+	{
+		std::wstring folded = value ? value : L"";
+		for (size_t i = 0; i < folded.size(); i++)
+			folded[i] = (wchar_t)towlower(folded[i]);
+		return folded;
+	}
+
+	namespace
+	{
+		struct SettingIdLess
+		{
+			const NVDRS_SETTING *settings;
+			bool operator()(NvU32 a, NvU32 b) const { return settings[a].settingId < settings[b].settingId; }
+		};
+
+		struct SettingRowLess
+		{
+			const DrsSnapshot::SettingTable *table;
+			bool operator()(NvU32 a, NvU32 b) const
+			{
+				if (table->settingId[a] != table->settingId[b])
+					return table->settingId[a] < table->settingId[b];
+				return table->profile[a] < table->profile[b];
+			}
+		};
+	}
+
+	DrsSnapshot::DrsSnapshot()
+		: baseProfile(npos)
+	{
+	}
+
+	void DrsSnapshot::Clear()
+	{
+		baseProfile = npos;
+		profiles = ProfileTable();
+		applications = ApplicationTable();
+		settings = SettingTable();
+		strings.clear();
+		blobs.clear();
+		profileIndex.clear();
+		applicationIndex.clear();
+		settingIndex.clear();
+		settingOrder.clear();
+	}
+
+	NvU32 DrsSnapshot::AddString(const NvU16 *value)
+	{
+		NvU32 offset = (NvU32)strings.size();
+		for (NvU32 i = 0; i < NVAPI_UNICODE_STRING_MAX && value[i] != 0; i++)
+			strings.push_back((wchar_t)value[i]);
+		strings.push_back(0);
+		return offset;
+	}
+
+	NvU32 DrsSnapshot::AddBlob(const NvU8 *data, NvU32 length)
+	{
+		NvU32 offset = (NvU32)blobs.size();
+		blobs.insert(blobs.end(), data, data + length);
+		return offset;
+	}
+
+	NvAPI_Status DrsSnapshot::Load(DrsSession &session)
+	{
+		NvAPI_Status status;
+
+		Clear();
+
+		if (!session.IsLoaded())
+		{
+			status = session.Load();
+			if (status != NVAPI_OK)
+				return status;
+		}
+
+		NvU32 numProfiles = 0;
+		if (Drs().GetNumProfiles(session.Handle(), &numProfiles) == NVAPI_OK)
+		{
+			profiles.name.reserve(numProfiles);
+			profiles.isPredefined.reserve(numProfiles);
+			profiles.firstApplication.reserve(numProfiles);
+			profiles.applicationCount.reserve(numProfiles);
+			profiles.firstSetting.reserve(numProfiles);
+			profiles.settingCount.reserve(numProfiles);
+			profiles.handle.reserve(numProfiles);
+		}
+
+		NvDRSProfileHandle base = NULL;
+		Drs().GetBaseProfile(session.Handle(), &base);
+
+		DrsScratchArena scratch;
+		std::vector<NvU32> order;
+
+		NvDRSProfileHandle profile = NULL;
+		NvU32 profileIdx = 0;
+		while ((status = Drs().EnumProfiles(session.Handle(), profileIdx, &profile)) == NVAPI_OK)
+		{
+			NVDRS_PROFILE profileInfo = { 0 };
+			profileInfo.version = NVDRS_PROFILE_VER;
+			status = Drs().GetProfileInfo(session.Handle(), profile, &profileInfo);
+			if (status != NVAPI_OK)
+				return status;
+
+			profiles.name.push_back(AddString(profileInfo.profileName));
+			profiles.isPredefined.push_back(profileInfo.isPredefined ? 1 : 0);
+			profiles.handle.push_back(profile);
+			if (profile == base)
+				baseProfile = profileIdx;
+			profiles.firstApplication.push_back(ApplicationCount());
+			profiles.firstSetting.push_back(SettingCount());
+
+			NvU32 appCount = profileInfo.numOfApps;
+			if (appCount > 0)
+			{
+				NVDRS_APPLICATION *appBuffer = scratch.Applications(appCount);
+				if (appBuffer == NULL)
+					return NVAPI_OUT_OF_MEMORY;
+
+				status = Drs().EnumApplications(session.Handle(), profile, 0, &appCount, appBuffer);
+				if (status != NVAPI_OK)
+					return status;
+
+				for (NvU32 i = 0; i < appCount; i++)
+				{
+					const NVDRS_APPLICATION &app = appBuffer[i];
+					applications.profile.push_back(profileIdx);
+					applications.appName.push_back(AddString(app.appName));
+					applications.userFriendlyName.push_back(AddString(app.userFriendlyName));
+					applications.launcher.push_back(AddString(app.launcher));
+					applications.fileInFolder.push_back(AddString(app.fileInFolder));
+					applications.isPredefined.push_back(app.isPredefined ? 1 : 0);
+					applications.isMetro.push_back(app.isMetro ? 1 : 0);
+				}
+			}
+			profiles.applicationCount.push_back(appCount);
+
+			NvU32 settingCount = profileInfo.numOfSettings;
+			NvU32 rowCount = 0;
+			if (settingCount > 0)
+			{
+				NVDRS_SETTING *settingBuffer = scratch.Settings(settingCount);
+				if (settingBuffer == NULL)
+					return NVAPI_OUT_OF_MEMORY;
+
+				status = Drs().EnumSettings(session.Handle(), profile, 0, &settingCount, settingBuffer);
+				if (status != NVAPI_OK)
+					return status;
+
+				// Only values stored on this profile, sorted by ID for merge joins
+				order.clear();
+				for (NvU32 i = 0; i < settingCount; i++)
+				{
+					if (settingBuffer[i].settingLocation == NVDRS_CURRENT_PROFILE_LOCATION)
+						order.push_back(i);
+				}
+				SettingIdLess less = { settingBuffer };
+				std::sort(order.begin(), order.end(), less);
+
+				for (size_t i = 0; i < order.size(); i++)
+				{
+					const NVDRS_SETTING &setting = settingBuffer[order[i]];
+					settings.profile.push_back(profileIdx);
+					settings.settingId.push_back(setting.settingId);
+					settings.settingType.push_back((NvU8)setting.settingType);
+					settings.isPredefined.push_back(setting.isCurrentPredefined ? 1 : 0);
+
+					switch (setting.settingType)
+					{
+					case NVDRS_DWORD_TYPE:
+						settings.value.push_back(setting.u32CurrentValue);
+						settings.length.push_back(sizeof(NvU32));
+						break;
+
+					case NVDRS_BINARY_TYPE:
+					{
+						NvU32 length = setting.binaryCurrentValue.valueLength;
+						if (length > NVAPI_BINARY_DATA_MAX)
+							length = NVAPI_BINARY_DATA_MAX;
+						settings.value.push_back(AddBlob(setting.binaryCurrentValue.valueData, length));
+						settings.length.push_back(length);
+						break;
+					}
+
+					default:
+					{
+						NvU32 offset = AddString(setting.wszCurrentValue);
+						settings.value.push_back(offset);
+						settings.length.push_back((NvU32)wcslen(&strings[offset]));
+						break;
+					}
+					}
+				}
+				rowCount = (NvU32)order.size();
+			}
+			profiles.settingCount.push_back(rowCount);
+
+			profileIdx++;
+		}
+
+		if (status != NVAPI_END_ENUMERATION)
+			return status;
+
+		BuildIndexes();
+		return NVAPI_OK;
+	}
+
+	void DrsSnapshot::BuildIndexes()
+	{
+		profileIndex.reserve(ProfileCount());
+		for (NvU32 i = 0; i < ProfileCount(); i++)
+			profileIndex[FoldCase(String(profiles.name[i]))] = i;
+
+		applicationIndex.reserve(ApplicationCount());
+		for (NvU32 i = 0; i < ApplicationCount(); i++)
+			applicationIndex.insert(std::make_pair(FoldCase(String(applications.appName[i])), i));
+
+		settingOrder.resize(SettingCount());
+		for (NvU32 i = 0; i < SettingCount(); i++)
+			settingOrder[i] = i;
+		SettingRowLess less = { &settings };
+		std::sort(settingOrder.begin(), settingOrder.end(), less);
+
+		for (NvU32 i = 0; i < SettingCount();)
+		{
+			NvU32 settingId = settings.settingId[settingOrder[i]];
+			NvU32 first = i;
+			while (i < SettingCount() && settings.settingId[settingOrder[i]] == settingId)
+				i++;
+			settingIndex[settingId] = std::make_pair(first, i - first);
+		}
+	}
+
+	NvU32 DrsSnapshot::FindProfile(const wchar_t *profileName) const
+	{
+		std::unordered_map<std::wstring, NvU32>::const_iterator it = profileIndex.find(FoldCase(profileName));
+		return it != profileIndex.end() ? it->second : npos;
+	}
+
+	size_t DrsSnapshot::FindApplications(const wchar_t *appName, std::vector<NvU32> &result) const
+	{
+		result.clear();
+
+		typedef std::unordered_multimap<std::wstring, NvU32>::const_iterator Iterator;
+		std::pair<Iterator, Iterator> range = applicationIndex.equal_range(FoldCase(appName));
+		for (Iterator it = range.first; it != range.second; ++it)
+			result.push_back(it->second);
+
+		std::sort(result.begin(), result.end());
+		return result.size();
+	}
+
+	NvU32 DrsSnapshot::FindSettingRows(NvU32 settingId, const NvU32 **rows) const
+	{
+		std::unordered_map<NvU32, std::pair<NvU32, NvU32> >::const_iterator it = settingIndex.find(settingId);
+		if (it == settingIndex.end())
+		{
+			*rows = NULL;
+			return 0;
+		}
+
+		*rows = &settingOrder[it->second.first];
+		return it->second.second;
+	}
+
+	NvU32 DrsSnapshot::FindSetting(NvU32 profile, NvU32 settingId) const
+	{
+		if (profile >= ProfileCount() || profiles.settingCount[profile] == 0)
+			return npos;
+
+		const NvU32 *first = &settings.settingId[0] + profiles.firstSetting[profile];
+		const NvU32 *last = first + profiles.settingCount[profile];
+		const NvU32 *it = std::lower_bound(first, last, settingId);
+		if (it == last || *it != settingId)
+			return npos;
+
+		return (NvU32)(it - &settings.settingId[0]);
+	}
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "nvapi.h"
+#include "DrsSession.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ControlPanel
+{
+	/*
+	Whole DRS database loaded once into flat struct-of-arrays tables.
+	Strings live in one pool and are referenced by offset, setting rows of a
+	profile are contiguous and sorted by setting ID, and hash indexes answer
+	lookups by profile name, executable name and setting ID without touching
+	the driver.
+	*/
+	class DrsSnapshot
+	{
+	public:
+		static const NvU32 npos = 0xFFFFFFFF;
+
+		struct ProfileTable
+		{
+			std::vector<NvU32> name;                // string pool offset
+			std::vector<NvU8> isPredefined;
+			std::vector<NvU32> firstApplication;
+			std::vector<NvU32> applicationCount;
+			std::vector<NvU32> firstSetting;
+			std::vector<NvU32> settingCount;
+			std::vector<NvDRSProfileHandle> handle; // valid while the source session stays loaded
+		};
+
+		struct ApplicationTable
+		{
+			std::vector<NvU32> profile;
+			std::vector<NvU32> appName;             // string pool offsets
+			std::vector<NvU32> userFriendlyName;
+			std::vector<NvU32> launcher;
+			std::vector<NvU32> fileInFolder;
+			std::vector<NvU8> isPredefined;
+			std::vector<NvU8> isMetro;
+		};
+
+		struct SettingTable
+		{
+			std::vector<NvU32> profile;
+			std::vector<NvU32> settingId;
+			std::vector<NvU8> settingType;          // NVDRS_SETTING_TYPE
+			std::vector<NvU8> isPredefined;
+			std::vector<NvU32> value;               // DWORD value, string pool offset or blob offset
+			std::vector<NvU32> length;              // characters of a string, bytes of a binary value
+		};
+
+		DrsSnapshot();
+
+		// Loads the session's settings if needed and captures every profile
+		NvAPI_Status Load(DrsSession &session);
+		void Clear();
+
+		NvU32 ProfileCount() const { return (NvU32)profiles.name.size(); }
+		NvU32 ApplicationCount() const { return (NvU32)applications.profile.size(); }
+		NvU32 SettingCount() const { return (NvU32)settings.profile.size(); }
+
+		NvU32 BaseProfile() const { return baseProfile; }
+
+		const ProfileTable &Profiles() const { return profiles; }
+		const ApplicationTable &Applications() const { return applications; }
+		const SettingTable &Settings() const { return settings; }
+
+		const wchar_t *String(NvU32 offset) const { return &strings[offset]; }
+		// An empty value may sit at the end of the pool, so offset == size is valid; NULL past it
+		const NvU8 *Blob(NvU32 offset) const { return offset <= blobs.size() ? blobs.data() + offset : NULL; }
+		const std::vector<wchar_t> &StringPool() const { return strings; }
+		const std::vector<NvU8> &BlobPool() const { return blobs; }
+
+		// Case-insensitive; returns npos when absent
+		NvU32 FindProfile(const wchar_t *profileName) const;
+
+		// Every application entry (across profiles) whose executable matches, case-insensitive
+		size_t FindApplications(const wchar_t *appName, std::vector<NvU32> &result) const;
+
+		// Setting rows overriding settingId, ordered by profile index
+		NvU32 FindSettingRows(NvU32 settingId, const NvU32 **rows) const;
+
+		// Row of settingId in a profile, or npos when the profile does not override it
+		NvU32 FindSetting(NvU32 profile, NvU32 settingId) const;
+
+	private:
+		NvU32 AddString(const NvU16 *value);
+		NvU32 AddBlob(const NvU8 *data, NvU32 length);
+		void BuildIndexes();
+
+		NvU32 baseProfile;
+		ProfileTable profiles;
+		ApplicationTable applications;
+		SettingTable settings;
+
+		std::vector<wchar_t> strings;
+		std::vector<NvU8> blobs;
+
+		std::unordered_map<std::wstring, NvU32> profileIndex;
+		std::unordered_multimap<std::wstring, NvU32> applicationIndex;
+		std::unordered_map<NvU32, std::pair<NvU32, NvU32> > settingIndex; // first, count into settingOrder
+		std::vector<NvU32> settingOrder;
+	};
+
+	// Lower-cases a name so that it can be used as a case-insensitive index key
+	std::wstring FoldCase(const wchar_t *value);
+};
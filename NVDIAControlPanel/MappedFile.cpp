@@ -0,0 +1,68 @@
+#include "targetver.h"
+#include "MappedFile.h"
+
+namespace ControlPanel
+{
+	MappedFile::MappedFile()
+		: file(INVALID_HANDLE_VALUE)
+		, mapping(NULL)
+		, data(NULL)
+		, size(0)
+	{
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(const char *path)
+	{
+		Close();
+
+		// FILE_SHARE_DELETE lets a writer replace the file while it is mapped, FILE_SHARE_WRITE lets it
+		// append to one it is still writing
+		file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0 || (unsigned long long)fileSize.QuadPart > (size_t)-1)
+		{
+			Close();
+			return false;
+		}
+
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping == NULL)
+		{
+			Close();
+			return false;
+		}
+
+		data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (data == NULL)
+		{
+			Close();
+			return false;
+		}
+
+		size = (size_t)fileSize.QuadPart;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (data != NULL)
+			UnmapViewOfFile(data);
+		if (mapping != NULL)
+			CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+
+		file = INVALID_HANDLE_VALUE;
+		mapping = NULL;
+		data = NULL;
+		size = 0;
+	}
+};
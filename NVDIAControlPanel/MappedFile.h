@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stddef.h>
+#include <Windows.h>
+
+namespace ControlPanel
+{
+	/*
+	Read-only view of a whole file. The pages are shared with the system file
+	cache, so reopening a file that was read recently costs no I/O and no copy.
+	*/
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+
+		bool Open(const char *path);
+		void Close();
+
+		bool IsOpen() const { return data != NULL; }
+		const void *Data() const { return data; }
+		size_t Size() const { return size; }
+
+	private:
+		MappedFile(const MappedFile &);
+		MappedFile &operator=(const MappedFile &);
+
+		HANDLE file;
+		HANDLE mapping;
+		const void *data;
+		size_t size;
+	};
+};
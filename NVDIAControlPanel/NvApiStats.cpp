@@ -0,0 +1,350 @@
+#include "targetver.h"
+#include "NvApiStats.h"
+#include "BufferedWriter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdio.h>
+
+namespace ControlPanel
+{
+	namespace
+	{
+		const char *const FUNCTION_NAMES[NVAPI_CALL_FUNCTION_COUNT] =
+		{
+			"NvAPI_Initialize",
+			"NvAPI_Unload",
+			"NvAPI_GetErrorMessage",
+			"NvAPI_SYS_GetDriverAndBranchVersion",
+			"NvAPI_EnumPhysicalGPUs",
+			"NvAPI_EnumLogicalGPUs",
+			"NvAPI_GetLogicalGPUFromPhysicalGPU",
+			"NvAPI_GPU_GetFullName",
+			"NvAPI_GPU_GetGpuCoreCount",
+			"NvAPI_GPU_GetShaderSubPipeCount",
+			"NvAPI_GPU_GetMemoryInfo",
+			"NvAPI_GPU_GetConnectedDisplayIds",
+			"NvAPI_GPU_GetConnectedDisplayIds (uncached)",
+			"NvAPI_GPU_GetThermalSettings",
+			"NvAPI_GPU_GetTachReading",
+			"NvAPI_GPU_GetAllClockFrequencies",
+			"NvAPI_GPU_GetCurrentPstate",
+			"NvAPI_GPU_GetPstates20",
+			"NvAPI_GPU_GetDynamicPstatesInfoEx",
+			"NvAPI_GPU_GetPCIIdentifiers",
+			"NvAPI_GPU_GetBusId",
+			"NvAPI_GPU_GetBoardInfo",
+			"NvAPI_GPU_GetPerfDecreaseInfo",
+			"NvAPI_GPU_GetECCStatusInfo",
+			"NvAPI_GPU_GetECCErrorInfo",
+			"NvAPI_DISP_GetDisplayConfig",
+			"NvAPI_DISP_GetTiming",
+			"NvAPI_DISP_TryCustomDisplay",
+			"NvAPI_DISP_SaveCustomDisplay",
+			"NvAPI_DISP_RevertCustomDisplayTrial",
+			"NvAPI_Disp_ColorControl",
+			"NvAPI_DRS_CreateSession",
+			"NvAPI_DRS_DestroySession",
+			"NvAPI_DRS_LoadSettings",
+			"NvAPI_DRS_SaveSettings",
+			"NvAPI_DRS_RestoreAllDefaults",
+			"NvAPI_DRS_GetNumProfiles",
+			"NvAPI_DRS_GetBaseProfile",
+			"NvAPI_DRS_EnumProfiles",
+			"NvAPI_DRS_FindProfileByName",
+			"NvAPI_DRS_GetProfileInfo",
+			"NvAPI_DRS_CreateProfile",
+			"NvAPI_DRS_DeleteProfile",
+			"NvAPI_DRS_RestoreProfileDefault",
+			"NvAPI_DRS_EnumApplications",
+			"NvAPI_DRS_CreateApplication",
+			"NvAPI_DRS_FindApplicationByName",
+			"NvAPI_DRS_EnumSettings",
+			"NvAPI_DRS_GetSetting",
+			"NvAPI_DRS_SetSetting",
+			"NvAPI_DRS_DeleteProfileSetting",
+			"NvAPI_DRS_RestoreProfileDefaultSetting",
+			"NvAPI_DRS_GetSettingNameFromId",
+			"NvAPI_DRS_GetSettingIdFromName",
+			"NvAPI_DRS_EnumAvailableSettingValues",
+		};
+
+		// Log-linear buckets as in HDR histograms: exact below 16 ticks, then 16 per power of two, so any
+		// bucket is narrower than 1/16 of its values and a quantile read at its middle is within about 3%
+		const NvU32 SUB_BUCKET_BITS = 4;
+		const NvU32 SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+		const NvU32 BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+		NvU32 HighestBit(NvU64 value)
+		{
+#if defined(_M_X64)
+			unsigned long index;
+			_BitScanReverse64(&index, value);
+			return (NvU32)index;
+#elif defined(__GNUC__)
+			return 63 - (NvU32)__builtin_clzll(value);
+#else
+			NvU32 bit = 0;
+			while (value >>= 1)
+				bit++;
+			return bit;
+#endif
+		}
+
+		NvU32 BucketOf(NvU64 ticks)
+		{
+			if (ticks < SUB_BUCKETS)
+				return (NvU32)ticks;
+
+			NvU32 top = HighestBit(ticks);
+			return (top - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + (NvU32)((ticks >> (top - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+		}
+
+		NvU64 BucketStart(NvU32 bucket)
+		{
+			if (bucket < SUB_BUCKETS)
+				return bucket;
+
+			NvU32 octave = bucket / SUB_BUCKETS;
+			return (NvU64)(SUB_BUCKETS + bucket % SUB_BUCKETS) << (octave - 1);
+		}
+
+		NvU64 BucketWidth(NvU32 bucket)
+		{
+			return bucket < SUB_BUCKETS ? 1 : 1ULL << (bucket / SUB_BUCKETS - 1);
+		}
+
+		struct Counters
+		{
+			std::atomic<NvU64> calls;
+			std::atomic<NvU64> errors;
+			std::atomic<NvU64> ticks;
+			std::atomic<NvU64> maxTicks;
+			std::atomic<std::atomic<NvU64> *> buckets;     // BUCKET_COUNT, from the first call on
+		};
+
+		// One per thread that ever called the driver. Only that thread writes it, so counting is a plain load and
+		// store; the atomics only let reports read it meanwhile. Kept after the thread exits, for the reports.
+		struct ThreadCounters
+		{
+			Counters functions[NVAPI_CALL_FUNCTION_COUNT];
+		};
+
+		std::mutex registryMutex;
+		std::vector<ThreadCounters *> registry;
+		thread_local ThreadCounters *threadCounters = NULL;
+
+		inline void Add(std::atomic<NvU64> &counter, NvU64 amount)
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+		}
+
+		ThreadCounters *RegisterThread()
+		{
+			ThreadCounters *counters = new ThreadCounters;
+			for (int i = 0; i < NVAPI_CALL_FUNCTION_COUNT; i++)
+			{
+				counters->functions[i].calls.store(0);
+				counters->functions[i].errors.store(0);
+				counters->functions[i].ticks.store(0);
+				counters->functions[i].maxTicks.store(0);
+				counters->functions[i].buckets.store(NULL);
+			}
+
+			std::lock_guard<std::mutex> lock(registryMutex);
+			registry.push_back(counters);
+			return counters;
+		}
+
+		// Ticks against the steady clock since the process started, so nothing is calibrated until a report asks
+		struct Calibration
+		{
+			NvU64 ticks;
+			std::chrono::steady_clock::time_point time;
+
+			Calibration() : ticks(NvApiTicks()), time(std::chrono::steady_clock::now()) {}
+		};
+
+		const Calibration calibration;
+
+		double TicksPerMicrosecond()
+		{
+#ifdef NVAPI_STATS_RDTSC
+			for (;;)
+			{
+				NvU64 ticks = NvApiTicks();
+				double microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - calibration.time).count();
+				if (microseconds >= 10000.0)
+					return (ticks - calibration.ticks) / microseconds;
+			}
+#else
+			return 1000.0;
+#endif
+		}
+
+		// Every thread's buckets of the function added up; returns their total count
+		NvU64 MergeBuckets(NvApiFunction function, std::vector<NvU64> &merged, NvU64 &calls, NvU64 &errors, NvU64 &ticks, NvU64 &maxTicks)
+		{
+			merged.assign(BUCKET_COUNT, 0);
+			calls = errors = ticks = maxTicks = 0;
+			NvU64 total = 0;
+
+			std::lock_guard<std::mutex> lock(registryMutex);
+			for (size_t i = 0; i < registry.size(); i++)
+			{
+				const Counters &counters = registry[i]->functions[function];
+				calls += counters.calls.load(std::memory_order_relaxed);
+				errors += counters.errors.load(std::memory_order_relaxed);
+				ticks += counters.ticks.load(std::memory_order_relaxed);
+				NvU64 threadMax = counters.maxTicks.load(std::memory_order_relaxed);
+				maxTicks = threadMax > maxTicks ? threadMax : maxTicks;
+
+				const std::atomic<NvU64> *buckets = counters.buckets.load(std::memory_order_acquire);
+				for (NvU32 b = 0; buckets != NULL && b < BUCKET_COUNT; b++)
+				{
+					NvU64 count = buckets[b].load(std::memory_order_relaxed);
+					merged[b] += count;
+					total += count;
+				}
+			}
+			return total;
+		}
+
+		// Middle of the bucket holding the value of rank ceil(q * total)
+		double Quantile(const std::vector<NvU64> &buckets, NvU64 total, double q)
+		{
+			NvU64 rank = (NvU64)(q * total + 0.999999);
+			rank = rank < 1 ? 1 : rank;
+			NvU64 seen = 0;
+			for (NvU32 b = 0; b < BUCKET_COUNT; b++)
+			{
+				seen += buckets[b];
+				if (seen >= rank)
+					return BucketStart(b) + (BucketWidth(b) - 1) / 2.0;
+			}
+			return 0.0;
+		}
+
+		bool MoreTotalTime(const NvApiCallStats &a, const NvApiCallStats &b)
+		{
+			return a.totalMicroseconds > b.totalMicroseconds;
+		}
+	}
+
+	const char *NvApiFunctionName(NvApiFunction function)
+	{
+		return function >= 0 && function < NVAPI_CALL_FUNCTION_COUNT ? FUNCTION_NAMES[function] : "unknown";
+	}
+
+	void RecordNvApiCall(NvApiFunction function, NvU64 ticks, NvAPI_Status status)
+	{
+		ThreadCounters *counters = threadCounters;
+		if (counters == NULL)
+			counters = threadCounters = RegisterThread();
+
+		Counters &called = counters->functions[function];
+		std::atomic<NvU64> *buckets = called.buckets.load(std::memory_order_relaxed);
+		if (buckets == NULL)
+		{
+			buckets = new std::atomic<NvU64>[BUCKET_COUNT];
+			for (NvU32 b = 0; b < BUCKET_COUNT; b++)
+				buckets[b].store(0, std::memory_order_relaxed);
+			called.buckets.store(buckets, std::memory_order_release);
+		}
+
+		Add(called.calls, 1);
+		Add(called.ticks, ticks);
+		Add(buckets[BucketOf(ticks)], 1);
+		if (status != NVAPI_OK)
+			Add(called.errors, 1);
+		if (ticks > called.maxTicks.load(std::memory_order_relaxed))
+			called.maxTicks.store(ticks, std::memory_order_relaxed);
+	}
+
+	void CollectNvApiStats(std::vector<NvApiCallStats> &stats)
+	{
+		stats.clear();
+		double perMicrosecond = TicksPerMicrosecond();
+		std::vector<NvU64> buckets;
+		for (int function = 0; function < NVAPI_CALL_FUNCTION_COUNT; function++)
+		{
+			NvU64 calls, errors, ticks, maxTicks;
+			NvU64 total = MergeBuckets((NvApiFunction)function, buckets, calls, errors, ticks, maxTicks);
+			if (calls == 0)
+				continue;
+
+			NvApiCallStats entry;
+			entry.function = (NvApiFunction)function;
+			entry.calls = calls;
+			entry.errors = errors;
+			entry.totalMicroseconds = ticks / perMicrosecond;
+			entry.maxMicroseconds = maxTicks / perMicrosecond;
+
+			// The middle of a bucket can lie past the largest value in it
+			double quantiles[] = { 0.5, 0.9, 0.99 };
+			double *results[] = { &entry.p50Microseconds, &entry.p90Microseconds, &entry.p99Microseconds };
+			for (int i = 0; i < 3; i++)
+			{
+				double microseconds = Quantile(buckets, total, quantiles[i]) / perMicrosecond;
+				*results[i] = microseconds < entry.maxMicroseconds ? microseconds : entry.maxMicroseconds;
+			}
+			stats.push_back(entry);
+		}
+		std::sort(stats.begin(), stats.end(), MoreTotalTime);
+	}
+
+	void PrintNvApiStats()
+	{
+		std::vector<NvApiCallStats> stats;
+		CollectNvApiStats(stats);
+		printf("%-44s %9s %7s %11s %10s %10s %10s %10s\n", "NVAPI call", "calls", "errors", "total ms", "p50 us", "p90 us", "p99 us", "max us");
+		for (size_t i = 0; i < stats.size(); i++)
+		{
+			const NvApiCallStats &entry = stats[i];
+			printf("%-44s %9llu %7llu %11.3f %10.2f %10.2f %10.2f %10.2f\n", NvApiFunctionName(entry.function), entry.calls, entry.errors,
+				entry.totalMicroseconds / 1000.0, entry.p50Microseconds, entry.p90Microseconds, entry.p99Microseconds, entry.maxMicroseconds);
+		}
+		if (stats.empty())
+			printf("No NVAPI calls\n");
+	}
+
+	bool WriteNvApiStatsJson(const char *path)
+	{
+		FILE *file = OpenFile(path, "w");
+		if (file == NULL)
+			return false;
+
+		std::vector<NvApiCallStats> stats;
+		CollectNvApiStats(stats);
+		double perMicrosecond = TicksPerMicrosecond();
+		fprintf(file, "{\n  \"ticksPerMicrosecond\": %.3f,\n  \"calls\": [", perMicrosecond);
+
+		std::vector<NvU64> buckets;
+		for (size_t i = 0; i < stats.size(); i++)
+		{
+			const NvApiCallStats &entry = stats[i];
+			fprintf(file, "%s\n    { \"function\": \"%s\", \"calls\": %llu, \"errors\": %llu, \"totalMicroseconds\": %.3f, "
+				"\"p50Microseconds\": %.3f, \"p90Microseconds\": %.3f, \"p99Microseconds\": %.3f, \"maxMicroseconds\": %.3f,\n"
+				"      \"histogram\": [", i > 0 ? "," : "", NvApiFunctionName(entry.function), entry.calls, entry.errors,
+				entry.totalMicroseconds, entry.p50Microseconds, entry.p90Microseconds, entry.p99Microseconds, entry.maxMicroseconds);
+
+			// [lowest microseconds of the bucket, calls] for every bucket with calls in it
+			NvU64 calls, errors, ticks, maxTicks;
+			MergeBuckets(entry.function, buckets, calls, errors, ticks, maxTicks);
+			bool first = true;
+			for (NvU32 b = 0; b < BUCKET_COUNT; b++)
+			{
+				if (buckets[b] == 0)
+					continue;
+
+				fprintf(file, "%s[%.4f, %llu]", first ? "" : ", ", BucketStart(b) / perMicrosecond, buckets[b]);
+				first = false;
+			}
+			fprintf(file, "] }");
+		}
+		fprintf(file, "\n  ]\n}\n");
+		return fclose(file) == 0;
+	}
+};
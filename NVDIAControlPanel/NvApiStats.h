@@ -0,0 +1,129 @@
+#pragma once
+
+#include "nvapi.h"
+
+#include <vector>
+
+#if defined(_M_IX86) || defined(_M_X64)
+#include <intrin.h>
+#define NVAPI_STATS_RDTSC
+#elif defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#define NVAPI_STATS_RDTSC
+#else
+#include <chrono>
+#endif
+
+namespace ControlPanel
+{
+	// Every NVAPI function the tool calls, each counted on its own
+	enum NvApiFunction
+	{
+		NVAPI_CALL_INITIALIZE,
+		NVAPI_CALL_UNLOAD,
+		NVAPI_CALL_GET_ERROR_MESSAGE,
+		NVAPI_CALL_SYS_GET_DRIVER_AND_BRANCH_VERSION,
+		NVAPI_CALL_ENUM_PHYSICAL_GPUS,
+		NVAPI_CALL_ENUM_LOGICAL_GPUS,
+		NVAPI_CALL_GET_LOGICAL_GPU_FROM_PHYSICAL_GPU,
+		NVAPI_CALL_GPU_GET_FULL_NAME,
+		NVAPI_CALL_GPU_GET_GPU_CORE_COUNT,
+		NVAPI_CALL_GPU_GET_SHADER_SUB_PIPE_COUNT,
+		NVAPI_CALL_GPU_GET_MEMORY_INFO,
+		NVAPI_CALL_GPU_GET_CONNECTED_DISPLAY_IDS,
+		NVAPI_CALL_GPU_GET_CONNECTED_DISPLAY_IDS_UNCACHED,     // with NV_GPU_CONNECTED_IDS_FLAG_UNCACHED
+		NVAPI_CALL_GPU_GET_THERMAL_SETTINGS,
+		NVAPI_CALL_GPU_GET_TACH_READING,
+		NVAPI_CALL_GPU_GET_ALL_CLOCK_FREQUENCIES,
+		NVAPI_CALL_GPU_GET_CURRENT_PSTATE,
+		NVAPI_CALL_GPU_GET_PSTATES20,
+		NVAPI_CALL_GPU_GET_DYNAMIC_PSTATES_INFO_EX,
+		NVAPI_CALL_GPU_GET_PCI_IDENTIFIERS,
+		NVAPI_CALL_GPU_GET_BUS_ID,
+		NVAPI_CALL_GPU_GET_BOARD_INFO,
+		NVAPI_CALL_GPU_GET_PERF_DECREASE_INFO,
+		NVAPI_CALL_GPU_GET_ECC_STATUS_INFO,
+		NVAPI_CALL_GPU_GET_ECC_ERROR_INFO,
+		NVAPI_CALL_DISP_GET_DISPLAY_CONFIG,
+		NVAPI_CALL_DISP_GET_TIMING,
+		NVAPI_CALL_DISP_TRY_CUSTOM_DISPLAY,
+		NVAPI_CALL_DISP_SAVE_CUSTOM_DISPLAY,
+		NVAPI_CALL_DISP_REVERT_CUSTOM_DISPLAY_TRIAL,
+		NVAPI_CALL_DISP_COLOR_CONTROL,
+		NVAPI_CALL_DRS_CREATE_SESSION,
+		NVAPI_CALL_DRS_DESTROY_SESSION,
+		NVAPI_CALL_DRS_LOAD_SETTINGS,
+		NVAPI_CALL_DRS_SAVE_SETTINGS,
+		NVAPI_CALL_DRS_RESTORE_ALL_DEFAULTS,
+		NVAPI_CALL_DRS_GET_NUM_PROFILES,
+		NVAPI_CALL_DRS_GET_BASE_PROFILE,
+		NVAPI_CALL_DRS_ENUM_PROFILES,
+		NVAPI_CALL_DRS_FIND_PROFILE_BY_NAME,
+		NVAPI_CALL_DRS_GET_PROFILE_INFO,
+		NVAPI_CALL_DRS_CREATE_PROFILE,
+		NVAPI_CALL_DRS_DELETE_PROFILE,
+		NVAPI_CALL_DRS_RESTORE_PROFILE_DEFAULT,
+		NVAPI_CALL_DRS_ENUM_APPLICATIONS,
+		NVAPI_CALL_DRS_CREATE_APPLICATION,
+		NVAPI_CALL_DRS_FIND_APPLICATION_BY_NAME,
+		NVAPI_CALL_DRS_ENUM_SETTINGS,
+		NVAPI_CALL_DRS_GET_SETTING,
+		NVAPI_CALL_DRS_SET_SETTING,
+		NVAPI_CALL_DRS_DELETE_PROFILE_SETTING,
+		NVAPI_CALL_DRS_RESTORE_PROFILE_DEFAULT_SETTING,
+		NVAPI_CALL_DRS_GET_SETTING_NAME_FROM_ID,
+		NVAPI_CALL_DRS_GET_SETTING_ID_FROM_NAME,
+		NVAPI_CALL_DRS_ENUM_AVAILABLE_SETTING_VALUES,
+		NVAPI_CALL_FUNCTION_COUNT
+	};
+
+	// The NvAPI_* name, with a suffix for variants counted apart
+	const char *NvApiFunctionName(NvApiFunction function);
+
+	// Timestamp counter ticks where there is one, steady clock nanoseconds elsewhere
+	inline NvU64 NvApiTicks()
+	{
+#ifdef NVAPI_STATS_RDTSC
+		return __rdtsc();
+#else
+		return (NvU64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	// Adds one call to the calling thread's counters
+	void RecordNvApiCall(NvApiFunction function, NvU64 ticks, NvAPI_Status status);
+
+	/*
+	Every driver call goes through here: NvApiCall(NVAPI_CALL_GPU_GET_TACH_READING,
+	NvAPI_GPU_GetTachReading, gpu, &rpm) returns what the function returned,
+	after adding its latency to the calling thread's counters.
+	*/
+	template <typename Function, typename... Arguments>
+	inline NvAPI_Status NvApiCall(NvApiFunction function, Function call, Arguments... arguments)
+	{
+		NvU64 start = NvApiTicks();
+		NvAPI_Status status = call(arguments...);
+		RecordNvApiCall(function, NvApiTicks() - start, status);
+		return status;
+	}
+
+	struct NvApiCallStats
+	{
+		NvApiFunction function;
+		unsigned long long calls;
+		unsigned long long errors;              // status other than NVAPI_OK
+		double totalMicroseconds;
+		double p50Microseconds;                 // within about 3%
+		double p90Microseconds;
+		double p99Microseconds;
+		double maxMicroseconds;
+	};
+
+	// Every function called so far, all threads merged, most total time first; exact once the calling threads are idle
+	void CollectNvApiStats(std::vector<NvApiCallStats> &stats);
+
+	void PrintNvApiStats();
+
+	// The same as JSON, with each function's non-empty histogram buckets
+	bool WriteNvApiStatsJson(const char *path);
+};
@@ -0,0 +1,178 @@
+#include "targetver.h"
+#include "PstateCatalogue.h"
+#include "NvApiStats.h"
+
+#include <string.h>
+
+namespace ControlPanel
+{
+	PstateCatalogue::PstateCatalogue()
+		: gpuCount(0), tableReads(0)
+	{
+		memset(gpus, 0, sizeof(gpus));
+		for (NvU32 gpu = 0; gpu < NVAPI_MAX_PHYSICAL_GPUS; gpu++)
+			memset(gpus[gpu].entryOf, NOT_LISTED, sizeof(gpus[gpu].entryOf));
+	}
+
+	NvAPI_Status PstateCatalogue::Open()
+	{
+		NvPhysicalGpuHandle handles[NVAPI_MAX_PHYSICAL_GPUS] = { 0 };
+		gpuCount = 0;
+		NvAPI_Status status = NvApiCall(NVAPI_CALL_ENUM_PHYSICAL_GPUS, NvAPI_EnumPhysicalGPUs, handles, &gpuCount);
+		if (status != NVAPI_OK)
+			return status;
+
+		memset(gpus, 0, sizeof(gpus));
+		for (NvU32 gpu = 0; gpu < NVAPI_MAX_PHYSICAL_GPUS; gpu++)
+		{
+			gpus[gpu].handle = handles[gpu];
+			memset(gpus[gpu].entryOf, NOT_LISTED, sizeof(gpus[gpu].entryOf));
+		}
+
+		return Validate();
+	}
+
+	NvAPI_Status PstateCatalogue::Validate()
+	{
+		NvU32 driverVersion = 0;
+		NvAPI_ShortString branch = { 0 };
+		NvAPI_Status status = NvApiCall(NVAPI_CALL_SYS_GET_DRIVER_AND_BRANCH_VERSION, NvAPI_SYS_GetDriverAndBranchVersion, &driverVersion, branch);
+		if (status != NVAPI_OK)
+			return status;
+
+		for (NvU32 gpu = 0; gpu < gpuCount; gpu++)
+		{
+			PstateCatalogueKey key;
+			status = ReadKey(gpu, driverVersion, key);
+			if (status != NVAPI_OK)
+				return status;
+
+			if (gpus[gpu].valid && memcmp(&key, &gpus[gpu].key, sizeof(key)) == 0)
+				continue;
+
+			gpus[gpu].key = key;
+			status = ReadTables(gpu);
+			if (status != NVAPI_OK)
+				return status;
+		}
+
+		return NVAPI_OK;
+	}
+
+	const PstateEntry *PstateCatalogue::Find(NvU32 gpu, NV_GPU_PERF_PSTATE_ID id) const
+	{
+		if ((NvU32)id >= NVAPI_MAX_GPU_PERF_PSTATES || gpus[gpu].entryOf[id] == NOT_LISTED)
+			return NULL;
+		return &gpus[gpu].entries[gpus[gpu].entryOf[id]];
+	}
+
+	NvAPI_Status PstateCatalogue::Current(NvU32 gpu, NV_GPU_PERF_PSTATE_ID &id, const PstateEntry *&entry)
+	{
+		entry = NULL;
+		NvAPI_Status status = NvApiCall(NVAPI_CALL_GPU_GET_CURRENT_PSTATE, NvAPI_GPU_GetCurrentPstate, gpus[gpu].handle, &id);
+
+		// The driver was reloaded: enumerate again, which also checks every key
+		if (status == NVAPI_HANDLE_INVALIDATED || status == NVAPI_EXPECTED_PHYSICAL_GPU_HANDLE)
+		{
+			status = Open();
+			if (status != NVAPI_OK)
+				return status;
+			if (gpu >= gpuCount)
+				return NVAPI_INVALID_HANDLE;
+
+			status = NvApiCall(NVAPI_CALL_GPU_GET_CURRENT_PSTATE, NvAPI_GPU_GetCurrentPstate, gpus[gpu].handle, &id);
+		}
+		if (status != NVAPI_OK)
+			return status;
+
+		entry = Find(gpu, id);
+		if (entry != NULL || (NvU32)id >= NVAPI_MAX_GPU_PERF_PSTATES)
+			return NVAPI_OK;
+
+		// Not listed: the tables may be stale. Checked once per P-state until they are read again,
+		// as some boards report states their tables leave out.
+		NvU32 bit = 1u << id;
+		if ((gpus[gpu].unlistedChecked & bit) != 0)
+			return NVAPI_OK;
+
+		status = Validate();
+		gpus[gpu].unlistedChecked |= bit;
+		entry = Find(gpu, id);
+		return status;
+	}
+
+	NvAPI_Status PstateCatalogue::ReadKey(NvU32 gpu, NvU32 driverVersion, PstateCatalogueKey &key)
+	{
+		memset(&key, 0, sizeof(key));
+		key.driverVersion = driverVersion;
+
+		NvU32 extDeviceId = 0;
+		NvAPI_Status status = NvApiCall(NVAPI_CALL_GPU_GET_PCI_IDENTIFIERS, NvAPI_GPU_GetPCIIdentifiers, gpus[gpu].handle,
+			&key.deviceId, &key.subSystemId, &key.revisionId, &extDeviceId);
+		if (status != NVAPI_OK)
+			return status;
+
+		status = NvApiCall(NVAPI_CALL_GPU_GET_BUS_ID, NvAPI_GPU_GetBusId, gpus[gpu].handle, &key.busId);
+		if (status != NVAPI_OK)
+			return status;
+
+		// Only some boards have a serial number
+		NV_BOARD_INFO boardInfo;
+		memset(&boardInfo, 0, sizeof(NV_BOARD_INFO));
+		boardInfo.version = NV_BOARD_INFO_VER;
+		if (NvApiCall(NVAPI_CALL_GPU_GET_BOARD_INFO, NvAPI_GPU_GetBoardInfo, gpus[gpu].handle, &boardInfo) == NVAPI_OK)
+			memcpy(key.boardNumber, boardInfo.BoardNum, sizeof(key.boardNumber));
+
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status PstateCatalogue::ReadTables(NvU32 gpu)
+	{
+		GpuTables &tables = gpus[gpu];
+		tables.valid = false;
+		tables.entryCount = 0;
+		tables.unlistedChecked = 0;
+		memset(tables.entryOf, NOT_LISTED, sizeof(tables.entryOf));
+
+		NV_GPU_PERF_PSTATES20_INFO pState20Info;
+		memset(&pState20Info, 0, sizeof(NV_GPU_PERF_PSTATES20_INFO));
+		pState20Info.version = NV_GPU_PERF_PSTATES20_INFO_VER;
+
+		NvAPI_Status status = NvApiCall(NVAPI_CALL_GPU_GET_PSTATES20, NvAPI_GPU_GetPstates20, tables.handle, &pState20Info);
+		tableReads++;
+		if (status != NVAPI_OK)
+			return status;
+
+		NvU32 clockCount = pState20Info.numClocks < NVAPI_MAX_GPU_PSTATE20_CLOCKS ? pState20Info.numClocks : NVAPI_MAX_GPU_PSTATE20_CLOCKS;
+		NvU32 voltageCount = pState20Info.numBaseVoltages < NVAPI_MAX_GPU_PSTATE20_BASE_VOLTAGES ? pState20Info.numBaseVoltages : NVAPI_MAX_GPU_PSTATE20_BASE_VOLTAGES;
+		for (NvU32 i = 0; i < pState20Info.numPstates && i < NVAPI_MAX_GPU_PSTATE20_PSTATES; i++)
+		{
+			PstateEntry &entry = tables.entries[tables.entryCount];
+			entry.id = pState20Info.pstates[i].pstateId;
+			entry.editable = pState20Info.pstates[i].bIsEditable != 0;
+
+			entry.clockCount = clockCount;
+			for (NvU32 c = 0; c < clockCount; c++)
+			{
+				const NV_GPU_PSTATE20_CLOCK_ENTRY_V1 &clock = pState20Info.pstates[i].clocks[c];
+				bool range = clock.typeId == NVAPI_GPU_PERF_PSTATE20_CLOCK_TYPE_RANGE;
+				entry.clocks[c].domain = clock.domainId;
+				entry.clocks[c].minKHz = range ? clock.data.range.minFreq_kHz : clock.data.single.freq_kHz;
+				entry.clocks[c].maxKHz = range ? clock.data.range.maxFreq_kHz : clock.data.single.freq_kHz;
+				entry.clocks[c].deltaKHz = clock.freqDelta_kHz.value;
+				entry.clocks[c].editable = clock.bIsEditable != 0;
+			}
+
+			entry.voltageCount = voltageCount;
+			for (NvU32 v = 0; v < voltageCount; v++)
+				entry.baseVoltageMicrovolts[v] = pState20Info.pstates[i].baseVoltages[v].volt_uV;
+
+			if ((NvU32)entry.id < NVAPI_MAX_GPU_PERF_PSTATES)
+				tables.entryOf[entry.id] = (NvU8)tables.entryCount;
+			tables.entryCount++;
+		}
+
+		tables.valid = true;
+		return NVAPI_OK;
+	}
+};
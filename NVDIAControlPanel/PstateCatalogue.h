@@ -0,0 +1,98 @@
+#pragma once
+
+#include "nvapi.h"
+
+namespace ControlPanel
+{
+	// What a GPU's P-state tables were read under; they are read again when any of it changes
+	struct PstateCatalogueKey
+	{
+		NvU32 driverVersion;        // NvAPI_SYS_GetDriverAndBranchVersion
+		NvU32 deviceId;             // NvAPI_GPU_GetPCIIdentifiers
+		NvU32 subSystemId;
+		NvU32 revisionId;
+		NvU32 busId;                // NvAPI_GPU_GetBusId
+		NvU8 boardNumber[16];       // NvAPI_GPU_GetBoardInfo, zero where the board does not report one
+	};
+
+	struct PstateClock
+	{
+		NV_GPU_PUBLIC_CLOCK_ID domain;
+		NvU32 minKHz;               // equal to maxKHz for a single frequency
+		NvU32 maxKHz;
+		NvS32 deltaKHz;             // current offset from nominal
+		bool editable;
+	};
+
+	struct PstateEntry
+	{
+		NV_GPU_PERF_PSTATE_ID id;
+		bool editable;
+		NvU32 clockCount;
+		PstateClock clocks[NVAPI_MAX_GPU_PSTATE20_CLOCKS];
+		NvU32 voltageCount;
+		NvU32 baseVoltageMicrovolts[NVAPI_MAX_GPU_PSTATE20_BASE_VOLTAGES];
+	};
+
+	/*
+	The P-state tables of every GPU, read with NvAPI_GPU_GetPstates20 once and
+	kept until the driver version or the board changes. Steady-state sampling
+	is then one NvAPI_GPU_GetCurrentPstate per GPU, mapped to its entry by
+	table lookup. A P-state the tables do not list, or a handle the driver has
+	invalidated, makes Current check the keys and read again before it gives
+	up. Overclocking changes the tables without changing a key, so whoever
+	applies an overclock calls Invalidate. Not thread-safe.
+	*/
+	class PstateCatalogue
+	{
+	public:
+		PstateCatalogue();
+
+		// Enumerates the GPUs and reads the tables of each
+		NvAPI_Status Open();
+
+		// Reads again the tables of every GPU whose key changed; one driver call plus three per GPU when none did
+		NvAPI_Status Validate();
+
+		// The next Validate reads this GPU's tables whatever its key
+		void Invalidate(NvU32 gpu) { gpus[gpu].valid = false; }
+
+		NvU32 GpuCount() const { return gpuCount; }
+		NvPhysicalGpuHandle Gpu(NvU32 gpu) const { return gpus[gpu].handle; }
+		const PstateCatalogueKey &Key(NvU32 gpu) const { return gpus[gpu].key; }
+		NvU32 EntryCount(NvU32 gpu) const { return gpus[gpu].entryCount; }
+		const PstateEntry &Entry(NvU32 gpu, NvU32 index) const { return gpus[gpu].entries[index]; }
+
+		// NULL when the tables do not list the P-state
+		const PstateEntry *Find(NvU32 gpu, NV_GPU_PERF_PSTATE_ID id) const;
+
+		// One NvAPI_GPU_GetCurrentPstate mapped against the tables; entry is NULL for a P-state they do not list
+		NvAPI_Status Current(NvU32 gpu, NV_GPU_PERF_PSTATE_ID &id, const PstateEntry *&entry);
+
+		unsigned long long TableReads() const { return tableReads; }
+
+	private:
+		PstateCatalogue(const PstateCatalogue &);
+		PstateCatalogue &operator=(const PstateCatalogue &);
+
+		static const NvU8 NOT_LISTED = 0xFF;
+
+		struct GpuTables
+		{
+			NvPhysicalGpuHandle handle;
+			bool valid;
+			PstateCatalogueKey key;
+			NvU32 entryCount;
+			PstateEntry entries[NVAPI_MAX_GPU_PSTATE20_PSTATES];
+			NvU8 entryOf[NVAPI_MAX_GPU_PERF_PSTATES];       // index into entries by NV_GPU_PERF_PSTATE_ID
+			NvU32 unlistedChecked;                          // bit per P-state Current has already validated the tables for
+		};
+
+		NvAPI_Status ReadKey(NvU32 gpu, NvU32 driverVersion, PstateCatalogueKey &key);
+		NvAPI_Status ReadTables(NvU32 gpu);
+
+		GpuTables gpus[NVAPI_MAX_PHYSICAL_GPUS];
+		NvU32 gpuCount;
+		unsigned long long tableReads;
+	};
+};
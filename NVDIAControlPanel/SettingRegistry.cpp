@@ -0,0 +1,149 @@
+#include "targetver.h"
+#include "SettingRegistry.h"
+
+#include <stdio.h>
+#include <wchar.h>
+
+namespace ControlPanel
+{
+	namespace
+	{
+		// The SDK's reference tables; the .c file does not include nvapi.h itself,
+		// so it is only built here, after it, and kept local to the check
+#include "NvApiDriverSettings.c"
+
+		bool SameString(const wchar_t *a, const wchar_t *b)
+		{
+			if (a == NULL || b == NULL)
+				return a == b;
+			return wcscmp(a, b) == 0;
+		}
+
+		NvU32 CheckEntry(const SettingInfo *info, NvU32 settingId, const wchar_t *name, NVDRS_SETTING_TYPE settingType, NvU32 valueCount)
+		{
+			if (info == NULL)
+			{
+				wprintf(L"0x%08X %s: missing from the registry\n", settingId, name);
+				return 1;
+			}
+
+			NvU32 errors = 0;
+			if (!SameString(info->name, name))
+			{
+				wprintf(L"0x%08X: name \"%s\", expected \"%s\"\n", settingId, info->name, name);
+				errors++;
+			}
+			if (info->settingType != settingType)
+			{
+				wprintf(L"0x%08X %s: wrong setting type\n", settingId, name);
+				errors++;
+			}
+			if (info->valueCount != valueCount)
+			{
+				wprintf(L"0x%08X %s: %u values, expected %u\n", settingId, name, info->valueCount, valueCount);
+				errors++;
+			}
+			if (FindSettingInfoByName(info->symbol) != info)
+			{
+				wprintf(L"0x%08X %s: symbol %s does not resolve back\n", settingId, name, info->symbol);
+				errors++;
+			}
+
+			// Display names shared by several settings are not indexed
+			const SettingInfo *byName = FindSettingInfoByName(name);
+			if (byName != info && byName != NULL)
+			{
+				wprintf(L"0x%08X %s: name resolves to 0x%08X\n", settingId, name, byName->settingId);
+				errors++;
+			}
+			return errors;
+		}
+	}
+
+	bool IsLegalSettingValue(const SettingInfo &info, NvU32 value)
+	{
+		// Some defaults (0 for "not set") are not among the listed values
+		if (info.valueKind == SETTING_VALUES_ANY || info.valueKind == SETTING_VALUES_BITFIELD || value == info.defaultValue)
+			return true;
+
+		for (NvU32 i = 0; i < info.valueCount; i++)
+		{
+			if (settingValuePool[info.firstValue + i] == value)
+				return true;
+		}
+
+		if (info.valueKind != SETTING_VALUES_RANGE)
+			return false;
+
+		// A minimum above the maximum is a negative bound (LODBIASADJUST)
+		if (info.minValue <= info.maxValue)
+			return value >= info.minValue && value <= info.maxValue;
+		return (NvS32)value >= (NvS32)info.minValue && (NvS32)value <= (NvS32)info.maxValue;
+	}
+
+	NvAPI_Status CheckSettingRegistry()
+	{
+		NvU32 errors = 0;
+
+		for (NvU32 i = 0; i < TOTAL_DWORD_SETTING_NUM; i++)
+		{
+			const SettingDWORDNameString &expected = mapSettingDWORD[i];
+			const SettingInfo *info = FindSettingInfo(expected.settingId);
+			NvU32 entryErrors = CheckEntry(info, expected.settingId, expected.settingNameString, NVDRS_DWORD_TYPE, expected.numSettingValues);
+			if (entryErrors == 0)
+			{
+				for (NvU32 v = 0; v < expected.numSettingValues; v++)
+				{
+					if (settingValuePool[info->firstValue + v] != expected.settingValues[v])
+					{
+						wprintf(L"0x%08X %s: value %u is 0x%08X, expected 0x%08X\n", expected.settingId, expected.settingNameString,
+							v, settingValuePool[info->firstValue + v], expected.settingValues[v]);
+						entryErrors++;
+					}
+				}
+				if (info->defaultValue != expected.defaultValue)
+				{
+					wprintf(L"0x%08X %s: default 0x%08X, expected 0x%08X\n", expected.settingId, expected.settingNameString,
+						info->defaultValue, expected.defaultValue);
+					entryErrors++;
+				}
+			}
+			errors += entryErrors;
+		}
+
+		for (NvU32 i = 0; i < TOTAL_WSTRING_SETTING_NUM; i++)
+		{
+			const SettingWSTRINGNameString &expected = mapSettingWSTRING[i];
+			const SettingInfo *info = FindSettingInfo(expected.settingId);
+			NvU32 entryErrors = CheckEntry(info, expected.settingId, expected.settingNameString, NVDRS_WSTRING_TYPE, expected.numSettingValues);
+			if (entryErrors == 0)
+			{
+				for (NvU32 v = 0; v < expected.numSettingValues; v++)
+				{
+					if (!SameString(settingStringPool[info->firstValue + v], expected.settingValues[v]))
+					{
+						wprintf(L"0x%08X %s: value %u is \"%s\", expected \"%s\"\n", expected.settingId, expected.settingNameString,
+							v, settingStringPool[info->firstValue + v], expected.settingValues[v]);
+						entryErrors++;
+					}
+				}
+				if (!SameString(info->defaultString, expected.defaultValue))
+				{
+					wprintf(L"0x%08X %s: default \"%s\", expected \"%s\"\n", expected.settingId, expected.settingNameString,
+						info->defaultString, expected.defaultValue);
+					entryErrors++;
+				}
+			}
+			errors += entryErrors;
+		}
+
+		if (FindSettingInfo(INVALID_SETTING_ID) != NULL)
+		{
+			wprintf(L"INVALID_SETTING_ID resolves to a setting\n");
+			errors++;
+		}
+
+		wprintf(L"Setting registry: %u settings, %u mismatches\n", SETTING_REGISTRY_COUNT, errors);
+		return errors == 0 ? NVAPI_OK : NVAPI_ERROR;
+	}
+};
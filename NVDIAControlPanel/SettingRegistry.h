@@ -0,0 +1,128 @@
+#pragma once
+
+#include "nvapi.h"
+#include "NvApiDriverSettings.h"
+
+namespace ControlPanel
+{
+	/*
+	Compile-time registry of the settings documented by NvApiDriverSettings.h:
+	name, type, legal values and default of every setting ID, without a
+	NvAPI_DRS_GetSettingNameFromId or NvAPI_DRS_EnumAvailableSettingValues call.
+	IDs and names are resolved through two hash-and-displace perfect hashes whose
+	seeds are generated with the table itself by tools/GenSettingRegistry.py.
+	*/
+	enum SettingValueKind
+	{
+		SETTING_VALUES_ANY,             // free-form DWORD or string setting
+		SETTING_VALUES_LIST,            // exactly one of the listed values
+		SETTING_VALUES_RANGE,           // a listed value or anything in [minValue, maxValue]
+		SETTING_VALUES_BITFIELD         // packed fields, the listed values are flags and masks
+	};
+
+	struct SettingInfo
+	{
+		NvU32 settingId;
+		const wchar_t *name;            // display name, as NvAPI_DRS_GetSettingNameFromId returns it
+		const wchar_t *symbol;          // SDK identifier without the _ID suffix
+		NVDRS_SETTING_TYPE settingType;
+		SettingValueKind valueKind;
+		NvU32 firstValue;               // into settingValuePool (DWORD) or settingStringPool (string)
+		NvU32 valueCount;
+		NvU32 defaultValue;
+		const wchar_t *defaultString;
+		NvU32 minValue;
+		NvU32 maxValue;
+	};
+
+	const NvU32 SETTING_ID_SLOTS = 128;
+	const NvU32 SETTING_ID_BUCKETS = 32;
+	const NvU32 SETTING_NAME_SLOTS = 256;
+	const NvU32 SETTING_NAME_BUCKETS = 64;
+	const NvU8 SETTING_NO_SLOT = 0xFF;
+
+	constexpr NvU32 SettingHashShift(NvU32 hash, int bits)
+	{
+		return hash ^ (hash >> bits);
+	}
+
+	// murmur3 finalizer of the seeded key; the generator uses the same function
+	constexpr NvU32 SettingHashMix(NvU32 key, NvU32 seed)
+	{
+		return SettingHashShift((SettingHashShift((SettingHashShift((key ^ seed) & 0xFFFFFFFF, 16) * 0x85EBCA6B) & 0xFFFFFFFF, 13) * 0xC2B2AE35) & 0xFFFFFFFF, 16);
+	}
+
+	constexpr NvU32 SettingNameFold(wchar_t c)
+	{
+		return (c >= L'A' && c <= L'Z') ? (NvU32)(c - L'A' + L'a') : (NvU32)c;
+	}
+
+	// FNV-1a, ASCII case-insensitive. Non-ASCII characters are skipped: the SDK
+	// header is not UTF-8, so their value depends on the compiler's code page.
+	constexpr NvU32 SettingNameHash(const wchar_t *name, NvU32 hash = 2166136261u)
+	{
+		return *name == 0 ? hash :
+			SettingNameHash(name + 1, (NvU32)*name > 0x7F ? hash : ((hash ^ SettingNameFold(*name)) * 16777619u) & 0xFFFFFFFF);
+	}
+
+	constexpr bool SettingNameEquals(const wchar_t *a, const wchar_t *b)
+	{
+		return SettingNameFold(*a) != SettingNameFold(*b) ? false : (*a == 0 ? true : SettingNameEquals(a + 1, b + 1));
+	}
+
+#include "SettingRegistry.inl"
+
+	constexpr NvU32 SettingIdSlot(NvU32 settingId)
+	{
+		return SettingHashMix(settingId, settingIdSeeds[SettingHashMix(settingId, 0) % SETTING_ID_BUCKETS]) % SETTING_ID_SLOTS;
+	}
+
+	constexpr NvU32 SettingNameSlot(NvU32 nameHash)
+	{
+		return SettingHashMix(nameHash, settingNameSeeds[SettingHashMix(nameHash, 0) % SETTING_NAME_BUCKETS]) % SETTING_NAME_SLOTS;
+	}
+
+	// NULL when the setting is not documented by the SDK headers
+	constexpr const SettingInfo *FindSettingInfo(NvU32 settingId)
+	{
+		return settingRegistry[SettingIdSlot(settingId)].name != NULL && settingRegistry[SettingIdSlot(settingId)].settingId == settingId
+			? &settingRegistry[SettingIdSlot(settingId)] : NULL;
+	}
+
+	constexpr const SettingInfo *MatchSettingName(NvU8 slot, const wchar_t *name)
+	{
+		return slot != SETTING_NO_SLOT && (SettingNameEquals(settingRegistry[slot].name, name) || SettingNameEquals(settingRegistry[slot].symbol, name))
+			? &settingRegistry[slot] : NULL;
+	}
+
+	// Accepts the display name ("Vertical Sync") or the SDK symbol ("VSYNCMODE"), ignoring case.
+	// A display name shared by several settings only resolves through the symbol.
+	constexpr const SettingInfo *FindSettingInfoByName(const wchar_t *name)
+	{
+		return MatchSettingName(settingNameIndex[SettingNameSlot(SettingNameHash(name))], name);
+	}
+
+	constexpr bool SettingRegistryIsPerfect(NvU32 slot)
+	{
+		return slot == SETTING_ID_SLOTS ? true :
+			(settingRegistry[slot].name == NULL ||
+				(SettingIdSlot(settingRegistry[slot].settingId) == slot && FindSettingInfoByName(settingRegistry[slot].symbol) == &settingRegistry[slot]))
+			&& SettingRegistryIsPerfect(slot + 1);
+	}
+
+	constexpr NvU32 SettingRegistryCount(NvU32 slot)
+	{
+		return slot == SETTING_ID_SLOTS ? 0 : (settingRegistry[slot].name != NULL ? 1 : 0) + SettingRegistryCount(slot + 1);
+	}
+
+	static_assert(SettingRegistryIsPerfect(0), "SettingRegistry.inl is stale, rerun tools/GenSettingRegistry.py");
+	static_assert(SettingRegistryCount(0) == TOTAL_SETTING_NUM, "SettingRegistry.inl does not cover every ESetting");
+	static_assert(FindSettingInfo(VSYNCMODE_ID)->settingId == VSYNCMODE_ID && FindSettingInfoByName(L"vertical sync") == FindSettingInfo(VSYNCMODE_ID), "VSYNCMODE lookup");
+
+	// True for the default and the values the SDK lists; SETTING_VALUES_ANY and BITFIELD accept everything
+	bool IsLegalSettingValue(const SettingInfo &info, NvU32 value);
+
+	// Compares the registry with the reference tables of NvApiDriverSettings.c,
+	// prints every mismatch and returns NVAPI_ERROR if there is one
+	NvAPI_Status CheckSettingRegistry();
+};
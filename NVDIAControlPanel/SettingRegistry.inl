@@ -0,0 +1,657 @@
+// Generated by tools/GenSettingRegistry.py from NvApiDriverSettings.h/.c, do not edit.
+// Included by SettingRegistry.h inside namespace ControlPanel.
+
+const NvU32 SETTING_REGISTRY_COUNT = 96;
+
+constexpr NvU32 settingIdSeeds[SETTING_ID_BUCKETS] =
+{
+	0x00000002, 0x00000007, 0x00000001, 0x00000003, 0x0000000A, 0x0000000D, 0x00000009, 0x00000001,
+	0x00000001, 0x00000001, 0x00000003, 0x00000001, 0x00000000, 0x00000003, 0x00000010, 0x00000006,
+	0x00000006, 0x00000019, 0x00000001, 0x00000010, 0x00000001, 0x00000006, 0x00000006, 0x00000001,
+	0x00000000, 0x00000001, 0x00000007, 0x00000003, 0x0000000B, 0x00000008, 0x00000007, 0x00000000,
+};
+
+constexpr NvU32 settingNameSeeds[SETTING_NAME_BUCKETS] =
+{
+	0x00000001, 0x00000004, 0x00000001, 0x00000004, 0x00000006, 0x00000002, 0x00000004, 0x00000001,
+	0x00000003, 0x00000006, 0x00000007, 0x00000003, 0x0000000C, 0x00000007, 0x00000005, 0x00000015,
+	0x00000009, 0x00000001, 0x00000001, 0x00000004, 0x00000006, 0x00000005, 0x0000000B, 0x0000000A,
+	0x0000000D, 0x00000006, 0x00000001, 0x00000001, 0x00000002, 0x00000001, 0x00000005, 0x00000015,
+	0x00000001, 0x00000007, 0x00000004, 0x00000006, 0x00000001, 0x00000018, 0x00000001, 0x0000000C,
+	0x00000010, 0x00000010, 0x0000000B, 0x00000011, 0x00000001, 0x00000000, 0x00000002, 0x00000003,
+	0x00000001, 0x00000001, 0x00000001, 0x00000010, 0x00000003, 0x00000006, 0x00000002, 0x00000003,
+	0x00000013, 0x00000006, 0x00000005, 0x00000001, 0x00000004, 0x00000005, 0x00000006, 0x00000001,
+};
+
+constexpr NvU32 settingValuePool[] =
+{
+	OGL_AA_LINE_GAMMA_DISABLED,
+	OGL_AA_LINE_GAMMA_ENABLED,
+	OGL_AA_LINE_GAMMA_MIN,
+	OGL_AA_LINE_GAMMA_MAX,
+	OGL_DEEP_COLOR_SCANOUT_DISABLE,
+	OGL_DEEP_COLOR_SCANOUT_ENABLE,
+	OGL_DEFAULT_SWAP_INTERVAL_TEAR,
+	OGL_DEFAULT_SWAP_INTERVAL_VSYNC_ONE,
+	OGL_DEFAULT_SWAP_INTERVAL_VSYNC,
+	OGL_DEFAULT_SWAP_INTERVAL_VALUE_MASK,
+	(NvU32)OGL_DEFAULT_SWAP_INTERVAL_FORCE_MASK,
+	(NvU32)OGL_DEFAULT_SWAP_INTERVAL_FORCE_OFF,
+	OGL_DEFAULT_SWAP_INTERVAL_FORCE_ON,
+	OGL_DEFAULT_SWAP_INTERVAL_APP_CONTROLLED,
+	(NvU32)OGL_DEFAULT_SWAP_INTERVAL_DISABLE,
+	OGL_DEFAULT_SWAP_INTERVAL_FRACTIONAL_ZERO_SCANLINES,
+	OGL_DEFAULT_SWAP_INTERVAL_FRACTIONAL_ONE_FULL_FRAME_OF_SCANLINES,
+	OGL_DEFAULT_SWAP_INTERVAL_SIGN_POSITIVE,
+	OGL_DEFAULT_SWAP_INTERVAL_SIGN_NEGATIVE,
+	OGL_EVENT_LOG_SEVERITY_THRESHOLD_DISABLE,
+	OGL_EVENT_LOG_SEVERITY_THRESHOLD_CRITICAL,
+	OGL_EVENT_LOG_SEVERITY_THRESHOLD_WARNING,
+	OGL_EVENT_LOG_SEVERITY_THRESHOLD_INFORMATION,
+	OGL_EVENT_LOG_SEVERITY_THRESHOLD_ALL,
+	OGL_FORCE_BLIT_ON,
+	OGL_FORCE_BLIT_OFF,
+	OGL_FORCE_STEREO_OFF,
+	OGL_FORCE_STEREO_ON,
+	OGL_OVERLAY_PIXEL_TYPE_NONE,
+	OGL_OVERLAY_PIXEL_TYPE_CI,
+	OGL_OVERLAY_PIXEL_TYPE_RGBA,
+	OGL_OVERLAY_PIXEL_TYPE_CI_AND_RGBA,
+	OGL_OVERLAY_SUPPORT_OFF,
+	OGL_OVERLAY_SUPPORT_ON,
+	OGL_OVERLAY_SUPPORT_FORCE_SW,
+	(NvU32)OGL_QUALITY_ENHANCEMENTS_HQUAL,
+	OGL_QUALITY_ENHANCEMENTS_QUAL,
+	OGL_QUALITY_ENHANCEMENTS_PERF,
+	OGL_QUALITY_ENHANCEMENTS_HPERF,
+	OGL_SINGLE_BACKDEPTH_BUFFER_DISABLE,
+	OGL_SINGLE_BACKDEPTH_BUFFER_ENABLE,
+	(NvU32)OGL_SINGLE_BACKDEPTH_BUFFER_USE_HW_DEFAULT,
+	OGL_SLI_MULTICAST_DISABLE,
+	OGL_SLI_MULTICAST_ENABLE,
+	OGL_SLI_MULTICAST_FORCE_DISABLE,
+	OGL_SLI_MULTICAST_ALLOW_MOSAIC,
+	OGL_THREAD_CONTROL_ENABLE,
+	OGL_THREAD_CONTROL_DISABLE,
+	OGL_TMON_LEVEL_DISABLE,
+	OGL_TMON_LEVEL_CRITICAL,
+	OGL_TMON_LEVEL_WARNING,
+	OGL_TMON_LEVEL_INFORMATION,
+	OGL_TMON_LEVEL_MOST,
+	OGL_TMON_LEVEL_VERBOSE,
+	OGL_TRIPLE_BUFFER_DISABLED,
+	OGL_TRIPLE_BUFFER_ENABLED,
+	AA_BEHAVIOR_FLAGS_NONE,
+	AA_BEHAVIOR_FLAGS_TREAT_OVERRIDE_AS_APP_CONTROLLED,
+	AA_BEHAVIOR_FLAGS_TREAT_OVERRIDE_AS_ENHANCE,
+	AA_BEHAVIOR_FLAGS_DISABLE_OVERRIDE,
+	AA_BEHAVIOR_FLAGS_TREAT_ENHANCE_AS_APP_CONTROLLED,
+	AA_BEHAVIOR_FLAGS_TREAT_ENHANCE_AS_OVERRIDE,
+	AA_BEHAVIOR_FLAGS_DISABLE_ENHANCE,
+	AA_BEHAVIOR_FLAGS_MAP_VCAA_TO_MULTISAMPLING,
+	AA_BEHAVIOR_FLAGS_SLI_DISABLE_TRANSPARENCY_SUPERSAMPLING,
+	AA_BEHAVIOR_FLAGS_DISABLE_CPLAA,
+	AA_BEHAVIOR_FLAGS_SKIP_RT_DIM_CHECK_FOR_ENHANCE,
+	AA_BEHAVIOR_FLAGS_DISABLE_SLIAA,
+	AA_BEHAVIOR_FLAGS_DEFAULT,
+	(NvU32)AA_BEHAVIOR_FLAGS_AA_RT_BPP_DIV_4,
+	AA_BEHAVIOR_FLAGS_AA_RT_BPP_DIV_4_SHIFT,
+	AA_BEHAVIOR_FLAGS_NON_AA_RT_BPP_DIV_4,
+	AA_BEHAVIOR_FLAGS_NON_AA_RT_BPP_DIV_4_SHIFT,
+	(NvU32)AA_BEHAVIOR_FLAGS_MASK,
+	AA_MODE_ALPHATOCOVERAGE_MODE_MASK,
+	AA_MODE_ALPHATOCOVERAGE_MODE_OFF,
+	AA_MODE_ALPHATOCOVERAGE_MODE_ON,
+	AA_MODE_ALPHATOCOVERAGE_MODE_MAX,
+	AA_MODE_GAMMACORRECTION_MASK,
+	AA_MODE_GAMMACORRECTION_OFF,
+	AA_MODE_GAMMACORRECTION_ON_IF_FOS,
+	AA_MODE_GAMMACORRECTION_ON_ALWAYS,
+	AA_MODE_GAMMACORRECTION_MAX,
+	AA_MODE_GAMMACORRECTION_DEFAULT,
+	AA_MODE_GAMMACORRECTION_DEFAULT_TESLA,
+	AA_MODE_GAMMACORRECTION_DEFAULT_FERMI,
+	AA_MODE_METHOD_NONE,
+	AA_MODE_METHOD_SUPERSAMPLE_2X_H,
+	AA_MODE_METHOD_SUPERSAMPLE_2X_V,
+	AA_MODE_METHOD_SUPERSAMPLE_1_5X1_5,
+	AA_MODE_METHOD_FREE_0x03,
+	AA_MODE_METHOD_FREE_0x04,
+	AA_MODE_METHOD_SUPERSAMPLE_4X,
+	AA_MODE_METHOD_SUPERSAMPLE_4X_BIAS,
+	AA_MODE_METHOD_SUPERSAMPLE_4X_GAUSSIAN,
+	AA_MODE_METHOD_FREE_0x08,
+	AA_MODE_METHOD_FREE_0x09,
+	AA_MODE_METHOD_SUPERSAMPLE_9X,
+	AA_MODE_METHOD_SUPERSAMPLE_9X_BIAS,
+	AA_MODE_METHOD_SUPERSAMPLE_16X,
+	AA_MODE_METHOD_SUPERSAMPLE_16X_BIAS,
+	AA_MODE_METHOD_MULTISAMPLE_2X_DIAGONAL,
+	AA_MODE_METHOD_MULTISAMPLE_2X_QUINCUNX,
+	AA_MODE_METHOD_MULTISAMPLE_4X,
+	AA_MODE_METHOD_FREE_0x11,
+	AA_MODE_METHOD_MULTISAMPLE_4X_GAUSSIAN,
+	AA_MODE_METHOD_MIXEDSAMPLE_4X_SKEWED_4TAP,
+	AA_MODE_METHOD_FREE_0x14,
+	AA_MODE_METHOD_FREE_0x15,
+	AA_MODE_METHOD_MIXEDSAMPLE_6X,
+	AA_MODE_METHOD_MIXEDSAMPLE_6X_SKEWED_6TAP,
+	AA_MODE_METHOD_MIXEDSAMPLE_8X,
+	AA_MODE_METHOD_MIXEDSAMPLE_8X_SKEWED_8TAP,
+	AA_MODE_METHOD_MIXEDSAMPLE_16X,
+	AA_MODE_METHOD_MULTISAMPLE_4X_GAMMA,
+	AA_MODE_METHOD_MULTISAMPLE_16X,
+	AA_MODE_METHOD_VCAA_32X_8v24,
+	AA_MODE_METHOD_CORRUPTION_CHECK,
+	AA_MODE_METHOD_6X_CT,
+	AA_MODE_METHOD_MULTISAMPLE_2X_DIAGONAL_GAMMA,
+	AA_MODE_METHOD_SUPERSAMPLE_4X_GAMMA,
+	AA_MODE_METHOD_MULTISAMPLE_4X_FOSGAMMA,
+	AA_MODE_METHOD_MULTISAMPLE_2X_DIAGONAL_FOSGAMMA,
+	AA_MODE_METHOD_SUPERSAMPLE_4X_FOSGAMMA,
+	AA_MODE_METHOD_MULTISAMPLE_8X,
+	AA_MODE_METHOD_VCAA_8X_4v4,
+	AA_MODE_METHOD_VCAA_16X_4v12,
+	AA_MODE_METHOD_VCAA_16X_8v8,
+	AA_MODE_METHOD_MIXEDSAMPLE_32X,
+	AA_MODE_METHOD_SUPERVCAA_64X_4v12,
+	AA_MODE_METHOD_SUPERVCAA_64X_8v8,
+	AA_MODE_METHOD_MIXEDSAMPLE_64X,
+	AA_MODE_METHOD_MIXEDSAMPLE_128X,
+	AA_MODE_METHOD_COUNT,
+	AA_MODE_METHOD_METHOD_MASK,
+	(NvU32)AA_MODE_METHOD_METHOD_MAX,
+	AA_MODE_REPLAY_SAMPLES_MASK,
+	AA_MODE_REPLAY_SAMPLES_ONE,
+	AA_MODE_REPLAY_SAMPLES_TWO,
+	AA_MODE_REPLAY_SAMPLES_FOUR,
+	AA_MODE_REPLAY_SAMPLES_EIGHT,
+	AA_MODE_REPLAY_SAMPLES_MAX,
+	AA_MODE_REPLAY_MODE_MASK,
+	AA_MODE_REPLAY_MODE_OFF,
+	AA_MODE_REPLAY_MODE_ALPHA_TEST,
+	AA_MODE_REPLAY_MODE_PIXEL_KILL,
+	AA_MODE_REPLAY_MODE_DYN_BRANCH,
+	AA_MODE_REPLAY_MODE_OPTIMAL,
+	AA_MODE_REPLAY_MODE_ALL,
+	AA_MODE_REPLAY_MODE_MAX,
+	AA_MODE_REPLAY_TRANSPARENCY,
+	AA_MODE_REPLAY_DISALLOW_TRAA,
+	AA_MODE_REPLAY_TRANSPARENCY_DEFAULT,
+	AA_MODE_REPLAY_TRANSPARENCY_DEFAULT_TESLA,
+	AA_MODE_REPLAY_TRANSPARENCY_DEFAULT_FERMI,
+	AA_MODE_REPLAY_MASK,
+	AA_MODE_SELECTOR_MASK,
+	AA_MODE_SELECTOR_APP_CONTROL,
+	AA_MODE_SELECTOR_OVERRIDE,
+	AA_MODE_SELECTOR_ENHANCE,
+	AA_MODE_SELECTOR_MAX,
+	AA_MODE_SELECTOR_SLIAA_DISABLED,
+	AA_MODE_SELECTOR_SLIAA_ENABLED,
+	ANISO_MODE_LEVEL_MASK,
+	ANISO_MODE_LEVEL_NONE_POINT,
+	ANISO_MODE_LEVEL_NONE_LINEAR,
+	ANISO_MODE_LEVEL_MAX,
+	ANISO_MODE_LEVEL_DEFAULT,
+	ANISO_MODE_SELECTOR_MASK,
+	ANISO_MODE_SELECTOR_APP,
+	ANISO_MODE_SELECTOR_USER,
+	ANISO_MODE_SELECTOR_COND,
+	ANISO_MODE_SELECTOR_MAX,
+	ANISO_MODE_SELECTOR_DEFAULT,
+	ANSEL_ALLOW_DISALLOWED,
+	ANSEL_ALLOW_ALLOWED,
+	ANSEL_ENABLE_OFF,
+	ANSEL_ENABLE_ON,
+	ANSEL_WHITELISTED_DISALLOWED,
+	ANSEL_WHITELISTED_ALLOWED,
+	APPLICATION_PROFILE_NOTIFICATION_TIMEOUT_DISABLED,
+	APPLICATION_PROFILE_NOTIFICATION_TIMEOUT_NINE_SECONDS,
+	APPLICATION_PROFILE_NOTIFICATION_TIMEOUT_FIFTEEN_SECONDS,
+	APPLICATION_PROFILE_NOTIFICATION_TIMEOUT_THIRTY_SECONDS,
+	APPLICATION_PROFILE_NOTIFICATION_TIMEOUT_ONE_MINUTE,
+	APPLICATION_PROFILE_NOTIFICATION_TIMEOUT_TWO_MINUTES,
+	BATTERY_BOOST_MIN,
+	BATTERY_BOOST_MAX,
+	BATTERY_BOOST_ENABLED,
+	BATTERY_BOOST_DISABLED,
+	CPL_HIDDEN_PROFILE_DISABLED,
+	CPL_HIDDEN_PROFILE_ENABLED,
+	EXPORT_PERF_COUNTERS_OFF,
+	EXPORT_PERF_COUNTERS_ON,
+	FXAA_ALLOW_DISALLOWED,
+	FXAA_ALLOW_ALLOWED,
+	FXAA_ENABLE_OFF,
+	FXAA_ENABLE_ON,
+	FXAA_INDICATOR_ENABLE_OFF,
+	FXAA_INDICATOR_ENABLE_ON,
+	MCSFRSHOWSPLIT_DISABLED,
+	MCSFRSHOWSPLIT_ENABLED,
+	NV_QUALITY_UPSCALING_OFF,
+	NV_QUALITY_UPSCALING_ON,
+	OPTIMUS_MAXAA_MIN,
+	OPTIMUS_MAXAA_MAX,
+	PHYSXINDICATOR_DISABLED,
+	PHYSXINDICATOR_ENABLED,
+	PREFERRED_PSTATE_ADAPTIVE,
+	PREFERRED_PSTATE_PREFER_MAX,
+	PREFERRED_PSTATE_DRIVER_CONTROLLED,
+	PREFERRED_PSTATE_PREFER_CONSISTENT_PERFORMANCE,
+	PREFERRED_PSTATE_PREFER_MIN,
+	PREFERRED_PSTATE_OPTIMAL_POWER,
+	PREFERRED_PSTATE_MIN,
+	PREFERRED_PSTATE_MAX,
+	PREVENT_UI_AF_OVERRIDE_OFF,
+	PREVENT_UI_AF_OVERRIDE_ON,
+	PS_FRAMERATE_LIMITER_DISABLED,
+	PS_FRAMERATE_LIMITER_FPS_20,
+	PS_FRAMERATE_LIMITER_FPS_30,
+	PS_FRAMERATE_LIMITER_FPS_40,
+	PS_FRAMERATE_LIMITER_FPSMASK,
+	PS_FRAMERATE_LIMITER_NO_ALIGN,
+	PS_FRAMERATE_LIMITER_BB_QM,
+	PS_FRAMERATE_LIMITER_LOWER_FPS_TO_ALIGN,
+	PS_FRAMERATE_LIMITER_FORCE_VSYNC_OFF,
+	PS_FRAMERATE_LIMITER_GPS_WEB,
+	PS_FRAMERATE_LIMITER_DISALLOWED,
+	PS_FRAMERATE_LIMITER_USE_CPU_WAIT,
+	PS_FRAMERATE_LIMITER_NO_LAG_OFFSET,
+	PS_FRAMERATE_LIMITER_ACCURATE,
+	PS_FRAMERATE_LIMITER_ALLOW_WINDOWED,
+	PS_FRAMERATE_LIMITER_FORCEON,
+	(NvU32)PS_FRAMERATE_LIMITER_ENABLED,
+	(NvU32)PS_FRAMERATE_LIMITER_OPENGL_REMOTE_DESKTOP,
+	(NvU32)PS_FRAMERATE_LIMITER_MASK,
+	PS_FRAMERATE_LIMITER_2_CONTROL_DELAY_CE,
+	PS_FRAMERATE_LIMITER_2_CONTROL_DELAY_3D,
+	PS_FRAMERATE_LIMITER_2_CONTROL_AVOID_NOOP,
+	PS_FRAMERATE_LIMITER_2_CONTROL_DELAY_CE_PRESENT_3D,
+	PS_FRAMERATE_LIMITER_2_CONTROL_ALLOW_ALL_MAXWELL,
+	PS_FRAMERATE_LIMITER_2_CONTROL_ALLOW_ALL,
+	PS_FRAMERATE_LIMITER_2_CONTROL_FORCE_OFF,
+	PS_FRAMERATE_LIMITER_2_CONTROL_ENABLE_VCE,
+	PS_FRAMERATE_LIMITER_2_CONTROL_DEFAULT_FOR_GM10X,
+	PS_FRAMERATE_LIMITER_GPS_CTRL_DISABLED,
+	PS_FRAMERATE_LIMITER_GPS_CTRL_DECREASE_FILTER_MASK,
+	PS_FRAMERATE_LIMITER_GPS_CTRL_PAUSE_TIME_MASK,
+	PS_FRAMERATE_LIMITER_GPS_CTRL_PAUSE_TIME_SHIFT,
+	PS_FRAMERATE_LIMITER_GPS_CTRL_TARGET_RENDER_TIME_MASK,
+	PS_FRAMERATE_LIMITER_GPS_CTRL_TARGET_RENDER_TIME_SHIFT,
+	PS_FRAMERATE_LIMITER_GPS_CTRL_PERF_STEP_SIZE_MASK,
+	PS_FRAMERATE_LIMITER_GPS_CTRL_PERF_STEP_SIZE_SHIFT,
+	(NvU32)PS_FRAMERATE_LIMITER_GPS_CTRL_INCREASE_FILTER_MASK,
+	PS_FRAMERATE_LIMITER_GPS_CTRL_INCREASE_FILTER_SHIFT,
+	PS_FRAMERATE_LIMITER_GPS_CTRL_OPTIMAL_SETTING,
+	PS_FRAMERATE_MONITOR_CTRL_DISABLED,
+	PS_FRAMERATE_MONITOR_CTRL_THRESHOLD_PCT_MASK,
+	PS_FRAMERATE_MONITOR_CTRL_MOVING_AVG_X_MASK,
+	PS_FRAMERATE_MONITOR_CTRL_MOVING_AVG_X_SHIFT,
+	PS_FRAMERATE_MONITOR_CTRL_ENABLE_FINE_GRAINED,
+	PS_FRAMERATE_MONITOR_CTRL_ENABLE_ON_VSYNC,
+	PS_FRAMERATE_MONITOR_CTRL_VSYNC_OFFSET_MASK,
+	PS_FRAMERATE_MONITOR_CTRL_VSYNC_OFFSET_SHIFT,
+	PS_FRAMERATE_MONITOR_CTRL_FPS_USE_FRL,
+	PS_FRAMERATE_MONITOR_CTRL_FPS_30,
+	PS_FRAMERATE_MONITOR_CTRL_FPS_60,
+	(NvU32)PS_FRAMERATE_MONITOR_CTRL_FPS_MASK,
+	PS_FRAMERATE_MONITOR_CTRL_FPS_SHIFT,
+	PS_FRAMERATE_MONITOR_CTRL_OPTIMAL_SETTING,
+	PS_FRAMERATE_MONITOR_CTRL_VSYNC_OPTIMAL_SETTING,
+	SHIM_MCCOMPAT_INTEGRATED,
+	SHIM_MCCOMPAT_ENABLE,
+	SHIM_MCCOMPAT_USER_EDITABLE,
+	SHIM_MCCOMPAT_MASK,
+	SHIM_MCCOMPAT_VIDEO_MASK,
+	SHIM_MCCOMPAT_VARYING_BIT,
+	SHIM_MCCOMPAT_AUTO_SELECT,
+	(NvU32)SHIM_MCCOMPAT_OVERRIDE_BIT,
+	SHIM_RENDERING_MODE_INTEGRATED,
+	SHIM_RENDERING_MODE_ENABLE,
+	SHIM_RENDERING_MODE_USER_EDITABLE,
+	SHIM_RENDERING_MODE_MASK,
+	SHIM_RENDERING_MODE_VIDEO_MASK,
+	SHIM_RENDERING_MODE_VARYING_BIT,
+	SHIM_RENDERING_MODE_AUTO_SELECT,
+	(NvU32)SHIM_RENDERING_MODE_OVERRIDE_BIT,
+	SHIM_RENDERING_OPTIONS_DEFAULT_RENDERING_MODE,
+	SHIM_RENDERING_OPTIONS_DISABLE_ASYNC_PRESENT,
+	SHIM_RENDERING_OPTIONS_EHSHELL_DETECT,
+	SHIM_RENDERING_OPTIONS_FLASHPLAYER_HOST_DETECT,
+	SHIM_RENDERING_OPTIONS_VIDEO_DRM_APP_DETECT,
+	SHIM_RENDERING_OPTIONS_IGNORE_OVERRIDES,
+	SHIM_RENDERING_OPTIONS_RESERVED1,
+	SHIM_RENDERING_OPTIONS_ENABLE_DWM_ASYNC_PRESENT,
+	SHIM_RENDERING_OPTIONS_RESERVED2,
+	SHIM_RENDERING_OPTIONS_ALLOW_INHERITANCE,
+	SHIM_RENDERING_OPTIONS_DISABLE_WRAPPERS,
+	SHIM_RENDERING_OPTIONS_DISABLE_DXGI_WRAPPERS,
+	SHIM_RENDERING_OPTIONS_PRUNE_UNSUPPORTED_FORMATS,
+	SHIM_RENDERING_OPTIONS_ENABLE_ALPHA_FORMAT,
+	SHIM_RENDERING_OPTIONS_IGPU_TRANSCODING,
+	SHIM_RENDERING_OPTIONS_DISABLE_CUDA,
+	SHIM_RENDERING_OPTIONS_ALLOW_CP_CAPS_FOR_VIDEO,
+	SHIM_RENDERING_OPTIONS_IGPU_TRANSCODING_FWD_OPTIMUS,
+	SHIM_RENDERING_OPTIONS_DISABLE_DURING_SECURE_BOOT,
+	SHIM_RENDERING_OPTIONS_INVERT_FOR_QUADRO,
+	SHIM_RENDERING_OPTIONS_INVERT_FOR_MSHYBRID,
+	SHIM_RENDERING_OPTIONS_REGISTER_PROCESS_ENABLE_GOLD,
+	SHIM_RENDERING_OPTIONS_HANDLE_WINDOWED_MODE_PERF_OPT,
+	SHIM_RENDERING_OPTIONS_HANDLE_WIN7_ASYNC_RUNTIME_BUG,
+	SHIM_RENDERING_OPTIONS_EXPLICIT_ADAPTER_OPTED_BY_APP,
+	SLI_GPU_COUNT_AUTOSELECT,
+	SLI_GPU_COUNT_ONE,
+	SLI_GPU_COUNT_TWO,
+	SLI_GPU_COUNT_THREE,
+	SLI_GPU_COUNT_FOUR,
+	SLI_PREDEFINED_GPU_COUNT_AUTOSELECT,
+	SLI_PREDEFINED_GPU_COUNT_ONE,
+	SLI_PREDEFINED_GPU_COUNT_TWO,
+	SLI_PREDEFINED_GPU_COUNT_THREE,
+	SLI_PREDEFINED_GPU_COUNT_FOUR,
+	SLI_PREDEFINED_GPU_COUNT_DX10_AUTOSELECT,
+	SLI_PREDEFINED_GPU_COUNT_DX10_ONE,
+	SLI_PREDEFINED_GPU_COUNT_DX10_TWO,
+	SLI_PREDEFINED_GPU_COUNT_DX10_THREE,
+	SLI_PREDEFINED_GPU_COUNT_DX10_FOUR,
+	SLI_PREDEFINED_MODE_AUTOSELECT,
+	SLI_PREDEFINED_MODE_FORCE_SINGLE,
+	SLI_PREDEFINED_MODE_FORCE_AFR,
+	SLI_PREDEFINED_MODE_FORCE_AFR2,
+	SLI_PREDEFINED_MODE_FORCE_SFR,
+	SLI_PREDEFINED_MODE_FORCE_AFR_OF_SFR__FALLBACK_3AFR,
+	SLI_PREDEFINED_MODE_DX10_AUTOSELECT,
+	SLI_PREDEFINED_MODE_DX10_FORCE_SINGLE,
+	SLI_PREDEFINED_MODE_DX10_FORCE_AFR,
+	SLI_PREDEFINED_MODE_DX10_FORCE_AFR2,
+	SLI_PREDEFINED_MODE_DX10_FORCE_SFR,
+	SLI_PREDEFINED_MODE_DX10_FORCE_AFR_OF_SFR__FALLBACK_3AFR,
+	SLI_RENDERING_MODE_AUTOSELECT,
+	SLI_RENDERING_MODE_FORCE_SINGLE,
+	SLI_RENDERING_MODE_FORCE_AFR,
+	SLI_RENDERING_MODE_FORCE_AFR2,
+	SLI_RENDERING_MODE_FORCE_SFR,
+	SLI_RENDERING_MODE_FORCE_AFR_OF_SFR__FALLBACK_3AFR,
+	VRPRERENDERLIMIT_MIN,
+	VRPRERENDERLIMIT_MAX,
+	VRPRERENDERLIMIT_APP_CONTROLLED,
+	VRPRERENDERLIMIT_DEFAULT,
+	VRRFEATUREINDICATOR_DISABLED,
+	VRRFEATUREINDICATOR_ENABLED,
+	VRROVERLAYINDICATOR_DISABLED,
+	VRROVERLAYINDICATOR_ENABLED,
+	VRRREQUESTSTATE_DISABLED,
+	VRRREQUESTSTATE_FULLSCREEN_ONLY,
+	VRRREQUESTSTATE_FULLSCREEN_AND_WINDOWED,
+	VRR_APP_OVERRIDE_ALLOW,
+	VRR_APP_OVERRIDE_FORCE_OFF,
+	VRR_APP_OVERRIDE_DISALLOW,
+	VRR_APP_OVERRIDE_ULMB,
+	VRR_APP_OVERRIDE_FIXED_REFRESH,
+	VRR_APP_OVERRIDE_REQUEST_STATE_ALLOW,
+	VRR_APP_OVERRIDE_REQUEST_STATE_FORCE_OFF,
+	VRR_APP_OVERRIDE_REQUEST_STATE_DISALLOW,
+	VRR_APP_OVERRIDE_REQUEST_STATE_ULMB,
+	VRR_APP_OVERRIDE_REQUEST_STATE_FIXED_REFRESH,
+	VRR_MODE_DISABLED,
+	VRR_MODE_FULLSCREEN_ONLY,
+	VRR_MODE_FULLSCREEN_AND_WINDOWED,
+	VSYNCSMOOTHAFR_OFF,
+	VSYNCSMOOTHAFR_ON,
+	VSYNCVRRCONTROL_DISABLE,
+	VSYNCVRRCONTROL_ENABLE,
+	(NvU32)VSYNCVRRCONTROL_NOTSUPPORTED,
+	VSYNC_BEHAVIOR_FLAGS_NONE,
+	VSYNC_BEHAVIOR_FLAGS_DEFAULT,
+	VSYNC_BEHAVIOR_FLAGS_IGNORE_FLIPINTERVAL_MULTIPLE,
+	WKS_API_STEREO_EYES_EXCHANGE_OFF,
+	WKS_API_STEREO_EYES_EXCHANGE_ON,
+	WKS_API_STEREO_MODE_SHUTTER_GLASSES,
+	WKS_API_STEREO_MODE_VERTICAL_INTERLACED,
+	WKS_API_STEREO_MODE_TWINVIEW,
+	WKS_API_STEREO_MODE_NV17_SHUTTER_GLASSES_AUTO,
+	WKS_API_STEREO_MODE_NV17_SHUTTER_GLASSES_DAC0,
+	WKS_API_STEREO_MODE_NV17_SHUTTER_GLASSES_DAC1,
+	WKS_API_STEREO_MODE_COLOR_LINE,
+	WKS_API_STEREO_MODE_COLOR_INTERLEAVED,
+	WKS_API_STEREO_MODE_ANAGLYPH,
+	WKS_API_STEREO_MODE_HORIZONTAL_INTERLACED,
+	WKS_API_STEREO_MODE_SIDE_FIELD,
+	WKS_API_STEREO_MODE_SUB_FIELD,
+	WKS_API_STEREO_MODE_CHECKERBOARD,
+	WKS_API_STEREO_MODE_INVERSE_CHECKERBOARD,
+	WKS_API_STEREO_MODE_TRIDELITY_SL,
+	WKS_API_STEREO_MODE_TRIDELITY_MV,
+	WKS_API_STEREO_MODE_SEEFRONT,
+	WKS_API_STEREO_MODE_STEREO_MIRROR,
+	WKS_API_STEREO_MODE_FRAME_SEQUENTIAL,
+	WKS_API_STEREO_MODE_AUTODETECT_PASSIVE_MODE,
+	WKS_API_STEREO_MODE_AEGIS_DT_FRAME_SEQUENTIAL,
+	WKS_API_STEREO_MODE_OEM_EMITTER_FRAME_SEQUENTIAL,
+	WKS_API_STEREO_MODE_DP_INBAND,
+	(NvU32)WKS_API_STEREO_MODE_USE_HW_DEFAULT,
+	WKS_API_STEREO_MODE_DEFAULT_GL,
+	WKS_MEMORY_ALLOCATION_POLICY_AS_NEEDED,
+	WKS_MEMORY_ALLOCATION_POLICY_MODERATE_PRE_ALLOCATION,
+	WKS_MEMORY_ALLOCATION_POLICY_AGGRESSIVE_PRE_ALLOCATION,
+	WKS_STEREO_DONGLE_SUPPORT_OFF,
+	WKS_STEREO_DONGLE_SUPPORT_DAC,
+	WKS_STEREO_DONGLE_SUPPORT_DLP,
+	WKS_STEREO_SUPPORT_OFF,
+	WKS_STEREO_SUPPORT_ON,
+	WKS_STEREO_SWAP_MODE_APPLICATION_CONTROL,
+	WKS_STEREO_SWAP_MODE_PER_EYE,
+	WKS_STEREO_SWAP_MODE_PER_EYE_PAIR,
+	WKS_STEREO_SWAP_MODE_LEGACY_BEHAVIOR,
+	AO_MODE_OFF,
+	AO_MODE_LOW,
+	AO_MODE_MEDIUM,
+	AO_MODE_HIGH,
+	AO_MODE_ACTIVE_DISABLED,
+	AO_MODE_ACTIVE_ENABLED,
+	AUTO_LODBIASADJUST_OFF,
+	AUTO_LODBIASADJUST_ON,
+	EXPORT_PERF_COUNTERS_DX9_ONLY_OFF,
+	EXPORT_PERF_COUNTERS_DX9_ONLY_ON,
+	(NvU32)LODBIASADJUST_MIN,
+	LODBIASADJUST_MAX,
+	MAXWELL_B_SAMPLE_INTERLEAVE_OFF,
+	MAXWELL_B_SAMPLE_INTERLEAVE_ON,
+	PRERENDERLIMIT_MIN,
+	PRERENDERLIMIT_MAX,
+	PRERENDERLIMIT_APP_CONTROLLED,
+	PS_SHADERDISKCACHE_OFF,
+	PS_SHADERDISKCACHE_ON,
+	PS_TEXFILTER_ANISO_OPTS2_OFF,
+	PS_TEXFILTER_ANISO_OPTS2_ON,
+	PS_TEXFILTER_BILINEAR_IN_ANISO_OFF,
+	PS_TEXFILTER_BILINEAR_IN_ANISO_ON,
+	PS_TEXFILTER_DISABLE_TRILIN_SLOPE_OFF,
+	PS_TEXFILTER_DISABLE_TRILIN_SLOPE_ON,
+	PS_TEXFILTER_NO_NEG_LODBIAS_OFF,
+	PS_TEXFILTER_NO_NEG_LODBIAS_ON,
+	(NvU32)QUALITY_ENHANCEMENTS_HIGHQUALITY,
+	QUALITY_ENHANCEMENTS_QUALITY,
+	QUALITY_ENHANCEMENTS_PERFORMANCE,
+	QUALITY_ENHANCEMENTS_HIGHPERFORMANCE,
+	REFRESH_RATE_OVERRIDE_APPLICATION_CONTROLLED,
+	REFRESH_RATE_OVERRIDE_HIGHEST_AVAILABLE,
+	REFRESH_RATE_OVERRIDE_LOW_LATENCY_RR_MASK,
+	SET_POWER_THROTTLE_FOR_PCIe_COMPLIANCE_OFF,
+	SET_POWER_THROTTLE_FOR_PCIe_COMPLIANCE_ON,
+	SET_VAB_DATA_ZERO,
+	SET_VAB_DATA_UINT_ONE,
+	SET_VAB_DATA_FLOAT_ONE,
+	SET_VAB_DATA_FLOAT_POS_INF,
+	SET_VAB_DATA_FLOAT_NAN,
+	(NvU32)SET_VAB_DATA_USE_API_DEFAULTS,
+	VSYNCMODE_PASSIVE,
+	VSYNCMODE_FORCEOFF,
+	VSYNCMODE_FORCEON,
+	VSYNCMODE_FLIPINTERVAL2,
+	VSYNCMODE_FLIPINTERVAL3,
+	VSYNCMODE_FLIPINTERVAL4,
+	VSYNCMODE_VIRTUAL,
+	(NvU32)VSYNCTEARCONTROL_DISABLE,
+	(NvU32)VSYNCTEARCONTROL_ENABLE,
+};
+
+constexpr const wchar_t *settingStringPool[] =
+{
+	OGL_IMPLICIT_GPU_AFFINITY_AUTOSELECT,
+	CUDA_EXCLUDED_GPUS_NONE,
+	D3DOGL_GPU_MAX_POWER_DEFAULTPOWER,
+};
+
+// Indexed by SettingIdSlot(settingId)
+constexpr SettingInfo settingRegistry[SETTING_ID_SLOTS] =
+{
+	{ FXAA_ALLOW_ID, FXAA_ALLOW_STRING, L"FXAA_ALLOW", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 194, 2, FXAA_ALLOW_ALLOWED, NULL, 0, 0 },
+	{ ANISO_MODE_LEVEL_ID, ANISO_MODE_LEVEL_STRING, L"ANISO_MODE_LEVEL", NVDRS_DWORD_TYPE, SETTING_VALUES_BITFIELD, 163, 5, ANISO_MODE_LEVEL_DEFAULT, NULL, 0, 0 },
+	{ OGL_DEFAULT_SWAP_INTERVAL_FRACTIONAL_ID, OGL_DEFAULT_SWAP_INTERVAL_FRACTIONAL_STRING, L"OGL_DEFAULT_SWAP_INTERVAL_FRACTIONAL", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 15, 2, 0x00000000, NULL, 0, 0 },
+	{ OGL_TRIPLE_BUFFER_ID, OGL_TRIPLE_BUFFER_STRING, L"OGL_TRIPLE_BUFFER", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 54, 2, OGL_TRIPLE_BUFFER_DISABLED, NULL, 0, 0 },
+	{ OGL_DEFAULT_SWAP_INTERVAL_SIGN_ID, OGL_DEFAULT_SWAP_INTERVAL_SIGN_STRING, L"OGL_DEFAULT_SWAP_INTERVAL_SIGN", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 17, 2, OGL_DEFAULT_SWAP_INTERVAL_SIGN_POSITIVE, NULL, 0, 0 },
+	{ OGL_SINGLE_BACKDEPTH_BUFFER_ID, OGL_SINGLE_BACKDEPTH_BUFFER_STRING, L"OGL_SINGLE_BACKDEPTH_BUFFER", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 39, 3, OGL_SINGLE_BACKDEPTH_BUFFER_DISABLE, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ PS_SHADERDISKCACHE_ID, PS_SHADERDISKCACHE_STRING, L"PS_SHADERDISKCACHE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 434, 2, 0x00000000, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ OGL_OVERLAY_PIXEL_TYPE_ID, OGL_OVERLAY_PIXEL_TYPE_STRING, L"OGL_OVERLAY_PIXEL_TYPE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 28, 4, OGL_OVERLAY_PIXEL_TYPE_CI, NULL, 0, 0 },
+	{ ICAFE_LOGO_CONFIG_ID, ICAFE_LOGO_CONFIG_STRING, L"ICAFE_LOGO_CONFIG", NVDRS_WSTRING_TYPE, SETTING_VALUES_ANY, 3, 0, 0, L"", 0, 0 },
+	{ VRR_APP_OVERRIDE_ID, VRR_APP_OVERRIDE_STRING, L"VRR_APP_OVERRIDE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 357, 5, VRR_APP_OVERRIDE_ALLOW, NULL, 0, 0 },
+	{ ANSEL_ALLOW_ID, ANSEL_ALLOW_STRING, L"ANSEL_ALLOW", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 174, 2, ANSEL_ALLOW_ALLOWED, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ SLI_RENDERING_MODE_ID, SLI_RENDERING_MODE_STRING, L"SLI_RENDERING_MODE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 340, 6, SLI_RENDERING_MODE_AUTOSELECT, NULL, 0, 0 },
+	{ MAXWELL_B_SAMPLE_INTERLEAVE_ID, MAXWELL_B_SAMPLE_INTERLEAVE_STRING, L"MAXWELL_B_SAMPLE_INTERLEAVE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 429, 2, MAXWELL_B_SAMPLE_INTERLEAVE_OFF, NULL, 0, 0 },
+	{ AA_MODE_SELECTOR_ID, AA_MODE_SELECTOR_STRING, L"AA_MODE_SELECTOR", NVDRS_DWORD_TYPE, SETTING_VALUES_BITFIELD, 156, 5, AA_MODE_SELECTOR_APP_CONTROL, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ CUDA_EXCLUDED_GPUS_ID, CUDA_EXCLUDED_GPUS_STRING, L"CUDA_EXCLUDED_GPUS", NVDRS_WSTRING_TYPE, SETTING_VALUES_ANY, 1, 1, 0, L"none", 0, 0 },
+	{ VRROVERLAYINDICATOR_ID, VRROVERLAYINDICATOR_STRING, L"VRROVERLAYINDICATOR", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 352, 2, VRROVERLAYINDICATOR_ENABLED, NULL, 0, 0 },
+	{ CPL_HIDDEN_PROFILE_ID, CPL_HIDDEN_PROFILE_STRING, L"CPL_HIDDEN_PROFILE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 190, 2, CPL_HIDDEN_PROFILE_DISABLED, NULL, 0, 0 },
+	{ VSYNCVRRCONTROL_ID, VSYNCVRRCONTROL_STRING, L"VSYNCVRRCONTROL", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 372, 3, VSYNCVRRCONTROL_ENABLE, NULL, 0, 0 },
+	{ AO_MODE_ACTIVE_ID, AO_MODE_ACTIVE_STRING, L"AO_MODE_ACTIVE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 421, 2, AO_MODE_ACTIVE_DISABLED, NULL, 0, 0 },
+	{ VRR_APP_OVERRIDE_REQUEST_STATE_ID, VRR_APP_OVERRIDE_REQUEST_STATE_STRING, L"VRR_APP_OVERRIDE_REQUEST_STATE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 362, 5, VRR_APP_OVERRIDE_REQUEST_STATE_ALLOW, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ OGL_MAX_FRAMES_ALLOWED_ID, OGL_MAX_FRAMES_ALLOWED_STRING, L"OGL_MAX_FRAMES_ALLOWED", NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 28, 0, 0x00000002, NULL, 0, 0 },
+	{ OGL_DEFAULT_SWAP_INTERVAL_ID, OGL_DEFAULT_SWAP_INTERVAL_STRING, L"OGL_DEFAULT_SWAP_INTERVAL", NVDRS_DWORD_TYPE, SETTING_VALUES_BITFIELD, 6, 9, OGL_DEFAULT_SWAP_INTERVAL_VSYNC_ONE, NULL, 0, 0 },
+	{ REFRESH_RATE_OVERRIDE_ID, REFRESH_RATE_OVERRIDE_STRING, L"REFRESH_RATE_OVERRIDE", NVDRS_DWORD_TYPE, SETTING_VALUES_BITFIELD, 448, 3, REFRESH_RATE_OVERRIDE_APPLICATION_CONTROLLED, NULL, 0, 0 },
+	{ SLI_PREDEFINED_MODE_ID, SLI_PREDEFINED_MODE_STRING, L"SLI_PREDEFINED_MODE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 328, 6, SLI_PREDEFINED_MODE_AUTOSELECT, NULL, 0, 0 },
+	{ OGL_FORCE_STEREO_ID, OGL_FORCE_STEREO_STRING, L"OGL_FORCE_STEREO", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 26, 2, OGL_FORCE_STEREO_OFF, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ FXAA_ENABLE_ID, FXAA_ENABLE_STRING, L"FXAA_ENABLE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 196, 2, FXAA_ENABLE_OFF, NULL, 0, 0 },
+	{ FXAA_INDICATOR_ENABLE_ID, FXAA_INDICATOR_ENABLE_STRING, L"FXAA_INDICATOR_ENABLE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 198, 2, FXAA_INDICATOR_ENABLE_OFF, NULL, 0, 0 },
+	{ SLI_PREDEFINED_GPU_COUNT_ID, SLI_PREDEFINED_GPU_COUNT_STRING, L"SLI_PREDEFINED_GPU_COUNT", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 318, 5, SLI_PREDEFINED_GPU_COUNT_AUTOSELECT, NULL, 0, 0 },
+	{ PS_FRAMERATE_LIMITER_2_CONTROL_ID, PS_FRAMERATE_LIMITER_2_CONTROL_STRING, L"PS_FRAMERATE_LIMITER_2_CONTROL", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 237, 9, 0x00000000, NULL, 0, 0 },
+	{ OGL_THREAD_CONTROL_ID, OGL_THREAD_CONTROL_STRING, L"OGL_THREAD_CONTROL", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 46, 2, 0x00000000, NULL, 0, 0 },
+	{ PS_TEXFILTER_DISABLE_TRILIN_SLOPE_ID, PS_TEXFILTER_DISABLE_TRILIN_SLOPE_STRING, L"PS_TEXFILTER_DISABLE_TRILIN_SLOPE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 440, 2, PS_TEXFILTER_DISABLE_TRILIN_SLOPE_OFF, NULL, 0, 0 },
+	{ EXPORT_PERF_COUNTERS_DX9_ONLY_ID, EXPORT_PERF_COUNTERS_DX9_ONLY_STRING, L"EXPORT_PERF_COUNTERS_DX9_ONLY", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 425, 2, EXPORT_PERF_COUNTERS_DX9_ONLY_OFF, NULL, 0, 0 },
+	{ PREVENT_UI_AF_OVERRIDE_ID, PREVENT_UI_AF_OVERRIDE_STRING, L"PREVENT_UI_AF_OVERRIDE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 216, 2, PREVENT_UI_AF_OVERRIDE_OFF, NULL, 0, 0 },
+	{ SET_VAB_DATA_ID, SET_VAB_DATA_STRING, L"SET_VAB_DATA", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 453, 6, (NvU32)SET_VAB_DATA_USE_API_DEFAULTS, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ QUALITY_ENHANCEMENTS_ID, QUALITY_ENHANCEMENTS_STRING, L"QUALITY_ENHANCEMENTS", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 444, 4, QUALITY_ENHANCEMENTS_QUALITY, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ SET_POWER_THROTTLE_FOR_PCIe_COMPLIANCE_ID, SET_POWER_THROTTLE_FOR_PCIe_COMPLIANCE_STRING, L"SET_POWER_THROTTLE_FOR_PCIe_COMPLIANCE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 451, 2, SET_POWER_THROTTLE_FOR_PCIe_COMPLIANCE_OFF, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ LODBIASADJUST_ID, LODBIASADJUST_STRING, L"LODBIASADJUST", NVDRS_DWORD_TYPE, SETTING_VALUES_RANGE, 427, 2, 0x00000000, NULL, (NvU32)LODBIASADJUST_MIN, LODBIASADJUST_MAX },
+	{ VSYNC_BEHAVIOR_FLAGS_ID, VSYNC_BEHAVIOR_FLAGS_STRING, L"VSYNC_BEHAVIOR_FLAGS", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 375, 3, VSYNC_BEHAVIOR_FLAGS_DEFAULT, NULL, 0, 0 },
+	{ PS_TEXFILTER_ANISO_OPTS2_ID, PS_TEXFILTER_ANISO_OPTS2_STRING, L"PS_TEXFILTER_ANISO_OPTS2", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 436, 2, PS_TEXFILTER_ANISO_OPTS2_OFF, NULL, 0, 0 },
+	{ SHIM_RENDERING_MODE_ID, SHIM_RENDERING_MODE_STRING, L"SHIM_RENDERING_MODE", NVDRS_DWORD_TYPE, SETTING_VALUES_BITFIELD, 280, 8, SHIM_RENDERING_MODE_AUTO_SELECT, NULL, 0, 0 },
+	{ OGL_OVERLAY_SUPPORT_ID, OGL_OVERLAY_SUPPORT_STRING, L"OGL_OVERLAY_SUPPORT", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 32, 3, OGL_OVERLAY_SUPPORT_OFF, NULL, 0, 0 },
+	{ OGL_EVENT_LOG_SEVERITY_THRESHOLD_ID, OGL_EVENT_LOG_SEVERITY_THRESHOLD_STRING, L"OGL_EVENT_LOG_SEVERITY_THRESHOLD", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 19, 5, OGL_EVENT_LOG_SEVERITY_THRESHOLD_ALL, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ VRPRERENDERLIMIT_ID, VRPRERENDERLIMIT_STRING, L"VRPRERENDERLIMIT", NVDRS_DWORD_TYPE, SETTING_VALUES_RANGE, 346, 4, VRPRERENDERLIMIT_DEFAULT, NULL, VRPRERENDERLIMIT_MIN, VRPRERENDERLIMIT_MAX },
+	{ APPLICATION_STEAM_ID_ID, APPLICATION_STEAM_ID_STRING, L"APPLICATION_STEAM_ID", NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 186, 0, 0x00000000, NULL, 0, 0 },
+	{ AA_MODE_SELECTOR_SLIAA_ID, AA_MODE_SELECTOR_SLIAA_STRING, L"AA_MODE_SELECTOR_SLIAA", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 161, 2, AA_MODE_SELECTOR_SLIAA_DISABLED, NULL, 0, 0 },
+	{ OGL_TMON_LEVEL_ID, OGL_TMON_LEVEL_STRING, L"OGL_TMON_LEVEL", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 48, 6, OGL_TMON_LEVEL_MOST, NULL, 0, 0 },
+	{ OGL_AA_LINE_GAMMA_ID, OGL_AA_LINE_GAMMA_STRING, L"OGL_AA_LINE_GAMMA", NVDRS_DWORD_TYPE, SETTING_VALUES_RANGE, 0, 4, OGL_AA_LINE_GAMMA_DISABLED, NULL, OGL_AA_LINE_GAMMA_MIN, OGL_AA_LINE_GAMMA_MAX },
+	{ VSYNCSMOOTHAFR_ID, VSYNCSMOOTHAFR_STRING, L"VSYNCSMOOTHAFR", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 370, 2, VSYNCSMOOTHAFR_OFF, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ WKS_STEREO_SWAP_MODE_ID, WKS_STEREO_SWAP_MODE_STRING, L"WKS_STEREO_SWAP_MODE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 413, 4, WKS_STEREO_SWAP_MODE_APPLICATION_CONTROL, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ NV_QUALITY_UPSCALING_ID, NV_QUALITY_UPSCALING_STRING, L"NV_QUALITY_UPSCALING", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 202, 2, NV_QUALITY_UPSCALING_OFF, NULL, 0, 0 },
+	{ VRRREQUESTSTATE_ID, VRRREQUESTSTATE_STRING, L"VRRREQUESTSTATE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 354, 3, VRRREQUESTSTATE_FULLSCREEN_ONLY, NULL, 0, 0 },
+	{ VSYNCTEARCONTROL_ID, VSYNCTEARCONTROL_STRING, L"VSYNCTEARCONTROL", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 466, 2, (NvU32)VSYNCTEARCONTROL_DISABLE, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ PS_TEXFILTER_BILINEAR_IN_ANISO_ID, PS_TEXFILTER_BILINEAR_IN_ANISO_STRING, L"PS_TEXFILTER_BILINEAR_IN_ANISO", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 438, 2, PS_TEXFILTER_BILINEAR_IN_ANISO_OFF, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ AA_BEHAVIOR_FLAGS_ID, AA_BEHAVIOR_FLAGS_STRING, L"AA_BEHAVIOR_FLAGS", NVDRS_DWORD_TYPE, SETTING_VALUES_BITFIELD, 56, 18, AA_BEHAVIOR_FLAGS_DEFAULT, NULL, 0, 0 },
+	{ SHIM_MCCOMPAT_ID, SHIM_MCCOMPAT_STRING, L"SHIM_MCCOMPAT", NVDRS_DWORD_TYPE, SETTING_VALUES_BITFIELD, 272, 8, SHIM_MCCOMPAT_AUTO_SELECT, NULL, 0, 0 },
+	{ WKS_STEREO_SUPPORT_ID, WKS_STEREO_SUPPORT_STRING, L"WKS_STEREO_SUPPORT", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 411, 2, WKS_STEREO_SUPPORT_OFF, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ SLI_GPU_COUNT_ID, SLI_GPU_COUNT_STRING, L"SLI_GPU_COUNT", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 313, 5, SLI_GPU_COUNT_AUTOSELECT, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ MCSFRSHOWSPLIT_ID, MCSFRSHOWSPLIT_STRING, L"MCSFRSHOWSPLIT", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 200, 2, MCSFRSHOWSPLIT_DISABLED, NULL, 0, 0 },
+	{ OGL_FORCE_BLIT_ID, OGL_FORCE_BLIT_STRING, L"OGL_FORCE_BLIT", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 24, 2, OGL_FORCE_BLIT_OFF, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ BATTERY_BOOST_ID, BATTERY_BOOST_STRING, L"BATTERY_BOOST", NVDRS_DWORD_TYPE, SETTING_VALUES_RANGE, 186, 4, BATTERY_BOOST_DISABLED, NULL, BATTERY_BOOST_MIN, BATTERY_BOOST_MAX },
+	{ WKS_API_STEREO_MODE_ID, WKS_API_STEREO_MODE_STRING, L"WKS_API_STEREO_MODE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 380, 25, WKS_API_STEREO_MODE_SHUTTER_GLASSES, NULL, 0, 0 },
+	{ PRERENDERLIMIT_ID, PRERENDERLIMIT_STRING, L"PRERENDERLIMIT", NVDRS_DWORD_TYPE, SETTING_VALUES_RANGE, 431, 3, PRERENDERLIMIT_APP_CONTROLLED, NULL, PRERENDERLIMIT_MIN, PRERENDERLIMIT_MAX },
+	{ OGL_SLI_MULTICAST_ID, OGL_SLI_MULTICAST_STRING, L"OGL_SLI_MULTICAST", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 42, 4, OGL_SLI_MULTICAST_DISABLE, NULL, 0, 0 },
+	{ AA_MODE_REPLAY_ID, AA_MODE_REPLAY_STRING, L"AA_MODE_REPLAY", NVDRS_DWORD_TYPE, SETTING_VALUES_BITFIELD, 136, 20, 0x00000000, NULL, 0, 0 },
+	{ OPTIMUS_MAXAA_ID, OPTIMUS_MAXAA_STRING, L"OPTIMUS_MAXAA", NVDRS_DWORD_TYPE, SETTING_VALUES_RANGE, 204, 2, 0x00000000, NULL, OPTIMUS_MAXAA_MIN, OPTIMUS_MAXAA_MAX },
+	{ PS_FRAMERATE_LIMITER_ID, PS_FRAMERATE_LIMITER_STRING, L"PS_FRAMERATE_LIMITER", NVDRS_DWORD_TYPE, SETTING_VALUES_BITFIELD, 218, 19, PS_FRAMERATE_LIMITER_DISABLED, NULL, 0, 0 },
+	{ AA_MODE_ALPHATOCOVERAGE_ID, AA_MODE_ALPHATOCOVERAGE_STRING, L"AA_MODE_ALPHATOCOVERAGE", NVDRS_DWORD_TYPE, SETTING_VALUES_BITFIELD, 74, 4, 0x00000000, NULL, 0, 0 },
+	{ SLI_PREDEFINED_MODE_DX10_ID, SLI_PREDEFINED_MODE_DX10_STRING, L"SLI_PREDEFINED_MODE_DX10", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 334, 6, SLI_PREDEFINED_MODE_DX10_AUTOSELECT, NULL, 0, 0 },
+	{ PS_FRAMERATE_LIMITER_GPS_CTRL_ID, PS_FRAMERATE_LIMITER_GPS_CTRL_STRING, L"PS_FRAMERATE_LIMITER_GPS_CTRL", NVDRS_DWORD_TYPE, SETTING_VALUES_BITFIELD, 246, 11, PS_FRAMERATE_LIMITER_GPS_CTRL_DISABLED, NULL, 0, 0 },
+	{ D3DOGL_GPU_MAX_POWER_ID, D3DOGL_GPU_MAX_POWER_STRING, L"D3DOGL_GPU_MAX_POWER", NVDRS_WSTRING_TYPE, SETTING_VALUES_ANY, 2, 1, 0, L"0", 0, 0 },
+	{ WKS_API_STEREO_EYES_EXCHANGE_ID, WKS_API_STEREO_EYES_EXCHANGE_STRING, L"WKS_API_STEREO_EYES_EXCHANGE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 378, 2, WKS_API_STEREO_EYES_EXCHANGE_OFF, NULL, 0, 0 },
+	{ AA_MODE_GAMMACORRECTION_ID, AA_MODE_GAMMACORRECTION_STRING, L"AA_MODE_GAMMACORRECTION", NVDRS_DWORD_TYPE, SETTING_VALUES_BITFIELD, 78, 8, 0x00000000, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ SHIM_RENDERING_OPTIONS_ID, SHIM_RENDERING_OPTIONS_STRING, L"SHIM_RENDERING_OPTIONS", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 288, 25, SHIM_RENDERING_OPTIONS_DEFAULT_RENDERING_MODE, NULL, 0, 0 },
+	{ WKS_STEREO_DONGLE_SUPPORT_ID, WKS_STEREO_DONGLE_SUPPORT_STRING, L"WKS_STEREO_DONGLE_SUPPORT", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 408, 3, WKS_STEREO_DONGLE_SUPPORT_OFF, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ PS_TEXFILTER_NO_NEG_LODBIAS_ID, PS_TEXFILTER_NO_NEG_LODBIAS_STRING, L"PS_TEXFILTER_NO_NEG_LODBIAS", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 442, 2, PS_TEXFILTER_NO_NEG_LODBIAS_OFF, NULL, 0, 0 },
+	{ VRR_MODE_ID, VRR_MODE_STRING, L"VRR_MODE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 367, 3, VRR_MODE_FULLSCREEN_ONLY, NULL, 0, 0 },
+	{ VRRFEATUREINDICATOR_ID, VRRFEATUREINDICATOR_STRING, L"VRRFEATUREINDICATOR", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 350, 2, VRRFEATUREINDICATOR_ENABLED, NULL, 0, 0 },
+	{ ANSEL_WHITELISTED_ID, ANSEL_WHITELISTED_STRING, L"ANSEL_WHITELISTED", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 178, 2, ANSEL_WHITELISTED_DISALLOWED, NULL, 0, 0 },
+	{ SHIM_MAXRES_ID, SHIM_MAXRES_STRING, L"SHIM_MAXRES", NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 272, 0, 0x00000000, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ OGL_DEEP_COLOR_SCANOUT_ID, OGL_DEEP_COLOR_SCANOUT_STRING, L"OGL_DEEP_COLOR_SCANOUT", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 4, 2, OGL_DEEP_COLOR_SCANOUT_ENABLE, NULL, 0, 0 },
+	{ PHYSXINDICATOR_ID, PHYSXINDICATOR_STRING, L"PHYSXINDICATOR", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 206, 2, PHYSXINDICATOR_DISABLED, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ ANISO_MODE_SELECTOR_ID, ANISO_MODE_SELECTOR_STRING, L"ANISO_MODE_SELECTOR", NVDRS_DWORD_TYPE, SETTING_VALUES_BITFIELD, 168, 6, ANISO_MODE_SELECTOR_DEFAULT, NULL, 0, 0 },
+	{ AO_MODE_ID, AO_MODE_STRING, L"AO_MODE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 417, 4, AO_MODE_OFF, NULL, 0, 0 },
+	{ OGL_QUALITY_ENHANCEMENTS_ID, OGL_QUALITY_ENHANCEMENTS_STRING, L"OGL_QUALITY_ENHANCEMENTS", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 35, 4, OGL_QUALITY_ENHANCEMENTS_QUAL, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ AUTO_LODBIASADJUST_ID, AUTO_LODBIASADJUST_STRING, L"AUTO_LODBIASADJUST", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 423, 2, AUTO_LODBIASADJUST_ON, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ WKS_MEMORY_ALLOCATION_POLICY_ID, WKS_MEMORY_ALLOCATION_POLICY_STRING, L"WKS_MEMORY_ALLOCATION_POLICY", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 405, 3, WKS_MEMORY_ALLOCATION_POLICY_AS_NEEDED, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ ANSEL_ENABLE_ID, ANSEL_ENABLE_STRING, L"ANSEL_ENABLE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 176, 2, ANSEL_ENABLE_ON, NULL, 0, 0 },
+	{ APPLICATION_PROFILE_NOTIFICATION_TIMEOUT_ID, APPLICATION_PROFILE_NOTIFICATION_TIMEOUT_STRING, L"APPLICATION_PROFILE_NOTIFICATION_TIMEOUT", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 180, 6, APPLICATION_PROFILE_NOTIFICATION_TIMEOUT_DISABLED, NULL, 0, 0 },
+	{ SLI_PREDEFINED_GPU_COUNT_DX10_ID, SLI_PREDEFINED_GPU_COUNT_DX10_STRING, L"SLI_PREDEFINED_GPU_COUNT_DX10", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 323, 5, SLI_PREDEFINED_GPU_COUNT_DX10_AUTOSELECT, NULL, 0, 0 },
+	{ OGL_IMPLICIT_GPU_AFFINITY_ID, OGL_IMPLICIT_GPU_AFFINITY_STRING, L"OGL_IMPLICIT_GPU_AFFINITY", NVDRS_WSTRING_TYPE, SETTING_VALUES_ANY, 0, 1, 0, L"autoselect", 0, 0 },
+	{ EXPORT_PERF_COUNTERS_ID, EXPORT_PERF_COUNTERS_STRING, L"EXPORT_PERF_COUNTERS", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 192, 2, EXPORT_PERF_COUNTERS_OFF, NULL, 0, 0 },
+	{ VSYNCMODE_ID, VSYNCMODE_STRING, L"VSYNCMODE", NVDRS_DWORD_TYPE, SETTING_VALUES_LIST, 459, 7, VSYNCMODE_PASSIVE, NULL, 0, 0 },
+	{ PS_FRAMERATE_MONITOR_CTRL_ID, PS_FRAMERATE_MONITOR_CTRL_STRING, L"PS_FRAMERATE_MONITOR_CTRL", NVDRS_DWORD_TYPE, SETTING_VALUES_BITFIELD, 257, 15, PS_FRAMERATE_MONITOR_CTRL_DISABLED, NULL, 0, 0 },
+	{ OGL_EXTENSION_STRING_VERSION_ID, OGL_EXTENSION_STRING_VERSION_STRING, L"OGL_EXTENSION_STRING_VERSION", NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 24, 0, 0x00000000, NULL, 0, 0 },
+	{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 },
+	{ PREFERRED_PSTATE_ID, PREFERRED_PSTATE_STRING, L"PREFERRED_PSTATE", NVDRS_DWORD_TYPE, SETTING_VALUES_RANGE, 208, 8, PREFERRED_PSTATE_OPTIMAL_POWER, NULL, PREFERRED_PSTATE_MIN, PREFERRED_PSTATE_MAX },
+	{ AA_MODE_METHOD_ID, AA_MODE_METHOD_STRING, L"AA_MODE_METHOD", NVDRS_DWORD_TYPE, SETTING_VALUES_BITFIELD, 86, 50, AA_MODE_METHOD_NONE, NULL, 0, 0 },
+};
+
+// Indexed by SettingNameSlot(name), holds a settingRegistry slot or 0xFF
+constexpr NvU8 settingNameIndex[SETTING_NAME_SLOTS] =
+{
+	  50, 0xFF,   23,   55,   22,   35,  100,    7, 0xFF,  100,   34,   88,   34, 0xFF,   28,  122,
+	  76, 0xFF,   67,   89,   79,   47,  124, 0xFF,    2,   97,  101,   86,    3,    0,  122, 0xFF,
+	   9,  109,  123,   18,   79, 0xFF,  109,   80,    3,   47, 0xFF,   43,   52, 0xFF,   54,   18,
+	 121,   70, 0xFF,   87,   60,   15,   21, 0xFF,    5,   65, 0xFF,  110,   31,   60, 0xFF,   45,
+	  95, 0xFF,  127,  120,   11,  105,  111,   57,  101, 0xFF,   33,  115,   54, 0xFF,   46,  124,
+	  26, 0xFF,   45,  117,   20,  111,   39,   25,   80, 0xFF,    7,  105,   33,   85,   26,   69,
+	  16,   20,   36,   78,   50,  115,   90, 0xFF, 0xFF,   89,  104,  110,    9, 0xFF,  123, 0xFF,
+	  56,   31, 0xFF, 0xFF, 0xFF, 0xFF,   57, 0xFF,   90,   37,   41,   48,   95,   39, 0xFF,  113,
+	  56,   19,   94,   70, 0xFF,  104, 0xFF, 0xFF, 0xFF,   81,   64,   37, 0xFF,   55, 0xFF, 0xFF,
+	 127,  126, 0xFF,  119, 0xFF,   76,    5,   81,  118,   64, 0xFF, 0xFF,   43, 0xFF, 0xFF, 0xFF,
+	  29, 0xFF, 0xFF,   98,   15,   53,   14,   36,   16, 0xFF,    0, 0xFF,   67,   75,   94,   82,
+	0xFF,   10,    4, 0xFF,  119,   63, 0xFF,   83,   14,   25,    1,   75,   46,   12,   65,   63,
+	  71,   27, 0xFF,   52, 0xFF, 0xFF, 0xFF,   41,   49,   99,   12,   73,    4,   83,   78,  117,
+	0xFF, 0xFF,   86,   29,   71,   28,   22,   82, 0xFF, 0xFF,   32,   53,   38, 0xFF,  113,   87,
+	  97, 0xFF,   98,   38,   69, 0xFF, 0xFF, 0xFF,   84,    2,   85,   84,   19,   32,  120,   48,
+	  21,   10, 0xFF,    1,   27,   88,  126,   99, 0xFF,  121, 0xFF,  118,   73, 0xFF,   35,   49,
+};
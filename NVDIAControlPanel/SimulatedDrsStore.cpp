@@ -0,0 +1,815 @@
+#include "targetver.h"
+#include "SimulatedDrsStore.h"
+#include "DrsSession.h"
+#include "DrsSnapshot.h"
+#include "SettingRegistry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+namespace ControlPanel
+{
+	namespace
+	{
+		std::wstring ToWide(const NvU16 *text)
+		{
+			std::wstring result;
+			for (NvU32 i = 0; i < NVAPI_UNICODE_STRING_MAX && text[i] != 0; i++)
+				result.push_back((wchar_t)text[i]);
+			return result;
+		}
+
+		inline NvDRSProfileHandle ProfileHandle(NvU32 id)
+		{
+			return (NvDRSProfileHandle)(size_t)id;
+		}
+
+		inline NvU32 ProfileId(NvDRSProfileHandle handle)
+		{
+			return (NvU32)(size_t)handle;
+		}
+
+		// The file name of a path, or the whole string when it has no folder
+		const NvU16 *FileName(const NvU16 *path)
+		{
+			const NvU16 *name = path;
+			for (const NvU16 *c = path; *c; c++)
+			{
+				if (*c == L'\\' || *c == L'/')
+					name = c + 1;
+			}
+			return name;
+		}
+
+		void CopyValue(NVDRS_SETTING_TYPE settingType, NvU32 u32, const std::wstring &text, const std::vector<NvU8> &binary,
+			NvU32 *u32Target, NVDRS_BINARY_SETTING *binaryTarget, NvU16 *textTarget)
+		{
+			switch (settingType)
+			{
+			case NVDRS_DWORD_TYPE:
+				*u32Target = u32;
+				break;
+
+			case NVDRS_BINARY_TYPE:
+				binaryTarget->valueLength = (NvU32)binary.size();
+				if (!binary.empty())
+					memcpy(binaryTarget->valueData, &binary[0], binary.size());
+				break;
+
+			default:
+				CopyUnicodeString(textTarget, text.c_str());
+				break;
+			}
+		}
+
+		struct SettingIdLess
+		{
+			template <typename T>
+			bool operator()(const T &setting, NvU32 settingId) const { return setting.settingId < settingId; }
+
+			template <typename T>
+			bool operator()(const T &a, const T &b) const { return a.settingId < b.settingId; }
+		};
+	}
+
+	SimulatedDrsStore::SimulatedDrsStore()
+		: saveCount(0)
+		, callCount(0)
+	{
+		memset(&latency, 0, sizeof(latency));
+		Generate(0, 0, 0);
+	}
+
+	SimulatedDrsStore::~SimulatedDrsStore()
+	{
+		for (std::set<Session *>::iterator it = sessions.begin(); it != sessions.end(); ++it)
+			delete *it;
+	}
+
+	void SimulatedDrsStore::Generate(NvU32 profileCount, NvU32 applicationsPerProfile, NvU32 settingsPerProfile)
+	{
+		std::vector<const SettingInfo *> dwordSettings;
+		for (NvU32 slot = 0; slot < SETTING_ID_SLOTS; slot++)
+		{
+			if (settingRegistry[slot].name != NULL && settingRegistry[slot].settingType == NVDRS_DWORD_TYPE)
+				dwordSettings.push_back(&settingRegistry[slot]);
+		}
+
+		stored.profiles.clear();
+		stored.profiles.reserve(profileCount + 1);
+		stored.nextId = 1;
+
+		// The base profile predefines every documented DWORD setting at its default
+		Profile base;
+		base.id = stored.nextId++;
+		base.name = L"Base Profile";
+		base.isPredefined = true;
+		for (size_t i = 0; i < dwordSettings.size(); i++)
+		{
+			Setting setting;
+			setting.settingId = dwordSettings[i]->settingId;
+			setting.settingType = NVDRS_DWORD_TYPE;
+			setting.hasPredefined = true;
+			setting.hasUser = false;
+			setting.predefined.u32 = dwordSettings[i]->defaultValue;
+			setting.user.u32 = 0;
+			base.settings.push_back(setting);
+		}
+		std::sort(base.settings.begin(), base.settings.end(), SettingIdLess());
+		stored.profiles.push_back(base);
+
+		if (settingsPerProfile > dwordSettings.size())
+			settingsPerProfile = (NvU32)dwordSettings.size();
+
+		wchar_t text[64];
+		for (NvU32 p = 0; p < profileCount; p++)
+		{
+			stored.profiles.push_back(Profile());
+			Profile &profile = stored.profiles.back();
+			profile.id = stored.nextId++;
+			swprintf(text, sizeof(text) / sizeof(text[0]), L"Simulated Profile %05u", p);
+			profile.name = text;
+			profile.isPredefined = true;
+
+			for (NvU32 a = 0; a < applicationsPerProfile; a++)
+			{
+				Application application;
+				swprintf(text, sizeof(text) / sizeof(text[0]), L"simgame%u_%u.exe", p, a);
+				application.appName = text;
+				swprintf(text, sizeof(text) / sizeof(text[0]), L"Simulated Game %u", p);
+				application.userFriendlyName = text;
+				application.isPredefined = true;
+				application.isMetro = false;
+				profile.applications.push_back(application);
+			}
+
+			// A window of consecutive registry settings, with one of their listed values each
+			for (NvU32 s = 0; s < settingsPerProfile; s++)
+			{
+				const SettingInfo &info = *dwordSettings[(p + s) % dwordSettings.size()];
+
+				Setting setting;
+				setting.settingId = info.settingId;
+				setting.settingType = NVDRS_DWORD_TYPE;
+				setting.hasPredefined = true;
+				setting.hasUser = false;
+				setting.predefined.u32 = info.valueCount > 0 ? settingValuePool[info.firstValue + (p + s) % info.valueCount] : info.defaultValue;
+				setting.user.u32 = 0;
+				profile.settings.push_back(setting);
+			}
+			std::sort(profile.settings.begin(), profile.settings.end(), SettingIdLess());
+		}
+	}
+
+	void SimulatedDrsStore::Spend(NvU32 microseconds) const
+	{
+		if (microseconds == 0)
+			return;
+
+		// Sleep() resolution is a millisecond at best
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::microseconds(microseconds);
+		while (std::chrono::steady_clock::now() < end)
+		{
+		}
+	}
+
+	SimulatedDrsStore::Session *SimulatedDrsStore::Call(NvDRSSessionHandle handle)
+	{
+		callCount++;
+		Spend(latency.callMicroseconds);
+
+		Session *session = (Session *)handle;
+		if (sessions.find(session) == sessions.end())
+			return NULL;
+		return session;
+	}
+
+	SimulatedDrsStore::Profile *SimulatedDrsStore::FindProfile(Session &session, NvDRSProfileHandle handle)
+	{
+		std::unordered_map<NvU32, NvU32>::const_iterator row = session.rows.find(ProfileId(handle));
+		if (row == session.rows.end())
+			return NULL;
+		return &session.database.profiles[row->second];
+	}
+
+	void SimulatedDrsStore::Reindex(Session &session)
+	{
+		session.rows.clear();
+		session.names.clear();
+		session.executables.clear();
+
+		std::vector<Profile> &profiles = session.database.profiles;
+		for (NvU32 i = 0; i < (NvU32)profiles.size(); i++)
+		{
+			session.rows[profiles[i].id] = i;
+			session.names[FoldCase(profiles[i].name.c_str())] = profiles[i].id;
+			for (size_t a = 0; a < profiles[i].applications.size(); a++)
+				IndexApplication(session, profiles[i], profiles[i].applications[a]);
+		}
+	}
+
+	void SimulatedDrsStore::IndexApplication(Session &session, const Profile &profile, const Application &application)
+	{
+		std::vector<NvU32> &owners = session.executables[FoldCase(application.appName.c_str())];
+		if (std::find(owners.begin(), owners.end(), profile.id) == owners.end())
+			owners.push_back(profile.id);
+	}
+
+	void SimulatedDrsStore::UnindexApplications(Session &session, const Profile &profile, bool userOnly)
+	{
+		for (size_t a = 0; a < profile.applications.size(); a++)
+		{
+			const Application &application = profile.applications[a];
+			if (userOnly && application.isPredefined)
+				continue;
+
+			std::wstring key = FoldCase(application.appName.c_str());
+			std::vector<NvU32> &owners = session.executables[key];
+			owners.erase(std::remove(owners.begin(), owners.end(), profile.id), owners.end());
+			if (owners.empty())
+				session.executables.erase(key);
+		}
+	}
+
+	NvAPI_Status SimulatedDrsStore::RemoveProfile(Session &session, NvU32 id)
+	{
+		NvU32 row = session.rows[id];
+		Profile &profile = session.database.profiles[row];
+		UnindexApplications(session, profile, false);
+		session.names.erase(FoldCase(profile.name.c_str()));
+		session.rows.erase(id);
+
+		session.database.profiles.erase(session.database.profiles.begin() + row);
+		for (NvU32 i = row; i < (NvU32)session.database.profiles.size(); i++)
+			session.rows[session.database.profiles[i].id] = i;
+		return NVAPI_OK;
+	}
+
+	void SimulatedDrsStore::RestoreProfile(Session &session, Profile &profile)
+	{
+		UnindexApplications(session, profile, true);
+
+		std::vector<Application> &applications = profile.applications;
+		size_t keptApplications = 0;
+		for (size_t a = 0; a < applications.size(); a++)
+		{
+			if (applications[a].isPredefined)
+				applications[keptApplications++] = applications[a];
+		}
+		applications.resize(keptApplications);
+
+		std::vector<Setting> &settings = profile.settings;
+		size_t keptSettings = 0;
+		for (size_t s = 0; s < settings.size(); s++)
+		{
+			if (settings[s].hasPredefined)
+			{
+				settings[s].hasUser = false;
+				settings[keptSettings++] = settings[s];
+			}
+		}
+		settings.resize(keptSettings);
+	}
+
+	NvAPI_Status SimulatedDrsStore::CreateSession(NvDRSSessionHandle *handle)
+	{
+		callCount++;
+		Spend(latency.callMicroseconds);
+		if (handle == NULL)
+			return NVAPI_INVALID_POINTER;
+
+		Session *session = new Session;
+		session->loaded = false;
+		sessions.insert(session);
+		*handle = (NvDRSSessionHandle)session;
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status SimulatedDrsStore::DestroySession(NvDRSSessionHandle handle)
+	{
+		Session *session = Call(handle);
+		if (session == NULL)
+			return NVAPI_INVALID_HANDLE;
+
+		sessions.erase(session);
+		delete session;
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status SimulatedDrsStore::LoadSettings(NvDRSSessionHandle handle)
+	{
+		Session *session = Call(handle);
+		if (session == NULL)
+			return NVAPI_INVALID_HANDLE;
+
+		Spend(latency.loadMicrosecondsPerProfile * (NvU32)stored.profiles.size());
+		session->database = stored;
+		session->loaded = true;
+		Reindex(*session);
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status SimulatedDrsStore::SaveSettings(NvDRSSessionHandle handle)
+	{
+		Session *session = Call(handle);
+		if (session == NULL)
+			return NVAPI_INVALID_HANDLE;
+		if (!session->loaded)
+			return NVAPI_INVALID_CALL;
+
+		Spend(latency.saveMicrosecondsPerProfile * (NvU32)session->database.profiles.size());
+		stored = session->database;
+		saveCount++;
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status SimulatedDrsStore::RestoreAllDefaults(NvDRSSessionHandle handle)
+	{
+		Session *session = Call(handle);
+		if (session == NULL)
+			return NVAPI_INVALID_HANDLE;
+		if (!session->loaded)
+			return NVAPI_INVALID_CALL;
+
+		std::vector<Profile> &profiles = session->database.profiles;
+		size_t kept = 0;
+		for (size_t i = 0; i < profiles.size(); i++)
+		{
+			if (i == 0 || profiles[i].isPredefined)
+			{
+				RestoreProfile(*session, profiles[i]);
+				if (kept != i)
+					profiles[kept] = profiles[i];
+				kept++;
+			}
+		}
+		profiles.resize(kept);
+
+		Reindex(*session);
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status SimulatedDrsStore::GetNumProfiles(NvDRSSessionHandle handle, NvU32 *numProfiles)
+	{
+		Session *session = Call(handle);
+		if (session == NULL)
+			return NVAPI_INVALID_HANDLE;
+		if (numProfiles == NULL)
+			return NVAPI_INVALID_POINTER;
+
+		*numProfiles = session->loaded ? (NvU32)session->database.profiles.size() : 0;
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status SimulatedDrsStore::GetBaseProfile(NvDRSSessionHandle handle, NvDRSProfileHandle *profile)
+	{
+		Session *session = Call(handle);
+		if (session == NULL)
+			return NVAPI_INVALID_HANDLE;
+		if (profile == NULL)
+			return NVAPI_INVALID_POINTER;
+		if (!session->loaded)
+			return NVAPI_PROFILE_NOT_FOUND;
+
+		*profile = ProfileHandle(session->database.profiles[0].id);
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status SimulatedDrsStore::EnumProfiles(NvDRSSessionHandle handle, NvU32 index, NvDRSProfileHandle *profile)
+	{
+		Session *session = Call(handle);
+		if (session == NULL)
+			return NVAPI_INVALID_HANDLE;
+		if (profile == NULL)
+			return NVAPI_INVALID_POINTER;
+		if (!session->loaded || index >= session->database.profiles.size())
+			return NVAPI_END_ENUMERATION;
+
+		*profile = ProfileHandle(session->database.profiles[index].id);
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status SimulatedDrsStore::FindProfileByName(NvDRSSessionHandle handle, NvAPI_UnicodeString profileName, NvDRSProfileHandle *profile)
+	{
+		Session *session = Call(handle);
+		if (session == NULL)
+			return NVAPI_INVALID_HANDLE;
+		if (profile == NULL)
+			return NVAPI_INVALID_POINTER;
+
+		std::unordered_map<std::wstring, NvU32>::const_iterator found = session->names.find(FoldCase(ToWide(profileName).c_str()));
+		if (found == session->names.end())
+			return NVAPI_PROFILE_NOT_FOUND;
+
+		*profile = ProfileHandle(found->second);
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status SimulatedDrsStore::GetProfileInfo(NvDRSSessionHandle handle, NvDRSProfileHandle profileHandle, NVDRS_PROFILE *profileInfo)
+	{
+		Session *session = Call(handle);
+		if (session == NULL)
+			return NVAPI_INVALID_HANDLE;
+		if (profileInfo == NULL)
+			return NVAPI_INVALID_POINTER;
+		if (profileInfo->version != NVDRS_PROFILE_VER)
+			return NVAPI_INCOMPATIBLE_STRUCT_VERSION;
+
+		Profile *profile = FindProfile(*session, profileHandle);
+		if (profile == NULL)
+			return NVAPI_PROFILE_NOT_FOUND;
+
+		memset(profileInfo, 0, sizeof(NVDRS_PROFILE));
+		profileInfo->version = NVDRS_PROFILE_VER;
+		CopyUnicodeString(profileInfo->profileName, profile->name.c_str());
+		profileInfo->isPredefined = profile->isPredefined ? 1 : 0;
+		profileInfo->numOfApps = (NvU32)profile->applications.size();
+		profileInfo->numOfSettings = (NvU32)profile->settings.size();
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status SimulatedDrsStore::CreateProfile(NvDRSSessionHandle handle, NVDRS_PROFILE *profileInfo, NvDRSProfileHandle *profileHandle)
+	{
+		Session *session = Call(handle);
+		if (session == NULL)
+			return NVAPI_INVALID_HANDLE;
+		if (profileInfo == NULL || profileHandle == NULL)
+			return NVAPI_INVALID_POINTER;
+		if (profileInfo->version != NVDRS_PROFILE_VER)
+			return NVAPI_INCOMPATIBLE_STRUCT_VERSION;
+		if (!session->loaded)
+			return NVAPI_INVALID_CALL;
+
+		std::wstring name = ToWide(profileInfo->profileName);
+		if (name.empty())
+			return NVAPI_PROFILE_NAME_EMPTY;
+
+		std::wstring key = FoldCase(name.c_str());
+		if (session->names.find(key) != session->names.end())
+			return NVAPI_PROFILE_NAME_IN_USE;
+
+		Profile profile;
+		profile.id = session->database.nextId++;
+		profile.name = name;
+		profile.isPredefined = false;
+		session->database.profiles.push_back(profile);
+		session->rows[profile.id] = (NvU32)session->database.profiles.size() - 1;
+		session->names[key] = profile.id;
+
+		*profileHandle = ProfileHandle(profile.id);
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status SimulatedDrsStore::DeleteProfile(NvDRSSessionHandle handle, NvDRSProfileHandle profileHandle)
+	{
+		Session *session = Call(handle);
+		if (session == NULL)
+			return NVAPI_INVALID_HANDLE;
+
+		Profile *profile = FindProfile(*session, profileHandle);
+		if (profile == NULL)
+			return NVAPI_PROFILE_NOT_FOUND;
+
+		// Predefined profiles only go back to their predefined state
+		if (profile->isPredefined || profile->id == session->database.profiles[0].id)
+		{
+			RestoreProfile(*session, *profile);
+			return NVAPI_OK;
+		}
+
+		return RemoveProfile(*session, profile->id);
+	}
+
+	NvAPI_Status SimulatedDrsStore::RestoreProfileDefault(NvDRSSessionHandle handle, NvDRSProfileHandle profileHandle)
+	{
+		Session *session = Call(handle);
+		if (session == NULL)
+			return NVAPI_INVALID_HANDLE;
+
+		Profile *profile = FindProfile(*session, profileHandle);
+		if (profile == NULL)
+			return NVAPI_PROFILE_NOT_FOUND;
+
+		if (!profile->isPredefined && profile->id != session->database.profiles[0].id)
+		{
+			RemoveProfile(*session, profile->id);
+			return NVAPI_PROFILE_REMOVED;
+		}
+
+		RestoreProfile(*session, *profile);
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status SimulatedDrsStore::EnumApplications(NvDRSSessionHandle handle, NvDRSProfileHandle profileHandle, NvU32 startIndex, NvU32 *appCount, NVDRS_APPLICATION *applications)
+	{
+		Session *session = Call(handle);
+		if (session == NULL)
+			return NVAPI_INVALID_HANDLE;
+		if (appCount == NULL || applications == NULL)
+			return NVAPI_INVALID_POINTER;
+		if (applications[0].version != NVDRS_APPLICATION_VER)
+			return NVAPI_INCOMPATIBLE_STRUCT_VERSION;
+
+		Profile *profile = FindProfile(*session, profileHandle);
+		if (profile == NULL)
+			return NVAPI_PROFILE_NOT_FOUND;
+		return CopyApplications(*profile, startIndex, appCount, applications);
+	}
+
+	NvAPI_Status SimulatedDrsStore::CopyApplications(const Profile &profile, NvU32 startIndex, NvU32 *appCount, NVDRS_APPLICATION *applications)
+	{
+		if (startIndex >= profile.applications.size())
+			return NVAPI_END_ENUMERATION;
+
+		NvU32 count = (NvU32)profile.applications.size() - startIndex;
+		if (count > *appCount)
+			count = *appCount;
+
+		for (NvU32 i = 0; i < count; i++)
+		{
+			const Application &source = profile.applications[startIndex + i];
+			NVDRS_APPLICATION &target = applications[i];
+			memset(&target, 0, sizeof(NVDRS_APPLICATION));
+			target.version = NVDRS_APPLICATION_VER;
+			target.isPredefined = source.isPredefined ? 1 : 0;
+			target.isMetro = source.isMetro ? 1 : 0;
+			CopyUnicodeString(target.appName, source.appName.c_str());
+			CopyUnicodeString(target.userFriendlyName, source.userFriendlyName.c_str());
+			CopyUnicodeString(target.launcher, source.launcher.c_str());
+			CopyUnicodeString(target.fileInFolder, source.fileInFolder.c_str());
+		}
+
+		*appCount = count;
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status SimulatedDrsStore::CreateApplication(NvDRSSessionHandle handle, NvDRSProfileHandle profileHandle, NVDRS_APPLICATION *application)
+	{
+		Session *session = Call(handle);
+		if (session == NULL)
+			return NVAPI_INVALID_HANDLE;
+		if (application == NULL)
+			return NVAPI_INVALID_POINTER;
+		if (application->version != NVDRS_APPLICATION_VER)
+			return NVAPI_INCOMPATIBLE_STRUCT_VERSION;
+
+		Profile *profile = FindProfile(*session, profileHandle);
+		if (profile == NULL)
+			return NVAPI_PROFILE_NOT_FOUND;
+
+		Application created;
+		created.appName = ToWide(application->appName);
+		created.userFriendlyName = ToWide(application->userFriendlyName);
+		created.launcher = ToWide(application->launcher);
+		created.fileInFolder = ToWide(application->fileInFolder);
+		created.isPredefined = false;
+		created.isMetro = application->isMetro != 0;
+		if (created.appName.empty())
+			return NVAPI_INVALID_ARGUMENT;
+
+		// One executable per profile, unless fileInFolder tells the entries apart
+		std::wstring fileInFolder = FoldCase(created.fileInFolder.c_str());
+		std::unordered_map<std::wstring, std::vector<NvU32> >::const_iterator owners = session->executables.find(FoldCase(created.appName.c_str()));
+		if (owners != session->executables.end())
+		{
+			for (size_t o = 0; o < owners->second.size(); o++)
+			{
+				const Profile &owner = session->database.profiles[session->rows[owners->second[o]]];
+				for (size_t a = 0; a < owner.applications.size(); a++)
+				{
+					const Application &existing = owner.applications[a];
+					if (FoldCase(existing.appName.c_str()) == FoldCase(created.appName.c_str()) &&
+						FoldCase(existing.fileInFolder.c_str()) == fileInFolder)
+					{
+						return NVAPI_EXECUTABLE_ALREADY_IN_USE;
+					}
+				}
+			}
+		}
+
+		profile->applications.push_back(created);
+		IndexApplication(*session, *profile, created);
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status SimulatedDrsStore::FindApplicationByName(NvDRSSessionHandle handle, NvAPI_UnicodeString appName, NvDRSProfileHandle *profileHandle, NVDRS_APPLICATION *application)
+	{
+		Session *session = Call(handle);
+		if (session == NULL)
+			return NVAPI_INVALID_HANDLE;
+		if (profileHandle == NULL || application == NULL)
+			return NVAPI_INVALID_POINTER;
+		if (application->version != NVDRS_APPLICATION_VER)
+			return NVAPI_INCOMPATIBLE_STRUCT_VERSION;
+
+		// A full path matches the entries for its file name; the first profile in enumeration order wins
+		std::wstring key = FoldCase(ToWide(FileName(appName)).c_str());
+		std::unordered_map<std::wstring, std::vector<NvU32> >::const_iterator owners = session->executables.find(key);
+		if (owners == session->executables.end())
+			return NVAPI_EXECUTABLE_NOT_FOUND;
+
+		NvU32 row = (NvU32)session->database.profiles.size();
+		for (size_t o = 0; o < owners->second.size(); o++)
+			row = std::min(row, session->rows[owners->second[o]]);
+
+		const Profile &profile = session->database.profiles[row];
+		for (size_t a = 0; a < profile.applications.size(); a++)
+		{
+			const Application &source = profile.applications[a];
+			if (FoldCase(source.appName.c_str()) != key)
+				continue;
+
+			NvU32 count = 1;
+			*profileHandle = ProfileHandle(profile.id);
+			return CopyApplications(profile, (NvU32)a, &count, application);
+		}
+
+		return NVAPI_EXECUTABLE_NOT_FOUND;
+	}
+
+	NvAPI_Status SimulatedDrsStore::EnumSettings(NvDRSSessionHandle handle, NvDRSProfileHandle profileHandle, NvU32 startIndex, NvU32 *settingsCount, NVDRS_SETTING *settings)
+	{
+		Session *session = Call(handle);
+		if (session == NULL)
+			return NVAPI_INVALID_HANDLE;
+		if (settingsCount == NULL || settings == NULL)
+			return NVAPI_INVALID_POINTER;
+		if (settings[0].version != NVDRS_SETTING_VER)
+			return NVAPI_INCOMPATIBLE_STRUCT_VERSION;
+
+		Profile *profile = FindProfile(*session, profileHandle);
+		if (profile == NULL)
+			return NVAPI_PROFILE_NOT_FOUND;
+		return CopySettings(*profile, startIndex, settingsCount, settings);
+	}
+
+	NvAPI_Status SimulatedDrsStore::CopySettings(const Profile &profile, NvU32 startIndex, NvU32 *settingsCount, NVDRS_SETTING *settings)
+	{
+		if (startIndex >= profile.settings.size())
+			return NVAPI_END_ENUMERATION;
+
+		NvU32 count = (NvU32)profile.settings.size() - startIndex;
+		if (count > *settingsCount)
+			count = *settingsCount;
+
+		for (NvU32 i = 0; i < count; i++)
+		{
+			const Setting &source = profile.settings[startIndex + i];
+			NVDRS_SETTING &target = settings[i];
+			memset(&target, 0, sizeof(NVDRS_SETTING));
+			target.version = NVDRS_SETTING_VER;
+
+			const SettingInfo *info = FindSettingInfo(source.settingId);
+			CopyUnicodeString(target.settingName, info != NULL ? info->name : L"");
+			target.settingId = source.settingId;
+			target.settingType = source.settingType;
+			target.settingLocation = NVDRS_CURRENT_PROFILE_LOCATION;
+			target.isCurrentPredefined = source.hasUser ? 0 : 1;
+			target.isPredefinedValid = source.hasPredefined ? 1 : 0;
+
+			if (source.hasPredefined)
+			{
+				CopyValue(source.settingType, source.predefined.u32, source.predefined.text, source.predefined.binary,
+					&target.u32PredefinedValue, &target.binaryPredefinedValue, target.wszPredefinedValue);
+			}
+
+			const Value &current = source.hasUser ? source.user : source.predefined;
+			CopyValue(source.settingType, current.u32, current.text, current.binary,
+				&target.u32CurrentValue, &target.binaryCurrentValue, target.wszCurrentValue);
+		}
+
+		*settingsCount = count;
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status SimulatedDrsStore::GetSetting(NvDRSSessionHandle handle, NvDRSProfileHandle profileHandle, NvU32 settingId, NVDRS_SETTING *setting)
+	{
+		Session *session = Call(handle);
+		if (session == NULL)
+			return NVAPI_INVALID_HANDLE;
+		if (setting == NULL)
+			return NVAPI_INVALID_POINTER;
+		if (setting->version != NVDRS_SETTING_VER)
+			return NVAPI_INCOMPATIBLE_STRUCT_VERSION;
+
+		Profile *profile = FindProfile(*session, profileHandle);
+		if (profile == NULL)
+			return NVAPI_PROFILE_NOT_FOUND;
+
+		// A profile without its own value inherits the base profile's
+		NVDRS_SETTING_LOCATION location = NVDRS_CURRENT_PROFILE_LOCATION;
+		std::vector<Setting>::const_iterator found = std::lower_bound(profile->settings.begin(), profile->settings.end(), settingId, SettingIdLess());
+		if (found == profile->settings.end() || found->settingId != settingId)
+		{
+			profile = &session->database.profiles[0];
+			location = NVDRS_BASE_PROFILE_LOCATION;
+			found = std::lower_bound(profile->settings.begin(), profile->settings.end(), settingId, SettingIdLess());
+			if (found == profile->settings.end() || found->settingId != settingId)
+				return NVAPI_SETTING_NOT_FOUND;
+		}
+
+		NvU32 count = 1;
+		NvAPI_Status status = CopySettings(*profile, (NvU32)(found - profile->settings.begin()), &count, setting);
+		if (status == NVAPI_OK)
+			setting->settingLocation = location;
+		return status;
+	}
+
+	NvAPI_Status SimulatedDrsStore::SetSetting(NvDRSSessionHandle handle, NvDRSProfileHandle profileHandle, NVDRS_SETTING *setting)
+	{
+		Session *session = Call(handle);
+		if (session == NULL)
+			return NVAPI_INVALID_HANDLE;
+		if (setting == NULL)
+			return NVAPI_INVALID_POINTER;
+		if (setting->version != NVDRS_SETTING_VER)
+			return NVAPI_INCOMPATIBLE_STRUCT_VERSION;
+
+		Profile *profile = FindProfile(*session, profileHandle);
+		if (profile == NULL)
+			return NVAPI_PROFILE_NOT_FOUND;
+
+		std::vector<Setting>::iterator found = std::lower_bound(profile->settings.begin(), profile->settings.end(), setting->settingId, SettingIdLess());
+		if (found == profile->settings.end() || found->settingId != setting->settingId)
+		{
+			Setting created;
+			created.settingId = setting->settingId;
+			created.settingType = setting->settingType;
+			created.hasPredefined = false;
+			created.hasUser = false;
+			created.predefined.u32 = 0;
+			found = profile->settings.insert(found, created);
+		}
+		else if (found->settingType != setting->settingType)
+		{
+			return NVAPI_INVALID_ARGUMENT;
+		}
+
+		Value &user = found->user;
+		user.u32 = 0;
+		user.text.clear();
+		user.binary.clear();
+		switch (setting->settingType)
+		{
+		case NVDRS_DWORD_TYPE:
+			user.u32 = setting->u32CurrentValue;
+			break;
+
+		case NVDRS_BINARY_TYPE:
+		{
+			NvU32 length = setting->binaryCurrentValue.valueLength;
+			if (length > NVAPI_BINARY_DATA_MAX)
+				return NVAPI_INVALID_ARGUMENT;
+			user.binary.assign(setting->binaryCurrentValue.valueData, setting->binaryCurrentValue.valueData + length);
+			break;
+		}
+
+		default:
+			user.text = ToWide(setting->wszCurrentValue);
+			break;
+		}
+
+		found->hasUser = true;
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status SimulatedDrsStore::DeleteProfileSetting(NvDRSSessionHandle handle, NvDRSProfileHandle profileHandle, NvU32 settingId)
+	{
+		Session *session = Call(handle);
+		if (session == NULL)
+			return NVAPI_INVALID_HANDLE;
+
+		Profile *profile = FindProfile(*session, profileHandle);
+		if (profile == NULL)
+			return NVAPI_PROFILE_NOT_FOUND;
+		return RemoveSetting(*profile, settingId);
+	}
+
+	NvAPI_Status SimulatedDrsStore::RestoreProfileDefaultSetting(NvDRSSessionHandle handle, NvDRSProfileHandle profileHandle, NvU32 settingId)
+	{
+		Session *session = Call(handle);
+		if (session == NULL)
+			return NVAPI_INVALID_HANDLE;
+
+		Profile *profile = FindProfile(*session, profileHandle);
+		if (profile == NULL)
+			return NVAPI_PROFILE_NOT_FOUND;
+		return RemoveSetting(*profile, settingId);
+	}
+
+	NvAPI_Status SimulatedDrsStore::RemoveSetting(Profile &profile, NvU32 settingId)
+	{
+		std::vector<Setting>::iterator found = std::lower_bound(profile.settings.begin(), profile.settings.end(), settingId, SettingIdLess());
+		if (found == profile.settings.end() || found->settingId != settingId)
+			return NVAPI_SETTING_NOT_FOUND;
+
+		// Back to the predefined value, or gone when there is none
+		if (found->hasPredefined)
+			found->hasUser = false;
+		else
+			profile.settings.erase(found);
+		return NVAPI_OK;
+	}
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "nvapi.h"
+#include "DrsBackend.h"
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ControlPanel
+{
+	struct SimulatedDrsLatency
+	{
+		NvU32 callMicroseconds;             // every call
+		NvU32 loadMicrosecondsPerProfile;   // LoadSettings, on top of the call
+		NvU32 saveMicrosecondsPerProfile;   // SaveSettings, on top of the call
+	};
+
+	/*
+	In-process DRS database that behaves like the driver behind NvAPI_DRS_*.
+	Each session works on a private copy that LoadSettings fills from the
+	stored database and SaveSettings writes back. Profiles enumerate in creation
+	order, base profile first. Settings carry a predefined and a user value:
+	restoring drops the user value, and removes settings and profiles that only
+	the user created. Enumerations end with NVAPI_END_ENUMERATION. Configured
+	latencies are spent busy-waiting so that they show in timings.
+	*/
+	class SimulatedDrsStore : public DrsBackend
+	{
+	public:
+		SimulatedDrsStore();
+		~SimulatedDrsStore();
+
+		// Replaces the stored database with a base profile and profileCount predefined
+		// profiles, their executables and setting values drawn from SettingRegistry.h
+		void Generate(NvU32 profileCount, NvU32 applicationsPerProfile, NvU32 settingsPerProfile);
+		void SetLatency(const SimulatedDrsLatency &value) { latency = value; }
+
+		NvU32 StoredProfileCount() const { return (NvU32)stored.profiles.size(); }
+		NvU32 SaveCount() const { return saveCount; }
+		unsigned long long CallCount() const { return callCount; }
+
+		NvAPI_Status CreateSession(NvDRSSessionHandle *session);
+		NvAPI_Status DestroySession(NvDRSSessionHandle session);
+		NvAPI_Status LoadSettings(NvDRSSessionHandle session);
+		NvAPI_Status SaveSettings(NvDRSSessionHandle session);
+		NvAPI_Status RestoreAllDefaults(NvDRSSessionHandle session);
+
+		NvAPI_Status GetNumProfiles(NvDRSSessionHandle session, NvU32 *numProfiles);
+		NvAPI_Status GetBaseProfile(NvDRSSessionHandle session, NvDRSProfileHandle *profile);
+		NvAPI_Status EnumProfiles(NvDRSSessionHandle session, NvU32 index, NvDRSProfileHandle *profile);
+		NvAPI_Status FindProfileByName(NvDRSSessionHandle session, NvAPI_UnicodeString profileName, NvDRSProfileHandle *profile);
+		NvAPI_Status GetProfileInfo(NvDRSSessionHandle session, NvDRSProfileHandle profile, NVDRS_PROFILE *profileInfo);
+		NvAPI_Status CreateProfile(NvDRSSessionHandle session, NVDRS_PROFILE *profileInfo, NvDRSProfileHandle *profile);
+		NvAPI_Status DeleteProfile(NvDRSSessionHandle session, NvDRSProfileHandle profile);
+		NvAPI_Status RestoreProfileDefault(NvDRSSessionHandle session, NvDRSProfileHandle profile);
+
+		NvAPI_Status EnumApplications(NvDRSSessionHandle session, NvDRSProfileHandle profile, NvU32 startIndex, NvU32 *appCount, NVDRS_APPLICATION *applications);
+		NvAPI_Status CreateApplication(NvDRSSessionHandle session, NvDRSProfileHandle profile, NVDRS_APPLICATION *application);
+		NvAPI_Status FindApplicationByName(NvDRSSessionHandle session, NvAPI_UnicodeString appName, NvDRSProfileHandle *profile, NVDRS_APPLICATION *application);
+
+		NvAPI_Status EnumSettings(NvDRSSessionHandle session, NvDRSProfileHandle profile, NvU32 startIndex, NvU32 *settingsCount, NVDRS_SETTING *settings);
+		NvAPI_Status GetSetting(NvDRSSessionHandle session, NvDRSProfileHandle profile, NvU32 settingId, NVDRS_SETTING *setting);
+		NvAPI_Status SetSetting(NvDRSSessionHandle session, NvDRSProfileHandle profile, NVDRS_SETTING *setting);
+		NvAPI_Status DeleteProfileSetting(NvDRSSessionHandle session, NvDRSProfileHandle profile, NvU32 settingId);
+		NvAPI_Status RestoreProfileDefaultSetting(NvDRSSessionHandle session, NvDRSProfileHandle profile, NvU32 settingId);
+
+	private:
+		SimulatedDrsStore(const SimulatedDrsStore &);
+		SimulatedDrsStore &operator=(const SimulatedDrsStore &);
+
+		struct Value
+		{
+			NvU32 u32;
+			std::wstring text;
+			std::vector<NvU8> binary;
+		};
+
+		struct Setting
+		{
+			NvU32 settingId;
+			NVDRS_SETTING_TYPE settingType;
+			bool hasPredefined;
+			bool hasUser;
+			Value predefined;
+			Value user;
+		};
+
+		struct Application
+		{
+			std::wstring appName;
+			std::wstring userFriendlyName;
+			std::wstring launcher;
+			std::wstring fileInFolder;
+			bool isPredefined;
+			bool isMetro;
+		};
+
+		struct Profile
+		{
+			NvU32 id;                                   // the profile handle, stable while the profile exists
+			std::wstring name;
+			bool isPredefined;
+			std::vector<Application> applications;
+			std::vector<Setting> settings;              // sorted by settingId
+		};
+
+		struct Database
+		{
+			std::vector<Profile> profiles;              // profiles[0] is the base profile
+			NvU32 nextId;
+		};
+
+		struct Session
+		{
+			Database database;
+			bool loaded;
+			std::unordered_map<NvU32, NvU32> rows;      // profile id -> index
+			std::unordered_map<std::wstring, NvU32> names;              // case-folded name -> profile id
+			std::unordered_map<std::wstring, std::vector<NvU32> > executables;  // case-folded appName -> profile ids
+		};
+
+		void Spend(NvU32 microseconds) const;
+		Session *Call(NvDRSSessionHandle handle);
+		Profile *FindProfile(Session &session, NvDRSProfileHandle handle);
+
+		void Reindex(Session &session);
+		void IndexApplication(Session &session, const Profile &profile, const Application &application);
+		void UnindexApplications(Session &session, const Profile &profile, bool userOnly);
+		NvAPI_Status RemoveProfile(Session &session, NvU32 id);
+		void RestoreProfile(Session &session, Profile &profile);
+
+		// The work of the entry points that others share, without counting a call or spending its latency
+		NvAPI_Status CopyApplications(const Profile &profile, NvU32 startIndex, NvU32 *appCount, NVDRS_APPLICATION *applications);
+		NvAPI_Status CopySettings(const Profile &profile, NvU32 startIndex, NvU32 *settingsCount, NVDRS_SETTING *settings);
+		NvAPI_Status RemoveSetting(Profile &profile, NvU32 settingId);
+
+		Database stored;
+		std::set<Session *> sessions;
+		SimulatedDrsLatency latency;
+		NvU32 saveCount;
+		unsigned long long callCount;
+	};
+};
@@ -0,0 +1,183 @@
+#include "targetver.h"
+#include "SimulatedTelemetrySource.h"
+
+namespace ControlPanel
+{
+	namespace
+	{
+		const NvU64 PHASE_MICROSECONDS = 30000000;     // 20 s load, 10 s idle
+		const NvU64 LOAD_MICROSECONDS = 20000000;
+		const NvU32 SENSOR_COUNT = 2;
+
+		// -1, 0 or +1, stable for a second
+		int Noise(NvU64 time, NvU32 gpu, NvU32 channel)
+		{
+			NvU64 x = (time / 1000000) * 0x9E3779B97F4A7C15ULL ^ ((NvU64)gpu << 32 | channel);
+			x ^= x >> 29;
+			x *= 0xBF58476D1CE4E5B9ULL;
+			x ^= x >> 32;
+			return (int)(x % 3) - 1;
+		}
+
+		// 0 idle to 1 fully loaded, eased at both ends of the load phase
+		double Load(NvU64 time, NvU32 gpu)
+		{
+			NvU64 phase = (time + gpu * 3700000ULL) % PHASE_MICROSECONDS;
+			if (phase >= LOAD_MICROSECONDS)
+				return 0.0;
+
+			double t = (double)phase / LOAD_MICROSECONDS;
+			return t < 0.1 ? t * 10.0 : (t > 0.9 ? (1.0 - t) * 10.0 : 1.0);
+		}
+	}
+
+	SimulatedTelemetrySource::SimulatedTelemetrySource(NvU32 gpuCount, NvU32 readMicroseconds)
+		: gpuCount(gpuCount)
+		, readMicroseconds(readMicroseconds)
+		, epoch(TelemetryNow())
+		, readCount(0)
+	{
+	}
+
+	NvAPI_Status SimulatedTelemetrySource::Read(NvU32 gpu, TelemetryMetric metric, TelemetrySample *samples, NvU32 *count)
+	{
+		NvU64 now = TelemetryNow();
+		readCount++;
+		*count = 0;
+		if (gpu >= gpuCount)
+			return NVAPI_INVALID_ARGUMENT;
+
+		if (readMicroseconds > 0)
+		{
+			NvU64 end = now + readMicroseconds;
+			while (TelemetryNow() < end)
+			{
+			}
+		}
+
+		return ReadAt(gpu, metric, now - epoch, samples, count);
+	}
+
+	NvAPI_Status SimulatedTelemetrySource::ReadAt(NvU32 gpu, TelemetryMetric metric, NvU64 time, TelemetrySample *samples, NvU32 *count) const
+	{
+		*count = 0;
+		if (gpu >= gpuCount)
+			return NVAPI_INVALID_ARGUMENT;
+
+		double load = Load(time, gpu);
+		switch (metric)
+		{
+		case TELEMETRY_TEMPERATURE:
+			for (NvU32 i = 0; i < SENSOR_COUNT; i++)
+			{
+				samples[i].channel = (NvU8)i;
+				samples[i].value = 38 + (NvS64)(load * 40.0) + i * 4 + Noise(time, gpu, i);
+			}
+			*count = SENSOR_COUNT;
+			break;
+
+		case TELEMETRY_TACH:
+			samples[0].channel = 0;
+			samples[0].value = 900 + (NvS64)(load * 2100.0) + Noise(time, gpu, 0) * 15;
+			*count = 1;
+			break;
+
+		case TELEMETRY_CLOCKS:
+		case TELEMETRY_BASE_CLOCKS:
+		case TELEMETRY_BOOST_CLOCKS:
+		{
+			static const NvU8 domains[] = { NVAPI_GPU_PUBLIC_CLOCK_GRAPHICS, NVAPI_GPU_PUBLIC_CLOCK_MEMORY, NVAPI_GPU_PUBLIC_CLOCK_PROCESSOR, NVAPI_GPU_PUBLIC_CLOCK_VIDEO };
+			static const NvU32 idleKHz[] = { 300000, 405000, 600000, 540000 };
+			static const NvU32 baseKHz[] = { 1500000, 7000000, 3000000, 1300000 };
+			static const NvU32 boostKHz[] = { 1800000, 7000000, 3600000, 1500000 };
+
+			// Current clocks move in 15 MHz bins, so they are steady between load changes
+			for (NvU32 i = 0; i < sizeof(domains) / sizeof(domains[0]); i++)
+			{
+				NvU32 kHz = idleKHz[i] + (NvU32)(load * (boostKHz[i] - idleKHz[i]));
+				samples[i].channel = domains[i];
+				samples[i].value = metric == TELEMETRY_BASE_CLOCKS ? baseKHz[i] :
+					(metric == TELEMETRY_BOOST_CLOCKS ? boostKHz[i] : kHz - kHz % 15000);
+			}
+			*count = sizeof(domains) / sizeof(domains[0]);
+			break;
+		}
+
+		case TELEMETRY_PSTATE:
+			samples[0].channel = 0;
+			samples[0].value = load > 0.5 ? NVAPI_GPU_PERF_PSTATE_P0 : (load > 0.0 ? NVAPI_GPU_PERF_PSTATE_P2 : NVAPI_GPU_PERF_PSTATE_P8);
+			*count = 1;
+			break;
+
+		case TELEMETRY_UTILIZATION:
+		{
+			// Graphics, framebuffer, video and bus
+			static const double busyAtFullLoad[] = { 97.0, 60.0, 0.0, 20.0 };
+			for (NvU32 i = 0; i < sizeof(busyAtFullLoad) / sizeof(busyAtFullLoad[0]); i++)
+			{
+				NvS64 percent = (NvS64)(load * busyAtFullLoad[i]) + (load > 0.0 ? Noise(time, gpu, i) : 0);
+				samples[i].channel = (NvU8)i;
+				samples[i].value = percent < 0 ? 0 : (percent > 100 ? 100 : percent);
+			}
+			*count = sizeof(busyAtFullLoad) / sizeof(busyAtFullLoad[0]);
+			break;
+		}
+
+		case TELEMETRY_MEMORY:
+		{
+			// 8 GB, of which 1 GB idle to 6 GB loaded is in use, in 4 MB steps
+			const NvS64 TOTAL_KB = 8 * 1024 * 1024;
+			NvS64 usedKB = 1024 * 1024 + (NvS64)(load * 5 * 1024 * 1024);
+			samples[0].channel = 0;
+			samples[0].value = TOTAL_KB;
+			samples[1].channel = 1;
+			samples[1].value = TOTAL_KB - (usedKB - usedKB % 4096);
+			*count = 2;
+			break;
+		}
+
+		case TELEMETRY_THROTTLE:
+		{
+			// Power capping in bursts while fully loaded, a few seconds of each 7, and thermal slowdown once
+			// the load has run hot for 12 s
+			NvU64 phase = (time + gpu * 3700000ULL) % PHASE_MICROSECONDS;
+			NvS64 reasons = NV_GPU_PERF_DECREASE_NONE;
+			if (load >= 1.0 && (phase / 1000000 + gpu) % 7 < 3)
+				reasons |= NV_GPU_PERF_DECREASE_REASON_POWER_CONTROL;
+			if (load >= 1.0 && phase >= 14000000)
+				reasons |= NV_GPU_PERF_DECREASE_REASON_THERMAL_PROTECTION;
+			samples[0].channel = 0;
+			samples[0].value = reasons;
+			*count = 1;
+			break;
+		}
+
+		case TELEMETRY_ECC:
+		{
+			// Every fourth GPU is clean; the others gain a burst of five single-bit errors, one each 2 s, every
+			// 20 to 35 minutes, and on every eighth GPU one burst in three starts with a double-bit error
+			NvU64 burstMicroseconds = (20 + (NvU64)(gpu % 4) * 5) * 60000000;
+			NvU64 shifted = time + gpu * 97000000ULL;
+			NvU64 bursts = gpu % 4 == 3 ? 0 : shifted / burstMicroseconds;
+			NvU64 inBurst = gpu % 4 == 3 ? 0 : (shifted % burstMicroseconds) / 2000000;
+			NvS64 singleBit = (NvS64)(bursts * 5 + (inBurst < 5 ? inBurst : 5));
+			NvS64 doubleBit = gpu % 8 == 1 ? (NvS64)((bursts + 2) / 3) : 0;
+			samples[0].channel = TELEMETRY_ECC_SINGLE_BIT;
+			samples[0].value = singleBit;
+			samples[1].channel = TELEMETRY_ECC_DOUBLE_BIT;
+			samples[1].value = doubleBit;
+			samples[2].channel = TELEMETRY_ECC_AGGREGATE_SINGLE_BIT;
+			samples[2].value = singleBit + gpu * 40;
+			samples[3].channel = TELEMETRY_ECC_AGGREGATE_DOUBLE_BIT;
+			samples[3].value = doubleBit + gpu % 3;
+			*count = TELEMETRY_ECC_COUNTERS;
+			break;
+		}
+
+		default:
+			return NVAPI_INVALID_ARGUMENT;
+		}
+
+		return NVAPI_OK;
+	}
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "nvapi.h"
+#include "TelemetrySource.h"
+
+#include <atomic>
+
+namespace ControlPanel
+{
+	/*
+	Synthetic GPUs for running the telemetry pipeline without hardware. Every
+	GPU alternates between load and idle phases (offset per GPU), and its
+	temperatures, fan speed, clocks, P-state, utilization, memory in use and
+	throttle reasons follow the phase, with a little deterministic noise.
+	ECC errors come in rare short bursts, independent of the load. Values
+	depend only on the GPU and the read time, so concurrent reads are safe.
+	The configured latency is spent busy-waiting on every read, like a driver
+	call.
+	*/
+	class SimulatedTelemetrySource : public TelemetrySource
+	{
+	public:
+		SimulatedTelemetrySource(NvU32 gpuCount, NvU32 readMicroseconds = 0);
+
+		NvU32 GpuCount() const { return gpuCount; }
+		NvAPI_Status Read(NvU32 gpu, TelemetryMetric metric, TelemetrySample *samples, NvU32 *count);
+
+		// What a read time microseconds after construction returns, without the latency; for generating history
+		NvAPI_Status ReadAt(NvU32 gpu, TelemetryMetric metric, NvU64 time, TelemetrySample *samples, NvU32 *count) const;
+
+		unsigned long long ReadCount() const { return readCount; }
+
+	private:
+		SimulatedTelemetrySource(const SimulatedTelemetrySource &);
+		SimulatedTelemetrySource &operator=(const SimulatedTelemetrySource &);
+
+		NvU32 gpuCount;
+		NvU32 readMicroseconds;
+		NvU64 epoch;
+		std::atomic<unsigned long long> readCount;
+	};
+};
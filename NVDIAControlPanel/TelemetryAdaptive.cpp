@@ -0,0 +1,126 @@
+#include "targetver.h"
+#include "TelemetryAdaptive.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace ControlPanel
+{
+	bool IsTelemetryAdaptive(TelemetryMetric metric)
+	{
+		return metric == TELEMETRY_TEMPERATURE || metric == TELEMETRY_TACH || metric == TELEMETRY_CLOCKS || metric == TELEMETRY_ECC;
+	}
+
+	TelemetryAdaptiveConfig DefaultTelemetryAdaptiveConfig(TelemetryMetric metric)
+	{
+		TelemetryAdaptiveConfig config;
+		config.minPeriodMs = 250;
+		config.periodMs = 1000;
+		config.maxPeriodMs = 2000;
+		switch (metric)
+		{
+		case TELEMETRY_TEMPERATURE:
+			// Sensors wander by a degree either way
+			config.deadband = 2;
+			config.ratePerSecond = 2;
+			config.deviation = 2;
+			break;
+
+		case TELEMETRY_TACH:
+			config.deadband = 50;
+			config.ratePerSecond = 100;
+			config.deviation = 100;
+			break;
+
+		case TELEMETRY_ECC:
+			// A single error is worth following
+			config.minPeriodMs = 1000;
+			config.periodMs = 10000;
+			config.maxPeriodMs = 20000;
+			config.deadband = 0;
+			config.ratePerSecond = 0;
+			config.deviation = 0;
+			break;
+
+		default:
+			// kHz; current clocks move in 15 MHz bins
+			config.deadband = 15000;
+			config.ratePerSecond = 100000;
+			config.deviation = 50000;
+			break;
+		}
+		return config;
+	}
+
+	TelemetryAdaptiveRate::TelemetryAdaptiveRate(const TelemetryAdaptiveConfig &config)
+		: config(config)
+		, lastTimestamp(0)
+		, periodMicroseconds((NvU64)config.minPeriodMs * 1000)
+		, owedMicroseconds(0)
+		, volatileReads(0)
+	{
+		memset(series, 0, sizeof(series));
+		if (this->config.periodMs < this->config.minPeriodMs)
+			this->config.periodMs = this->config.minPeriodMs;
+		if (this->config.maxPeriodMs < this->config.periodMs)
+			this->config.maxPeriodMs = this->config.periodMs;
+	}
+
+	NvU64 TelemetryAdaptiveRate::Update(const TelemetrySample *samples, NvU32 count, NvU64 timestamp)
+	{
+		NvU64 elapsed = timestamp > lastTimestamp ? timestamp - lastTimestamp : 1;
+		bool moving = false;
+		for (NvU32 i = 0; i < count; i++)
+		{
+			if (samples[i].channel >= TELEMETRY_MAX_CHANNELS)
+				continue;
+
+			Series &channel = series[samples[i].channel];
+			NvS64 value = samples[i].value;
+			if (channel.count > 0)
+			{
+				NvS64 last = channel.values[(channel.count - 1) % WINDOW];
+				NvS64 change = value > last ? value - last : last - value;
+				if (change > config.deadband && (double)change * 1000000.0 / elapsed >= (double)config.ratePerSecond)
+					moving = true;
+			}
+			channel.values[channel.count % WINDOW] = value;
+			channel.count++;
+
+			NvU32 window = channel.count < WINDOW ? channel.count : WINDOW;
+			if (window < 2)
+				continue;
+
+			double mean = 0.0;
+			for (NvU32 j = 0; j < window; j++)
+				mean += (double)channel.values[j];
+			mean /= window;
+
+			double variance = 0.0;
+			for (NvU32 j = 0; j < window; j++)
+				variance += ((double)channel.values[j] - mean) * ((double)channel.values[j] - mean);
+			if (sqrt(variance / (window - 1)) > (double)config.deviation)
+				moving = true;
+		}
+		lastTimestamp = timestamp;
+
+		// Straight to the fastest rate while moving. Every read taken that way is paid back with a whole
+		// period once quiet, reads at most the maximum apart, so once paid back they match the fixed period's
+		NvU64 period = (NvU64)config.periodMs * 1000;
+		if (moving)
+		{
+			volatileReads++;
+			periodMicroseconds = (NvU64)config.minPeriodMs * 1000;
+			owedMicroseconds += period;
+		}
+		else
+		{
+			NvU64 stretch = (NvU64)config.maxPeriodMs * 1000 - period;
+			if (stretch > owedMicroseconds)
+				stretch = owedMicroseconds;
+			periodMicroseconds = period + stretch;
+			owedMicroseconds -= stretch;
+		}
+		return periodMicroseconds;
+	}
+};
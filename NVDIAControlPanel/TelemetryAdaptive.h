@@ -0,0 +1,65 @@
+#pragma once
+
+#include "nvapi.h"
+#include "TelemetrySource.h"
+
+namespace ControlPanel
+{
+	struct TelemetryAdaptiveConfig
+	{
+		NvU32 minPeriodMs;
+		NvU32 periodMs;             // reads average out to this period, the metric's fixed one
+		NvU32 maxPeriodMs;
+		NvS64 deadband;             // changes this small are sensor noise, in the metric's unit
+		NvS64 ratePerSecond;        // a larger change per second is a movement worth following
+		NvS64 deviation;            // as is a recent standard deviation above this
+	};
+
+	// Temperature, tach, current clocks and ECC counters; false for metrics that are sampled at a fixed period
+	bool IsTelemetryAdaptive(TelemetryMetric metric);
+
+	// 250 ms while moving, paid back at up to 2 s, around the fixed 1 s; thresholds sit above the noise
+	// of each sensor. ECC counters, which only ever count up, 1 s on any change, paid back at up to 20 s
+	// around the fixed 10 s
+	TelemetryAdaptiveConfig DefaultTelemetryAdaptiveConfig(TelemetryMetric metric);
+
+	/*
+	Period of one (GPU, metric) read, from what its channels did lately. Every
+	channel is a series with its last few values; when any of them moved
+	faster than the rate since the previous read, or the recent values deviate
+	more than the threshold, the next read comes after the minimum period.
+	Once the signal is quiet again those extra reads are paid back by reading
+	up to the maximum period apart, then it reads at the fixed period: the
+	reads it spends go where the signal moves, and once paid back add up to
+	no more than the fixed period's. The window is short so a step stops counting as
+	volatile soon after the signal settles. One driver call reads every
+	channel, so the most volatile channel sets the rate of all of them.
+	*/
+	class TelemetryAdaptiveRate
+	{
+	public:
+		explicit TelemetryAdaptiveRate(const TelemetryAdaptiveConfig &config);
+
+		// One read's samples, all stamped at timestamp (microseconds); returns the period until the next read
+		NvU64 Update(const TelemetrySample *samples, NvU32 count, NvU64 timestamp);
+
+		NvU64 PeriodMicroseconds() const { return periodMicroseconds; }
+		unsigned long long VolatileReads() const { return volatileReads; }
+
+	private:
+		static const NvU32 WINDOW = 4;
+
+		struct Series
+		{
+			NvU32 count;                // values seen, the window is full from WINDOW on
+			NvS64 values[WINDOW];       // ring, newest at (count - 1) % WINDOW
+		};
+
+		TelemetryAdaptiveConfig config;
+		Series series[TELEMETRY_MAX_CHANNELS];     // by channel
+		NvU64 lastTimestamp;
+		NvU64 periodMicroseconds;
+		NvU64 owedMicroseconds;     // reads taken early, still to be paid back
+		unsigned long long volatileReads;
+	};
+};
@@ -0,0 +1,506 @@
+#include "targetver.h"
+#include "TelemetryAlerts.h"
+#include "TelemetryDelta.h"
+
+#include <ctype.h>
+#include <limits>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define TELEMETRY_ALERTS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace ControlPanel
+{
+	namespace
+	{
+		const NvU32 NO_SERIES = 0xFFFFFFFF;
+		const double DEFAULT_HYSTERESIS = 0.05;    // of the limit
+
+		void SkipSpaces(const char *&text)
+		{
+			while (*text == ' ' || *text == '\t')
+				text++;
+		}
+
+		// A whole word, then any spaces after it
+		bool ParseWord(const char *&text, const char *word)
+		{
+			size_t length = strlen(word);
+			if (strncmp(text, word, length) != 0 || isalpha((unsigned char)text[length]))
+				return false;
+
+			text += length;
+			SkipSpaces(text);
+			return true;
+		}
+
+		bool ParseNumber(const char *&text, double &value)
+		{
+			char *end = NULL;
+			value = strtod(text, &end);
+			if (end == text)
+				return false;
+
+			text = end;
+			SkipSpaces(text);
+			return true;
+		}
+
+		bool ParseDuration(const char *&text, NvU32 &milliseconds)
+		{
+			char *end = NULL;
+			double value = strtod(text, &end);
+			if (end == text || value < 0.0)
+				return false;
+
+			double scale;
+			if (strncmp(end, "ms", 2) == 0)
+			{
+				scale = 1.0;
+				end += 2;
+			}
+			else if (*end == 's' || *end == 'm')
+			{
+				scale = *end == 's' ? 1000.0 : 60000.0;
+				end++;
+			}
+			else
+			{
+				return false;
+			}
+
+			milliseconds = (NvU32)(value * scale + 0.5);
+			text = end;
+			SkipSpaces(text);
+			return true;
+		}
+
+		// A channel name of the metric, or its number
+		bool ParseChannel(const char *&text, TelemetryMetric metric, int &channel)
+		{
+			// Names as TelemetryChannelName spells them, e.g. "aggregate-double-bit"
+			const char *start = text;
+			while (isalnum((unsigned char)*text) || *text == '-')
+				text++;
+
+			std::string token(start, text - start);
+			if (token.empty())
+				return false;
+
+			if (isdigit((unsigned char)token[0]))
+			{
+				channel = atoi(token.c_str());
+				return channel < (int)TELEMETRY_MAX_CHANNELS;
+			}
+
+			for (NvU32 i = 0; i < TELEMETRY_MAX_CHANNELS; i++)
+			{
+				const char *name = TelemetryChannelName(metric, i);
+				if (name != NULL && token == name)
+				{
+					channel = (int)i;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool Matches(const TelemetryAlertRule &rule, NvU32 series)
+		{
+			TelemetrySample sample;
+			SetTelemetrySeries(sample, series);
+			return sample.metric == rule.metric && (rule.gpu < 0 || sample.gpu == rule.gpu) && (rule.channel < 0 || sample.channel == rule.channel);
+		}
+
+		NvU32 RoundUp4(NvU32 count)
+		{
+			return (count + 3) & ~3u;
+		}
+	}
+
+	bool ParseTelemetryAlertRule(const char *text, TelemetryAlertRule &rule)
+	{
+		rule.text = text;
+		rule.gpu = -1;
+		rule.channel = -1;
+		rule.limit = 0.0;
+		rule.percent = false;
+		rule.windowMs = 0;
+		rule.sustainMs = 0;
+		rule.hysteresis = -1.0;
+
+		const char *p = text;
+		SkipSpaces(p);
+		const char *start = p;
+		while (isalpha((unsigned char)*p) || *p == '-')
+			p++;
+
+		std::string metric(start, p - start);
+		if (!ParseTelemetryMetric(metric.c_str(), &rule.metric))
+			return false;
+
+		if (*p == '.')
+		{
+			p++;
+			if (!ParseChannel(p, rule.metric, rule.channel))
+				return false;
+		}
+		if (*p == '@')
+		{
+			p++;
+			if (!isdigit((unsigned char)*p))
+				return false;
+
+			rule.gpu = (int)strtol(p, (char **)&p, 10);
+		}
+		SkipSpaces(p);
+
+		const char *operation = p;
+		if (*p == '>' || *p == '<')
+		{
+			rule.kind = *p == '>' ? TELEMETRY_ALERT_ABOVE : TELEMETRY_ALERT_BELOW;
+			p++;
+			SkipSpaces(p);
+			if (!ParseNumber(p, rule.limit))
+				return false;
+		}
+		else if (ParseWord(p, "rises") || ParseWord(p, "falls"))
+		{
+			rule.kind = *operation == 'r' ? TELEMETRY_ALERT_RISE : TELEMETRY_ALERT_FALL;
+			if (!ParseNumber(p, rule.limit) || rule.limit < 0.0)
+				return false;
+
+			if (*p == '%')
+			{
+				rule.percent = true;
+				p++;
+				SkipSpaces(p);
+			}
+		}
+		else
+		{
+			return false;
+		}
+
+		while (*p != '\0')
+		{
+			if (ParseWord(p, "for"))
+			{
+				if (!ParseDuration(p, rule.sustainMs))
+					return false;
+			}
+			else if (ParseWord(p, "in"))
+			{
+				if (!ParseDuration(p, rule.windowMs))
+					return false;
+			}
+			else if (ParseWord(p, "hysteresis"))
+			{
+				if (!ParseNumber(p, rule.hysteresis) || rule.hysteresis < 0.0)
+					return false;
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		bool change = rule.kind == TELEMETRY_ALERT_RISE || rule.kind == TELEMETRY_ALERT_FALL;
+		if (change && rule.windowMs == 0)
+			return false;
+
+		if (rule.hysteresis < 0.0)
+			rule.hysteresis = (rule.limit < 0.0 ? -rule.limit : rule.limit) * DEFAULT_HYSTERESIS;
+		return true;
+	}
+
+	TelemetryAlertEngine::TelemetryAlertEngine(NvU32 tickMs)
+		: tickMicroseconds((NvU64)(tickMs > 0 ? tickMs : 1) * 1000)
+		, lastTick(0)
+		, vectorised(true)
+		, evaluations(0)
+		, raised(0)
+		, cleared(0)
+	{
+	}
+
+	NvU32 TelemetryAlertEngine::AddRule(const TelemetryAlertRule &rule)
+	{
+		CompiledRule compiled;
+		compiled.rule = rule;
+		compiled.laneCount = 0;
+
+		// Falling compares negated values, so every rule raises on "greater than"
+		float limit = (float)rule.limit;
+		float hysteresis = (float)rule.hysteresis;
+		switch (rule.kind)
+		{
+		case TELEMETRY_ALERT_ABOVE:
+			compiled.sign = 1.0f;
+			compiled.raiseScale = 0.0f;
+			compiled.raiseOffset = limit;
+			compiled.clearScale = 0.0f;
+			compiled.clearOffset = limit - hysteresis;
+			break;
+
+		case TELEMETRY_ALERT_BELOW:
+			compiled.sign = -1.0f;
+			compiled.raiseScale = 0.0f;
+			compiled.raiseOffset = -limit;
+			compiled.clearScale = 0.0f;
+			compiled.clearOffset = -(limit + hysteresis);
+			break;
+
+		case TELEMETRY_ALERT_RISE:
+			compiled.sign = 1.0f;
+			compiled.raiseScale = rule.percent ? 1.0f + limit / 100.0f : 1.0f;
+			compiled.raiseOffset = rule.percent ? 0.0f : limit;
+			compiled.clearScale = rule.percent ? 1.0f + (limit - hysteresis) / 100.0f : 1.0f;
+			compiled.clearOffset = rule.percent ? 0.0f : limit - hysteresis;
+			break;
+
+		default:
+			compiled.sign = -1.0f;
+			compiled.raiseScale = rule.percent ? -(1.0f - limit / 100.0f) : -1.0f;
+			compiled.raiseOffset = rule.percent ? 0.0f : limit;
+			compiled.clearScale = rule.percent ? -(1.0f - (limit - hysteresis) / 100.0f) : -1.0f;
+			compiled.clearOffset = rule.percent ? 0.0f : limit - hysteresis;
+			break;
+		}
+
+		NvU64 tickMs = tickMicroseconds / 1000;
+		compiled.sustainTicks = (NvS32)((rule.sustainMs + tickMs - 1) / tickMs);
+		if (compiled.sustainTicks < 1)
+			compiled.sustainTicks = 1;
+
+		compiled.windowTicks = 0;
+		if (rule.kind == TELEMETRY_ALERT_RISE || rule.kind == TELEMETRY_ALERT_FALL)
+		{
+			compiled.windowTicks = (NvU32)((rule.windowMs + tickMs / 2) / tickMs);
+			if (compiled.windowTicks < 1)
+				compiled.windowTicks = 1;
+		}
+
+		NvU32 index = (NvU32)rules.size();
+		rules.push_back(compiled);
+
+		// Series that already reported join straight away
+		for (std::unordered_map<NvU32, std::vector<Lane> >::iterator it = lanesBySeries.begin(); it != lanesBySeries.end(); ++it)
+		{
+			if (!Matches(rule, it->first))
+				continue;
+
+			Lane lane = { index, rules[index].laneCount };
+			AddLane(rules[index], it->first);
+			it->second.push_back(lane);
+		}
+		return index;
+	}
+
+	NvU32 TelemetryAlertEngine::LaneCount() const
+	{
+		NvU32 count = 0;
+		for (size_t i = 0; i < rules.size(); i++)
+			count += rules[i].laneCount;
+		return count;
+	}
+
+	void TelemetryAlertEngine::AddSeries(NvU32 series, std::vector<Lane> &lanes)
+	{
+		for (NvU32 i = 0; i < (NvU32)rules.size(); i++)
+		{
+			if (!Matches(rules[i].rule, series))
+				continue;
+
+			Lane lane = { i, rules[i].laneCount };
+			AddLane(rules[i], series);
+			lanes.push_back(lane);
+		}
+	}
+
+	void TelemetryAlertEngine::AddLane(CompiledRule &rule, NvU32 series)
+	{
+		NvU32 width = RoundUp4(rule.laneCount);
+		if (rule.laneCount == width)
+		{
+			// Four more lanes of padding; the history rows are copied to the wider layout
+			const float NOT_A_NUMBER = std::numeric_limits<float>::quiet_NaN();
+			rule.series.resize(width + 4, NO_SERIES);
+			rule.values.resize(width + 4, NOT_A_NUMBER);
+			rule.held.resize(width + 4, 0);
+			rule.active.resize(width + 4, 0);
+			if (rule.windowTicks > 0)
+			{
+				std::vector<float> history((size_t)rule.windowTicks * (width + 4), NOT_A_NUMBER);
+				for (NvU32 row = 0; row < rule.windowTicks && width > 0; row++)
+					memcpy(&history[(size_t)row * (width + 4)], &rule.history[(size_t)row * width], width * sizeof(float));
+				rule.history.swap(history);
+			}
+		}
+
+		rule.series[rule.laneCount++] = series;
+	}
+
+	void TelemetryAlertEngine::OnSamples(const TelemetrySample *samples, NvU32 count)
+	{
+		if (count == 0)
+			return;
+
+		Update(samples, count);
+
+		NvU64 latest = 0;
+		for (NvU32 i = 0; i < count; i++)
+			latest = samples[i].timestamp > latest ? samples[i].timestamp : latest;
+		Evaluate(latest);
+	}
+
+	void TelemetryAlertEngine::Update(const TelemetrySample *samples, NvU32 count)
+	{
+		for (NvU32 i = 0; i < count; i++)
+		{
+			NvU32 series = TelemetrySeriesKey(samples[i]);
+			std::unordered_map<NvU32, std::vector<Lane> >::iterator it = lanesBySeries.find(series);
+			if (it == lanesBySeries.end())
+			{
+				it = lanesBySeries.insert(std::make_pair(series, std::vector<Lane>())).first;
+				AddSeries(series, it->second);
+			}
+
+			const std::vector<Lane> &lanes = it->second;
+			for (size_t j = 0; j < lanes.size(); j++)
+				rules[lanes[j].rule].values[lanes[j].lane] = (float)samples[i].value;
+		}
+	}
+
+	void TelemetryAlertEngine::Evaluate(NvU64 timestamp)
+	{
+		NvU64 tick = timestamp / tickMicroseconds;
+		if (evaluations > 0 && tick <= lastTick)
+			return;
+
+		// Ticks since the last evaluation, so sustain counts what the previous values held for
+		NvU64 elapsed = evaluations > 0 ? tick - lastTick : 1;
+		NvS32 ticks = elapsed < 0x100000 ? (NvS32)elapsed : 0x100000;
+		for (NvU32 index = 0; index < (NvU32)rules.size(); index++)
+		{
+			CompiledRule &rule = rules[index];
+			NvU32 width = RoundUp4(rule.laneCount);
+			if (width == 0)
+				continue;
+
+			const float *reference = NULL;
+			NvU32 window = rule.windowTicks;
+			if (window > 0)
+			{
+				// Skipped ticks get the values that were current through them; the row of tick is tick - window
+				NvU64 skipped = elapsed - 1 < window ? elapsed - 1 : window;
+				for (NvU64 t = tick - skipped; t < tick; t++)
+					memcpy(&rule.history[(size_t)(t % window) * width], &rule.values[0], width * sizeof(float));
+				reference = &rule.history[(size_t)(tick % window) * width];
+			}
+
+#ifdef TELEMETRY_ALERTS_SSE2
+			if (vectorised)
+				EvaluateRule(index, reference, ticks, timestamp);
+			else
+#endif
+				EvaluateRuleScalar(index, reference, ticks, timestamp);
+
+			if (window > 0)
+				memcpy(&rule.history[(size_t)(tick % window) * width], &rule.values[0], width * sizeof(float));
+		}
+
+		lastTick = tick;
+		evaluations++;
+	}
+
+	void TelemetryAlertEngine::EvaluateRule(NvU32 index, const float *reference, NvS32 ticks, NvU64 timestamp)
+	{
+#ifdef TELEMETRY_ALERTS_SSE2
+		CompiledRule &rule = rules[index];
+		const __m128 sign = _mm_set1_ps(rule.sign);
+		const __m128 raiseScale = _mm_set1_ps(rule.raiseScale);
+		const __m128 raiseOffset = _mm_set1_ps(rule.raiseOffset);
+		const __m128 clearScale = _mm_set1_ps(rule.clearScale);
+		const __m128 clearOffset = _mm_set1_ps(rule.clearOffset);
+		const __m128i elapsed = _mm_set1_epi32(ticks);
+		const __m128i sustain = _mm_set1_epi32(rule.sustainTicks);
+		const __m128 zero = _mm_setzero_ps();
+
+		NvU32 width = RoundUp4(rule.laneCount);
+		float *values = &rule.values[0];
+		NvS32 *held = &rule.held[0];
+		NvS32 *active = &rule.active[0];
+		for (NvU32 i = 0; i < width; i += 4)
+		{
+			__m128 value = _mm_mul_ps(sign, _mm_loadu_ps(values + i));
+			__m128 earlier = reference != NULL ? _mm_loadu_ps(reference + i) : zero;
+
+			// NaN, a series that never reported or padding, compares false both ways
+			__m128i raising = _mm_castps_si128(_mm_cmpgt_ps(value, _mm_add_ps(_mm_mul_ps(raiseScale, earlier), raiseOffset)));
+			__m128i clearing = _mm_castps_si128(_mm_cmplt_ps(value, _mm_add_ps(_mm_mul_ps(clearScale, earlier), clearOffset)));
+
+			__m128i count = _mm_and_si128(_mm_add_epi32(_mm_loadu_si128((const __m128i *)(held + i)), elapsed), raising);
+			_mm_storeu_si128((__m128i *)(held + i), count);
+
+			// Raised once it held long enough, kept until the clear level
+			__m128i was = _mm_loadu_si128((const __m128i *)(active + i));
+			__m128i sustained = _mm_andnot_si128(_mm_cmpgt_epi32(sustain, count), raising);
+			__m128i now = _mm_or_si128(sustained, _mm_andnot_si128(clearing, was));
+			_mm_storeu_si128((__m128i *)(active + i), now);
+
+			int changed = _mm_movemask_ps(_mm_castsi128_ps(_mm_xor_si128(now, was)));
+			for (NvU32 lane = i; changed != 0; lane++, changed >>= 1)
+			{
+				if (changed & 1)
+					Emit(index, lane, reference, timestamp);
+			}
+		}
+#else
+		EvaluateRuleScalar(index, reference, ticks, timestamp);
+#endif
+	}
+
+	void TelemetryAlertEngine::EvaluateRuleScalar(NvU32 index, const float *reference, NvS32 ticks, NvU64 timestamp)
+	{
+		CompiledRule &rule = rules[index];
+		for (NvU32 lane = 0; lane < rule.laneCount; lane++)
+		{
+			float value = rule.sign * rule.values[lane];
+			float earlier = reference != NULL ? reference[lane] : 0.0f;
+			bool raising = value > rule.raiseScale * earlier + rule.raiseOffset;
+			bool clearing = value < rule.clearScale * earlier + rule.clearOffset;
+
+			rule.held[lane] = raising ? rule.held[lane] + ticks : 0;
+			bool was = rule.active[lane] != 0;
+			bool now = (raising && rule.held[lane] >= rule.sustainTicks) || (was && !clearing);
+			if (now != was)
+			{
+				rule.active[lane] = now ? -1 : 0;
+				Emit(index, lane, reference, timestamp);
+			}
+		}
+	}
+
+	void TelemetryAlertEngine::Emit(NvU32 index, NvU32 lane, const float *reference, NvU64 timestamp)
+	{
+		const CompiledRule &rule = rules[index];
+		TelemetryAlertEvent event;
+		event.timestamp = timestamp;
+		event.rule = index;
+		event.series = rule.series[lane];
+		event.raised = rule.active[lane] != 0;
+		event.value = rule.values[lane];
+		event.reference = reference != NULL ? reference[lane] : 0.0f;
+		if (event.raised)
+			raised++;
+		else
+			cleared++;
+
+		for (size_t i = 0; i < sinks.size(); i++)
+			sinks[i]->OnAlert(rule.rule, event);
+	}
+};
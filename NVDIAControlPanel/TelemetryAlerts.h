@@ -0,0 +1,150 @@
+#pragma once
+
+#include "nvapi.h"
+#include "TelemetrySource.h"
+#include "TelemetrySampler.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ControlPanel
+{
+	enum TelemetryAlertKind
+	{
+		TELEMETRY_ALERT_ABOVE,      // value > limit
+		TELEMETRY_ALERT_BELOW,      // value < limit
+		TELEMETRY_ALERT_RISE,       // value - the value windowMs ago > limit
+		TELEMETRY_ALERT_FALL        // the value windowMs ago - value > limit
+	};
+
+	struct TelemetryAlertRule
+	{
+		std::string text;           // as written, for events
+		TelemetryMetric metric;
+		int gpu;                    // -1 for every GPU
+		int channel;                // -1 for every channel
+		TelemetryAlertKind kind;
+		double limit;
+		bool percent;               // rise and fall: limit is a percentage of the earlier value
+		NvU32 windowMs;             // rise and fall
+		NvU32 sustainMs;            // how long the condition must hold before the alert is raised
+		double hysteresis;          // how far back past the limit the value must go to clear, in the unit of limit
+	};
+
+	/*
+	<metric>[.<channel>][@<gpu>] > <limit> [for <duration>] [hysteresis <amount>]
+	<metric>[.<channel>][@<gpu>] < <limit> ...
+	<metric>[.<channel>][@<gpu>] rises <amount>[%] in <duration> ...
+	<metric>[.<channel>][@<gpu>] falls <amount>[%] in <duration> ...
+
+	Channels by name (clocks.graphics, ecc.double-bit) or number
+	(temperature.1), durations in ms, s or m. Hysteresis defaults to 5% of the
+	limit. For example "temperature > 85 for 10s" or "tach falls 40% in 5s".
+	*/
+	bool ParseTelemetryAlertRule(const char *text, TelemetryAlertRule &rule);
+
+	struct TelemetryAlertEvent
+	{
+		NvU64 timestamp;            // of the evaluation that changed the state
+		NvU32 rule;                 // index returned by AddRule
+		NvU32 series;               // TelemetrySeriesKey
+		bool raised;                // false when the alert cleared
+		float value;
+		float reference;            // rise and fall: the value windowMs earlier
+	};
+
+	class TelemetryAlertSink
+	{
+	public:
+		virtual ~TelemetryAlertSink() {}
+
+		virtual void OnAlert(const TelemetryAlertRule &rule, const TelemetryAlertEvent &event) = 0;
+	};
+
+	/*
+	Evaluates every rule against every series it matches, once per tick.
+	Each rule keeps its series as columns (latest value, ticks the condition
+	has held, raised or not, and for rise and fall a ring of past values)
+	padded to a multiple of four, so a tick is a straight SSE2 pass over each
+	rule: a multiply-add and compare for the condition, another for the clear
+	level, an add-and-mask for the sustain count and a mask merge for the
+	state. Only a group of four whose state changed leaves the vector path to
+	emit events. Series join the rules they match when they first report; one
+	that stops reporting keeps its last value. Every rule compiles to:
+
+		raise:  sign * value > raiseScale * reference + raiseOffset, for sustainTicks
+		clear:  sign * value < clearScale * reference + clearOffset
+	*/
+	class TelemetryAlertEngine : public TelemetrySubscriber
+	{
+	public:
+		explicit TelemetryAlertEngine(NvU32 tickMs = 100);
+
+		NvU32 AddRule(const TelemetryAlertRule &rule);
+		void Subscribe(TelemetryAlertSink *sink) { sinks.push_back(sink); }
+
+		// Update with the batch, then Evaluate at its latest timestamp
+		void OnSamples(const TelemetrySample *samples, NvU32 count);
+
+		void Update(const TelemetrySample *samples, NvU32 count);
+
+		// Does nothing until a tick boundary has passed since the last evaluation
+		void Evaluate(NvU64 timestamp);
+
+		// The scalar loop, for comparison and for targets without SSE2
+		void SetVectorised(bool vectorised) { this->vectorised = vectorised; }
+
+		const TelemetryAlertRule &Rule(NvU32 rule) const { return rules[rule].rule; }
+		NvU32 SeriesCount() const { return (NvU32)lanesBySeries.size(); }
+		NvU32 LaneCount() const;
+		unsigned long long EvaluationCount() const { return evaluations; }
+		unsigned long long RaisedCount() const { return raised; }
+		unsigned long long ClearedCount() const { return cleared; }
+
+	private:
+		TelemetryAlertEngine(const TelemetryAlertEngine &);
+		TelemetryAlertEngine &operator=(const TelemetryAlertEngine &);
+
+		struct CompiledRule
+		{
+			TelemetryAlertRule rule;
+			float sign;
+			float raiseScale;
+			float raiseOffset;
+			float clearScale;
+			float clearOffset;
+			NvS32 sustainTicks;             // at least 1
+			NvU32 windowTicks;              // 0 for above and below
+
+			NvU32 laneCount;                // series matched; the columns are padded to a multiple of 4
+			std::vector<NvU32> series;
+			std::vector<float> values;      // NaN until the series reports, and in padding
+			std::vector<NvS32> held;        // ticks the raise condition has held
+			std::vector<NvS32> active;      // 0 or -1
+			std::vector<float> history;     // windowTicks rows of the padded width, row = tick % windowTicks
+		};
+
+		struct Lane
+		{
+			NvU32 rule;
+			NvU32 lane;
+		};
+
+		void AddSeries(NvU32 series, std::vector<Lane> &lanes);
+		void AddLane(CompiledRule &rule, NvU32 series);
+		void EvaluateRule(NvU32 index, const float *reference, NvS32 ticks, NvU64 timestamp);
+		void EvaluateRuleScalar(NvU32 index, const float *reference, NvS32 ticks, NvU64 timestamp);
+		void Emit(NvU32 index, NvU32 lane, const float *reference, NvU64 timestamp);
+
+		NvU64 tickMicroseconds;
+		std::vector<CompiledRule> rules;
+		std::unordered_map<NvU32, std::vector<Lane> > lanesBySeries;
+		std::vector<TelemetryAlertSink *> sinks;
+		NvU64 lastTick;
+		bool vectorised;
+		unsigned long long evaluations;
+		unsigned long long raised;
+		unsigned long long cleared;
+	};
+};
@@ -0,0 +1,99 @@
+#include "targetver.h"
+#include "TelemetryDelta.h"
+
+#include <string.h>
+
+namespace ControlPanel
+{
+	namespace
+	{
+		const char DELTA_MAGIC[8] = { 'N', 'V', 'C', 'P', 'D', 'L', 'T', '2' };
+	}
+
+	TelemetryDeltaFilter::TelemetryDeltaFilter()
+		: seen(0)
+		, changed(0)
+	{
+	}
+
+	void TelemetryDeltaFilter::OnSamples(const TelemetrySample *samples, NvU32 count)
+	{
+		changes.clear();
+		for (NvU32 i = 0; i < count; i++)
+		{
+			std::pair<std::unordered_map<NvU32, NvS64>::iterator, bool> entry =
+				last.insert(std::make_pair(TelemetrySeriesKey(samples[i]), samples[i].value));
+			if (entry.second || entry.first->second != samples[i].value)
+			{
+				entry.first->second = samples[i].value;
+				changes.push_back(samples[i]);
+			}
+		}
+
+		seen += count;
+		changed += changes.size();
+		if (changes.empty())
+			return;
+
+		for (size_t i = 0; i < subscribers.size(); i++)
+			subscribers[i]->OnSamples(&changes[0], (NvU32)changes.size());
+	}
+
+	TelemetryDeltaWriter::TelemetryDeltaWriter(BufferedWriter &writer)
+		: writer(writer)
+		, lastTimestamp(0)
+		, sampleCount(0)
+	{
+		writer.Write(DELTA_MAGIC, sizeof(DELTA_MAGIC));
+	}
+
+	void TelemetryDeltaWriter::OnSamples(const TelemetrySample *samples, NvU32 count)
+	{
+		for (NvU32 i = 0; i < count; i++)
+		{
+			const TelemetrySample &sample = samples[i];
+			NvU32 key = TelemetrySeriesKey(sample);
+
+			// Samples of one read share a timestamp, so after the first the delta is a single zero byte; reads
+			// of different GPUs can finish out of order, so it is signed
+			NvS64 &previous = last[key];
+			PutVarint(writer, ZigZag((NvS64)(sample.timestamp - lastTimestamp)));
+			PutVarint(writer, key);
+			PutVarint(writer, ZigZag(sample.value - previous));
+
+			lastTimestamp = sample.timestamp;
+			previous = sample.value;
+		}
+		sampleCount += count;
+	}
+
+	bool DecodeTelemetryDeltas(const NvU8 *data, size_t size, std::vector<TelemetrySample> &samples)
+	{
+		if (size < sizeof(DELTA_MAGIC) || memcmp(data, DELTA_MAGIC, sizeof(DELTA_MAGIC)) != 0)
+			return false;
+
+		const NvU8 *end = data + size;
+		data += sizeof(DELTA_MAGIC);
+
+		std::unordered_map<NvU32, NvS64> last;
+		NvU64 timestamp = 0;
+		while (data < end)
+		{
+			NvU64 elapsed, key, delta;
+			if (!ReadVarint(data, end, elapsed) || !ReadVarint(data, end, key) || !ReadVarint(data, end, delta))
+				return false;
+
+			NvS64 &previous = last[(NvU32)key];
+			previous += UnZigZag(delta);
+			timestamp += (NvU64)UnZigZag(elapsed);
+
+			TelemetrySample sample;
+			memset(&sample, 0, sizeof(sample));
+			sample.timestamp = timestamp;
+			sample.value = previous;
+			SetTelemetrySeries(sample, (NvU32)key);
+			samples.push_back(sample);
+		}
+		return true;
+	}
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "nvapi.h"
+#include "TelemetrySource.h"
+#include "TelemetrySampler.h"
+#include "BufferedWriter.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace ControlPanel
+{
+	// Identifies one series: GPU, metric and channel packed together
+	inline NvU32 TelemetrySeriesKey(const TelemetrySample &sample)
+	{
+		return (NvU32)sample.gpu << 13 | (NvU32)sample.metric << 8 | sample.channel;
+	}
+
+	inline void SetTelemetrySeries(TelemetrySample &sample, NvU32 key)
+	{
+		sample.gpu = (NvU16)(key >> 13);
+		sample.metric = (NvU8)(key >> 8 & 0x1F);
+		sample.channel = (NvU8)key;
+	}
+
+	// Varints and zigzag, shared by the binary telemetry formats
+	inline NvU64 ZigZag(NvS64 value)
+	{
+		return ((NvU64)value << 1) ^ (NvU64)(value >> 63);
+	}
+
+	inline NvS64 UnZigZag(NvU64 value)
+	{
+		return (NvS64)(value >> 1) ^ -(NvS64)(value & 1);
+	}
+
+	inline void PutVarint(std::vector<NvU8> &bytes, NvU64 value)
+	{
+		while (value >= 0x80)
+		{
+			bytes.push_back((NvU8)(value | 0x80));
+			value >>= 7;
+		}
+		bytes.push_back((NvU8)value);
+	}
+
+	inline void PutVarint(BufferedWriter &writer, NvU64 value)
+	{
+		while (value >= 0x80)
+		{
+			writer.Put((char)(value | 0x80));
+			value >>= 7;
+		}
+		writer.Put((char)value);
+	}
+
+	inline bool ReadVarint(const NvU8 *&data, const NvU8 *end, NvU64 &value)
+	{
+		value = 0;
+		for (int shift = 0; shift < 64 && data < end; shift += 7)
+		{
+			NvU8 byte = *data++;
+			value |= (NvU64)(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+				return true;
+		}
+		return false;
+	}
+
+	/*
+	Forwards only the samples whose value differs from the previous sample of
+	the same series; the first sample of every series always passes. Steady
+	clocks, P-states and fan speeds then cost nothing downstream.
+	*/
+	class TelemetryDeltaFilter : public TelemetrySubscriber
+	{
+	public:
+		TelemetryDeltaFilter();
+
+		void Subscribe(TelemetrySubscriber *subscriber) { subscribers.push_back(subscriber); }
+		void OnSamples(const TelemetrySample *samples, NvU32 count);
+
+		unsigned long long SeenCount() const { return seen; }
+		unsigned long long ChangedCount() const { return changed; }
+
+	private:
+		std::unordered_map<NvU32, NvS64> last;
+		std::vector<TelemetrySubscriber *> subscribers;
+		std::vector<TelemetrySample> changes;
+		unsigned long long seen;
+		unsigned long long changed;
+	};
+
+	/*
+	Delta-encoded capture, binary:
+
+		"NVCPDLT2"                  8-byte magic
+		per sample:
+		  varint    zigzag(microseconds since the previous sample, the first: since 0)
+		  varint    TelemetrySeriesKey
+		  varint    zigzag(value - previous value of the series, 0 before the first)
+
+	Put it behind a TelemetryDeltaFilter so that only changes are written;
+	a mostly-steady capture then grows only when something moves.
+	*/
+	class TelemetryDeltaWriter : public TelemetrySubscriber
+	{
+	public:
+		explicit TelemetryDeltaWriter(BufferedWriter &writer);
+
+		void OnSamples(const TelemetrySample *samples, NvU32 count);
+
+		unsigned long long SampleCount() const { return sampleCount; }
+
+	private:
+		BufferedWriter &writer;
+		std::unordered_map<NvU32, NvS64> last;
+		NvU64 lastTimestamp;
+		unsigned long long sampleCount;
+	};
+
+	// Rebuilds the samples of a capture; false when it is not one or is cut short
+	bool DecodeTelemetryDeltas(const NvU8 *data, size_t size, std::vector<TelemetrySample> &samples);
+};
@@ -0,0 +1,73 @@
+#include "targetver.h"
+#include "TelemetryEcc.h"
+
+#include <string.h>
+
+namespace ControlPanel
+{
+	TelemetryEccMonitor::TelemetryEccMonitor()
+		: reads(0)
+		, eventCount(0)
+	{
+	}
+
+	void TelemetryEccMonitor::OnSamples(const TelemetrySample *samples, NvU32 count)
+	{
+		events.clear();
+		for (NvU32 i = 0; i < count; i++)
+		{
+			const TelemetrySample &sample = samples[i];
+			if (sample.metric != TELEMETRY_ECC || sample.channel >= TELEMETRY_ECC_COUNTERS)
+				continue;
+
+			if (sample.gpu >= gpus.size())
+			{
+				size_t first = gpus.size();
+				gpus.resize((size_t)sample.gpu + 1);
+				for (size_t g = first; g < gpus.size(); g++)
+					memset(&gpus[g], 0, sizeof(GpuCounters));
+			}
+
+			// The counters of one read share its timestamp
+			GpuCounters &gpu = gpus[sample.gpu];
+			if (gpu.baselined == 0 || sample.timestamp != gpu.lastRead)
+			{
+				gpu.previousRead = gpu.baselined != 0 ? gpu.lastRead : sample.timestamp;
+				gpu.lastRead = sample.timestamp;
+				reads++;
+			}
+
+			NvU32 counter = sample.channel;
+			NvU64 value = sample.value > 0 ? (NvU64)sample.value : 0;
+			if ((gpu.baselined >> counter & 1) == 0)
+			{
+				gpu.baselined |= 1u << counter;
+				gpu.baseline[counter] = value;
+				gpu.last[counter] = value;
+				continue;
+			}
+			if (value == gpu.last[counter])
+				continue;
+
+			TelemetryEccEvent event;
+			event.timestamp = sample.timestamp;
+			event.window = (NvU32)(gpu.lastRead - gpu.previousRead);
+			event.gpu = sample.gpu;
+			event.counter = (NvU8)counter;
+			event.reset = value < gpu.last[counter];
+			event.errors = event.reset ? value : value - gpu.last[counter];
+			event.total = value;
+			events.push_back(event);
+
+			gpu.gained[counter] += event.errors;
+			gpu.last[counter] = value;
+		}
+
+		eventCount += events.size();
+		if (events.empty())
+			return;
+
+		for (size_t i = 0; i < sinks.size(); i++)
+			sinks[i]->OnEcc(&events[0], (NvU32)events.size());
+	}
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "nvapi.h"
+#include "TelemetrySource.h"
+#include "TelemetrySampler.h"
+
+#include <vector>
+
+namespace ControlPanel
+{
+	// Errors one ECC counter of one GPU gained between two reads
+	struct TelemetryEccEvent
+	{
+		NvU64 timestamp;            // of the read that saw the errors
+		NvU32 window;               // microseconds back to the read before; the errors happened in between
+		NvU16 gpu;
+		NvU8 counter;               // TelemetryEccCounter
+		bool reset;                 // the counter went down, so it was reset and errors counts from zero
+		NvU64 errors;
+		NvU64 total;                // the counter now
+	};
+
+	class TelemetryEccSink
+	{
+	public:
+		virtual ~TelemetryEccSink() {}
+
+		virtual void OnEcc(const TelemetryEccEvent *events, NvU32 count) = 0;
+	};
+
+	/*
+	Keeps the last counters read from each GPU and reports only what they
+	gained: a read that matches the previous one costs four compares and
+	produces nothing. The first read of a GPU is its baseline. Scheduled
+	adaptively, TELEMETRY_ECC is read every 64 s on a healthy board and every
+	second from when a counter moves until it has been still for a few reads.
+	*/
+	class TelemetryEccMonitor : public TelemetrySubscriber
+	{
+	public:
+		TelemetryEccMonitor();
+
+		void Subscribe(TelemetryEccSink *sink) { sinks.push_back(sink); }
+		void OnSamples(const TelemetrySample *samples, NvU32 count);
+
+		// GPUs up to the highest one that reported counters; Reporting is false for those with ECC off
+		NvU32 GpuCount() const { return (NvU32)gpus.size(); }
+		bool Reporting(NvU32 gpu) const { return gpus[gpu].baselined != 0; }
+
+		NvU64 Baseline(NvU32 gpu, NvU32 counter) const { return gpus[gpu].baseline[counter]; }
+		NvU64 Counter(NvU32 gpu, NvU32 counter) const { return gpus[gpu].last[counter]; }
+
+		// Errors counted since the baseline, across resets
+		NvU64 Gained(NvU32 gpu, NvU32 counter) const { return gpus[gpu].gained[counter]; }
+
+		unsigned long long ReadCount() const { return reads; }
+		unsigned long long EventCount() const { return eventCount; }
+
+	private:
+		struct GpuCounters
+		{
+			NvU32 baselined;                            // bit per counter read at least once
+			NvU64 previousRead;
+			NvU64 lastRead;
+			NvU64 baseline[TELEMETRY_ECC_COUNTERS];
+			NvU64 last[TELEMETRY_ECC_COUNTERS];
+			NvU64 gained[TELEMETRY_ECC_COUNTERS];
+		};
+
+		std::vector<GpuCounters> gpus;
+		std::vector<TelemetryEccEvent> events;
+		std::vector<TelemetryEccSink *> sinks;
+		unsigned long long reads;
+		unsigned long long eventCount;
+	};
+};
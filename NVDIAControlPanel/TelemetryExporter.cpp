@@ -0,0 +1,542 @@
+#include "targetver.h"
+#include "TelemetryExporter.h"
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <stdio.h>
+#include <string.h>
+
+#pragma comment(lib, "ws2_32.lib")
+
+namespace ControlPanel
+{
+	namespace
+	{
+		const size_t HEADER_RESERVE = 160;
+		const size_t FAMILY_HEADER_MAX = 320;
+		const size_t LINE_MAX = 128;
+		const size_t EOF_RESERVE = 8;
+		const NvU32 REQUEST_CAPACITY = 2048;
+		const int POLL_MILLISECONDS = 100;
+
+		const char NOT_FOUND[] =
+			"HTTP/1.1 404 Not Found\r\n"
+			"Content-Type: text/plain\r\n"
+			"Content-Length: 10\r\n"
+			"\r\n"
+			"Not found\n";
+
+		// One metric family per TelemetryMetric; scale converts the sample to the unit of the name
+		struct Family
+		{
+			const char *name;
+			const char *unit;           // NULL for none
+			const char *help;
+			const char *channelLabel;   // NULL when the metric has a single channel
+			NvS64 scale;
+		};
+
+		const Family FAMILIES[TELEMETRY_METRIC_COUNT] =
+		{
+			{ "nvcp_gpu_temperature_celsius", "celsius", "GPU temperature per thermal sensor", "sensor", 1 },
+			{ "nvcp_gpu_fan_speed_rpm", "rpm", "Fan speed", NULL, 1 },
+			{ "nvcp_gpu_clock_hertz", "hertz", "Current clock per domain", "domain", 1000 },
+			{ "nvcp_gpu_base_clock_hertz", "hertz", "Base clock per domain", "domain", 1000 },
+			{ "nvcp_gpu_boost_clock_hertz", "hertz", "Boost clock per domain", "domain", 1000 },
+			{ "nvcp_gpu_pstate", NULL, "Current performance state, 0 is the fastest", NULL, 1 },
+			{ "nvcp_gpu_utilization_percent", "percent", "Share of the last second each domain was busy", "domain", 1 },
+			{ "nvcp_gpu_memory_bytes", "bytes", "Dedicated video memory, total and currently available", "pool", 1024 },
+			{ "nvcp_gpu_perf_decrease_reasons", NULL, "Bitmask of the reasons the GPU is slowed down for: 1 thermal, 2 power, 4 AC/battery, 8 API, 16 insufficient power", NULL, 1 },
+			{ "nvcp_gpu_ecc_errors", NULL, "ECC errors since boot and, as aggregate, since the counters were last reset", "counter", 1 },
+		};
+
+		// Appends to a fixed buffer; text that does not fit is dropped whole
+		class TextCursor
+		{
+		public:
+			TextCursor(char *begin, char *end) : next(begin), end(end) {}
+
+			void Put(const char *text)
+			{
+				size_t length = strlen(text);
+				if ((size_t)(end - next) >= length)
+				{
+					memcpy(next, text, length);
+					next += length;
+				}
+			}
+
+			void PutDecimal(NvS64 value)
+			{
+				char digits[24];
+				char *first = digits + sizeof(digits);
+				*--first = '\0';
+				NvU64 magnitude = value < 0 ? 0 - (NvU64)value : (NvU64)value;
+				do
+				{
+					*--first = (char)('0' + magnitude % 10);
+					magnitude /= 10;
+				} while (magnitude > 0);
+				if (value < 0)
+					*--first = '-';
+				Put(first);
+			}
+
+			char *Next() const { return next; }
+
+		private:
+			char *next;
+			char *end;
+		};
+
+		bool StartsWith(const char *text, const char *end, const char *prefix)
+		{
+			size_t length = strlen(prefix);
+			return (size_t)(end - text) >= length && memcmp(text, prefix, length) == 0;
+		}
+
+		// Case-insensitive, as header names are
+		bool Contains(const char *text, const char *end, const char *lowercase)
+		{
+			size_t length = strlen(lowercase);
+			for (; (size_t)(end - text) >= length; text++)
+			{
+				size_t i = 0;
+				while (i < length && (text[i] >= 'A' && text[i] <= 'Z' ? text[i] - 'A' + 'a' : text[i]) == lowercase[i])
+					i++;
+				if (i == length)
+					return true;
+			}
+			return false;
+		}
+
+		const char *FindHeaderEnd(const char *text, const char *end)
+		{
+			for (; end - text >= 4; text++)
+			{
+				if (memcmp(text, "\r\n\r\n", 4) == 0)
+					return text + 4;
+			}
+			return NULL;
+		}
+	}
+
+	struct TelemetryExporter::Server
+	{
+		struct Connection
+		{
+			SOCKET socket;
+			char request[REQUEST_CAPACITY];
+			NvU32 received;
+			int response;               // index into responses, -1 for a static reply or none
+			const char *sending;
+			size_t remaining;
+			bool closeAfter;
+		};
+
+		explicit Server(TelemetryExporter &exporter)
+			: exporter(exporter)
+			, listener(INVALID_SOCKET)
+			, freeCount(0)
+		{
+			for (NvU32 i = TELEMETRY_EXPORTER_MAX_CONNECTIONS; i-- > 0;)
+			{
+				connections[i].socket = INVALID_SOCKET;
+				freeSlots[freeCount++] = i;
+			}
+		}
+
+		void Poll();
+		void Accept();
+		void Receive(Connection &connection);
+		void Serve(Connection &connection);
+		void Send(Connection &connection);
+		void Close(Connection &connection);
+
+		TelemetryExporter &exporter;
+		SOCKET listener;
+		Connection connections[TELEMETRY_EXPORTER_MAX_CONNECTIONS];
+		NvU32 freeSlots[TELEMETRY_EXPORTER_MAX_CONNECTIONS];
+		NvU32 freeCount;
+		WSAPOLLFD polls[TELEMETRY_EXPORTER_MAX_CONNECTIONS + 1];
+		NvU32 polled[TELEMETRY_EXPORTER_MAX_CONNECTIONS + 1];
+	};
+
+	void TelemetryExporter::Server::Poll()
+	{
+		NvU32 count = 0;
+		polls[count].fd = listener;
+		polls[count].events = freeCount > 0 ? POLLRDNORM : 0;
+		polls[count].revents = 0;
+		count++;
+
+		for (NvU32 i = 0; i < TELEMETRY_EXPORTER_MAX_CONNECTIONS; i++)
+		{
+			if (connections[i].socket == INVALID_SOCKET)
+				continue;
+
+			polls[count].fd = connections[i].socket;
+			polls[count].events = connections[i].remaining > 0 ? POLLWRNORM : POLLRDNORM;
+			polls[count].revents = 0;
+			polled[count] = i;
+			count++;
+		}
+
+		if (WSAPoll(polls, count, POLL_MILLISECONDS) <= 0)
+			return;
+
+		for (NvU32 i = 1; i < count; i++)
+		{
+			Connection &connection = connections[polled[i]];
+			if (polls[i].revents & POLLWRNORM)
+			{
+				Send(connection);
+				if (connection.socket != INVALID_SOCKET && connection.remaining == 0)
+					Serve(connection);
+			}
+			else if (polls[i].revents & POLLRDNORM)
+				Receive(connection);
+			else if (polls[i].revents & (POLLERR | POLLHUP | POLLNVAL))
+				Close(connection);
+		}
+
+		// After the connections, so a slot freed above can take a new one
+		if (polls[0].revents & POLLRDNORM)
+			Accept();
+	}
+
+	void TelemetryExporter::Server::Accept()
+	{
+		while (freeCount > 0)
+		{
+			SOCKET socket = accept(listener, NULL, NULL);
+			if (socket == INVALID_SOCKET)
+				return;
+
+			u_long nonBlocking = 1;
+			int noDelay = 1;
+			ioctlsocket(socket, FIONBIO, &nonBlocking);
+			setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char *)&noDelay, sizeof(noDelay));
+
+			Connection &connection = connections[freeSlots[--freeCount]];
+			connection.socket = socket;
+			connection.received = 0;
+			connection.response = -1;
+			connection.sending = NULL;
+			connection.remaining = 0;
+			connection.closeAfter = false;
+			exporter.stats.connections++;
+		}
+	}
+
+	void TelemetryExporter::Server::Receive(Connection &connection)
+	{
+		int received = recv(connection.socket, connection.request + connection.received, (int)(REQUEST_CAPACITY - connection.received), 0);
+		if (received == 0 || (received == SOCKET_ERROR && WSAGetLastError() != WSAEWOULDBLOCK))
+		{
+			Close(connection);
+			return;
+		}
+		if (received > 0)
+			connection.received += received;
+		Serve(connection);
+	}
+
+	void TelemetryExporter::Server::Serve(Connection &connection)
+	{
+		// Pipelined requests are answered one at a time, each after the previous one is sent
+		while (connection.socket != INVALID_SOCKET && connection.remaining == 0)
+		{
+			const char *request = connection.request;
+			const char *end = request + connection.received;
+			const char *headerEnd = FindHeaderEnd(request, end);
+			if (headerEnd == NULL)
+			{
+				if (connection.received == REQUEST_CAPACITY)
+					Close(connection);
+				return;
+			}
+
+			const char *line = request;
+			while (line < headerEnd && *line != '\r')
+				line++;
+			if (StartsWith(request, headerEnd, "GET /metrics ") || StartsWith(request, headerEnd, "GET /metrics?"))
+			{
+				connection.response = exporter.AcquireResponse();
+				connection.sending = exporter.responses[connection.response].data;
+				connection.remaining = exporter.responses[connection.response].size;
+				exporter.stats.scrapes++;
+			}
+			else
+			{
+				connection.response = -1;
+				connection.sending = NOT_FOUND;
+				connection.remaining = sizeof(NOT_FOUND) - 1;
+				exporter.stats.notFound++;
+			}
+			connection.closeAfter = Contains(request, line, "http/1.0") || Contains(request, headerEnd, "\nconnection: close");
+
+			NvU32 used = (NvU32)(headerEnd - request);
+			memmove(connection.request, headerEnd, connection.received - used);
+			connection.received -= used;
+
+			Send(connection);
+			if (connection.remaining > 0)
+				exporter.stats.partialSends++;
+		}
+	}
+
+	void TelemetryExporter::Server::Send(Connection &connection)
+	{
+		int sent = send(connection.socket, connection.sending, (int)connection.remaining, 0);
+		if (sent == SOCKET_ERROR)
+		{
+			if (WSAGetLastError() != WSAEWOULDBLOCK)
+				Close(connection);
+			return;
+		}
+
+		connection.sending += sent;
+		connection.remaining -= sent;
+		if (connection.remaining > 0)
+			return;
+
+		if (connection.response >= 0)
+			exporter.ReleaseResponse(connection.response);
+		connection.response = -1;
+		if (connection.closeAfter)
+			Close(connection);
+	}
+
+	void TelemetryExporter::Server::Close(Connection &connection)
+	{
+		if (connection.response >= 0)
+			exporter.ReleaseResponse(connection.response);
+		connection.response = -1;
+		connection.remaining = 0;
+
+		closesocket(connection.socket);
+		connection.socket = INVALID_SOCKET;
+		freeSlots[freeCount++] = (NvU32)(&connection - connections);
+	}
+
+	TelemetryExporter::TelemetryExporter(const char *address, NvU16 port)
+		: address(address)
+		, port(port)
+		, gpuCount(0)
+		, served(0)
+		, server(NULL)
+		, stopping(false)
+	{
+		memset(&stats, 0, sizeof(stats));
+		for (int i = 0; i < 2; i++)
+		{
+			responses[i].data = NULL;
+			responses[i].size = 0;
+			responses[i].readers.store(0);
+		}
+	}
+
+	TelemetryExporter::~TelemetryExporter()
+	{
+		Stop();
+	}
+
+	bool TelemetryExporter::Start(NvU32 gpuCount)
+	{
+		if (server != NULL)
+			return false;
+
+		this->gpuCount = gpuCount;
+		size_t slots = (size_t)gpuCount * TELEMETRY_METRIC_COUNT * TELEMETRY_MAX_CHANNELS;
+		values.assign(slots, 0);
+		present.assign(slots, 0);
+		for (int i = 0; i < 2; i++)
+			responses[i].buffer.assign(HEADER_RESERVE + TELEMETRY_METRIC_COUNT * FAMILY_HEADER_MAX + slots * LINE_MAX + EOF_RESERVE, 0);
+
+		// Scrapes before the first sample get an empty exposition
+		memset(&stats, 0, sizeof(stats));
+		served.store(0);
+		Render();
+
+		WSADATA data;
+		if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+			return false;
+
+		server = new Server(*this);
+		sockaddr_in endpoint;
+		memset(&endpoint, 0, sizeof(endpoint));
+		endpoint.sin_family = AF_INET;
+		endpoint.sin_port = htons(port);
+		socklen_t endpointSize = sizeof(endpoint);
+		u_long nonBlocking = 1;
+
+		server->listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (server->listener == INVALID_SOCKET ||
+			inet_pton(AF_INET, address.c_str(), &endpoint.sin_addr) != 1 ||
+			bind(server->listener, (const sockaddr *)&endpoint, sizeof(endpoint)) != 0 ||
+			listen(server->listener, SOMAXCONN) != 0 ||
+			ioctlsocket(server->listener, FIONBIO, &nonBlocking) != 0 ||
+			getsockname(server->listener, (sockaddr *)&endpoint, &endpointSize) != 0)
+		{
+			if (server->listener != INVALID_SOCKET)
+				closesocket(server->listener);
+			delete server;
+			server = NULL;
+			WSACleanup();
+			return false;
+		}
+
+		port = ntohs(endpoint.sin_port);
+		stopping = false;
+		thread = std::thread(&TelemetryExporter::Run, this);
+		return true;
+	}
+
+	void TelemetryExporter::Stop()
+	{
+		if (server == NULL)
+			return;
+
+		stopping = true;
+		if (thread.joinable())
+			thread.join();
+
+		for (NvU32 i = 0; i < TELEMETRY_EXPORTER_MAX_CONNECTIONS; i++)
+		{
+			if (server->connections[i].socket != INVALID_SOCKET)
+				server->Close(server->connections[i]);
+		}
+		closesocket(server->listener);
+		delete server;
+		server = NULL;
+		WSACleanup();
+	}
+
+	void TelemetryExporter::Run()
+	{
+		while (!stopping)
+			server->Poll();
+	}
+
+	int TelemetryExporter::AcquireResponse()
+	{
+		// Rendering only ever writes the buffer not served, and checks for readers after switching; a reader that
+		// counted itself in while the buffer was switched away backs out and takes the new one
+		for (;;)
+		{
+			int response = served.load();
+			responses[response].readers++;
+			if (served.load() == response)
+				return response;
+			responses[response].readers--;
+		}
+	}
+
+	void TelemetryExporter::ReleaseResponse(int response)
+	{
+		responses[response].readers--;
+	}
+
+	void TelemetryExporter::OnSamples(const TelemetrySample *samples, NvU32 count)
+	{
+		for (NvU32 i = 0; i < count; i++)
+		{
+			const TelemetrySample &sample = samples[i];
+			if (sample.gpu >= gpuCount || sample.metric >= TELEMETRY_METRIC_COUNT || sample.channel >= TELEMETRY_MAX_CHANNELS)
+				continue;
+
+			size_t slot = ((size_t)sample.gpu * TELEMETRY_METRIC_COUNT + sample.metric) * TELEMETRY_MAX_CHANNELS + sample.channel;
+			values[slot] = sample.value;
+			present[slot] = 1;
+		}
+		Render();
+	}
+
+	void TelemetryExporter::Render()
+	{
+		int spare = 1 - served.load();
+		Response &response = responses[spare];
+		if (response.readers.load() != 0)
+		{
+			stats.skippedRenders++;
+			return;
+		}
+
+		NvU64 started = TelemetryNow();
+		char *body = &response.buffer[0] + HEADER_RESERVE;
+		TextCursor text(body, &response.buffer[0] + response.buffer.size() - EOF_RESERVE);
+		for (int metric = 0; metric < TELEMETRY_METRIC_COUNT; metric++)
+		{
+			const Family &family = FAMILIES[metric];
+			bool described = false;
+			for (NvU32 gpu = 0; gpu < gpuCount; gpu++)
+			{
+				size_t first = ((size_t)gpu * TELEMETRY_METRIC_COUNT + metric) * TELEMETRY_MAX_CHANNELS;
+				for (NvU32 channel = 0; channel < TELEMETRY_MAX_CHANNELS; channel++)
+				{
+					if (!present[first + channel])
+						continue;
+
+					// A family's samples follow its metadata, all together
+					if (!described)
+					{
+						text.Put("# TYPE ");
+						text.Put(family.name);
+						text.Put(" gauge\n");
+						if (family.unit != NULL)
+						{
+							text.Put("# UNIT ");
+							text.Put(family.name);
+							text.Put(" ");
+							text.Put(family.unit);
+							text.Put("\n");
+						}
+						text.Put("# HELP ");
+						text.Put(family.name);
+						text.Put(" ");
+						text.Put(family.help);
+						text.Put("\n");
+						described = true;
+					}
+
+					text.Put(family.name);
+					text.Put("{gpu=\"");
+					text.PutDecimal(gpu);
+					if (family.channelLabel != NULL)
+					{
+						const char *channelName = TelemetryChannelName((TelemetryMetric)metric, channel);
+						text.Put("\",");
+						text.Put(family.channelLabel);
+						text.Put("=\"");
+						if (channelName != NULL)
+							text.Put(channelName);
+						else
+							text.PutDecimal(channel);
+					}
+					text.Put("\"} ");
+					text.PutDecimal(values[first + channel] * family.scale);
+					text.Put("\n");
+				}
+			}
+		}
+
+		// Room for the terminator is kept outside the cursor
+		memcpy(text.Next(), "# EOF\n", 6);
+		size_t bodySize = text.Next() + 6 - body;
+
+		char header[HEADER_RESERVE];
+		int headerSize = snprintf(header, sizeof(header),
+			"HTTP/1.1 200 OK\r\n"
+			"Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+			"Content-Length: %u\r\n"
+			"\r\n", (NvU32)bodySize);
+		memcpy(body - headerSize, header, headerSize);
+		response.data = body - headerSize;
+		response.size = headerSize + bodySize;
+
+		served.store(spare);
+		stats.renders++;
+		stats.renderMicroseconds += TelemetryNow() - started;
+	}
+};
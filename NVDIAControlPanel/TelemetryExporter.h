@@ -0,0 +1,95 @@
+#pragma once
+
+#include "nvapi.h"
+#include "TelemetrySource.h"
+#include "TelemetrySampler.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ControlPanel
+{
+	// Scrapes served at the same time; further connections wait in the listen backlog
+	const NvU32 TELEMETRY_EXPORTER_MAX_CONNECTIONS = 1024;
+
+	// Written by the delivering thread (renders) and the server thread (scrapes); read them after Stop
+	struct TelemetryExporterStats
+	{
+		unsigned long long renders;
+		unsigned long long skippedRenders;      // the spare buffer was still being sent
+		unsigned long long renderMicroseconds;
+		unsigned long long scrapes;
+		unsigned long long notFound;
+		unsigned long long partialSends;        // responses that did not fit the socket buffer in one send
+		unsigned long long connections;
+	};
+
+	/*
+	OpenMetrics text endpoint for the latest sample of every series, at
+	GET /metrics. Every delivered batch renders the whole response, headers
+	included, into the spare one of two preallocated buffers, which then
+	becomes the one served, so a scrape is a single send of bytes that are
+	already there: nothing is formatted or allocated per scrape or per sample.
+	A buffer still being sent is never rendered into; that batch's render is
+	skipped and the next one catches up.
+
+	One thread serves every connection from a poll loop over non-blocking
+	sockets, with keep-alive.
+	*/
+	class TelemetryExporter : public TelemetrySubscriber
+	{
+	public:
+		// address is a dotted IPv4 address, 127.0.0.1 to serve this machine only; port 0 picks a free one
+		TelemetryExporter(const char *address, NvU16 port);
+		~TelemetryExporter();
+
+		// Allocates the tables and buffers for gpuCount GPUs, then listens
+		bool Start(NvU32 gpuCount);
+		void Stop();
+
+		// Renders the next response; call from one thread
+		void OnSamples(const TelemetrySample *samples, NvU32 count);
+
+		NvU16 Port() const { return port; }
+		const TelemetryExporterStats &Stats() const { return stats; }
+
+	private:
+		TelemetryExporter(const TelemetryExporter &);
+		TelemetryExporter &operator=(const TelemetryExporter &);
+
+		struct Response
+		{
+			std::vector<char> buffer;
+			const char *data;               // inside buffer: headers, then body
+			size_t size;
+			std::atomic<NvU32> readers;     // connections sending it
+		};
+
+		struct Server;                      // sockets, defined with the platform headers
+
+		void Render();
+		void Run();
+
+		// The only places a buffer's reader count changes
+		int AcquireResponse();
+		void ReleaseResponse(int response);
+
+		std::string address;
+		NvU16 port;
+		NvU32 gpuCount;
+
+		// Latest value per GPU, metric and channel
+		std::vector<NvS64> values;
+		std::vector<NvU8> present;
+
+		Response responses[2];
+		std::atomic<int> served;
+
+		Server *server;
+		std::thread thread;
+		std::atomic<bool> stopping;
+		TelemetryExporterStats stats;
+	};
+};
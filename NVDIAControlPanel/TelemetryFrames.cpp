@@ -0,0 +1,273 @@
+#include "targetver.h"
+#include "TelemetryFrames.h"
+
+#include <assert.h>
+#include <chrono>
+#include <string.h>
+#include <Windows.h>
+
+namespace ControlPanel
+{
+	namespace
+	{
+		const NvU32 POP_BATCH = 256;
+	}
+
+	TelemetryFrameSampler::TelemetryFrameSampler(TelemetrySource &source, NvU32 frameHz)
+		: source(source)
+		, periodMicroseconds(1000000 / (frameHz == 0 ? 1 : (frameHz > TELEMETRY_MAX_FRAME_HZ ? TELEMETRY_MAX_FRAME_HZ : frameHz)))
+		, pinning(false)
+		, firstCore(0)
+		, ring(1 << 16)
+		, lastError(NVAPI_OK)
+		, releasedTick(0)
+		, stopping(false)
+	{
+		memset(&stats, 0, sizeof(stats));
+	}
+
+	TelemetryFrameSampler::~TelemetryFrameSampler()
+	{
+		Stop();
+	}
+
+	void TelemetryFrameSampler::Schedule(TelemetryMetric metric, NvU32 periodMs)
+	{
+		assert(periodMicroseconds >= 1);
+
+		Scheduled entry;
+		entry.metric = metric;
+		entry.everyTicks = (NvU32)((NvU64)periodMs * 1000 / periodMicroseconds);
+		if (entry.everyTicks == 0)
+			entry.everyTicks = 1;
+		scheduled.push_back(entry);
+	}
+
+	bool TelemetryFrameSampler::Start()
+	{
+		if (coordinator.joinable())
+			return false;
+
+		memset(&stats, 0, sizeof(stats));
+		lastError = NVAPI_OK;
+		frameSamples.reserve(source.GpuCount() * scheduled.size() * TELEMETRY_MAX_CHANNELS);
+		releasedTick = 0;
+		stopping = false;
+
+		for (NvU32 gpu = 0; gpu < source.GpuCount(); gpu++)
+		{
+			Worker *worker = new Worker;
+			worker->gpu = gpu;
+			worker->completedTick.store(0);
+			worker->readStart.store(0);
+			worker->skippedTicks = 0;
+			worker->lastError = NVAPI_OK;
+			worker->thread = std::thread(&TelemetryFrameSampler::RunWorker, this, worker);
+			workers.push_back(worker);
+		}
+
+		coordinator = std::thread(&TelemetryFrameSampler::Run, this);
+		return true;
+	}
+
+	void TelemetryFrameSampler::Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		tickReleased.notify_all();
+		tickCompleted.notify_all();
+
+		if (coordinator.joinable())
+			coordinator.join();
+
+		for (size_t i = 0; i < workers.size(); i++)
+		{
+			workers[i]->thread.join();
+			stats.skippedTicks += workers[i]->skippedTicks;
+		}
+		lastError = LastError();
+
+		for (size_t i = 0; i < workers.size(); i++)
+			delete workers[i];
+		workers.clear();
+	}
+
+	NvAPI_Status TelemetryFrameSampler::LastError() const
+	{
+		for (size_t i = 0; i < workers.size(); i++)
+		{
+			if (workers[i]->lastError != NVAPI_OK)
+				return workers[i]->lastError;
+		}
+		return lastError;
+	}
+
+	void TelemetryFrameSampler::RunWorker(Worker *worker)
+	{
+		// Pinned before its first read; an affinity mask only reaches the first
+		// 64 processors, those of the thread's own processor group
+		NvU32 cores = std::thread::hardware_concurrency();
+		if (cores > sizeof(DWORD_PTR) * 8)
+			cores = sizeof(DWORD_PTR) * 8;
+		if (pinning && cores > 0)
+			SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << ((firstCore + worker->gpu) % cores));
+
+		TelemetrySample samples[TELEMETRY_MAX_CHANNELS];
+		NvU32 seen = 0;
+
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;)
+		{
+			while (!stopping && releasedTick == seen)
+				tickReleased.wait(lock);
+			if (stopping)
+				break;
+
+			NvU32 tick = releasedTick;
+			if (seen != 0 && tick > seen + 1)
+				worker->skippedTicks += tick - seen - 1;
+			seen = tick;
+			lock.unlock();
+
+			worker->readStart.store(TelemetryNow(), std::memory_order_relaxed);
+			for (size_t i = 0; i < scheduled.size(); i++)
+			{
+				if (tick % scheduled[i].everyTicks != 0)
+					continue;
+
+				NvU32 count = 0;
+				NvU64 timestamp = TelemetryNow();
+				NvAPI_Status status = source.Read(worker->gpu, scheduled[i].metric, samples, &count);
+				if (status != NVAPI_OK)
+				{
+					worker->lastError = status;
+					continue;
+				}
+
+				for (NvU32 j = 0; j < count; j++)
+				{
+					samples[j].timestamp = timestamp;
+					samples[j].gpu = (NvU16)worker->gpu;
+					samples[j].metric = (NvU8)scheduled[i].metric;
+					samples[j].tick = tick;
+					samples[j].reserved[0] = 0;
+					samples[j].reserved[1] = 0;
+				}
+				ring.Publish(samples, count);
+			}
+			worker->completedTick.store(tick, std::memory_order_release);
+
+			lock.lock();
+			tickCompleted.notify_all();
+		}
+	}
+
+	bool TelemetryFrameSampler::AllCompleted(NvU32 tick) const
+	{
+		for (size_t i = 0; i < workers.size(); i++)
+		{
+			if (workers[i]->completedTick.load(std::memory_order_acquire) != tick)
+				return false;
+		}
+		return true;
+	}
+
+	void TelemetryFrameSampler::Run()
+	{
+		NvU64 startTime = TelemetryNow();
+
+		std::unique_lock<std::mutex> lock(mutex);
+		for (NvU32 tick = 0; !stopping; )
+		{
+			NvU64 due = startTime + (NvU64)(tick + 1) * periodMicroseconds;
+			std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point(std::chrono::microseconds(due));
+			while (!stopping && TelemetryNow() < due)
+				tickReleased.wait_until(lock, deadline);
+			if (stopping)
+				break;
+
+			// A coordinator that fell behind releases only the tick due now; the ones it slept through are counted, not replayed
+			NvU32 current = (NvU32)((TelemetryNow() - startTime) / periodMicroseconds);
+			if (current > tick + 1)
+				stats.missedTicks += current - tick - 1;
+			tick = current > tick + 1 ? current : tick + 1;
+			due = startTime + (NvU64)tick * periodMicroseconds;
+
+			releasedTick = tick;
+			tickReleased.notify_all();
+
+			// A frame closes when every GPU reported or when the next tick is due
+			std::chrono::steady_clock::time_point closes(std::chrono::microseconds(due + periodMicroseconds));
+			while (!stopping && !AllCompleted(tick) && TelemetryNow() < due + periodMicroseconds)
+				tickCompleted.wait_until(lock, closes);
+			if (stopping)
+				break;
+
+			lock.unlock();
+			Deliver(tick, due);
+			lock.lock();
+		}
+	}
+
+	void TelemetryFrameSampler::Deliver(NvU32 tick, NvU64 due)
+	{
+		TelemetryFrame frame;
+		frame.tick = tick;
+		frame.gpuCount = (NvU32)workers.size();
+		frame.reportedGpus = 0;
+		frame.due = due;
+		frame.firstRead = 0;
+		frame.lastRead = 0;
+		for (size_t i = 0; i < workers.size(); i++)
+		{
+			if (workers[i]->completedTick.load(std::memory_order_acquire) != tick)
+				continue;
+
+			NvU64 readStart = workers[i]->readStart.load(std::memory_order_relaxed);
+			if (frame.reportedGpus == 0 || readStart < frame.firstRead)
+				frame.firstRead = readStart;
+			if (frame.reportedGpus == 0 || readStart > frame.lastRead)
+				frame.lastRead = readStart;
+			frame.reportedGpus++;
+		}
+
+		// Popped after the completion checks, so every reported GPU's samples are already in the ring
+		TelemetrySample popped[POP_BATCH];
+		NvU32 count;
+		while ((count = ring.Pop(popped, POP_BATCH)) > 0)
+		{
+			for (NvU32 i = 0; i < count; i++)
+			{
+				if (popped[i].tick == tick)
+					frameSamples.push_back(popped[i]);
+				else
+					stats.lateSamples++;
+			}
+		}
+		frame.samples = frameSamples.empty() ? NULL : &frameSamples[0];
+		frame.sampleCount = (NvU32)frameSamples.size();
+
+		NvU64 skew = frame.lastRead - frame.firstRead;
+		NvU64 latency = TelemetryNow() - due;
+		stats.frames++;
+		if (frame.reportedGpus < frame.gpuCount)
+			stats.incompleteFrames++;
+		stats.totalSkewMicroseconds += skew;
+		if (skew > stats.maxSkewMicroseconds)
+			stats.maxSkewMicroseconds = skew;
+		stats.totalLatencyMicroseconds += latency;
+		if (latency > stats.maxLatencyMicroseconds)
+			stats.maxLatencyMicroseconds = latency;
+
+		for (size_t i = 0; i < frameSubscribers.size(); i++)
+			frameSubscribers[i]->OnFrame(frame);
+		if (frame.sampleCount > 0)
+		{
+			for (size_t i = 0; i < subscribers.size(); i++)
+				subscribers[i]->OnSamples(frame.samples, frame.sampleCount);
+		}
+		frameSamples.clear();
+	}
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "nvapi.h"
+#include "TelemetrySource.h"
+#include "TelemetrySampler.h"
+#include "TelemetryRing.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ControlPanel
+{
+	// Fastest frame rate, a tick each microsecond; faster rates are clamped to it
+	const NvU32 TELEMETRY_MAX_FRAME_HZ = 1000000;
+
+	// Everything the GPUs returned for one tick
+	struct TelemetryFrame
+	{
+		NvU32 tick;
+		NvU32 gpuCount;
+		NvU32 reportedGpus;         // GPUs whose reads finished before the next tick was due
+		NvU64 due;                  // when the tick was released to the workers
+		NvU64 firstRead;            // earliest and latest start of a worker's reads; the difference is the skew
+		NvU64 lastRead;
+		const TelemetrySample *samples;
+		NvU32 sampleCount;
+	};
+
+	class TelemetryFrameSubscriber
+	{
+	public:
+		virtual ~TelemetryFrameSubscriber() {}
+
+		virtual void OnFrame(const TelemetryFrame &frame) = 0;
+	};
+
+	struct TelemetryFrameStats
+	{
+		unsigned long long frames;
+		unsigned long long incompleteFrames;    // some GPU missed the deadline
+		unsigned long long lateSamples;         // arrived after their frame was delivered, dropped
+		unsigned long long skippedTicks;        // ticks a worker never started because it was still busy
+		unsigned long long missedTicks;         // ticks that came and went while the coordinator was behind, never released
+		unsigned long long totalSkewMicroseconds;
+		unsigned long long maxSkewMicroseconds;
+		unsigned long long totalLatencyMicroseconds;    // due to delivery
+		unsigned long long maxLatencyMicroseconds;
+	};
+
+	/*
+	One worker thread per GPU, so a slow driver call on one board no longer
+	holds back the others. A coordinator releases a tick to every worker at
+	once at the frame rate; each worker reads its GPU's due metrics and
+	publishes them, tagged with the tick, into a shared MPSC ring. The
+	coordinator waits until every worker reported or the next tick is due,
+	then delivers the tick's samples as one frame. A worker still busy when
+	its next tick comes skips to the newest one, and so does a coordinator
+	whose subscribers held it up. Metric periods are rounded to
+	whole frames. The source must allow concurrent reads of different GPUs.
+	*/
+	class TelemetryFrameSampler
+	{
+	public:
+		TelemetryFrameSampler(TelemetrySource &source, NvU32 frameHz);
+		~TelemetryFrameSampler();
+
+		void Schedule(TelemetryMetric metric, NvU32 periodMs);     // on every GPU
+		void PinWorkers(NvU32 firstCore) { pinning = true; this->firstCore = firstCore; }  // worker i on core firstCore + i
+		void SubscribeFrames(TelemetryFrameSubscriber *subscriber) { frameSubscribers.push_back(subscriber); }
+		void Subscribe(TelemetrySubscriber *subscriber) { subscribers.push_back(subscriber); }     // each frame's samples
+
+		bool Start();
+		void Stop();
+
+		// Read after Stop
+		const TelemetryFrameStats &Stats() const { return stats; }
+		NvAPI_Status LastError() const;
+
+	private:
+		TelemetryFrameSampler(const TelemetryFrameSampler &);
+		TelemetryFrameSampler &operator=(const TelemetryFrameSampler &);
+
+		struct Scheduled
+		{
+			TelemetryMetric metric;
+			NvU32 everyTicks;
+		};
+
+		struct Worker
+		{
+			NvU32 gpu;
+			std::thread thread;
+			std::atomic<NvU32> completedTick;
+			std::atomic<NvU64> readStart;           // of completedTick
+			unsigned long long skippedTicks;
+			NvAPI_Status lastError;
+		};
+
+		void RunWorker(Worker *worker);
+		void Run();
+		bool AllCompleted(NvU32 tick) const;
+		void Deliver(NvU32 tick, NvU64 due);
+
+		TelemetrySource &source;
+		NvU64 periodMicroseconds;
+		std::vector<Scheduled> scheduled;
+		bool pinning;
+		NvU32 firstCore;
+
+		std::vector<Worker *> workers;
+		TelemetryMpscRing ring;
+		std::vector<TelemetrySample> frameSamples;
+		std::vector<TelemetryFrameSubscriber *> frameSubscribers;
+		std::vector<TelemetrySubscriber *> subscribers;
+		TelemetryFrameStats stats;
+		NvAPI_Status lastError;                 // of workers already stopped
+
+		std::thread coordinator;
+		std::mutex mutex;
+		std::condition_variable tickReleased;
+		std::condition_variable tickCompleted;
+		NvU32 releasedTick;
+		bool stopping;
+	};
+};
@@ -0,0 +1,249 @@
+#include "targetver.h"
+#include "TelemetryRing.h"
+
+#include <malloc.h>
+#include <new>
+#include <string.h>
+
+namespace ControlPanel
+{
+	namespace
+	{
+		NvU32 RoundUpToPowerOfTwo(NvU32 value)
+		{
+			NvU32 result = 2;
+			while (result < value && result < 0x80000000)
+				result <<= 1;
+			return result;
+		}
+
+		const NvU32 DRAIN_BATCH = 256;
+	}
+
+	TelemetrySpscRing::TelemetrySpscRing(NvU32 capacity)
+		: mask(RoundUpToPowerOfTwo(capacity) - 1)
+		, head(0)
+		, cachedTail(0)
+		, tail(0)
+		, cachedHead(0)
+		, dropped(0)
+	{
+		slots = (TelemetrySample *)_aligned_malloc((size_t)(mask + 1) * sizeof(TelemetrySample), CACHE_LINE_SIZE);
+		if (slots == NULL)
+			throw std::bad_alloc();
+	}
+
+	TelemetrySpscRing::~TelemetrySpscRing()
+	{
+		_aligned_free(slots);
+	}
+
+	NvU32 TelemetrySpscRing::TryPush(const TelemetrySample *samples, NvU32 count)
+	{
+		NvU64 position = tail.load(std::memory_order_relaxed);
+		NvU64 space = (NvU64)Capacity() - (position - cachedHead);
+		if (space < count)
+		{
+			cachedHead = head.load(std::memory_order_acquire);
+			space = (NvU64)Capacity() - (position - cachedHead);
+		}
+		if (count > space)
+			count = (NvU32)space;
+
+		// At most two copies: up to the end of the array, then from its start
+		NvU32 first = (NvU32)(position & mask);
+		NvU32 untilEnd = Capacity() - first;
+		NvU32 split = count < untilEnd ? count : untilEnd;
+		memcpy(slots + first, samples, split * sizeof(TelemetrySample));
+		memcpy(slots, samples + split, (count - split) * sizeof(TelemetrySample));
+
+		tail.store(position + count, std::memory_order_release);
+		return count;
+	}
+
+	NvU32 TelemetrySpscRing::Publish(const TelemetrySample *samples, NvU32 count)
+	{
+		NvU32 pushed = TryPush(samples, count);
+		if (pushed < count)
+			dropped.fetch_add(count - pushed, std::memory_order_relaxed);
+		return pushed;
+	}
+
+	NvU32 TelemetrySpscRing::Pop(TelemetrySample *samples, NvU32 capacity)
+	{
+		NvU64 position = head.load(std::memory_order_relaxed);
+		NvU64 available = cachedTail - position;
+		if (available == 0)
+		{
+			cachedTail = tail.load(std::memory_order_acquire);
+			available = cachedTail - position;
+		}
+
+		NvU32 count = available < capacity ? (NvU32)available : capacity;
+		NvU32 first = (NvU32)(position & mask);
+		NvU32 untilEnd = Capacity() - first;
+		NvU32 split = count < untilEnd ? count : untilEnd;
+		memcpy(samples, slots + first, split * sizeof(TelemetrySample));
+		memcpy(samples + split, slots, (count - split) * sizeof(TelemetrySample));
+
+		head.store(position + count, std::memory_order_release);
+		return count;
+	}
+
+	TelemetryMpscRing::TelemetryMpscRing(NvU32 capacity)
+		: mask(RoundUpToPowerOfTwo(capacity) - 1)
+		, tail(0)
+		, dropped(0)
+		, head(0)
+	{
+		slots = (Slot *)_aligned_malloc((size_t)(mask + 1) * sizeof(Slot), CACHE_LINE_SIZE);
+		if (slots == NULL)
+			throw std::bad_alloc();
+
+		for (NvU32 i = 0; i <= mask; i++)
+		{
+			new (&slots[i]) Slot;
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	TelemetryMpscRing::~TelemetryMpscRing()
+	{
+		_aligned_free(slots);
+	}
+
+	bool TelemetryMpscRing::TryPush(const TelemetrySample &sample)
+	{
+		NvU64 position = tail.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Slot &slot = slots[position & mask];
+			NvU64 sequence = slot.sequence.load(std::memory_order_acquire);
+			NvS64 difference = (NvS64)(sequence - position);
+			if (difference == 0)
+			{
+				// The slot is free for this position: claim it
+				if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					slot.sample = sample;
+					slot.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0)
+			{
+				// Still holding the sample from one lap ago: full
+				return false;
+			}
+			else
+			{
+				position = tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	NvU32 TelemetryMpscRing::Publish(const TelemetrySample *samples, NvU32 count)
+	{
+		NvU32 pushed = 0;
+		while (pushed < count && TryPush(samples[pushed]))
+			pushed++;
+
+		if (pushed < count)
+			dropped.fetch_add(count - pushed, std::memory_order_relaxed);
+		return pushed;
+	}
+
+	NvU32 TelemetryMpscRing::Pop(TelemetrySample *samples, NvU32 capacity)
+	{
+		NvU32 count = 0;
+		while (count < capacity)
+		{
+			Slot &slot = slots[head & mask];
+			if (slot.sequence.load(std::memory_order_acquire) != head + 1)
+				break;
+
+			samples[count++] = slot.sample;
+			slot.sequence.store(head + mask + 1, std::memory_order_release);
+			head++;
+		}
+		return count;
+	}
+
+	TelemetryDrain::TelemetryDrain(TelemetrySubscriber &consumer, NvU32 capacity)
+		: consumer(consumer)
+		, ring(capacity)
+		, stopping(false)
+		, parked(false)
+	{
+	}
+
+	TelemetryDrain::~TelemetryDrain()
+	{
+		Stop();
+	}
+
+	void TelemetryDrain::OnSamples(const TelemetrySample *samples, NvU32 count)
+	{
+		ring.Publish(samples, count);
+
+		// Pairs with the fence in Run: either the drain sees these samples before
+		// it waits, or this sees it parked and wakes it
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (parked.load(std::memory_order_relaxed))
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			wake.notify_one();
+		}
+	}
+
+	void TelemetryDrain::Start()
+	{
+		if (thread.joinable())
+			return;
+
+		stopping = false;
+		thread = std::thread(&TelemetryDrain::Run, this);
+	}
+
+	void TelemetryDrain::Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_one();
+
+		if (thread.joinable())
+			thread.join();
+
+		while (Deliver() > 0)
+		{
+		}
+	}
+
+	NvU32 TelemetryDrain::Deliver()
+	{
+		TelemetrySample samples[DRAIN_BATCH];
+		NvU32 count = ring.Pop(samples, DRAIN_BATCH);
+		if (count > 0)
+			consumer.OnSamples(samples, count);
+		return count;
+	}
+
+	void TelemetryDrain::Run()
+	{
+		while (!stopping)
+		{
+			if (Deliver() > 0)
+				continue;
+
+			// Nothing queued: park until OnSamples or Stop wakes this thread
+			std::unique_lock<std::mutex> lock(mutex);
+			parked.store(true, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			while (!stopping && ring.Empty())
+				wake.wait(lock);
+			parked.store(false, std::memory_order_relaxed);
+		}
+	}
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "nvapi.h"
+#include "TelemetrySource.h"
+#include "TelemetrySampler.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace ControlPanel
+{
+	const size_t CACHE_LINE_SIZE = 64;
+
+	/*
+	Bounded single-producer single-consumer queue of samples. The producer and
+	the consumer each own one index, on separate cache lines, and keep a cached
+	copy of the other one so that a push or pop touches the shared line only
+	when the cached view says the ring looks full or empty. A full ring drops
+	what does not fit and counts it; nothing ever blocks.
+	*/
+	class TelemetrySpscRing
+	{
+	public:
+		explicit TelemetrySpscRing(NvU32 capacity);     // rounded up to a power of two
+		~TelemetrySpscRing();
+
+		// Producer: as many as fit, returns how many; Publish also counts the rest as dropped
+		NvU32 TryPush(const TelemetrySample *samples, NvU32 count);
+		NvU32 Publish(const TelemetrySample *samples, NvU32 count);
+
+		// Consumer: up to capacity samples in publication order
+		NvU32 Pop(TelemetrySample *samples, NvU32 capacity);
+		bool Empty() const { return tail.load(std::memory_order_acquire) == head.load(std::memory_order_relaxed); }
+
+		NvU32 Capacity() const { return mask + 1; }
+		unsigned long long Dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+	private:
+		TelemetrySpscRing(const TelemetrySpscRing &);
+		TelemetrySpscRing &operator=(const TelemetrySpscRing &);
+
+		TelemetrySample *slots;
+		NvU32 mask;
+		char padding0[CACHE_LINE_SIZE];
+
+		// Consumer line
+		std::atomic<NvU64> head;
+		NvU64 cachedTail;
+		char padding1[CACHE_LINE_SIZE];
+
+		// Producer line
+		std::atomic<NvU64> tail;
+		NvU64 cachedHead;
+		std::atomic<unsigned long long> dropped;
+		char padding2[CACHE_LINE_SIZE];
+	};
+
+	/*
+	Bounded multi-producer single-consumer queue (Vyukov): every slot carries
+	a sequence number that tells producers and the consumer whose turn it is,
+	so producers only contend on the tail index. Each slot is a whole cache
+	line, so producers filling neighbouring slots do not share lines.
+	*/
+	class TelemetryMpscRing
+	{
+	public:
+		explicit TelemetryMpscRing(NvU32 capacity);     // rounded up to a power of two
+		~TelemetryMpscRing();
+
+		// Any thread
+		bool TryPush(const TelemetrySample &sample);
+		NvU32 Publish(const TelemetrySample *samples, NvU32 count);
+
+		// One thread only
+		NvU32 Pop(TelemetrySample *samples, NvU32 capacity);
+
+		NvU32 Capacity() const { return mask + 1; }
+		unsigned long long Dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+	private:
+		TelemetryMpscRing(const TelemetryMpscRing &);
+		TelemetryMpscRing &operator=(const TelemetryMpscRing &);
+
+		struct Slot
+		{
+			std::atomic<NvU64> sequence;
+			NvU64 padding[3];
+			TelemetrySample sample;
+		};
+		static_assert(sizeof(Slot) == CACHE_LINE_SIZE, "one slot per cache line");
+
+		Slot *slots;
+		NvU32 mask;
+		char padding0[CACHE_LINE_SIZE];
+
+		std::atomic<NvU64> tail;
+		std::atomic<unsigned long long> dropped;
+		char padding1[CACHE_LINE_SIZE];
+
+		NvU64 head;
+		char padding2[CACHE_LINE_SIZE];
+	};
+
+	/*
+	Decouples a slow consumer (console, file, exporter) from the sampler: it
+	subscribes to the sampler, publishes each tick into its own SPSC ring and
+	delivers to the wrapped subscriber from its own thread. A consumer that
+	falls behind loses samples, counted in Dropped(), instead of delaying
+	the next read. An idle drain thread sleeps until the next tick wakes it.
+	*/
+	class TelemetryDrain : public TelemetrySubscriber
+	{
+	public:
+		TelemetryDrain(TelemetrySubscriber &consumer, NvU32 capacity = 1 << 14);
+		~TelemetryDrain();
+
+		void OnSamples(const TelemetrySample *samples, NvU32 count);
+
+		void Start();
+		void Stop();        // delivers what is still queued
+
+		unsigned long long Dropped() const { return ring.Dropped(); }
+
+	private:
+		TelemetryDrain(const TelemetryDrain &);
+		TelemetryDrain &operator=(const TelemetryDrain &);
+
+		NvU32 Deliver();
+		void Run();
+
+		TelemetrySubscriber &consumer;
+		TelemetrySpscRing ring;
+		std::thread thread;
+		std::atomic<bool> stopping;
+
+		// Parking; the sampler takes the mutex only while the drain thread is parked
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::atomic<bool> parked;
+	};
+};
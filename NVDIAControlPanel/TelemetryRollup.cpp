@@ -0,0 +1,651 @@
+#include "targetver.h"
+#include "TelemetryRollup.h"
+#include "TelemetryDelta.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <Windows.h>
+
+namespace ControlPanel
+{
+	namespace
+	{
+		const char ROLLUP_MAGIC[8] = { 'N', 'V', 'C', 'P', 'R', 'L', 'P', '1' };
+		const char ROLLUP_FOOTER_MAGIC[8] = { 'N', 'V', 'C', 'P', 'R', 'L', 'E', '1' };
+
+		// 1% relative accuracy
+		const double SKETCH_GAMMA = 1.01 / 0.99;
+		const double SKETCH_LOG_GAMMA = log(SKETCH_GAMMA);
+
+		NvS32 BucketIndex(NvU64 magnitude)
+		{
+			return (NvS32)ceil(log((double)magnitude) / SKETCH_LOG_GAMMA);
+		}
+
+		// Within 1% of every magnitude that falls into the bucket
+		double BucketValue(NvS32 index)
+		{
+			return 2.0 * pow(SKETCH_GAMMA, index) / (SKETCH_GAMMA + 1.0);
+		}
+
+		struct SeriesRecordsLess
+		{
+			template <typename Records>
+			bool operator()(const Records &a, const Records &b) const { return a.series < b.series; }
+		};
+
+		// One record of a rollup block
+		bool DecodeRollup(const NvU8 *&data, const NvU8 *end, NvU64 &windowNumber, TelemetryRollup &rollup)
+		{
+			NvU64 delta, count, minimum, range, sum;
+			if (!ReadVarint(data, end, delta) || !ReadVarint(data, end, count) || !ReadVarint(data, end, minimum) ||
+				!ReadVarint(data, end, range) || !ReadVarint(data, end, sum))
+				return false;
+
+			windowNumber += delta;
+			rollup.count = count;
+			rollup.minimum = UnZigZag(minimum);
+			rollup.maximum = rollup.minimum + (NvS64)range;
+			rollup.sum = UnZigZag(sum);
+			return rollup.sketch.Decode(data, end);
+		}
+
+		NvU64 Summarize(const TelemetryRollupReader &rollups, const TelemetryStoreReader *raw, int tier,
+			NvU32 series, NvU64 from, NvU64 to, TelemetryRollup &result)
+		{
+			if (from >= to)
+				return 0;
+
+			if (tier < 0)
+			{
+				if (raw == NULL)
+					return 0;
+
+				std::vector<TelemetrySample> samples;
+				raw->Query(series, from, to, samples);
+				for (size_t i = 0; i < samples.size(); i++)
+					result.Add(samples[i].value);
+				return samples.size();
+			}
+
+			if (!rollups.HasTier((TelemetryRollupTier)tier))
+				return Summarize(rollups, raw, tier - 1, series, from, to, result);
+
+			// Whole windows of this tier, then the ragged ends one tier down
+			NvU64 window = TelemetryRollupWindow((TelemetryRollupTier)tier);
+			NvU64 first = from % window == 0 ? from : from - from % window + window;
+			NvU64 last = to - to % window;
+			if (first >= last)
+				return Summarize(rollups, raw, tier - 1, series, from, to, result);
+
+			NvU64 read = rollups.Query((TelemetryRollupTier)tier, series, first, last, result);
+			read += Summarize(rollups, raw, tier - 1, series, from, first, result);
+			read += Summarize(rollups, raw, tier - 1, series, last, to, result);
+			return read;
+		}
+	}
+
+	void TelemetrySketch::Insert(std::vector<Bucket> &buckets, NvS32 index, NvU64 count)
+	{
+		size_t low = 0;
+		size_t high = buckets.size();
+		while (low < high)
+		{
+			size_t middle = (low + high) / 2;
+			if (buckets[middle].index < index)
+				low = middle + 1;
+			else
+				high = middle;
+		}
+
+		if (low < buckets.size() && buckets[low].index == index)
+		{
+			buckets[low].count += count;
+			return;
+		}
+
+		Bucket bucket;
+		bucket.index = index;
+		bucket.count = count;
+		buckets.insert(buckets.begin() + low, bucket);
+	}
+
+	void TelemetrySketch::MergeBuckets(std::vector<Bucket> &buckets, const std::vector<Bucket> &other)
+	{
+		if (other.empty())
+			return;
+
+		std::vector<Bucket> merged;
+		merged.reserve(buckets.size() + other.size());
+		size_t i = 0;
+		size_t j = 0;
+		while (i < buckets.size() || j < other.size())
+		{
+			if (j == other.size() || (i < buckets.size() && buckets[i].index < other[j].index))
+				merged.push_back(buckets[i++]);
+			else if (i == buckets.size() || other[j].index < buckets[i].index)
+				merged.push_back(other[j++]);
+			else
+			{
+				merged.push_back(buckets[i++]);
+				merged.back().count += other[j++].count;
+			}
+		}
+		buckets.swap(merged);
+	}
+
+	void TelemetrySketch::Add(NvS64 value)
+	{
+		count++;
+		if (value > 0)
+			Insert(positive, BucketIndex((NvU64)value), 1);
+		else if (value < 0)
+			Insert(negative, BucketIndex(0 - (NvU64)value), 1);
+		else
+			zero++;
+	}
+
+	void TelemetrySketch::Merge(const TelemetrySketch &other)
+	{
+		MergeBuckets(positive, other.positive);
+		MergeBuckets(negative, other.negative);
+		zero += other.zero;
+		count += other.count;
+	}
+
+	void TelemetrySketch::Clear()
+	{
+		positive.clear();
+		negative.clear();
+		zero = 0;
+		count = 0;
+	}
+
+	double TelemetrySketch::Quantile(double q) const
+	{
+		if (count == 0)
+			return 0.0;
+
+		// Most negative first, then zero, then ascending
+		NvU64 rank = (NvU64)(q * (count - 1));
+		NvU64 seen = 0;
+		for (size_t i = negative.size(); i-- > 0;)
+		{
+			seen += negative[i].count;
+			if (seen > rank)
+				return -BucketValue(negative[i].index);
+		}
+
+		seen += zero;
+		if (seen > rank)
+			return 0.0;
+
+		for (size_t i = 0; i < positive.size(); i++)
+		{
+			seen += positive[i].count;
+			if (seen > rank)
+				return BucketValue(positive[i].index);
+		}
+		return positive.empty() ? 0.0 : BucketValue(positive.back().index);
+	}
+
+	void TelemetrySketch::Encode(std::vector<NvU8> &bytes) const
+	{
+		PutVarint(bytes, zero);
+
+		const std::vector<Bucket> *signs[] = { &positive, &negative };
+		for (int sign = 0; sign < 2; sign++)
+		{
+			const std::vector<Bucket> &buckets = *signs[sign];
+			PutVarint(bytes, buckets.size());
+
+			NvS32 previous = 0;
+			for (size_t i = 0; i < buckets.size(); i++)
+			{
+				PutVarint(bytes, ZigZag((NvS64)buckets[i].index - previous));
+				PutVarint(bytes, buckets[i].count);
+				previous = buckets[i].index;
+			}
+		}
+	}
+
+	bool TelemetrySketch::Decode(const NvU8 *&data, const NvU8 *end)
+	{
+		Clear();
+		if (!ReadVarint(data, end, zero))
+			return false;
+		count = zero;
+
+		std::vector<Bucket> *signs[] = { &positive, &negative };
+		for (int sign = 0; sign < 2; sign++)
+		{
+			// Every bucket takes at least two bytes
+			NvU64 bucketCount;
+			if (!ReadVarint(data, end, bucketCount) || bucketCount > (NvU64)(end - data) / 2)
+				return false;
+
+			std::vector<Bucket> &buckets = *signs[sign];
+			buckets.resize((size_t)bucketCount);
+			NvS64 index = 0;
+			for (size_t i = 0; i < buckets.size(); i++)
+			{
+				NvU64 delta;
+				if (!ReadVarint(data, end, delta) || !ReadVarint(data, end, buckets[i].count))
+					return false;
+
+				index += UnZigZag(delta);
+				buckets[i].index = (NvS32)index;
+				count += buckets[i].count;
+			}
+		}
+		return true;
+	}
+
+	void TelemetryRollup::Add(NvS64 value)
+	{
+		if (count == 0 || value < minimum)
+			minimum = value;
+		if (count == 0 || value > maximum)
+			maximum = value;
+		sum += value;
+		count++;
+		sketch.Add(value);
+	}
+
+	void TelemetryRollup::Merge(const TelemetryRollup &other)
+	{
+		if (other.count == 0)
+			return;
+
+		if (count == 0 || other.minimum < minimum)
+			minimum = other.minimum;
+		if (count == 0 || other.maximum > maximum)
+			maximum = other.maximum;
+		sum += other.sum;
+		count += other.count;
+		sketch.Merge(other.sketch);
+	}
+
+	void TelemetryRollup::Clear()
+	{
+		count = 0;
+		minimum = 0;
+		maximum = 0;
+		sum = 0;
+		sketch.Clear();
+	}
+
+	double TelemetryRollup::Quantile(double q) const
+	{
+		double value = sketch.Quantile(q);
+		if (value < (double)minimum)
+			return (double)minimum;
+		return value > (double)maximum ? (double)maximum : value;
+	}
+
+	NvU64 TelemetryRollupWindow(TelemetryRollupTier tier)
+	{
+		switch (tier)
+		{
+		case TELEMETRY_ROLLUP_1S: return 1000000ULL;
+		case TELEMETRY_ROLLUP_1M: return 60ULL * 1000000;
+		default: return 3600ULL * 1000000;
+		}
+	}
+
+	const char *TelemetryRollupTierName(TelemetryRollupTier tier)
+	{
+		switch (tier)
+		{
+		case TELEMETRY_ROLLUP_1S: return "1s";
+		case TELEMETRY_ROLLUP_1M: return "1m";
+		case TELEMETRY_ROLLUP_1H: return "1h";
+		default: return "unknown";
+		}
+	}
+
+	TelemetryRollupEngine::TelemetryRollupEngine()
+		: clockOffset(TelemetryWallClockOffset())
+	{
+		memset(windowCount, 0, sizeof(windowCount));
+	}
+
+	void TelemetryRollupEngine::OnSamples(const TelemetrySample *samples, NvU32 count)
+	{
+		TelemetrySample converted[256];
+		while (count > 0)
+		{
+			NvU32 batch = count < 256 ? count : 256;
+			for (NvU32 i = 0; i < batch; i++)
+			{
+				converted[i] = samples[i];
+				converted[i].timestamp = (NvU64)((NvS64)samples[i].timestamp + clockOffset);
+			}
+			Append(converted, batch);
+			samples += batch;
+			count -= batch;
+		}
+	}
+
+	void TelemetryRollupEngine::Append(const TelemetrySample *samples, NvU32 count)
+	{
+		const NvU64 SECOND = TelemetryRollupWindow(TELEMETRY_ROLLUP_1S);
+		for (NvU32 i = 0; i < count; i++)
+		{
+			const TelemetrySample &sample = samples[i];
+			NvU32 series = TelemetrySeriesKey(sample);
+			std::pair<std::unordered_map<NvU32, NvU32>::iterator, bool> entry =
+				windowsBySeries.insert(std::make_pair(series, (NvU32)windows.size()));
+			if (entry.second)
+			{
+				windows.push_back(SeriesWindows());
+				for (int tier = 0; tier < TELEMETRY_ROLLUP_TIER_COUNT; tier++)
+					windows.back().open[tier].series = series;
+			}
+
+			SeriesWindows &series_ = windows[entry.first->second];
+			TelemetryRollup &second = series_.open[TELEMETRY_ROLLUP_1S];
+			NvU64 windowStart = sample.timestamp - sample.timestamp % SECOND;
+			if (second.count > 0 && second.windowStart != windowStart)
+				Close(series_, TELEMETRY_ROLLUP_1S);
+
+			second.windowStart = windowStart;
+			second.Add(sample.value);
+		}
+	}
+
+	void TelemetryRollupEngine::Close(SeriesWindows &series, int tier)
+	{
+		TelemetryRollup &closed = series.open[tier];
+		windowCount[tier]++;
+		for (size_t i = 0; i < sinks.size(); i++)
+			sinks[i]->OnRollup((TelemetryRollupTier)tier, closed);
+
+		if (tier + 1 < TELEMETRY_ROLLUP_TIER_COUNT)
+		{
+			TelemetryRollup &parent = series.open[tier + 1];
+			NvU64 window = TelemetryRollupWindow((TelemetryRollupTier)(tier + 1));
+			NvU64 windowStart = closed.windowStart - closed.windowStart % window;
+			if (parent.count > 0 && parent.windowStart != windowStart)
+				Close(series, tier + 1);
+
+			parent.windowStart = windowStart;
+			parent.Merge(closed);
+		}
+		closed.Clear();
+	}
+
+	void TelemetryRollupEngine::Flush()
+	{
+		for (size_t i = 0; i < windows.size(); i++)
+		{
+			for (int tier = 0; tier < TELEMETRY_ROLLUP_TIER_COUNT; tier++)
+			{
+				if (windows[i].open[tier].count > 0)
+					Close(windows[i], tier);
+			}
+		}
+	}
+
+	TelemetryRollupWriter::TelemetryRollupWriter(const char *directory, TelemetryRollupTier firstTier, NvU64 segmentMicroseconds)
+		: directory(directory)
+		, firstTier(firstTier)
+		, segmentMicroseconds(segmentMicroseconds > 0 ? segmentMicroseconds : 1)
+		, failed(false)
+	{
+		for (int tier = 0; tier < TELEMETRY_ROLLUP_TIER_COUNT; tier++)
+		{
+			tiers[tier].open = false;
+			tiers[tier].segmentStart = 0;
+			tiers[tier].records = 0;
+			tiers[tier].bytes = 0;
+		}
+	}
+
+	TelemetryRollupWriter::~TelemetryRollupWriter()
+	{
+		Seal();
+	}
+
+	void TelemetryRollupWriter::OnRollup(TelemetryRollupTier tier, const TelemetryRollup &rollup)
+	{
+		if (tier < firstTier)
+			return;
+
+		Tier &current = tiers[tier];
+		if (current.open && rollup.windowStart >= current.segmentStart + segmentMicroseconds)
+			SealTier(tier);
+		if (!current.open)
+		{
+			current.open = true;
+			current.segmentStart = rollup.windowStart - rollup.windowStart % segmentMicroseconds;
+		}
+
+		std::pair<std::unordered_map<NvU32, NvU32>::iterator, bool> entry =
+			current.seriesIndex.insert(std::make_pair(rollup.series, (NvU32)current.series.size()));
+		if (entry.second)
+		{
+			current.series.push_back(SeriesRecords());
+			current.series.back().series = rollup.series;
+			current.series.back().count = 0;
+		}
+
+		SeriesRecords &records = current.series[entry.first->second];
+		NvU64 window = TelemetryRollupWindow(tier);
+		PutVarint(records.bytes, rollup.windowStart / window - (records.count > 0 ? records.lastWindow / window : 0));
+		PutVarint(records.bytes, rollup.count);
+		PutVarint(records.bytes, ZigZag(rollup.minimum));
+		PutVarint(records.bytes, (NvU64)(rollup.maximum - rollup.minimum));
+		PutVarint(records.bytes, ZigZag(rollup.sum));
+		rollup.sketch.Encode(records.bytes);
+
+		if (records.count == 0)
+			records.firstWindow = rollup.windowStart;
+		records.lastWindow = rollup.windowStart;
+		records.count++;
+	}
+
+	bool TelemetryRollupWriter::SealTier(int tier)
+	{
+		Tier &current = tiers[tier];
+		if (!current.open)
+			return true;
+		current.open = false;
+
+		// Named after the segment's span and the time it was sealed, so a recording restarted within the span adds a file
+		char fileName[96];
+		NvU64 sealedAt = (NvU64)((NvS64)TelemetryNow() + TelemetryWallClockOffset());
+		snprintf(fileName, sizeof(fileName), "%s-%016llx-%016llx.rlp", TelemetryRollupTierName((TelemetryRollupTier)tier),
+			(unsigned long long)current.segmentStart, (unsigned long long)sealedAt);
+		std::string path = directory + "\\" + fileName;
+		std::string temporary = path + ".tmp";
+
+		CreateDirectoryA(directory.c_str(), NULL);
+		FILE *file = OpenFile(temporary.c_str(), "wb");
+		bool written = file != NULL;
+		if (written)
+		{
+			std::sort(current.series.begin(), current.series.end(), SeriesRecordsLess());
+
+			BufferedWriter writer(file);
+			writer.Write(ROLLUP_MAGIC, sizeof(ROLLUP_MAGIC));
+
+			std::vector<TelemetryBlockIndex> index;
+			for (size_t i = 0; i < current.series.size(); i++)
+			{
+				const SeriesRecords &records = current.series[i];
+				TelemetryBlockIndex entry;
+				entry.series = records.series;
+				entry.count = records.count;
+				entry.firstTimestamp = records.firstWindow;
+				entry.lastTimestamp = records.lastWindow;
+				entry.offset = writer.BytesWritten();
+				entry.size = (NvU32)records.bytes.size();
+				entry.flags = 0;
+				index.push_back(entry);
+
+				writer.Write(&records.bytes[0], records.bytes.size());
+				current.records += records.count;
+			}
+
+			WriteTelemetrySegmentIndex(writer, index, ROLLUP_FOOTER_MAGIC);
+			written = writer.Flush();
+			current.bytes += writer.BytesWritten();
+			written = fclose(file) == 0 && written;
+		}
+
+		current.series.clear();
+		current.seriesIndex.clear();
+		if (written && MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+			return true;
+
+		DeleteFileA(temporary.c_str());
+		failed = true;
+		return false;
+	}
+
+	bool TelemetryRollupWriter::Seal()
+	{
+		bool sealed = true;
+		for (int tier = 0; tier < TELEMETRY_ROLLUP_TIER_COUNT; tier++)
+			sealed = SealTier(tier) && sealed;
+		return sealed;
+	}
+
+	TelemetryRollupReader::TelemetryRollupReader()
+		: corruptSegments(0)
+	{
+		memset(recordCount, 0, sizeof(recordCount));
+		memset(bytes, 0, sizeof(bytes));
+	}
+
+	TelemetryRollupReader::~TelemetryRollupReader()
+	{
+		Close();
+	}
+
+	bool TelemetryRollupReader::BlockLess(const Block &a, const Block &b)
+	{
+		if (a.index->series != b.index->series)
+			return a.index->series < b.index->series;
+		return a.index->firstTimestamp < b.index->firstTimestamp;
+	}
+
+	bool TelemetryRollupReader::Open(const char *directory)
+	{
+		Close();
+
+		std::vector<std::string> names;
+		WIN32_FIND_DATAA found;
+		HANDLE search = FindFirstFileA((std::string(directory) + "\\*.rlp").c_str(), &found);
+		if (search != INVALID_HANDLE_VALUE)
+		{
+			do
+			{
+				names.push_back(found.cFileName);
+			} while (FindNextFileA(search, &found));
+			FindClose(search);
+		}
+
+		for (size_t i = 0; i < names.size(); i++)
+		{
+			int tier = 0;
+			while (tier < TELEMETRY_ROLLUP_TIER_COUNT && names[i].compare(0, 3, std::string(TelemetryRollupTierName((TelemetryRollupTier)tier)) + "-") != 0)
+				tier++;
+
+			MappedFile *segment = new MappedFile;
+			NvU32 blockCount = 0;
+			const TelemetryBlockIndex *index = NULL;
+			if (tier < TELEMETRY_ROLLUP_TIER_COUNT && segment->Open((std::string(directory) + "\\" + names[i]).c_str()))
+				index = ValidateTelemetrySegment(*segment, ROLLUP_MAGIC, ROLLUP_FOOTER_MAGIC, &blockCount);
+			if (index == NULL)
+			{
+				delete segment;
+				corruptSegments++;
+				continue;
+			}
+
+			const NvU8 *data = (const NvU8 *)segment->Data();
+			for (NvU32 j = 0; j < blockCount; j++)
+			{
+				Block block;
+				block.index = &index[j];
+				block.data = data + index[j].offset;
+				blocks[tier].push_back(block);
+				recordCount[tier] += index[j].count;
+			}
+			bytes[tier] += segment->Size();
+			segments.push_back(segment);
+		}
+
+		for (int tier = 0; tier < TELEMETRY_ROLLUP_TIER_COUNT; tier++)
+			std::sort(blocks[tier].begin(), blocks[tier].end(), BlockLess);
+		return !segments.empty();
+	}
+
+	void TelemetryRollupReader::Close()
+	{
+		for (size_t i = 0; i < segments.size(); i++)
+			delete segments[i];
+		segments.clear();
+		for (int tier = 0; tier < TELEMETRY_ROLLUP_TIER_COUNT; tier++)
+		{
+			blocks[tier].clear();
+			recordCount[tier] = 0;
+			bytes[tier] = 0;
+		}
+		corruptSegments = 0;
+	}
+
+	NvU32 TelemetryRollupReader::Query(TelemetryRollupTier tier, NvU32 series, NvU64 from, NvU64 to, TelemetryRollup &result) const
+	{
+		// Blocks of a series cover disjoint spans, except where a recording was restarted within one
+		TelemetryBlockIndex probeIndex;
+		memset(&probeIndex, 0, sizeof(probeIndex));
+		probeIndex.series = series;
+		probeIndex.firstTimestamp = from;
+		Block probe;
+		probe.index = &probeIndex;
+		probe.data = NULL;
+
+		const std::vector<Block> &tierBlocks = blocks[tier];
+		std::vector<Block>::const_iterator block = std::lower_bound(tierBlocks.begin(), tierBlocks.end(), probe, BlockLess);
+		while (block != tierBlocks.begin() && (block - 1)->index->series == series && (block - 1)->index->lastTimestamp >= from)
+			--block;
+
+		NvU64 window = TelemetryRollupWindow(tier);
+		TelemetryRollup record;
+		NvU32 merged = 0;
+		for (; block != tierBlocks.end() && block->index->series == series && block->index->firstTimestamp < to; ++block)
+		{
+			if (block->index->lastTimestamp < from)
+				continue;
+
+			const NvU8 *data = block->data;
+			const NvU8 *end = data + block->index->size;
+			NvU64 windowNumber = 0;
+			for (NvU32 i = 0; i < block->index->count && DecodeRollup(data, end, windowNumber, record); i++)
+			{
+				NvU64 windowStart = windowNumber * window;
+				if (windowStart >= to)
+					break;
+				if (windowStart < from)
+					continue;
+
+				result.Merge(record);
+				merged++;
+			}
+		}
+		return merged;
+	}
+
+	NvU64 SummarizeTelemetry(const TelemetryRollupReader &rollups, const TelemetryStoreReader *raw,
+		NvU32 series, NvU64 from, NvU64 to, TelemetryRollup &result)
+	{
+		result.series = series;
+		result.windowStart = from;
+		return Summarize(rollups, raw, TELEMETRY_ROLLUP_TIER_COUNT - 1, series, from, to, result);
+	}
+};
@@ -0,0 +1,244 @@
+#pragma once
+
+#include "nvapi.h"
+#include "TelemetrySource.h"
+#include "TelemetrySampler.h"
+#include "TelemetryStore.h"
+#include "MappedFile.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ControlPanel
+{
+	/*
+	Mergeable quantile sketch with relative accuracy (DDSketch): a value v
+	falls into bucket ceil(log(|v|) / log(gamma)), kept apart by sign with
+	zero counted on its own. Two sketches merge by adding bucket counts, so
+	a minute's sketch is the sum of its seconds' and an answer over a month
+	is the sum of its hours', with the same error bound of about 1%.
+	*/
+	class TelemetrySketch
+	{
+	public:
+		TelemetrySketch() : zero(0), count(0) {}
+
+		void Add(NvS64 value);
+		void Merge(const TelemetrySketch &other);
+		void Clear();
+
+		// 0 <= q <= 1; 0 when empty
+		double Quantile(double q) const;
+		NvU64 Count() const { return count; }
+
+		void Encode(std::vector<NvU8> &bytes) const;
+		bool Decode(const NvU8 *&data, const NvU8 *end);
+
+	private:
+		struct Bucket
+		{
+			NvS32 index;
+			NvU64 count;
+		};
+
+		static void Insert(std::vector<Bucket> &buckets, NvS32 index, NvU64 count);
+		static void MergeBuckets(std::vector<Bucket> &buckets, const std::vector<Bucket> &other);
+
+		std::vector<Bucket> positive;   // ascending index
+		std::vector<Bucket> negative;   // ascending index of the magnitude
+		NvU64 zero;
+		NvU64 count;
+	};
+
+	// Everything one series did in one window
+	struct TelemetryRollup
+	{
+		NvU32 series;               // TelemetrySeriesKey
+		NvU64 windowStart;          // microseconds since 1970 (UTC)
+		NvU64 count;
+		NvS64 minimum;
+		NvS64 maximum;
+		NvS64 sum;
+		TelemetrySketch sketch;
+
+		TelemetryRollup() : series(0), windowStart(0), count(0), minimum(0), maximum(0), sum(0) {}
+
+		void Add(NvS64 value);
+		void Merge(const TelemetryRollup &other);
+		void Clear();
+
+		double Mean() const { return count ? (double)sum / count : 0.0; }
+		double Quantile(double q) const;    // the sketch's estimate, clamped to minimum and maximum
+	};
+
+	enum TelemetryRollupTier
+	{
+		TELEMETRY_ROLLUP_1S,
+		TELEMETRY_ROLLUP_1M,
+		TELEMETRY_ROLLUP_1H,
+		TELEMETRY_ROLLUP_TIER_COUNT
+	};
+
+	NvU64 TelemetryRollupWindow(TelemetryRollupTier tier);     // microseconds
+	const char *TelemetryRollupTierName(TelemetryRollupTier tier);
+
+	class TelemetryRollupSink
+	{
+	public:
+		virtual ~TelemetryRollupSink() {}
+
+		virtual void OnRollup(TelemetryRollupTier tier, const TelemetryRollup &rollup) = 0;
+	};
+
+	/*
+	Keeps one open window per series and tier. Samples only ever touch the
+	1 s window; when a sample lands in a later second, the closed second is
+	handed to the sinks and merged into its minute, and a closed minute into
+	its hour, so every tier is maintained incrementally at the cost of the
+	tier below. Windows are aligned to wall-clock time.
+	*/
+	class TelemetryRollupEngine : public TelemetrySubscriber
+	{
+	public:
+		TelemetryRollupEngine();
+
+		void Subscribe(TelemetryRollupSink *sink) { sinks.push_back(sink); }
+
+		// Live samples: converts TelemetryNow() timestamps to wall-clock time
+		void OnSamples(const TelemetrySample *samples, NvU32 count);
+
+		// Samples already in wall-clock time, non-decreasing per series
+		void Append(const TelemetrySample *samples, NvU32 count);
+
+		// Closes every open window, at the end of a recording
+		void Flush();
+
+		unsigned long long WindowCount(TelemetryRollupTier tier) const { return windowCount[tier]; }
+
+	private:
+		struct SeriesWindows
+		{
+			TelemetryRollup open[TELEMETRY_ROLLUP_TIER_COUNT];
+		};
+
+		void Close(SeriesWindows &windows, int tier);
+
+		std::vector<SeriesWindows> windows;
+		std::unordered_map<NvU32, NvU32> windowsBySeries;
+		std::vector<TelemetryRollupSink *> sinks;
+		NvS64 clockOffset;
+		unsigned long long windowCount[TELEMETRY_ROLLUP_TIER_COUNT];
+	};
+
+	/*
+	Rollup segment, <directory>\<tier>-<segment start>-<sealed at>.rlp (16 hex
+	digits each), next to the raw segments of a recording and laid out like them:
+
+		"NVCPRLP1"                  8-byte magic
+		one block per series, its windows oldest first:
+		  varint    window number (windowStart / window length) minus the previous one, 0 before the first
+		  varint    count
+		  varint    zigzag(minimum)
+		  varint    maximum - minimum
+		  varint    zigzag(sum)
+		  sketch    varint zero count, then per sign: varint bucket count, per bucket varint zigzag(index delta), varint count
+		TelemetryBlockIndex[]       sorted by series; timestamps are the first and last window starts
+		TelemetrySegmentFooter      magic "NVCPRLE1"
+
+	Tiers finer than firstTier are not written: at one sample a second a 1 s
+	window repeats the raw sample at many times its size.
+	*/
+	class TelemetryRollupWriter : public TelemetryRollupSink
+	{
+	public:
+		TelemetryRollupWriter(const char *directory, TelemetryRollupTier firstTier = TELEMETRY_ROLLUP_1M,
+			NvU64 segmentMicroseconds = 24ULL * 3600 * 1000000);
+		~TelemetryRollupWriter();
+
+		void OnRollup(TelemetryRollupTier tier, const TelemetryRollup &rollup);
+		bool Seal();
+
+		unsigned long long RecordCount(TelemetryRollupTier tier) const { return tiers[tier].records; }
+		unsigned long long BytesWritten(TelemetryRollupTier tier) const { return tiers[tier].bytes; }
+		bool Failed() const { return failed; }
+
+	private:
+		TelemetryRollupWriter(const TelemetryRollupWriter &);
+		TelemetryRollupWriter &operator=(const TelemetryRollupWriter &);
+
+		struct SeriesRecords
+		{
+			NvU32 series;
+			NvU32 count;
+			NvU64 firstWindow;
+			NvU64 lastWindow;
+			std::vector<NvU8> bytes;
+		};
+
+		struct Tier
+		{
+			bool open;
+			NvU64 segmentStart;
+			std::vector<SeriesRecords> series;
+			std::unordered_map<NvU32, NvU32> seriesIndex;
+			unsigned long long records;     // sealed
+			unsigned long long bytes;
+		};
+
+		bool SealTier(int tier);
+
+		std::string directory;
+		TelemetryRollupTier firstTier;
+		NvU64 segmentMicroseconds;
+		Tier tiers[TELEMETRY_ROLLUP_TIER_COUNT];
+		bool failed;
+	};
+
+	// Maps every rollup segment of a directory read-only
+	class TelemetryRollupReader
+	{
+	public:
+		TelemetryRollupReader();
+		~TelemetryRollupReader();
+
+		bool Open(const char *directory);
+		void Close();
+
+		// Merges the series' windows that start in [from, to) into result; returns how many
+		NvU32 Query(TelemetryRollupTier tier, NvU32 series, NvU64 from, NvU64 to, TelemetryRollup &result) const;
+
+		bool HasTier(TelemetryRollupTier tier) const { return !blocks[tier].empty(); }
+		size_t SegmentCount() const { return segments.size(); }
+		NvU32 CorruptSegments() const { return corruptSegments; }
+		unsigned long long RecordCount(TelemetryRollupTier tier) const { return recordCount[tier]; }
+		unsigned long long Bytes(TelemetryRollupTier tier) const { return bytes[tier]; }
+
+	private:
+		TelemetryRollupReader(const TelemetryRollupReader &);
+		TelemetryRollupReader &operator=(const TelemetryRollupReader &);
+
+		struct Block
+		{
+			const TelemetryBlockIndex *index;
+			const NvU8 *data;
+		};
+
+		static bool BlockLess(const Block &a, const Block &b);
+
+		std::vector<MappedFile *> segments;
+		std::vector<Block> blocks[TELEMETRY_ROLLUP_TIER_COUNT];
+		NvU32 corruptSegments;
+		unsigned long long recordCount[TELEMETRY_ROLLUP_TIER_COUNT];
+		unsigned long long bytes[TELEMETRY_ROLLUP_TIER_COUNT];
+	};
+
+	/*
+	Aggregates [from, to) of one series from the coarsest windows that fit
+	inside it, finer tiers towards the edges and the raw samples for what no
+	window covers (skipped when raw is NULL). Only windows already closed are
+	in the rollups. Returns how many records and samples were read.
+	*/
+	NvU64 SummarizeTelemetry(const TelemetryRollupReader &rollups, const TelemetryStoreReader *raw,
+		NvU32 series, NvU64 from, NvU64 to, TelemetryRollup &result);
+};
@@ -0,0 +1,246 @@
+#include "targetver.h"
+#include "TelemetrySampler.h"
+
+#include <chrono>
+#include <string.h>
+
+namespace ControlPanel
+{
+	NvU32 DefaultTelemetryPeriodMs(TelemetryMetric metric)
+	{
+		switch (metric)
+		{
+		case TELEMETRY_PSTATE: return 500;
+		case TELEMETRY_BASE_CLOCKS:
+		case TELEMETRY_BOOST_CLOCKS:
+		case TELEMETRY_ECC: return 10000;
+		default: return 1000;
+		}
+	}
+
+	TelemetrySampler::TelemetrySampler(TelemetrySource &source, NvU32 tickMicroseconds)
+		: source(source)
+		, tickMicroseconds(tickMicroseconds > 0 ? tickMicroseconds : 1)
+		, currentTick(0)
+		, startTime(0)
+		, wakeCount(0)
+		, lastError(NVAPI_OK)
+		, stopping(false)
+	{
+		memset(slots, 0xFF, sizeof(slots));
+		memset(stats, 0, sizeof(stats));
+	}
+
+	TelemetrySampler::~TelemetrySampler()
+	{
+		Stop();
+	}
+
+	void TelemetrySampler::Schedule(NvU32 gpu, TelemetryMetric metric, NvU32 periodMs)
+	{
+		Task task;
+		task.gpu = gpu;
+		task.metric = metric;
+		task.periodTicks = (NvU32)((NvU64)periodMs * 1000 / tickMicroseconds);
+		if (task.periodTicks == 0)
+			task.periodTicks = 1;
+		task.rate = NO_TASK;
+		task.dueTick = 0;
+		task.rounds = 0;
+		task.next = NO_TASK;
+		tasks.push_back(task);
+	}
+
+	void TelemetrySampler::ScheduleAll(TelemetryMetric metric, NvU32 periodMs)
+	{
+		for (NvU32 gpu = 0; gpu < source.GpuCount(); gpu++)
+			Schedule(gpu, metric, periodMs);
+	}
+
+	void TelemetrySampler::ScheduleAdaptive(NvU32 gpu, TelemetryMetric metric, const TelemetryAdaptiveConfig &config)
+	{
+		Schedule(gpu, metric, config.minPeriodMs);
+		tasks.back().rate = (NvU32)rates.size();
+		rates.push_back(TelemetryAdaptiveRate(config));
+	}
+
+	void TelemetrySampler::ScheduleAllAdaptive(TelemetryMetric metric, const TelemetryAdaptiveConfig &config)
+	{
+		for (NvU32 gpu = 0; gpu < source.GpuCount(); gpu++)
+			ScheduleAdaptive(gpu, metric, config);
+	}
+
+	void TelemetrySampler::Subscribe(TelemetrySubscriber *subscriber)
+	{
+		subscribers.push_back(subscriber);
+	}
+
+	bool TelemetrySampler::Start()
+	{
+		if (thread.joinable())
+			return false;
+
+		memset(slots, 0xFF, sizeof(slots));
+		memset(stats, 0, sizeof(stats));
+		wakeCount = 0;
+		lastError = NVAPI_OK;
+		currentTick = 0;
+		for (NvU32 i = 0; i < (NvU32)tasks.size(); i++)
+			Insert(i, 1);
+
+		batch.reserve(tasks.size() * TELEMETRY_MAX_CHANNELS);
+		stopping = false;
+		startTime = TelemetryNow();
+		thread = std::thread(&TelemetrySampler::Run, this);
+		return true;
+	}
+
+	void TelemetrySampler::Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+
+		if (thread.joinable())
+			thread.join();
+	}
+
+	void TelemetrySampler::Insert(NvU32 task, NvU64 dueTick)
+	{
+		NvU32 slot = (NvU32)(dueTick & (WHEEL_SLOTS - 1));
+		tasks[task].dueTick = dueTick;
+		tasks[task].rounds = (NvU32)((dueTick - currentTick - 1) / WHEEL_SLOTS);
+		tasks[task].next = slots[slot];
+		slots[slot] = task;
+	}
+
+	NvU64 TelemetrySampler::NextOccupiedTick() const
+	{
+		for (NvU64 tick = currentTick + 1; tick <= currentTick + WHEEL_SLOTS; tick++)
+		{
+			if (slots[tick & (WHEEL_SLOTS - 1)] != NO_TASK)
+				return tick;
+		}
+		return 0;
+	}
+
+	void TelemetrySampler::Advance(NvU64 targetTick)
+	{
+		while (currentTick < targetTick)
+		{
+			currentTick++;
+			NvU32 slot = (NvU32)(currentTick & (WHEEL_SLOTS - 1));
+			NvU32 task = slots[slot];
+			slots[slot] = NO_TASK;
+
+			// Tasks that are a revolution or more away stay in the slot
+			NvU32 due = NO_TASK;
+			while (task != NO_TASK)
+			{
+				NvU32 next = tasks[task].next;
+				if (tasks[task].rounds > 0)
+				{
+					tasks[task].rounds--;
+					tasks[task].next = slots[slot];
+					slots[slot] = task;
+				}
+				else
+				{
+					tasks[task].next = due;
+					due = task;
+				}
+				task = next;
+			}
+
+			while (due != NO_TASK)
+			{
+				Task &fired = tasks[due];
+				NvU32 next = fired.next;
+				Read(fired);
+
+				// Behind schedule: skip to the first period after the target instead of catching up
+				NvU64 dueTick = fired.dueTick + fired.periodTicks;
+				if (dueTick <= targetTick)
+				{
+					NvU64 skipped = (targetTick - dueTick) / fired.periodTicks + 1;
+					stats[fired.metric].missed += skipped;
+					dueTick += skipped * fired.periodTicks;
+				}
+				Insert(due, dueTick);
+				due = next;
+			}
+		}
+
+		if (!batch.empty())
+		{
+			for (size_t i = 0; i < subscribers.size(); i++)
+				subscribers[i]->OnSamples(&batch[0], (NvU32)batch.size());
+			batch.clear();
+		}
+	}
+
+	void TelemetrySampler::Read(Task &task)
+	{
+		TelemetrySample samples[TELEMETRY_MAX_CHANNELS];
+		NvU32 count = 0;
+
+		NvU64 timestamp = TelemetryNow();
+		NvAPI_Status status = source.Read(task.gpu, task.metric, samples, &count);
+
+		TelemetryMetricStats &metricStats = stats[task.metric];
+		metricStats.reads++;
+		metricStats.readMicroseconds += TelemetryNow() - timestamp;
+		if (status != NVAPI_OK)
+		{
+			metricStats.errors++;
+			lastError = status;
+			return;
+		}
+
+		metricStats.samples += count;
+		if (task.rate != NO_TASK)
+		{
+			NvU64 periodTicks = rates[task.rate].Update(samples, count, timestamp) / tickMicroseconds;
+			task.periodTicks = periodTicks > 0 ? (NvU32)periodTicks : 1;
+		}
+
+		for (NvU32 i = 0; i < count; i++)
+		{
+			samples[i].timestamp = timestamp;
+			samples[i].gpu = (NvU16)task.gpu;
+			samples[i].metric = (NvU8)task.metric;
+			samples[i].tick = (NvU32)currentTick;
+			samples[i].reserved[0] = 0;
+			samples[i].reserved[1] = 0;
+			batch.push_back(samples[i]);
+		}
+	}
+
+	void TelemetrySampler::Run()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (!stopping)
+		{
+			NvU64 dueTick = NextOccupiedTick();
+			if (dueTick == 0)
+			{
+				wake.wait(lock);
+				continue;
+			}
+
+			std::chrono::steady_clock::time_point deadline(std::chrono::microseconds(startTime + dueTick * tickMicroseconds));
+			if (wake.wait_until(lock, deadline) != std::cv_status::timeout)
+				continue;
+
+			lock.unlock();
+			wakeCount++;
+
+			NvU64 nowTick = (TelemetryNow() - startTime) / tickMicroseconds;
+			Advance(nowTick > dueTick ? nowTick : dueTick);
+
+			lock.lock();
+		}
+	}
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "nvapi.h"
+#include "TelemetrySource.h"
+#include "TelemetryAdaptive.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ControlPanel
+{
+	// Receives every sample read in one tick, on the sampler thread
+	class TelemetrySubscriber
+	{
+	public:
+		virtual ~TelemetrySubscriber() {}
+
+		virtual void OnSamples(const TelemetrySample *samples, NvU32 count) = 0;
+	};
+
+	struct TelemetryMetricStats
+	{
+		unsigned long long reads;
+		unsigned long long samples;
+		unsigned long long errors;
+		unsigned long long missed;              // periods skipped because the sampler fell behind
+		unsigned long long readMicroseconds;    // wall time inside TelemetrySource::Read
+	};
+
+	// Console defaults: temperature, fans and current clocks every second, P-state twice a second,
+	// base and boost clocks (which only change with overclocking) and ECC counters every ten seconds
+	NvU32 DefaultTelemetryPeriodMs(TelemetryMetric metric);
+
+	/*
+	One background thread reading a TelemetrySource on a hashed timer wheel.
+	Each scheduled (GPU, metric) pair is a task with its own period; the thread
+	sleeps until the next occupied wheel slot and only reads the tasks that
+	are due, so idle time costs nothing and a slow metric does not make the
+	others poll faster. A task that overruns skips the periods it missed rather
+	than firing in a burst. An adaptive task sets its next period after every
+	read from what the read returned. Schedule and Subscribe before Start.
+	*/
+	class TelemetrySampler
+	{
+	public:
+		explicit TelemetrySampler(TelemetrySource &source, NvU32 tickMicroseconds = 1000);
+		~TelemetrySampler();
+
+		void Schedule(NvU32 gpu, TelemetryMetric metric, NvU32 periodMs);
+		void ScheduleAll(TelemetryMetric metric, NvU32 periodMs);   // every GPU of the source
+		void ScheduleAdaptive(NvU32 gpu, TelemetryMetric metric, const TelemetryAdaptiveConfig &config);
+		void ScheduleAllAdaptive(TelemetryMetric metric, const TelemetryAdaptiveConfig &config);
+		void Subscribe(TelemetrySubscriber *subscriber);
+
+		bool Start();
+		void Stop();
+
+		// Read after Stop, or approximately while running
+		const TelemetryMetricStats &Stats(TelemetryMetric metric) const { return stats[metric]; }
+		unsigned long long WakeCount() const { return wakeCount; }
+		NvAPI_Status LastError() const { return lastError; }
+
+	private:
+		TelemetrySampler(const TelemetrySampler &);
+		TelemetrySampler &operator=(const TelemetrySampler &);
+
+		static const NvU32 WHEEL_SLOTS = 256;
+		static const NvU32 NO_TASK = 0xFFFFFFFF;
+
+		struct Task
+		{
+			NvU32 gpu;
+			TelemetryMetric metric;
+			NvU32 periodTicks;
+			NvU32 rate;             // index into rates, NO_TASK for a fixed period
+			NvU64 dueTick;
+			NvU32 rounds;           // wheel revolutions left before dueTick comes round
+			NvU32 next;             // next task in the same slot
+		};
+
+		void Insert(NvU32 task, NvU64 dueTick);
+		NvU64 NextOccupiedTick() const;
+		void Advance(NvU64 targetTick);
+		void Read(Task &task);
+		void Run();
+
+		TelemetrySource &source;
+		NvU64 tickMicroseconds;
+		std::vector<Task> tasks;
+		std::vector<TelemetryAdaptiveRate> rates;
+		NvU32 slots[WHEEL_SLOTS];
+		NvU64 currentTick;
+		NvU64 startTime;
+
+		std::vector<TelemetrySubscriber *> subscribers;
+		std::vector<TelemetrySample> batch;
+
+		TelemetryMetricStats stats[TELEMETRY_METRIC_COUNT];
+		unsigned long long wakeCount;
+		NvAPI_Status lastError;
+
+		std::thread thread;
+		std::mutex mutex;
+		std::condition_variable wake;
+		bool stopping;
+	};
+};
@@ -0,0 +1,280 @@
+#include "targetver.h"
+#include "TelemetrySource.h"
+#include "NvApiStats.h"
+
+#include <chrono>
+#include <string.h>
+
+namespace ControlPanel
+{
+	NvU64 TelemetryNow()
+	{
+		return (NvU64)std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	NvS64 TelemetryWallClockOffset()
+	{
+		NvS64 wallClock = (NvS64)std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+		return wallClock - (NvS64)TelemetryNow();
+	}
+
+	const char *TelemetryMetricName(TelemetryMetric metric)
+	{
+		switch (metric)
+		{
+		case TELEMETRY_TEMPERATURE: return "temperature";
+		case TELEMETRY_TACH: return "tach";
+		case TELEMETRY_CLOCKS: return "clocks";
+		case TELEMETRY_BASE_CLOCKS: return "base-clocks";
+		case TELEMETRY_BOOST_CLOCKS: return "boost-clocks";
+		case TELEMETRY_PSTATE: return "pstate";
+		case TELEMETRY_UTILIZATION: return "utilization";
+		case TELEMETRY_MEMORY: return "memory";
+		case TELEMETRY_THROTTLE: return "throttle";
+		case TELEMETRY_ECC: return "ecc";
+		default: return "unknown";
+		}
+	}
+
+	const char *TelemetryChannelName(TelemetryMetric metric, NvU32 channel)
+	{
+		switch (metric)
+		{
+		case TELEMETRY_CLOCKS:
+		case TELEMETRY_BASE_CLOCKS:
+		case TELEMETRY_BOOST_CLOCKS:
+			switch (channel)
+			{
+			case NVAPI_GPU_PUBLIC_CLOCK_GRAPHICS: return "graphics";
+			case NVAPI_GPU_PUBLIC_CLOCK_MEMORY: return "memory";
+			case NVAPI_GPU_PUBLIC_CLOCK_PROCESSOR: return "processor";
+			case NVAPI_GPU_PUBLIC_CLOCK_VIDEO: return "video";
+			default: return "other";
+			}
+
+		case TELEMETRY_UTILIZATION:
+			switch (channel)
+			{
+			case 0: return "graphics";
+			case 1: return "framebuffer";
+			case 2: return "video";
+			case 3: return "bus";
+			default: return "other";
+			}
+
+		case TELEMETRY_MEMORY:
+			return channel == 0 ? "total" : "available";
+
+		case TELEMETRY_ECC:
+			switch (channel)
+			{
+			case TELEMETRY_ECC_SINGLE_BIT: return "single-bit";
+			case TELEMETRY_ECC_DOUBLE_BIT: return "double-bit";
+			case TELEMETRY_ECC_AGGREGATE_SINGLE_BIT: return "aggregate-single-bit";
+			case TELEMETRY_ECC_AGGREGATE_DOUBLE_BIT: return "aggregate-double-bit";
+			default: return "other";
+			}
+
+		default:
+			return NULL;
+		}
+	}
+
+	bool ParseTelemetryMetric(const char *name, TelemetryMetric *metric)
+	{
+		for (int i = 0; i < TELEMETRY_METRIC_COUNT; i++)
+		{
+			if (strcmp(name, TelemetryMetricName((TelemetryMetric)i)) == 0)
+			{
+				*metric = (TelemetryMetric)i;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	NvApiTelemetrySource::NvApiTelemetrySource()
+		: gpuCount(0)
+	{
+		memset(gpuHandles, 0, sizeof(gpuHandles));
+		for (NvU32 gpu = 0; gpu < NVAPI_MAX_PHYSICAL_GPUS; gpu++)
+			eccStates[gpu] = ECC_UNKNOWN;
+	}
+
+	NvAPI_Status NvApiTelemetrySource::Open()
+	{
+		for (NvU32 gpu = 0; gpu < NVAPI_MAX_PHYSICAL_GPUS; gpu++)
+			eccStates[gpu] = ECC_UNKNOWN;
+		return NvApiCall(NVAPI_CALL_ENUM_PHYSICAL_GPUS, NvAPI_EnumPhysicalGPUs, gpuHandles, &gpuCount);
+	}
+
+	NvAPI_Status NvApiTelemetrySource::Read(NvU32 gpu, TelemetryMetric metric, TelemetrySample *samples, NvU32 *count)
+	{
+		NvAPI_Status status = NVAPI_OK;
+		*count = 0;
+
+		switch (metric)
+		{
+		case TELEMETRY_TEMPERATURE:
+		{
+			NV_GPU_THERMAL_SETTINGS thermalSettings;
+			memset(&thermalSettings, 0, sizeof(NV_GPU_THERMAL_SETTINGS));
+			thermalSettings.version = NV_GPU_THERMAL_SETTINGS_VER;
+
+			status = NvApiCall(NVAPI_CALL_GPU_GET_THERMAL_SETTINGS, NvAPI_GPU_GetThermalSettings, gpuHandles[gpu], NVAPI_THERMAL_TARGET_ALL, &thermalSettings);
+			for (NvU32 i = 0; status == NVAPI_OK && i < thermalSettings.count && i < NVAPI_MAX_THERMAL_SENSORS_PER_GPU; i++)
+			{
+				samples[*count].channel = (NvU8)i;
+				samples[*count].value = thermalSettings.sensor[i].currentTemp;
+				(*count)++;
+			}
+			break;
+		}
+
+		case TELEMETRY_TACH:
+		{
+			NvU32 rpm = 0;
+			status = NvApiCall(NVAPI_CALL_GPU_GET_TACH_READING, NvAPI_GPU_GetTachReading, gpuHandles[gpu], &rpm);
+			if (status == NVAPI_OK)
+			{
+				samples[0].channel = 0;
+				samples[0].value = rpm;
+				*count = 1;
+			}
+			break;
+		}
+
+		case TELEMETRY_CLOCKS:
+		case TELEMETRY_BASE_CLOCKS:
+		case TELEMETRY_BOOST_CLOCKS:
+		{
+			NV_GPU_CLOCK_FREQUENCIES clocks;
+			memset(&clocks, 0, sizeof(NV_GPU_CLOCK_FREQUENCIES));
+			clocks.version = NV_GPU_CLOCK_FREQUENCIES_VER;
+			clocks.ClockType = metric == TELEMETRY_BASE_CLOCKS ? NV_GPU_CLOCK_FREQUENCIES_BASE_CLOCK :
+				(metric == TELEMETRY_BOOST_CLOCKS ? NV_GPU_CLOCK_FREQUENCIES_BOOST_CLOCK : NV_GPU_CLOCK_FREQUENCIES_CURRENT_FREQ);
+
+			status = NvApiCall(NVAPI_CALL_GPU_GET_ALL_CLOCK_FREQUENCIES, NvAPI_GPU_GetAllClockFrequencies, gpuHandles[gpu], &clocks);
+			for (NvU32 i = 0; status == NVAPI_OK && i < NVAPI_MAX_GPU_PUBLIC_CLOCKS; i++)
+			{
+				if (!clocks.domain[i].bIsPresent)
+					continue;
+
+				samples[*count].channel = (NvU8)i;
+				samples[*count].value = clocks.domain[i].frequency;
+				(*count)++;
+			}
+			break;
+		}
+
+		case TELEMETRY_PSTATE:
+		{
+			NV_GPU_PERF_PSTATE_ID currentPState;
+			status = NvApiCall(NVAPI_CALL_GPU_GET_CURRENT_PSTATE, NvAPI_GPU_GetCurrentPstate, gpuHandles[gpu], &currentPState);
+			if (status == NVAPI_OK)
+			{
+				samples[0].channel = 0;
+				samples[0].value = currentPState;
+				*count = 1;
+			}
+			break;
+		}
+
+		case TELEMETRY_UTILIZATION:
+		{
+			NV_GPU_DYNAMIC_PSTATES_INFO_EX dynamicPStates;
+			memset(&dynamicPStates, 0, sizeof(NV_GPU_DYNAMIC_PSTATES_INFO_EX));
+			dynamicPStates.version = NV_GPU_DYNAMIC_PSTATES_INFO_EX_VER;
+
+			status = NvApiCall(NVAPI_CALL_GPU_GET_DYNAMIC_PSTATES_INFO_EX, NvAPI_GPU_GetDynamicPstatesInfoEx, gpuHandles[gpu], &dynamicPStates);
+			for (NvU32 i = 0; status == NVAPI_OK && i < NVAPI_MAX_GPU_UTILIZATIONS; i++)
+			{
+				if (!dynamicPStates.utilization[i].bIsPresent)
+					continue;
+
+				samples[*count].channel = (NvU8)i;
+				samples[*count].value = dynamicPStates.utilization[i].percentage;
+				(*count)++;
+			}
+			break;
+		}
+
+		case TELEMETRY_MEMORY:
+		{
+			NV_DISPLAY_DRIVER_MEMORY_INFO memoryInfo;
+			memset(&memoryInfo, 0, sizeof(NV_DISPLAY_DRIVER_MEMORY_INFO));
+			memoryInfo.version = NV_DISPLAY_DRIVER_MEMORY_INFO_VER;
+
+			status = NvApiCall(NVAPI_CALL_GPU_GET_MEMORY_INFO, NvAPI_GPU_GetMemoryInfo, gpuHandles[gpu], &memoryInfo);
+			if (status == NVAPI_OK)
+			{
+				samples[0].channel = 0;
+				samples[0].value = memoryInfo.dedicatedVideoMemory;
+				samples[1].channel = 1;
+				samples[1].value = memoryInfo.curAvailableDedicatedVideoMemory;
+				*count = 2;
+			}
+			break;
+		}
+
+		case TELEMETRY_THROTTLE:
+		{
+			NvU32 reasons = NV_GPU_PERF_DECREASE_NONE;
+			status = NvApiCall(NVAPI_CALL_GPU_GET_PERF_DECREASE_INFO, NvAPI_GPU_GetPerfDecreaseInfo, gpuHandles[gpu], &reasons);
+			if (status == NVAPI_OK)
+			{
+				samples[0].channel = 0;
+				samples[0].value = reasons;
+				*count = 1;
+			}
+			break;
+		}
+
+		case TELEMETRY_ECC:
+		{
+			// Whether ECC is on only changes with a reboot, so it is asked once; without it there is nothing to read
+			if (eccStates[gpu] == ECC_UNKNOWN)
+			{
+				NV_GPU_ECC_STATUS_INFO eccStatus;
+				memset(&eccStatus, 0, sizeof(NV_GPU_ECC_STATUS_INFO));
+				eccStatus.version = NV_GPU_ECC_STATUS_INFO_VER;
+
+				status = NvApiCall(NVAPI_CALL_GPU_GET_ECC_STATUS_INFO, NvAPI_GPU_GetECCStatusInfo, gpuHandles[gpu], &eccStatus);
+				if (status == NVAPI_OK || status == NVAPI_NOT_SUPPORTED)
+					eccStates[gpu] = status == NVAPI_OK && eccStatus.isSupported && eccStatus.isEnabled ? ECC_ENABLED : ECC_OFF;
+				if (status == NVAPI_NOT_SUPPORTED)
+					status = NVAPI_OK;
+			}
+			if (eccStates[gpu] != ECC_ENABLED)
+				break;
+
+			NV_GPU_ECC_ERROR_INFO eccErrors;
+			memset(&eccErrors, 0, sizeof(NV_GPU_ECC_ERROR_INFO));
+			eccErrors.version = NV_GPU_ECC_ERROR_INFO_VER;
+
+			status = NvApiCall(NVAPI_CALL_GPU_GET_ECC_ERROR_INFO, NvAPI_GPU_GetECCErrorInfo, gpuHandles[gpu], &eccErrors);
+			if (status == NVAPI_OK)
+			{
+				samples[0].channel = TELEMETRY_ECC_SINGLE_BIT;
+				samples[0].value = (NvS64)eccErrors.current.singleBitErrors;
+				samples[1].channel = TELEMETRY_ECC_DOUBLE_BIT;
+				samples[1].value = (NvS64)eccErrors.current.doubleBitErrors;
+				samples[2].channel = TELEMETRY_ECC_AGGREGATE_SINGLE_BIT;
+				samples[2].value = (NvS64)eccErrors.aggregate.singleBitErrors;
+				samples[3].channel = TELEMETRY_ECC_AGGREGATE_DOUBLE_BIT;
+				samples[3].value = (NvS64)eccErrors.aggregate.doubleBitErrors;
+				*count = TELEMETRY_ECC_COUNTERS;
+			}
+			break;
+		}
+
+		default:
+			status = NVAPI_INVALID_ARGUMENT;
+			break;
+		}
+
+		return status;
+	}
+};
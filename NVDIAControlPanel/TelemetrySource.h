@@ -0,0 +1,98 @@
+#pragma once
+
+#include "nvapi.h"
+
+namespace ControlPanel
+{
+	enum TelemetryMetric
+	{
+		TELEMETRY_TEMPERATURE,      // degrees Celsius, channel = thermal sensor
+		TELEMETRY_TACH,             // fan RPM, channel 0
+		TELEMETRY_CLOCKS,           // current kHz, channel = NV_GPU_PUBLIC_CLOCK_ID of each present domain
+		TELEMETRY_BASE_CLOCKS,      // base kHz, as TELEMETRY_CLOCKS
+		TELEMETRY_BOOST_CLOCKS,     // boost kHz, as TELEMETRY_CLOCKS
+		TELEMETRY_PSTATE,           // NV_GPU_PERF_PSTATE_ID, channel 0
+		TELEMETRY_UTILIZATION,      // percent busy over the last second, channel = utilization domain (graphics, framebuffer, video, bus)
+		TELEMETRY_MEMORY,           // KB of dedicated video memory, channel 0 total, channel 1 currently available
+		TELEMETRY_THROTTLE,         // NVAPI_GPU_PERF_DECREASE reasons the GPU is slowed down for, as a bitmask, channel 0
+		TELEMETRY_ECC,              // ECC error counts, channel = TelemetryEccCounter; none from a GPU without ECC enabled
+		TELEMETRY_METRIC_COUNT
+	};
+
+	// Channels of TELEMETRY_ECC
+	enum TelemetryEccCounter
+	{
+		TELEMETRY_ECC_SINGLE_BIT,               // since boot
+		TELEMETRY_ECC_DOUBLE_BIT,
+		TELEMETRY_ECC_AGGREGATE_SINGLE_BIT,     // since the counters were last reset
+		TELEMETRY_ECC_AGGREGATE_DOUBLE_BIT,
+		TELEMETRY_ECC_COUNTERS
+	};
+
+	// Most samples one read can produce (one per clock domain)
+	const NvU32 TELEMETRY_MAX_CHANNELS = NVAPI_MAX_GPU_PUBLIC_CLOCKS;
+
+	// 32 bytes, so two records share a cache line and none straddles one
+	struct TelemetrySample
+	{
+		NvU64 timestamp;            // microseconds, TelemetryNow()
+		NvS64 value;
+		NvU16 gpu;
+		NvU8 metric;                // TelemetryMetric
+		NvU8 channel;
+		NvU32 tick;                 // sampler tick the read was due on
+		NvU32 reserved[2];          // zero
+	};
+
+	static_assert(sizeof(TelemetrySample) == 32, "TelemetrySample is half a cache line");
+
+	// Monotonic microseconds shared by every sample
+	NvU64 TelemetryNow();
+
+	// Added to a TelemetryNow() time, gives microseconds since 1970 (UTC)
+	NvS64 TelemetryWallClockOffset();
+
+	const char *TelemetryMetricName(TelemetryMetric metric);
+
+	// What a channel of the metric stands for, or NULL when channels are only numbered
+	const char *TelemetryChannelName(TelemetryMetric metric, NvU32 channel);
+	bool ParseTelemetryMetric(const char *name, TelemetryMetric *metric);
+
+	/*
+	Where samples come from: one read is one driver call for one metric of one
+	GPU, and fills value and channel of up to TELEMETRY_MAX_CHANNELS samples.
+	Reads may come from a background thread.
+	*/
+	class TelemetrySource
+	{
+	public:
+		virtual ~TelemetrySource() {}
+
+		virtual NvU32 GpuCount() const = 0;
+		virtual NvAPI_Status Read(NvU32 gpu, TelemetryMetric metric, TelemetrySample *samples, NvU32 *count) = 0;
+	};
+
+	// The physical GPUs NVAPI enumerates
+	class NvApiTelemetrySource : public TelemetrySource
+	{
+	public:
+		NvApiTelemetrySource();
+
+		NvAPI_Status Open();
+
+		NvU32 GpuCount() const { return gpuCount; }
+		NvAPI_Status Read(NvU32 gpu, TelemetryMetric metric, TelemetrySample *samples, NvU32 *count);
+
+	private:
+		enum EccState
+		{
+			ECC_UNKNOWN,
+			ECC_ENABLED,
+			ECC_OFF                 // unsupported or disabled
+		};
+
+		NvPhysicalGpuHandle gpuHandles[NVAPI_MAX_PHYSICAL_GPUS];
+		EccState eccStates[NVAPI_MAX_PHYSICAL_GPUS];   // read on the first ECC read of each GPU
+		NvU32 gpuCount;
+	};
+};
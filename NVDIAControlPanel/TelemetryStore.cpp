@@ -0,0 +1,665 @@
+#include "targetver.h"
+#include "TelemetryStore.h"
+#include "TelemetryDelta.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <Windows.h>
+
+namespace ControlPanel
+{
+	namespace
+	{
+		const char SEGMENT_MAGIC[8] = { 'N', 'V', 'C', 'P', 'T', 'S', 'S', '1' };
+		const char FOOTER_MAGIC[8] = { 'N', 'V', 'C', 'P', 'T', 'S', 'E', '1' };
+		const char CHECKPOINT_MAGIC[8] = { 'N', 'V', 'C', 'P', 'T', 'S', 'C', '1' };
+		const char CHECKPOINT_FOOTER_MAGIC[8] = { 'N', 'V', 'C', 'P', 'T', 'C', 'E', '1' };
+		const NvU32 SEGMENT_VERSION = 1;
+
+		// Marks an open block that has not written a value header yet
+		const NvU32 NO_WINDOW = 64;
+
+		NvU32 LeadingZeros(NvU64 value)
+		{
+			NvU32 count = 0;
+			for (NvU64 bit = 1ULL << 63; bit != 0 && (value & bit) == 0; bit >>= 1)
+				count++;
+			return count;
+		}
+
+		NvU32 TrailingZeros(NvU64 value)
+		{
+			NvU32 count = 0;
+			for (NvU64 bit = 1; bit != 0 && (value & bit) == 0; bit <<= 1)
+				count++;
+			return count;
+		}
+
+		NvS64 SignExtend(NvU64 value, NvU32 bits)
+		{
+			NvU64 sign = 1ULL << (bits - 1);
+			return (NvS64)((value ^ sign) - sign);
+		}
+
+		bool IndexLess(const TelemetryBlockIndex &a, const TelemetryBlockIndex &b)
+		{
+			return a.series != b.series ? a.series < b.series : a.firstTimestamp < b.firstTimestamp;
+		}
+
+		// The index of a mapped segment or checkpoint when its magics and footer check out, otherwise NULL
+		const TelemetryBlockIndex *FindSegmentIndex(const MappedFile &segment, const char *magic, const char *footerMagic,
+			const TelemetrySegmentFooter **footer)
+		{
+			const NvU8 *data = (const NvU8 *)segment.Data();
+			size_t size = segment.Size();
+			if (size < sizeof(SEGMENT_MAGIC) + sizeof(TelemetrySegmentFooter) || memcmp(data, magic, sizeof(SEGMENT_MAGIC)) != 0)
+				return NULL;
+
+			*footer = (const TelemetrySegmentFooter *)(data + size - sizeof(TelemetrySegmentFooter));
+			if (memcmp((*footer)->magic, footerMagic, sizeof((*footer)->magic)) != 0 || (*footer)->version != SEGMENT_VERSION ||
+				(*footer)->indexOffset % 8 != 0 ||
+				(*footer)->indexOffset + (NvU64)(*footer)->blockCount * sizeof(TelemetryBlockIndex) != size - sizeof(TelemetrySegmentFooter))
+				return NULL;
+
+			return (const TelemetryBlockIndex *)(data + (*footer)->indexOffset);
+		}
+
+		class BitReader
+		{
+		public:
+			BitReader(const NvU8 *data, size_t size) : data(data), bitSize((NvU64)size * 8), position(0), overrun(false) {}
+
+			NvU64 Read(NvU32 bits)
+			{
+				NvU64 value = 0;
+				while (bits > 0)
+				{
+					if (position >= bitSize)
+					{
+						overrun = true;
+						return 0;
+					}
+
+					NvU32 available = 8 - (NvU32)(position & 7);
+					NvU32 take = bits < available ? bits : available;
+					NvU8 byte = data[position >> 3];
+					value = value << take | (NvU64)((byte >> (available - take)) & ((1u << take) - 1));
+					position += take;
+					bits -= take;
+				}
+				return value;
+			}
+
+			bool Overrun() const { return overrun; }
+
+		private:
+			const NvU8 *data;
+			NvU64 bitSize;
+			NvU64 position;
+			bool overrun;
+		};
+
+		NvU32 DecodeBlock(const TelemetryBlockIndex &index, const NvU8 *data, NvU64 from, NvU64 to, std::vector<TelemetrySample> &samples)
+		{
+			TelemetrySample sample;
+			memset(&sample, 0, sizeof(sample));
+			SetTelemetrySeries(sample, index.series);
+
+			BitReader bits(data, index.size);
+			NvU64 timestamp = index.firstTimestamp;
+			NvS64 delta = 0;
+			NvU64 value = bits.Read(64);
+			NvU32 leading = 0;
+			NvU32 trailing = 0;
+
+			static const NvU32 DOD_BITS[] = { 0, 7, 12, 20, 32, 64 };
+			NvU32 decoded = 0;
+			for (NvU32 i = 0; i < index.count; i++)
+			{
+				if (i > 0)
+				{
+					NvU32 ones = 0;
+					while (ones < 5 && bits.Read(1) != 0)
+						ones++;
+					if (ones > 0)
+						delta += SignExtend(bits.Read(DOD_BITS[ones]), DOD_BITS[ones]);
+					timestamp += delta;
+
+					if (bits.Read(1) != 0)
+					{
+						if (bits.Read(1) != 0)
+						{
+							leading = (NvU32)bits.Read(6);
+							NvU32 length = (NvU32)bits.Read(6) + 1;
+							if (leading + length > 64)
+								break;
+							trailing = 64 - leading - length;
+						}
+						value ^= bits.Read(64 - leading - trailing) << trailing;
+					}
+				}
+
+				if (bits.Overrun() || timestamp >= to)
+					break;
+				if (timestamp < from)
+					continue;
+
+				sample.timestamp = timestamp;
+				sample.value = (NvS64)value;
+				samples.push_back(sample);
+				decoded++;
+			}
+			return decoded;
+		}
+	}
+
+	void WriteTelemetrySegmentIndex(BufferedWriter &writer, std::vector<TelemetryBlockIndex> &index, const char *footerMagic)
+	{
+		// The index is read in place from the mapping, so it starts 8-byte aligned
+		static const char zeros[8] = { 0 };
+		writer.Write(zeros, (size_t)((8 - writer.BytesWritten() % 8) % 8));
+
+		std::sort(index.begin(), index.end(), IndexLess);
+		TelemetrySegmentFooter footer;
+		footer.indexOffset = writer.BytesWritten();
+		footer.blockCount = (NvU32)index.size();
+		footer.version = SEGMENT_VERSION;
+		memcpy(footer.magic, footerMagic, sizeof(footer.magic));
+		if (!index.empty())
+			writer.Write(&index[0], index.size() * sizeof(TelemetryBlockIndex));
+		writer.Write(&footer, sizeof(footer));
+	}
+
+	const TelemetryBlockIndex *ValidateTelemetrySegment(const MappedFile &segment, const char *magic, const char *footerMagic, NvU32 *blockCount)
+	{
+		const TelemetrySegmentFooter *footer;
+		const TelemetryBlockIndex *index = FindSegmentIndex(segment, magic, footerMagic, &footer);
+		if (index == NULL)
+			return NULL;
+
+		for (NvU32 i = 0; i < footer->blockCount; i++)
+		{
+			if (index[i].count == 0 || index[i].offset < sizeof(SEGMENT_MAGIC) || index[i].offset + index[i].size > footer->indexOffset)
+				return NULL;
+		}
+
+		*blockCount = footer->blockCount;
+		return index;
+	}
+
+	TelemetryStoreWriter::TelemetryStoreWriter(const char *directory, const char *name, NvU64 segmentMicroseconds)
+		: directory(directory)
+		, name(name)
+		, segmentMicroseconds(segmentMicroseconds > 0 ? segmentMicroseconds : 1)
+		, checkpointMicroseconds(0)
+		, clockOffset(TelemetryWallClockOffset())
+		, file(NULL)
+		, writer(NULL)
+		, segmentStart(0)
+		, lastCheckpoint(0)
+		, sampleCount(0)
+		, sealedBytes(0)
+		, segmentCount(0)
+		, failed(false)
+	{
+	}
+
+	TelemetryStoreWriter::~TelemetryStoreWriter()
+	{
+		Seal();
+	}
+
+	void TelemetryStoreWriter::OnSamples(const TelemetrySample *samples, NvU32 count)
+	{
+		TelemetrySample converted[256];
+		while (count > 0)
+		{
+			NvU32 batch = count < 256 ? count : 256;
+			for (NvU32 i = 0; i < batch; i++)
+			{
+				converted[i] = samples[i];
+				converted[i].timestamp = (NvU64)((NvS64)samples[i].timestamp + clockOffset);
+			}
+			Append(converted, batch);
+			samples += batch;
+			count -= batch;
+		}
+	}
+
+	void TelemetryStoreWriter::Append(const TelemetrySample *samples, NvU32 count)
+	{
+		for (NvU32 i = 0; i < count; i++)
+		{
+			const TelemetrySample &sample = samples[i];
+			if (file != NULL && sample.timestamp >= segmentStart + segmentMicroseconds)
+				Seal();
+			if (file == NULL && !StartSegment(sample.timestamp))
+			{
+				failed = true;
+				return;
+			}
+
+			NvU32 series = TelemetrySeriesKey(sample);
+			std::pair<std::unordered_map<NvU32, NvU32>::iterator, bool> entry =
+				blockBySeries.insert(std::make_pair(series, (NvU32)blocks.size()));
+			if (entry.second)
+			{
+				blocks.push_back(OpenBlock());
+				blocks.back().series = series;
+				blocks.back().count = 0;
+			}
+
+			OpenBlock &block = blocks[entry.first->second];
+			Add(block, sample);
+			if (block.count == TELEMETRY_BLOCK_SAMPLES)
+				WriteBlock(block);
+			sampleCount++;
+
+			if (checkpointMicroseconds > 0 && sample.timestamp >= lastCheckpoint + checkpointMicroseconds)
+			{
+				lastCheckpoint = sample.timestamp;
+				Checkpoint();
+			}
+		}
+	}
+
+	bool TelemetryStoreWriter::StartSegment(NvU64 timestamp)
+	{
+		// Spans are aligned, so a day's segment covers that UTC day; the name is the first sample's time
+		segmentStart = timestamp - timestamp % segmentMicroseconds;
+		lastCheckpoint = timestamp;
+
+		char fileName[64];
+		snprintf(fileName, sizeof(fileName), "-%016llx.seg", (unsigned long long)timestamp);
+		segmentPath = directory + "\\" + name + fileName;
+
+		// Fails harmlessly when the directory exists
+		CreateDirectoryA(directory.c_str(), NULL);
+		file = OpenFile((segmentPath + ".tmp").c_str(), "wb");
+		if (file == NULL)
+			return false;
+
+		writer = new BufferedWriter(file);
+		writer->Write(SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+		return true;
+	}
+
+	void TelemetryStoreWriter::PutBits(OpenBlock &block, NvU64 value, NvU32 bits)
+	{
+		while (bits > 0)
+		{
+			if (block.bitFill == 0)
+				block.bytes.push_back(0);
+
+			NvU32 available = 8 - block.bitFill;
+			NvU32 take = bits < available ? bits : available;
+			NvU8 chunk = (NvU8)((value >> (bits - take)) & ((1u << take) - 1));
+			block.bytes.back() |= (NvU8)(chunk << (available - take));
+			block.bitFill = (block.bitFill + take) & 7;
+			bits -= take;
+		}
+	}
+
+	void TelemetryStoreWriter::Add(OpenBlock &block, const TelemetrySample &sample)
+	{
+		NvU64 value = (NvU64)sample.value;
+		if (block.count == 0)
+		{
+			block.firstTimestamp = sample.timestamp;
+			block.lastTimestamp = sample.timestamp;
+			block.lastDelta = 0;
+			block.lastValue = value;
+			block.leading = NO_WINDOW;
+			block.trailing = 0;
+			block.bitFill = 0;
+			block.bytes.clear();
+			PutBits(block, value, 64);
+			block.count = 1;
+			return;
+		}
+
+		NvS64 delta = (NvS64)(sample.timestamp - block.lastTimestamp);
+		NvS64 dod = delta - block.lastDelta;
+		if (dod == 0)
+			PutBits(block, 0, 1);
+		else if (dod >= -64 && dod < 64)
+		{
+			PutBits(block, 0x2, 2);
+			PutBits(block, (NvU64)dod, 7);
+		}
+		else if (dod >= -2048 && dod < 2048)
+		{
+			PutBits(block, 0x6, 3);
+			PutBits(block, (NvU64)dod, 12);
+		}
+		else if (dod >= -(1 << 19) && dod < (1 << 19))
+		{
+			PutBits(block, 0xE, 4);
+			PutBits(block, (NvU64)dod, 20);
+		}
+		else if (dod >= -(1LL << 31) && dod < (1LL << 31))
+		{
+			PutBits(block, 0x1E, 5);
+			PutBits(block, (NvU64)dod, 32);
+		}
+		else
+		{
+			PutBits(block, 0x1F, 5);
+			PutBits(block, (NvU64)dod, 64);
+		}
+
+		NvU64 changed = value ^ block.lastValue;
+		if (changed == 0)
+			PutBits(block, 0, 1);
+		else
+		{
+			NvU32 leading = LeadingZeros(changed);
+			NvU32 trailing = TrailingZeros(changed);
+			if (leading >= block.leading && trailing >= block.trailing)
+			{
+				PutBits(block, 0x2, 2);
+				PutBits(block, changed >> block.trailing, 64 - block.leading - block.trailing);
+			}
+			else
+			{
+				NvU32 length = 64 - leading - trailing;
+				PutBits(block, 0x3, 2);
+				PutBits(block, leading, 6);
+				PutBits(block, length - 1, 6);
+				PutBits(block, changed >> trailing, length);
+				block.leading = leading;
+				block.trailing = trailing;
+			}
+		}
+
+		block.lastDelta = delta;
+		block.lastTimestamp = sample.timestamp;
+		block.lastValue = value;
+		block.count++;
+	}
+
+	void TelemetryStoreWriter::WriteBlock(OpenBlock &block)
+	{
+		TelemetryBlockIndex entry;
+		entry.series = block.series;
+		entry.count = block.count;
+		entry.firstTimestamp = block.firstTimestamp;
+		entry.lastTimestamp = block.lastTimestamp;
+		entry.offset = writer->BytesWritten();
+		entry.size = (NvU32)block.bytes.size();
+		entry.flags = 0;
+		index.push_back(entry);
+
+		writer->Write(&block.bytes[0], block.bytes.size());
+		block.count = 0;
+	}
+
+	bool TelemetryStoreWriter::Checkpoint()
+	{
+		if (file == NULL)
+			return !failed;
+
+		// The index may only point at blocks that have reached the file
+		if (!writer->Flush())
+			return false;
+
+		std::string path = segmentPath + ".open";
+		std::string temporary = path + ".tmp";
+		FILE *checkpoint = OpenFile(temporary.c_str(), "wb");
+		if (checkpoint == NULL)
+			return false;
+
+		std::vector<TelemetryBlockIndex> entries(index);
+		bool written;
+		{
+			BufferedWriter out(checkpoint);
+			out.Write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+			for (size_t i = 0; i < blocks.size(); i++)
+			{
+				const OpenBlock &block = blocks[i];
+				if (block.count == 0)
+					continue;
+
+				TelemetryBlockIndex entry;
+				entry.series = block.series;
+				entry.count = block.count;
+				entry.firstTimestamp = block.firstTimestamp;
+				entry.lastTimestamp = block.lastTimestamp;
+				entry.offset = out.BytesWritten();
+				entry.size = (NvU32)block.bytes.size();
+				entry.flags = TELEMETRY_BLOCK_IN_CHECKPOINT;
+				entries.push_back(entry);
+				out.Write(&block.bytes[0], block.bytes.size());
+			}
+			WriteTelemetrySegmentIndex(out, entries, CHECKPOINT_FOOTER_MAGIC);
+			written = out.Flush();
+		}
+		written = fclose(checkpoint) == 0 && written;
+
+		// A reader that has the previous checkpoint mapped keeps it; the next checkpoint retries a failed one
+		if (!written || !MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+		{
+			DeleteFileA(temporary.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	bool TelemetryStoreWriter::Seal()
+	{
+		if (file == NULL)
+			return !failed;
+
+		// Gone before the segment takes its name, so a reader never finds both
+		DeleteFileA((segmentPath + ".open").c_str());
+
+		for (size_t i = 0; i < blocks.size(); i++)
+		{
+			if (blocks[i].count > 0)
+				WriteBlock(blocks[i]);
+		}
+
+		WriteTelemetrySegmentIndex(*writer, index, FOOTER_MAGIC);
+
+		bool written = writer->Flush();
+		sealedBytes += writer->BytesWritten();
+		delete writer;
+		writer = NULL;
+		written = fclose(file) == 0 && written;
+		file = NULL;
+
+		std::string temporary = segmentPath + ".tmp";
+		if (written && MoveFileExA(temporary.c_str(), segmentPath.c_str(), MOVEFILE_REPLACE_EXISTING))
+			segmentCount++;
+		else
+		{
+			DeleteFileA(temporary.c_str());
+			failed = true;
+		}
+
+		index.clear();
+		blocks.clear();
+		blockBySeries.clear();
+		return !failed;
+	}
+
+	TelemetryStoreReader::TelemetryStoreReader()
+		: corruptSegments(0)
+		, sampleCount(0)
+		, bytes(0)
+		, blocksDecoded(0)
+	{
+	}
+
+	TelemetryStoreReader::~TelemetryStoreReader()
+	{
+		Close();
+	}
+
+	bool TelemetryStoreReader::BlockLess(const Block &a, const Block &b)
+	{
+		return IndexLess(*a.index, *b.index);
+	}
+
+	bool TelemetryStoreReader::Open(const char *directory, const char *name)
+	{
+		Close();
+
+		std::vector<std::string> names;
+		std::string pattern = std::string(directory) + "\\" + name + "-*.seg";
+		WIN32_FIND_DATAA found;
+		HANDLE search = FindFirstFileA(pattern.c_str(), &found);
+		if (search != INVALID_HANDLE_VALUE)
+		{
+			do
+			{
+				names.push_back(found.cFileName);
+			} while (FindNextFileA(search, &found));
+			FindClose(search);
+		}
+		std::sort(names.begin(), names.end());
+
+		for (size_t i = 0; i < names.size(); i++)
+		{
+			MappedFile *segment = new MappedFile;
+			if (!segment->Open((std::string(directory) + "\\" + names[i]).c_str()))
+			{
+				delete segment;
+				corruptSegments++;
+				continue;
+			}
+
+			NvU32 blockCount = 0;
+			const TelemetryBlockIndex *index = ValidateTelemetrySegment(*segment, SEGMENT_MAGIC, FOOTER_MAGIC, &blockCount);
+			if (index == NULL)
+			{
+				delete segment;
+				corruptSegments++;
+				continue;
+			}
+
+			const NvU8 *data = (const NvU8 *)segment->Data();
+			for (NvU32 j = 0; j < blockCount; j++)
+			{
+				Block block;
+				block.index = &index[j];
+				block.data = data + index[j].offset;
+				blocks.push_back(block);
+				sampleCount += index[j].count;
+			}
+			bytes += segment->Size();
+			segments.push_back(segment);
+		}
+
+		// Segments still being written, listed after the sealed ones: a segment sealed in between is missed rather than read twice
+		names.clear();
+		pattern = std::string(directory) + "\\" + name + "-*.seg.open";
+		search = FindFirstFileA(pattern.c_str(), &found);
+		if (search != INVALID_HANDLE_VALUE)
+		{
+			do
+			{
+				names.push_back(found.cFileName);
+			} while (FindNextFileA(search, &found));
+			FindClose(search);
+		}
+		std::sort(names.begin(), names.end());
+		for (size_t i = 0; i < names.size(); i++)
+			OpenCheckpoint(std::string(directory) + "\\" + names[i]);
+
+		std::sort(blocks.begin(), blocks.end(), BlockLess);
+		return !segments.empty() || !openFiles.empty();
+	}
+
+	bool TelemetryStoreReader::OpenCheckpoint(const std::string &path)
+	{
+		// Either may be gone already when the writer has just sealed the segment
+		MappedFile *checkpoint = new MappedFile;
+		MappedFile *segment = new MappedFile;
+		const TelemetrySegmentFooter *footer = NULL;
+		const TelemetryBlockIndex *index = NULL;
+		if (checkpoint->Open(path.c_str()) && segment->Open((path.substr(0, path.size() - 5) + ".tmp").c_str()))
+			index = FindSegmentIndex(*checkpoint, CHECKPOINT_MAGIC, CHECKPOINT_FOOTER_MAGIC, &footer);
+
+		const NvU8 *segmentData = (const NvU8 *)segment->Data();
+		bool valid = index != NULL && segment->Size() >= sizeof(SEGMENT_MAGIC) && memcmp(segmentData, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) == 0;
+		for (NvU32 i = 0; valid && i < footer->blockCount; i++)
+		{
+			NvU64 limit = index[i].flags == TELEMETRY_BLOCK_IN_CHECKPOINT ? footer->indexOffset : segment->Size();
+			valid = index[i].count > 0 && index[i].offset >= sizeof(SEGMENT_MAGIC) && index[i].offset + index[i].size <= limit;
+		}
+		if (!valid)
+		{
+			delete checkpoint;
+			delete segment;
+			return false;
+		}
+
+		const NvU8 *checkpointData = (const NvU8 *)checkpoint->Data();
+		for (NvU32 i = 0; i < footer->blockCount; i++)
+		{
+			Block block;
+			block.index = &index[i];
+			block.data = (index[i].flags == TELEMETRY_BLOCK_IN_CHECKPOINT ? checkpointData : segmentData) + index[i].offset;
+			blocks.push_back(block);
+			sampleCount += index[i].count;
+		}
+		bytes += checkpoint->Size() + segment->Size();
+		openFiles.push_back(checkpoint);
+		openFiles.push_back(segment);
+		return true;
+	}
+
+	void TelemetryStoreReader::Close()
+	{
+		for (size_t i = 0; i < segments.size(); i++)
+			delete segments[i];
+		for (size_t i = 0; i < openFiles.size(); i++)
+			delete openFiles[i];
+		segments.clear();
+		openFiles.clear();
+		blocks.clear();
+		corruptSegments = 0;
+		sampleCount = 0;
+		bytes = 0;
+		blocksDecoded = 0;
+	}
+
+	NvU32 TelemetryStoreReader::Query(NvU32 series, NvU64 from, NvU64 to, std::vector<TelemetrySample> &samples) const
+	{
+		// A series' blocks do not overlap, so only the one before the first block starting at or after from can reach into the range
+		TelemetryBlockIndex probeIndex;
+		memset(&probeIndex, 0, sizeof(probeIndex));
+		probeIndex.series = series;
+		probeIndex.firstTimestamp = from;
+		Block probe;
+		probe.index = &probeIndex;
+		probe.data = NULL;
+
+		std::vector<Block>::const_iterator block = std::lower_bound(blocks.begin(), blocks.end(), probe, BlockLess);
+		if (block != blocks.begin() && (block - 1)->index->series == series)
+			--block;
+
+		NvU32 found = 0;
+		for (; block != blocks.end() && block->index->series == series && block->index->firstTimestamp < to; ++block)
+		{
+			if (block->index->lastTimestamp < from)
+				continue;
+
+			found += DecodeBlock(*block->index, block->data, from, to, samples);
+			blocksDecoded++;
+		}
+		return found;
+	}
+
+	void TelemetryStoreReader::Series(std::vector<NvU32> &series) const
+	{
+		series.clear();
+		for (size_t i = 0; i < blocks.size(); i++)
+		{
+			if (series.empty() || series.back() != blocks[i].index->series)
+				series.push_back(blocks[i].index->series);
+		}
+	}
+};
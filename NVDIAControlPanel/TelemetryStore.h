@@ -0,0 +1,206 @@
+#pragma once
+
+#include "nvapi.h"
+#include "TelemetrySource.h"
+#include "TelemetrySampler.h"
+#include "BufferedWriter.h"
+#include "MappedFile.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ControlPanel
+{
+	/*
+	Segment file, <directory>\<name>-<first timestamp, 16 hex digits>.seg:
+
+		"NVCPTSS1"                  8-byte magic
+		blocks                      one series each, up to TELEMETRY_BLOCK_SAMPLES samples
+		TelemetryBlockIndex[]       sorted by series, then first timestamp
+		TelemetrySegmentFooter
+
+	A block is a bit stream, most significant bit first, after the first
+	sample (whose timestamp is in the index):
+
+		64 bits                     first value
+		per later sample:
+		  timestamp, delta of delta:   0 | 10 +7 bits | 110 +12 | 1110 +20 | 11110 +32 | 11111 +64, two's complement
+		  value, XOR with previous:    0 same value
+		                               10 + the XOR's meaningful bits, inside the previous leading/trailing zero window
+		                               11 + 6 bits leading zeros + 6 bits (length - 1) + length bits
+
+	Samples read on a steady period cost one timestamp bit and a steady value
+	one more. Timestamps are microseconds since 1970 (UTC).
+
+	While a segment is written it is <name>-<first timestamp>.seg.tmp, and a
+	writer with a checkpoint interval keeps <name>-<first timestamp>.seg.open
+	next to it, replaced at every checkpoint:
+
+		"NVCPTSC1"                  8-byte magic
+		blocks                      a copy of every block still open in memory
+		TelemetryBlockIndex[]       every block so far; those flagged TELEMETRY_BLOCK_IN_CHECKPOINT are above,
+		                            the others in the .tmp file
+		TelemetrySegmentFooter      magic "NVCPTCE1"
+	*/
+	const NvU32 TELEMETRY_BLOCK_SAMPLES = 1024;
+	const NvU32 TELEMETRY_BLOCK_IN_CHECKPOINT = 1;
+
+	struct TelemetryBlockIndex
+	{
+		NvU32 series;               // TelemetrySeriesKey
+		NvU32 count;
+		NvU64 firstTimestamp;
+		NvU64 lastTimestamp;
+		NvU64 offset;               // from the start of the segment
+		NvU32 size;                 // bytes
+		NvU32 flags;                // TELEMETRY_BLOCK_IN_CHECKPOINT, otherwise zero
+	};
+
+	struct TelemetrySegmentFooter
+	{
+		NvU64 indexOffset;
+		NvU32 blockCount;
+		NvU32 version;
+		char magic[8];              // "NVCPTSE1"
+	};
+
+	// Pads to 8 bytes, then writes the index, sorted by series and first timestamp, and the footer
+	void WriteTelemetrySegmentIndex(BufferedWriter &writer, std::vector<TelemetryBlockIndex> &index, const char *footerMagic);
+
+	// The block index of a mapped segment when both magics, the footer and every block check out, otherwise NULL
+	const TelemetryBlockIndex *ValidateTelemetrySegment(const MappedFile &segment, const char *magic, const char *footerMagic, NvU32 *blockCount);
+
+	// A live recording rolls hourly segments and checkpoints the open one every 10 s of samples
+	const NvU64 TELEMETRY_LIVE_SEGMENT_MICROSECONDS = 3600ULL * 1000000;
+	const NvU64 TELEMETRY_LIVE_CHECKPOINT_MICROSECONDS = 10ULL * 1000000;
+
+	/*
+	Appends samples to the current segment of a store. Every series keeps one
+	open block in memory; a block goes to the segment file when full, and the
+	file becomes visible under its final name when sealed, so readers only
+	ever map complete segments. A segment is sealed when the first sample past
+	its time span arrives, by Seal, and on destruction. With a checkpoint
+	interval, the open segment is also readable up to its latest checkpoint:
+	the writer flushes the blocks written so far and replaces the segment's
+	checkpoint with a copy of the blocks still in memory and the index of all.
+	*/
+	class TelemetryStoreWriter : public TelemetrySubscriber
+	{
+	public:
+		TelemetryStoreWriter(const char *directory, const char *name = "raw", NvU64 segmentMicroseconds = 24ULL * 3600 * 1000000);
+		~TelemetryStoreWriter();
+
+		// Live samples: converts TelemetryNow() timestamps to wall-clock time
+		void OnSamples(const TelemetrySample *samples, NvU32 count);
+
+		// Samples already in wall-clock time, non-decreasing per series
+		void Append(const TelemetrySample *samples, NvU32 count);
+
+		bool Seal();
+
+		// Zero, the default, writes no checkpoints
+		void SetCheckpointInterval(NvU64 microseconds) { checkpointMicroseconds = microseconds; }
+		bool Checkpoint();
+
+		unsigned long long SampleCount() const { return sampleCount; }
+		unsigned long long BytesWritten() const { return sealedBytes + (writer != NULL ? writer->BytesWritten() : 0); }
+		NvU32 SegmentCount() const { return segmentCount; }
+		bool Failed() const { return failed; }
+
+	private:
+		TelemetryStoreWriter(const TelemetryStoreWriter &);
+		TelemetryStoreWriter &operator=(const TelemetryStoreWriter &);
+
+		struct OpenBlock
+		{
+			NvU32 series;
+			NvU32 count;
+			NvU64 firstTimestamp;
+			NvU64 lastTimestamp;
+			NvS64 lastDelta;
+			NvU64 lastValue;
+			NvU32 leading;          // zero window of the last XOR written with its own header
+			NvU32 trailing;
+			NvU32 bitFill;          // bits used in the last byte, 0 when it is full
+			std::vector<NvU8> bytes;
+		};
+
+		bool StartSegment(NvU64 timestamp);
+		void Add(OpenBlock &block, const TelemetrySample &sample);
+		void PutBits(OpenBlock &block, NvU64 value, NvU32 bits);
+		void WriteBlock(OpenBlock &block);
+
+		std::string directory;
+		std::string name;
+		NvU64 segmentMicroseconds;
+		NvU64 checkpointMicroseconds;
+		NvS64 clockOffset;          // wall clock minus TelemetryNow()
+
+		FILE *file;
+		BufferedWriter *writer;
+		std::string segmentPath;
+		NvU64 segmentStart;
+		NvU64 lastCheckpoint;
+		std::vector<TelemetryBlockIndex> index;
+		std::vector<OpenBlock> blocks;
+		std::unordered_map<NvU32, NvU32> blockBySeries;
+
+		unsigned long long sampleCount;
+		unsigned long long sealedBytes;
+		NvU32 segmentCount;
+		bool failed;
+	};
+
+	/*
+	Maps every sealed segment of a store read-only, and every segment still
+	being written through its latest checkpoint. A range query finds the
+	series' blocks by binary search over the merged indexes and decodes only
+	the blocks that overlap the range.
+	*/
+	class TelemetryStoreReader
+	{
+	public:
+		TelemetryStoreReader();
+		~TelemetryStoreReader();
+
+		// Segments that do not validate are skipped and counted
+		bool Open(const char *directory, const char *name = "raw");
+		void Close();
+
+		// Appends the series' samples with from <= timestamp < to, oldest first; returns how many
+		NvU32 Query(NvU32 series, NvU64 from, NvU64 to, std::vector<TelemetrySample> &samples) const;
+
+		// Every series in the store, ascending
+		void Series(std::vector<NvU32> &series) const;
+
+		size_t SegmentCount() const { return segments.size() + OpenSegmentCount(); }
+		size_t OpenSegmentCount() const { return openFiles.size() / 2; }
+		size_t BlockCount() const { return blocks.size(); }
+		NvU32 CorruptSegments() const { return corruptSegments; }
+		unsigned long long SampleCount() const { return sampleCount; }
+		unsigned long long Bytes() const { return bytes; }
+		unsigned long long BlocksDecoded() const { return blocksDecoded; }
+
+	private:
+		TelemetryStoreReader(const TelemetryStoreReader &);
+		TelemetryStoreReader &operator=(const TelemetryStoreReader &);
+
+		struct Block
+		{
+			const TelemetryBlockIndex *index;
+			const NvU8 *data;
+		};
+
+		static bool BlockLess(const Block &a, const Block &b);
+		bool OpenCheckpoint(const std::string &path);
+
+		std::vector<MappedFile *> segments;
+		std::vector<MappedFile *> openFiles;    // checkpoint, then .tmp segment, of each segment being written
+		std::vector<Block> blocks;
+		NvU32 corruptSegments;
+		unsigned long long sampleCount;
+		unsigned long long bytes;
+		mutable unsigned long long blocksDecoded;
+	};
+};
@@ -0,0 +1,156 @@
+#include "targetver.h"
+#include "TelemetryThrottle.h"
+#include "TelemetryDelta.h"
+
+#include <string.h>
+
+namespace ControlPanel
+{
+	namespace
+	{
+		const char THROTTLE_MAGIC[8] = { 'N', 'V', 'C', 'P', 'T', 'H', 'R', '2' };
+	}
+
+	const char *TelemetryThrottleReasonName(NvU32 reason)
+	{
+		switch (1u << reason)
+		{
+		case NV_GPU_PERF_DECREASE_REASON_THERMAL_PROTECTION: return "thermal";
+		case NV_GPU_PERF_DECREASE_REASON_POWER_CONTROL: return "power";
+		case NV_GPU_PERF_DECREASE_REASON_AC_BATT: return "ac-battery";
+		case NV_GPU_PERF_DECREASE_REASON_API_TRIGGERED: return "api";
+		case NV_GPU_PERF_DECREASE_REASON_INSUFFICIENT_POWER: return "insufficient-power";
+		default: return "unknown";
+		}
+	}
+
+	TelemetryThrottleTracker::TelemetryThrottleTracker()
+		: reads(0)
+		, eventCount(0)
+	{
+	}
+
+	void TelemetryThrottleTracker::OnSamples(const TelemetrySample *samples, NvU32 count)
+	{
+		events.clear();
+		for (NvU32 i = 0; i < count; i++)
+		{
+			const TelemetrySample &sample = samples[i];
+			if (sample.metric != TELEMETRY_THROTTLE)
+				continue;
+
+			if (sample.gpu >= gpus.size())
+			{
+				size_t first = gpus.size();
+				gpus.resize((size_t)sample.gpu + 1);
+				for (size_t g = first; g < gpus.size(); g++)
+					memset(&gpus[g], 0, sizeof(GpuState));
+			}
+
+			reads++;
+			GpuState &gpu = gpus[sample.gpu];
+			NvU32 reasons = (NvU32)sample.value;
+			NvU32 window = gpu.seen ? (NvU32)(sample.timestamp - gpu.lastRead) : 0;
+			NvU32 changed = gpu.seen ? reasons ^ gpu.reasons : reasons;
+			if (!gpu.seen)
+				gpu.firstRead = sample.timestamp;
+			gpu.seen = true;
+			gpu.reasons = reasons;
+			gpu.lastRead = sample.timestamp;
+
+			for (NvU32 reason = 0; changed != 0; reason++, changed >>= 1)
+			{
+				if ((changed & 1) == 0)
+					continue;
+
+				TelemetryThrottleEvent event;
+				event.timestamp = sample.timestamp;
+				event.window = window;
+				event.gpu = sample.gpu;
+				event.reason = (NvU8)reason;
+				event.set = (reasons >> reason & 1) != 0;
+				events.push_back(event);
+
+				if (event.set)
+				{
+					gpu.since[reason] = sample.timestamp;
+					gpu.episodes[reason]++;
+				}
+				else
+				{
+					gpu.throttled[reason] += sample.timestamp - gpu.since[reason];
+				}
+			}
+		}
+
+		eventCount += events.size();
+		if (events.empty())
+			return;
+
+		for (size_t i = 0; i < sinks.size(); i++)
+			sinks[i]->OnThrottle(&events[0], (NvU32)events.size());
+	}
+
+	NvU64 TelemetryThrottleTracker::ObservedMicroseconds(NvU32 gpu) const
+	{
+		return gpus[gpu].seen ? gpus[gpu].lastRead - gpus[gpu].firstRead : 0;
+	}
+
+	NvU64 TelemetryThrottleTracker::ThrottledMicroseconds(NvU32 gpu, NvU32 reason) const
+	{
+		const GpuState &state = gpus[gpu];
+		NvU64 throttled = state.throttled[reason];
+		if ((state.reasons >> reason & 1) != 0)
+			throttled += state.lastRead - state.since[reason];
+		return throttled;
+	}
+
+	TelemetryThrottleWriter::TelemetryThrottleWriter(BufferedWriter &writer)
+		: writer(writer)
+		, lastTimestamp(0)
+		, eventCount(0)
+	{
+		writer.Write(THROTTLE_MAGIC, sizeof(THROTTLE_MAGIC));
+	}
+
+	void TelemetryThrottleWriter::OnThrottle(const TelemetryThrottleEvent *events, NvU32 count)
+	{
+		for (NvU32 i = 0; i < count; i++)
+		{
+			const TelemetryThrottleEvent &event = events[i];
+			// Signed: events of different GPUs need not arrive in time order
+			PutVarint(writer, ZigZag((NvS64)(event.timestamp - lastTimestamp)));
+			PutVarint(writer, event.window);
+			PutVarint(writer, (NvU64)event.gpu << 6 | (NvU64)event.reason << 1 | (event.set ? 1 : 0));
+			lastTimestamp = event.timestamp;
+		}
+		eventCount += count;
+	}
+
+	bool DecodeTelemetryThrottleEvents(const NvU8 *data, size_t size, std::vector<TelemetryThrottleEvent> &events)
+	{
+		if (size < sizeof(THROTTLE_MAGIC) || memcmp(data, THROTTLE_MAGIC, sizeof(THROTTLE_MAGIC)) != 0)
+			return false;
+
+		const NvU8 *end = data + size;
+		data += sizeof(THROTTLE_MAGIC);
+
+		NvU64 timestamp = 0;
+		while (data < end)
+		{
+			NvU64 elapsed, window, key;
+			if (!ReadVarint(data, end, elapsed) || !ReadVarint(data, end, window) || !ReadVarint(data, end, key))
+				return false;
+
+			timestamp += (NvU64)UnZigZag(elapsed);
+			TelemetryThrottleEvent event;
+			event.timestamp = timestamp;
+			event.window = (NvU32)window;
+			event.gpu = (NvU16)(key >> 6);
+			event.reason = (NvU8)(key >> 1 & 0x1F);
+			event.set = (key & 1) != 0;
+			events.push_back(event);
+		}
+		return true;
+	}
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "nvapi.h"
+#include "TelemetrySource.h"
+#include "TelemetrySampler.h"
+#include "BufferedWriter.h"
+
+#include <vector>
+
+namespace ControlPanel
+{
+	const NvU32 TELEMETRY_THROTTLE_REASONS = 32;    // bits of NVAPI_GPU_PERF_DECREASE
+
+	// "thermal", "power", "ac-battery", "api", "insufficient-power" or "unknown", by bit index
+	const char *TelemetryThrottleReasonName(NvU32 reason);
+
+	// One throttle reason of one GPU starting or stopping
+	struct TelemetryThrottleEvent
+	{
+		NvU64 timestamp;            // of the read that saw the change
+		NvU32 window;               // microseconds back to the read before, which still had the old state, 0 on the first read;
+		                            // the edge lies in between
+		NvU16 gpu;
+		NvU8 reason;                // bit index in NVAPI_GPU_PERF_DECREASE
+		bool set;                   // false when the reason cleared
+	};
+
+	class TelemetryThrottleSink
+	{
+	public:
+		virtual ~TelemetryThrottleSink() {}
+
+		virtual void OnThrottle(const TelemetryThrottleEvent *events, NvU32 count) = 0;
+	};
+
+	/*
+	Turns TELEMETRY_THROTTLE bitmasks into edges: a read whose reasons equal
+	the previous read's costs a compare and produces nothing, and each bit that
+	flipped produces one event, so a long run holds as many events as the GPU
+	changed state rather than one bitmask per read. Also attributes throttled
+	time to each reason, from the read that saw it set to the read that saw it
+	clear.
+	*/
+	class TelemetryThrottleTracker : public TelemetrySubscriber
+	{
+	public:
+		TelemetryThrottleTracker();
+
+		void Subscribe(TelemetryThrottleSink *sink) { sinks.push_back(sink); }
+		void OnSamples(const TelemetrySample *samples, NvU32 count);
+
+		NvU32 GpuCount() const { return (NvU32)gpus.size(); }
+
+		// Time from the first to the latest read of the GPU
+		NvU64 ObservedMicroseconds(NvU32 gpu) const;
+
+		// Time the reason held up to the latest read, and how many times it was set
+		NvU64 ThrottledMicroseconds(NvU32 gpu, NvU32 reason) const;
+		NvU32 Episodes(NvU32 gpu, NvU32 reason) const { return gpus[gpu].episodes[reason]; }
+
+		unsigned long long ReadCount() const { return reads; }
+		unsigned long long EventCount() const { return eventCount; }
+
+	private:
+		struct GpuState
+		{
+			bool seen;
+			NvU32 reasons;
+			NvU64 firstRead;
+			NvU64 lastRead;
+			NvU64 since[TELEMETRY_THROTTLE_REASONS];        // read that saw the reason set
+			NvU64 throttled[TELEMETRY_THROTTLE_REASONS];    // closed episodes
+			NvU32 episodes[TELEMETRY_THROTTLE_REASONS];
+		};
+
+		std::vector<GpuState> gpus;
+		std::vector<TelemetryThrottleEvent> events;
+		std::vector<TelemetryThrottleSink *> sinks;
+		unsigned long long reads;
+		unsigned long long eventCount;
+	};
+
+	/*
+	Throttle event log, binary:
+
+		"NVCPTHR2"                  8-byte magic
+		per event:
+		  varint    zigzag(microseconds since the previous event, the first: since 0)
+		  varint    window
+		  varint    gpu << 6 | reason << 1 | set
+	*/
+	class TelemetryThrottleWriter : public TelemetryThrottleSink
+	{
+	public:
+		explicit TelemetryThrottleWriter(BufferedWriter &writer);
+
+		void OnThrottle(const TelemetryThrottleEvent *events, NvU32 count);
+
+		unsigned long long EventCount() const { return eventCount; }
+
+	private:
+		BufferedWriter &writer;
+		NvU64 lastTimestamp;
+		unsigned long long eventCount;
+	};
+
+	// Rebuilds the events of a log; false when it is not one or is cut short
+	bool DecodeTelemetryThrottleEvents(const NvU8 *data, size_t size, std::vector<TelemetryThrottleEvent> &events);
+};
@@ -0,0 +1,273 @@
+#include "targetver.h"
+#include "TelemetryTrace.h"
+#include "TelemetryDelta.h"
+
+#include <chrono>
+#include <string.h>
+#include <thread>
+
+namespace ControlPanel
+{
+	namespace
+	{
+		const char TRACE_MAGIC[8] = { 'N', 'V', 'C', 'P', 'T', 'R', 'C', '1' };
+	}
+
+	TelemetryTraceWriter::TelemetryTraceWriter(BufferedWriter &writer)
+		: writer(writer)
+		, lastTimestamp(0)
+		, lastTick(0)
+		, readCount(0)
+		, sampleCount(0)
+	{
+		std::vector<NvU8> schema;
+		PutVarint(schema, ZigZag(TelemetryWallClockOffset()));
+		PutVarint(schema, TELEMETRY_METRIC_COUNT);
+		for (int metric = 0; metric < TELEMETRY_METRIC_COUNT; metric++)
+		{
+			const char *name = TelemetryMetricName((TelemetryMetric)metric);
+			size_t length = strlen(name);
+			PutVarint(schema, (NvU64)metric);
+			schema.push_back((NvU8)length);
+			schema.insert(schema.end(), name, name + length);
+		}
+
+		writer.Write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+		PutVarint(writer, schema.size());
+		writer.Write(&schema[0], schema.size());
+	}
+
+	void TelemetryTraceWriter::OnSamples(const TelemetrySample *samples, NvU32 count)
+	{
+		// Consecutive samples of one GPU and metric with the same time and tick came from one read
+		for (NvU32 first = 0; first < count; )
+		{
+			const TelemetrySample &read = samples[first];
+			NvU32 next = first + 1;
+			while (next < count && samples[next].timestamp == read.timestamp && samples[next].gpu == read.gpu &&
+				samples[next].metric == read.metric && samples[next].tick == read.tick)
+			{
+				next++;
+			}
+
+			// Frames gather the reads of every worker, so times may step back between GPUs
+			PutVarint(writer, ZigZag((NvS64)(read.timestamp - lastTimestamp)));
+			PutVarint(writer, ZigZag((NvS64)read.tick - (NvS64)lastTick));
+			PutVarint(writer, (NvU64)read.gpu << 5 | read.metric);
+			PutVarint(writer, next - first);
+			for (NvU32 i = first; i < next; i++)
+			{
+				NvS64 &previous = last[TelemetrySeriesKey(samples[i])];
+				PutVarint(writer, samples[i].channel);
+				PutVarint(writer, ZigZag(samples[i].value - previous));
+				previous = samples[i].value;
+			}
+
+			lastTimestamp = read.timestamp;
+			lastTick = read.tick;
+			readCount++;
+			sampleCount += next - first;
+			first = next;
+		}
+	}
+
+	TelemetryTraceReader::TelemetryTraceReader()
+		: begin(NULL)
+		, end(NULL)
+		, cursor(NULL)
+		, timestamp(0)
+		, tick(0)
+		, pending(false)
+		, gpuCount(0)
+		, firstTimestamp(0)
+		, lastTimestamp(0)
+		, wallClockOffset(0)
+		, sampleCount(0)
+		, skippedCount(0)
+		, truncatedBytes(0)
+	{
+		memset(metrics, UNKNOWN_METRIC, sizeof(metrics));
+	}
+
+	bool TelemetryTraceReader::Open(const NvU8 *data, size_t size)
+	{
+		if (size < sizeof(TRACE_MAGIC) || memcmp(data, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0)
+			return false;
+
+		end = data + size;
+		data += sizeof(TRACE_MAGIC);
+
+		NvU64 schemaBytes, offset, metricCount;
+		if (!ReadVarint(data, end, schemaBytes) || schemaBytes > (NvU64)(end - data))
+			return false;
+
+		// Fields a later schema adds after the metrics are skipped
+		const NvU8 *schemaEnd = data + schemaBytes;
+		if (!ReadVarint(data, schemaEnd, offset) || !ReadVarint(data, schemaEnd, metricCount))
+			return false;
+		wallClockOffset = UnZigZag(offset);
+
+		memset(metrics, UNKNOWN_METRIC, sizeof(metrics));
+		for (NvU64 i = 0; i < metricCount; i++)
+		{
+			NvU64 id;
+			if (!ReadVarint(data, schemaEnd, id) || data >= schemaEnd || *data >= (size_t)(schemaEnd - data))
+				return false;
+
+			char name[256];
+			NvU8 length = *data++;
+			memcpy(name, data, length);
+			name[length] = '\0';
+			data += length;
+
+			TelemetryMetric metric;
+			if (id < TRACE_METRIC_IDS && ParseTelemetryMetric(name, &metric))
+				metrics[id] = (NvU8)metric;
+		}
+		begin = schemaEnd;
+
+		// One pass for what the trace holds; a last read cut short, as when --trace was killed, is dropped
+		gpuCount = 0;
+		sampleCount = 0;
+		skippedCount = 0;
+		truncatedBytes = 0;
+		Rewind();
+		bool first = true;
+		for (const NvU8 *scan = begin; scan < end; )
+		{
+			bool known;
+			const NvU8 *complete = scan;
+			if (!DecodeRead(scan, read, known))
+			{
+				truncatedBytes = end - complete;
+				end = complete;
+				break;
+			}
+			if (!known || read.empty())
+			{
+				skippedCount += read.size();
+				continue;
+			}
+
+			firstTimestamp = first || timestamp < firstTimestamp ? timestamp : firstTimestamp;
+			lastTimestamp = timestamp > lastTimestamp ? timestamp : lastTimestamp;
+			first = false;
+			gpuCount = read[0].gpu >= gpuCount ? read[0].gpu + 1u : gpuCount;
+			sampleCount += read.size();
+		}
+
+		Rewind();
+		return true;
+	}
+
+	void TelemetryTraceReader::Rewind()
+	{
+		cursor = begin;
+		last.clear();
+		timestamp = 0;
+		tick = 0;
+		pending = false;
+	}
+
+	bool TelemetryTraceReader::DecodeRead(const NvU8 *&data, std::vector<TelemetrySample> &samples, bool &known)
+	{
+		NvU64 elapsed, tickDelta, key, count;
+		if (!ReadVarint(data, end, elapsed) || !ReadVarint(data, end, tickDelta) || !ReadVarint(data, end, key) || !ReadVarint(data, end, count))
+			return false;
+
+		timestamp += (NvU64)UnZigZag(elapsed);
+		tick = (NvU32)((NvS64)tick + UnZigZag(tickDelta));
+		NvU8 metric = metrics[key & 0x1F];
+		known = metric != UNKNOWN_METRIC;
+
+		samples.clear();
+		for (NvU64 i = 0; i < count; i++)
+		{
+			NvU64 channel, delta;
+			if (!ReadVarint(data, end, channel) || !ReadVarint(data, end, delta))
+				return false;
+
+			// The previous value is kept per series in the trace's own numbering
+			TelemetrySample sample;
+			memset(&sample, 0, sizeof(sample));
+			sample.timestamp = timestamp;
+			sample.gpu = (NvU16)(key >> 5);
+			sample.metric = (NvU8)(key & 0x1F);
+			sample.channel = (NvU8)channel;
+			sample.tick = tick;
+
+			NvS64 &previous = last[TelemetrySeriesKey(sample)];
+			previous += UnZigZag(delta);
+			sample.value = previous;
+			sample.metric = metric;
+			samples.push_back(sample);
+		}
+		return true;
+	}
+
+	bool TelemetryTraceReader::Next(std::vector<TelemetrySample> &batch)
+	{
+		batch.clear();
+		if (pending)
+			batch.insert(batch.end(), read.begin(), read.end());
+		pending = false;
+
+		while (cursor < end)
+		{
+			bool known;
+			if (!DecodeRead(cursor, read, known))
+			{
+				cursor = end;
+				break;
+			}
+			if (!known || read.empty())
+				continue;
+
+			if (!batch.empty() && read[0].tick != batch[0].tick)
+			{
+				pending = true;
+				break;
+			}
+			batch.insert(batch.end(), read.begin(), read.end());
+		}
+		return !batch.empty();
+	}
+
+	TelemetryTraceReplay::TelemetryTraceReplay(TelemetryTraceReader &reader)
+		: reader(reader)
+	{
+		memset(&stats, 0, sizeof(stats));
+	}
+
+	void TelemetryTraceReplay::Run(double speed)
+	{
+		memset(&stats, 0, sizeof(stats));
+		reader.Rewind();
+
+		NvU64 started = TelemetryNow();
+		NvS64 shift = (NvS64)started - (NvS64)reader.FirstTimestamp();
+		std::vector<TelemetrySample> batch;
+		while (reader.Next(batch))
+		{
+			NvU64 traceTime = batch[0].timestamp - reader.FirstTimestamp();
+			if (speed > 0.0)
+			{
+				NvU64 due = started + (NvU64)(traceTime / speed);
+				NvU64 now = TelemetryNow();
+				if (due > now)
+					std::this_thread::sleep_for(std::chrono::microseconds(due - now));
+				else if (now - due > stats.maxLateMicroseconds)
+					stats.maxLateMicroseconds = now - due;
+			}
+
+			for (size_t i = 0; i < batch.size(); i++)
+				batch[i].timestamp = (NvU64)((NvS64)batch[i].timestamp + shift);
+			for (size_t i = 0; i < subscribers.size(); i++)
+				subscribers[i]->OnSamples(&batch[0], (NvU32)batch.size());
+
+			stats.ticks++;
+			stats.samples += batch.size();
+		}
+		stats.elapsedMicroseconds = TelemetryNow() - started;
+	}
+};
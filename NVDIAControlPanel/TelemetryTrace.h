@@ -0,0 +1,144 @@
+#pragma once
+
+#include "nvapi.h"
+#include "TelemetrySource.h"
+#include "TelemetrySampler.h"
+#include "BufferedWriter.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace ControlPanel
+{
+	/*
+	Trace of every raw sample, binary:
+
+		"NVCPTRC1"                  8-byte magic
+		varint      bytes of schema that follow
+		schema:
+		  varint    zigzag(TelemetryWallClockOffset() when the trace was written)
+		  varint    metrics
+		  per metric:
+		    varint  id used by the reads below
+		    u8      name length, then the TelemetryMetricName
+		per read:
+		  varint    zigzag(microseconds since the previous read), the first since 0
+		  varint    zigzag(tick - previous tick)
+		  varint    gpu << 5 | metric id
+		  varint    samples
+		  per sample:
+		    varint  channel
+		    varint  zigzag(value - previous value of the series, 0 before the first)
+
+	Metrics are named in the schema, so a trace still reads after metrics are
+	added or reordered. Unlike a delta capture, steady values are kept: a
+	sample that repeats its series costs two bytes, and a replay pushes
+	exactly what was read, tick by tick.
+	*/
+	class TelemetryTraceWriter : public TelemetrySubscriber
+	{
+	public:
+		explicit TelemetryTraceWriter(BufferedWriter &writer);
+
+		void OnSamples(const TelemetrySample *samples, NvU32 count);
+
+		unsigned long long ReadCount() const { return readCount; }
+		unsigned long long SampleCount() const { return sampleCount; }
+
+	private:
+		BufferedWriter &writer;
+		std::unordered_map<NvU32, NvS64> last;
+		NvU64 lastTimestamp;
+		NvU32 lastTick;
+		unsigned long long readCount;
+		unsigned long long sampleCount;
+	};
+
+	/*
+	Reads a trace in memory back, one sampler tick at a time. Open checks the
+	whole trace once, for its GPU count, time span and sample count; reads of
+	metrics this build does not know are skipped, and a trace whose writer
+	stopped mid-read is read up to its last complete read.
+	*/
+	class TelemetryTraceReader
+	{
+	public:
+		TelemetryTraceReader();
+
+		// False when it is not a trace or its schema is cut short
+		bool Open(const NvU8 *data, size_t size);
+
+		// The samples of the next tick; false at the end
+		bool Next(std::vector<TelemetrySample> &batch);
+		void Rewind();
+
+		NvU32 GpuCount() const { return gpuCount; }
+		NvU64 FirstTimestamp() const { return firstTimestamp; }
+		NvU64 LastTimestamp() const { return lastTimestamp; }
+		NvS64 WallClockOffset() const { return wallClockOffset; }
+		unsigned long long SampleCount() const { return sampleCount; }
+		unsigned long long SkippedCount() const { return skippedCount; }
+		size_t TruncatedBytes() const { return truncatedBytes; }   // after the last complete read
+
+	private:
+		static const NvU8 UNKNOWN_METRIC = 0xFF;
+		static const NvU32 TRACE_METRIC_IDS = 32;
+
+		// One read; false at the end or when it is cut short
+		bool DecodeRead(const NvU8 *&data, std::vector<TelemetrySample> &samples, bool &known);
+
+		const NvU8 *begin;          // first read
+		const NvU8 *end;
+		const NvU8 *cursor;
+		NvU8 metrics[TRACE_METRIC_IDS];     // TelemetryMetric of each id in the trace
+		std::unordered_map<NvU32, NvS64> last;
+		std::vector<TelemetrySample> read;
+		NvU64 timestamp;
+		NvU32 tick;
+		bool pending;               // read holds the first read of the next tick
+		NvU32 gpuCount;
+		NvU64 firstTimestamp;
+		NvU64 lastTimestamp;
+		NvS64 wallClockOffset;
+		unsigned long long sampleCount;
+		unsigned long long skippedCount;
+		size_t truncatedBytes;
+	};
+
+	struct TelemetryReplayStats
+	{
+		unsigned long long ticks;
+		unsigned long long samples;
+		NvU64 elapsedMicroseconds;
+		NvU64 maxLateMicroseconds;  // furthest behind the trace's pace, while paced
+	};
+
+	/*
+	Pushes a trace to subscribers as the sampler would have: each tick is one
+	batch, on the calling thread. At speed 1 the ticks come at their recorded
+	pace, at 4 four times as fast, and at 0 as fast as the subscribers take
+	them. Sample times keep their recorded spacing whatever the speed, moved
+	so the trace starts now, so a replay at any speed raises the same alerts
+	and closes the same windows.
+	*/
+	class TelemetryTraceReplay
+	{
+	public:
+		explicit TelemetryTraceReplay(TelemetryTraceReader &reader);
+
+		void Subscribe(TelemetrySubscriber *subscriber) { subscribers.push_back(subscriber); }
+
+		// From the start of the trace to its end
+		void Run(double speed);
+
+		const TelemetryReplayStats &Stats() const { return stats; }
+
+	private:
+		TelemetryTraceReplay(const TelemetryTraceReplay &);
+		TelemetryTraceReplay &operator=(const TelemetryTraceReplay &);
+
+		TelemetryTraceReader &reader;
+		std::vector<TelemetrySubscriber *> subscribers;
+		TelemetryReplayStats stats;
+	};
+};
@@ -0,0 +1,249 @@
+#include "targetver.h"
+#include "TelemetryUtilization.h"
+#include "TelemetryDelta.h"
+
+#include <string.h>
+
+namespace ControlPanel
+{
+	namespace
+	{
+		NvU32 BandOf(NvU32 percent)
+		{
+			return percent < 100 ? percent / 10 : TELEMETRY_UTILIZATION_BANDS - 1;
+		}
+
+		// Band shares in 1/255 that add up to exactly 255: floors first, then the largest remainders round up
+		void BandShares(const TelemetryUtilizationWindow &window, NvU8 shares[TELEMETRY_UTILIZATION_BANDS])
+		{
+			NvU64 bands[TELEMETRY_UTILIZATION_BANDS] = { 0 };
+			for (NvU32 p = 0; p <= 100; p++)
+				bands[BandOf(p)] += window.percent[p];
+
+			NvU64 remainders[TELEMETRY_UTILIZATION_BANDS];
+			NvU32 total = 0;
+			for (NvU32 b = 0; b < TELEMETRY_UTILIZATION_BANDS; b++)
+			{
+				shares[b] = (NvU8)(bands[b] * 255 / window.count);
+				remainders[b] = bands[b] * 255 % window.count;
+				total += shares[b];
+			}
+
+			for (; total < 255; total++)
+			{
+				NvU32 largest = 0;
+				for (NvU32 b = 1; b < TELEMETRY_UTILIZATION_BANDS; b++)
+				{
+					if (remainders[b] > remainders[largest])
+						largest = b;
+				}
+				shares[largest]++;
+				remainders[largest] = 0;
+			}
+		}
+	}
+
+	void TelemetryUtilizationWindow::Clear()
+	{
+		count = 0;
+		sum = 0;
+		memset(percent, 0, sizeof(percent));
+	}
+
+	NvU32 TelemetryUtilizationWindow::Minimum() const
+	{
+		for (NvU32 p = 0; p < 100; p++)
+		{
+			if (percent[p] != 0)
+				return p;
+		}
+		return 100;
+	}
+
+	NvU32 TelemetryUtilizationWindow::Maximum() const
+	{
+		for (NvU32 p = 100; p > 0; p--)
+		{
+			if (percent[p] != 0)
+				return p;
+		}
+		return 0;
+	}
+
+	NvU32 TelemetryUtilizationWindow::Percentile(double q) const
+	{
+		NvU64 rank = (NvU64)(q * count + 0.999999);
+		if (rank == 0)
+			rank = 1;
+
+		NvU64 seen = 0;
+		for (NvU32 p = 0; p <= 100; p++)
+		{
+			seen += percent[p];
+			if (seen >= rank)
+				return p;
+		}
+		return 100;
+	}
+
+	TelemetryUtilizationHistograms::TelemetryUtilizationHistograms(NvU32 windowSeconds)
+		: windowMicroseconds((NvU64)(windowSeconds > 0 ? windowSeconds : 1) * 1000000)
+		, windowStart(0)
+		, windowEnd(0)
+		, clockOffset(TelemetryWallClockOffset())
+		, windowCount(0)
+	{
+	}
+
+	void TelemetryUtilizationHistograms::OnSamples(const TelemetrySample *samples, NvU32 count)
+	{
+		TelemetrySample converted[256];
+		while (count > 0)
+		{
+			NvU32 batch = count < 256 ? count : 256;
+			for (NvU32 i = 0; i < batch; i++)
+			{
+				converted[i] = samples[i];
+				converted[i].timestamp = (NvU64)((NvS64)samples[i].timestamp + clockOffset);
+			}
+			Append(converted, batch);
+			samples += batch;
+			count -= batch;
+		}
+	}
+
+	void TelemetryUtilizationHistograms::Append(const TelemetrySample *samples, NvU32 count)
+	{
+		for (NvU32 i = 0; i < count; i++)
+		{
+			const TelemetrySample &sample = samples[i];
+			if (sample.metric != TELEMETRY_UTILIZATION || sample.channel >= NVAPI_MAX_GPU_UTILIZATIONS)
+				continue;
+
+			if (sample.timestamp >= windowEnd)
+			{
+				if (windowEnd != 0)
+					Close();
+				windowStart = sample.timestamp - sample.timestamp % windowMicroseconds;
+				windowEnd = windowStart + windowMicroseconds;
+			}
+
+			size_t index = (size_t)sample.gpu * NVAPI_MAX_GPU_UTILIZATIONS + sample.channel;
+			if (index >= open.size())
+			{
+				size_t first = open.size();
+				open.resize(((size_t)sample.gpu + 1) * NVAPI_MAX_GPU_UTILIZATIONS);
+				for (size_t w = first; w < open.size(); w++)
+				{
+					open[w].gpu = (NvU16)(w / NVAPI_MAX_GPU_UTILIZATIONS);
+					open[w].domain = (NvU8)(w % NVAPI_MAX_GPU_UTILIZATIONS);
+					open[w].Clear();
+				}
+			}
+
+			// A sample late for its window counts in the open one
+			NvU32 value = sample.value < 0 ? 0 : (sample.value > 100 ? 100 : (NvU32)sample.value);
+			TelemetryUtilizationWindow &window = open[index];
+			window.count++;
+			window.sum += value;
+			window.percent[value]++;
+		}
+	}
+
+	void TelemetryUtilizationHistograms::Flush()
+	{
+		if (windowEnd != 0)
+			Close();
+		windowEnd = 0;
+	}
+
+	void TelemetryUtilizationHistograms::Close()
+	{
+		closed.clear();
+		for (size_t w = 0; w < open.size(); w++)
+		{
+			if (open[w].count == 0)
+				continue;
+
+			open[w].windowStart = windowStart;
+			closed.push_back(open[w]);
+			open[w].Clear();
+		}
+		if (closed.empty())
+			return;
+
+		windowCount++;
+		for (size_t i = 0; i < sinks.size(); i++)
+			sinks[i]->OnUtilization(windowMicroseconds, &closed[0], (NvU32)closed.size());
+	}
+
+	void EncodeTelemetryUtilization(NvU64 windowMicroseconds, const TelemetryUtilizationWindow *windows, NvU32 count, std::vector<NvU8> &bytes)
+	{
+		PutVarint(bytes, count > 0 ? windows[0].windowStart / windowMicroseconds : 0);
+		PutVarint(bytes, windowMicroseconds / 1000);
+		PutVarint(bytes, count);
+		for (NvU32 i = 0; i < count; i++)
+		{
+			const TelemetryUtilizationWindow &window = windows[i];
+			PutVarint(bytes, (NvU64)window.gpu << 3 | window.domain);
+			PutVarint(bytes, window.count);
+			bytes.push_back((NvU8)(window.count ? ((NvU64)window.sum * 2 + window.count / 2) / window.count : 0));
+			if (window.count <= 1)
+				continue;
+
+			bytes.push_back((NvU8)window.Minimum());
+			bytes.push_back((NvU8)window.Percentile(0.5));
+			bytes.push_back((NvU8)window.Percentile(0.9));
+			bytes.push_back((NvU8)window.Maximum());
+
+			NvU8 shares[TELEMETRY_UTILIZATION_BANDS];
+			BandShares(window, shares);
+			bytes.insert(bytes.end(), shares, shares + TELEMETRY_UTILIZATION_BANDS);
+		}
+	}
+
+	bool DecodeTelemetryUtilization(const NvU8 *&data, const NvU8 *end, NvU64 &windowStart, NvU64 &windowMicroseconds,
+		std::vector<TelemetryUtilizationSummary> &summaries)
+	{
+		NvU64 window, milliseconds, count;
+		if (!ReadVarint(data, end, window) || !ReadVarint(data, end, milliseconds) || !ReadVarint(data, end, count))
+			return false;
+
+		windowMicroseconds = milliseconds * 1000;
+		windowStart = window * windowMicroseconds;
+		summaries.clear();
+		for (NvU64 i = 0; i < count; i++)
+		{
+			NvU64 key, samples;
+			if (!ReadVarint(data, end, key) || !ReadVarint(data, end, samples) || data >= end)
+				return false;
+
+			TelemetryUtilizationSummary summary;
+			memset(&summary, 0, sizeof(summary));
+			summary.gpu = (NvU16)(key >> 3);
+			summary.domain = (NvU8)(key & 7);
+			summary.count = (NvU32)samples;
+			summary.mean = *data++ / 2.0f;
+			if (samples <= 1)
+			{
+				// One sample is its own minimum, maximum and percentiles
+				NvU8 value = (NvU8)summary.mean;
+				summary.minimum = summary.median = summary.p90 = summary.maximum = value;
+				summary.bands[BandOf(value)] = samples ? 1.0f : 0.0f;
+				summaries.push_back(summary);
+				continue;
+			}
+
+			if ((size_t)(end - data) < 4 + TELEMETRY_UTILIZATION_BANDS)
+				return false;
+			summary.minimum = *data++;
+			summary.median = *data++;
+			summary.p90 = *data++;
+			summary.maximum = *data++;
+			for (NvU32 b = 0; b < TELEMETRY_UTILIZATION_BANDS; b++)
+				summary.bands[b] = *data++ / 255.0f;
+			summaries.push_back(summary);
+		}
+		return true;
+	}
+};
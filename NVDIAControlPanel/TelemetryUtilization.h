@@ -0,0 +1,118 @@
+#pragma once
+
+#include "nvapi.h"
+#include "TelemetrySource.h"
+#include "TelemetrySampler.h"
+
+#include <vector>
+
+namespace ControlPanel
+{
+	// Bands of the encoded histogram: 0-9%, 10-19%, ... 90-100%
+	const NvU32 TELEMETRY_UTILIZATION_BANDS = 10;
+
+	/*
+	One utilization domain (a channel of TELEMETRY_UTILIZATION) of one GPU over
+	one window. The driver reports whole percentages, so the histogram is exact:
+	a count per percentage, and any percentile is read straight from it.
+	*/
+	struct TelemetryUtilizationWindow
+	{
+		NvU64 windowStart;          // microseconds since 1970 (UTC)
+		NvU16 gpu;
+		NvU8 domain;
+		NvU32 count;
+		NvU32 sum;
+		NvU32 percent[101];         // samples at each percentage
+
+		void Clear();
+
+		double Mean() const { return count ? (double)sum / count : 0.0; }
+		NvU32 Minimum() const;
+		NvU32 Maximum() const;
+		NvU32 Percentile(double q) const;   // nearest rank, 0 <= q <= 1
+	};
+
+	class TelemetryUtilizationSink
+	{
+	public:
+		virtual ~TelemetryUtilizationSink() {}
+
+		// Every domain that reported during the window, ordered by GPU and domain
+		virtual void OnUtilization(NvU64 windowMicroseconds, const TelemetryUtilizationWindow *windows, NvU32 count) = 0;
+	};
+
+	/*
+	Per-window utilization histograms of every GPU and domain. All domains
+	share one window, aligned to wall-clock time, so every window closes into
+	a single report across GPUs; the first sample past its end closes it.
+	Windows live in a flat array indexed by GPU and domain, so a sample is an
+	increment and a compare, and other metrics are skipped.
+	*/
+	class TelemetryUtilizationHistograms : public TelemetrySubscriber
+	{
+	public:
+		explicit TelemetryUtilizationHistograms(NvU32 windowSeconds = 60);
+
+		void Subscribe(TelemetryUtilizationSink *sink) { sinks.push_back(sink); }
+
+		// Live samples: converts TelemetryNow() timestamps to wall-clock time
+		void OnSamples(const TelemetrySample *samples, NvU32 count);
+
+		// Samples already in wall-clock time
+		void Append(const TelemetrySample *samples, NvU32 count);
+
+		// Closes the open window, at the end of a recording
+		void Flush();
+
+		NvU64 WindowMicroseconds() const { return windowMicroseconds; }
+		unsigned long long WindowCount() const { return windowCount; }
+
+	private:
+		void Close();
+
+		NvU64 windowMicroseconds;
+		NvU64 windowStart;
+		NvU64 windowEnd;            // 0 while no window is open
+		std::vector<TelemetryUtilizationWindow> open;       // gpu * NVAPI_MAX_GPU_UTILIZATIONS + domain
+		std::vector<TelemetryUtilizationWindow> closed;
+		std::vector<TelemetryUtilizationSink *> sinks;
+		NvS64 clockOffset;
+		unsigned long long windowCount;
+	};
+
+	// A window as decoded from the report, in the encoding's fixed-point precision
+	struct TelemetryUtilizationSummary
+	{
+		NvU16 gpu;
+		NvU8 domain;
+		NvU32 count;
+		float mean;                 // to the half percent
+		NvU8 minimum;
+		NvU8 median;
+		NvU8 p90;
+		NvU8 maximum;
+		float bands[TELEMETRY_UTILIZATION_BANDS];   // share of samples, to 1/255, summing to 1
+	};
+
+	/*
+	Report of one window across GPUs:
+
+		varint      window number (windowStart / window length)
+		varint      window length in milliseconds
+		varint      domains
+		per domain:
+		  varint    gpu << 3 | domain
+		  varint    samples
+		  u8        mean in half percent (0-200)
+		  when there is more than one sample:
+		    u8      minimum, median, 90th percentile and maximum percent
+		    u8[10]  share of samples in each band, in 1/255, summing to 255
+
+	A domain is 17 bytes when the window holds several samples and 3 bytes
+	when it holds one, as a 1 s window at 1 Hz does.
+	*/
+	void EncodeTelemetryUtilization(NvU64 windowMicroseconds, const TelemetryUtilizationWindow *windows, NvU32 count, std::vector<NvU8> &bytes);
+	bool DecodeTelemetryUtilization(const NvU8 *&data, const NvU8 *end, NvU64 &windowStart, NvU64 &windowMicroseconds,
+		std::vector<TelemetryUtilizationSummary> &summaries);
+};
@@ -1,11 +1,38 @@
 #include "targetver.h"
 #include "nvapi.h"
 #include "NvApiDriverSettings.h"
+#include "DrsSession.h"
+#include "DrsSnapshot.h"
+#include "DrsRecords.h"
+#include "DrsDump.h"
+#include "DrsPlan.h"
+#include "DrsCache.h"
+#include "DrsAppResolver.h"
+#include "SettingRegistry.h"
+#include "SimulatedDrsStore.h"
+#include "TelemetrySampler.h"
+#include "TelemetryRing.h"
+#include "TelemetryDelta.h"
+#include "TelemetryFrames.h"
+#include "TelemetryStore.h"
+#include "TelemetryRollup.h"
+#include "TelemetryExporter.h"
+#include "TelemetryAlerts.h"
+#include "TelemetryUtilization.h"
+#include "TelemetryThrottle.h"
+#include "TelemetryEcc.h"
+#include "TelemetryTrace.h"
+#include "MappedFile.h"
+#include "NvApiStats.h"
+#include "PstateCatalogue.h"
+#include "Benchmarks.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <Windows.h>
+#include <io.h>
+#include <fcntl.h>
 
 /*
 This function is used to print to the command line a text message
@@ -14,7 +41,7 @@ describing the nvapi error and quits
 void PrintError(NvAPI_Status status)
 {
 	NvAPI_ShortString szDesc = { 0 };
-	NvAPI_GetErrorMessage(status, szDesc);
+	ControlPanel::NvApiCall(ControlPanel::NVAPI_CALL_GET_ERROR_MESSAGE, NvAPI_GetErrorMessage, status, szDesc);
 	printf(" NVAPI error: %s\n", szDesc);
 }
 
@@ -30,13 +57,13 @@ void CheckStatus(NvAPI_Status status)
 
 namespace ControlPanel
 {
-	bool DisplayProfileContents(NvDRSSessionHandle session, NvDRSProfileHandle profile)
+	bool DisplayProfileContents(NvDRSSessionHandle session, NvDRSProfileHandle profile, DrsScratchArena &scratch, DrsRecordBuffer &records)
 	{
 		NvAPI_Status status;
 
 		NVDRS_PROFILE profileInfo = { 0 };
 		profileInfo.version = NVDRS_PROFILE_VER;
-		status = NvAPI_DRS_GetProfileInfo(session, profile, &profileInfo);
+		status = Drs().GetProfileInfo(session, profile, &profileInfo);
 		if (status != NVAPI_OK)
 		{
 			PrintError(status);
@@ -50,70 +77,79 @@ namespace ControlPanel
 
 		if (profileInfo.numOfApps > 0)
 		{
-			NVDRS_APPLICATION *apps = new NVDRS_APPLICATION[profileInfo.numOfApps];
-			apps[0].version = NVDRS_APPLICATION_VER;
+			NVDRS_APPLICATION *apps = scratch.Applications(profileInfo.numOfApps);
+			if (apps == NULL)
+			{
+				PrintError(NVAPI_OUT_OF_MEMORY);
+				return false;
+			}
 
 			NvU32 appCount = profileInfo.numOfApps;
-			status = NvAPI_DRS_EnumApplications(session, profile, 0, &appCount, apps);
+			status = Drs().EnumApplications(session, profile, 0, &appCount, apps);
 			if (status != NVAPI_OK)
 			{
 				PrintError(status);
-				delete[] apps;
 				return false;
 			}
 
-			for (int i = 0; i < appCount; i++)
+			for (NvU32 i = 0; i < appCount; i++)
 			{
 				wprintf(L"Executable: %s\n", apps[i].appName);
 				wprintf(L"User friendly name: %s\n", apps[i].userFriendlyName);
 				printf("Is predefined: %d\n", apps[i].isPredefined);
 			}
-
-			delete[] apps;
 		}
 
+		records.Clear();
 		if (profileInfo.numOfSettings > 0)
 		{
-			NVDRS_SETTING *settings = new NVDRS_SETTING[profileInfo.numOfSettings];
-			settings[0].version = NVDRS_SETTING_VER;
+			NVDRS_SETTING *settings = scratch.Settings(profileInfo.numOfSettings);
+			if (settings == NULL)
+			{
+				PrintError(NVAPI_OUT_OF_MEMORY);
+				return false;
+			}
 
 			NvU32 settingCount = profileInfo.numOfSettings;
-			status = NvAPI_DRS_EnumSettings(session, profile, 0, &settingCount, settings);
+			status = Drs().EnumSettings(session, profile, 0, &settingCount, settings);
 			if (status != NVAPI_OK)
 			{
 				PrintError(status);
-				delete[] settings;
 				return false;
 			}
 
-			for (int i = 0; i < settingCount; i++)
+			// Keep only what this profile stores, in compact form; the scratch arena is reused next time
+			for (NvU32 i = 0; i < settingCount; i++)
 			{
-				if (settings[i].settingLocation != NVDRS_CURRENT_PROFILE_LOCATION)
-					continue;
-
-				wprintf(L"Setting name: %s\n", settings[i].settingName);
-				printf("Setting ID: %X\n", settings[i].settingId);
-				printf("Is predefined: %d\n", settings[i].isCurrentPredefined);
+				if (settings[i].settingLocation == NVDRS_CURRENT_PROFILE_LOCATION)
+					records.Append(settings[i]);
+			}
+		}
 
-				switch (settings[i].settingType)
-				{
-				case NVDRS_DWORD_TYPE:
-					printf("Setting value: %X\n", settings[i].u32CurrentValue);
-					break;
+		for (const DrsSettingRecord *record = records.First(); record != NULL; record = records.Next(record))
+		{
+			wprintf(L"Setting name: %.*s\n", (int)record->nameLength, (const wchar_t *)record->Name());
+			printf("Setting ID: %X\n", record->settingId);
+			printf("Is predefined: %d\n", (record->flags & DRS_RECORD_PREDEFINED) ? 1 : 0);
 
-				case NVDRS_BINARY_TYPE:
-					printf("Setting value (length=%d): ", settings[i].binaryCurrentValue.valueLength);
-					for (unsigned int len = 0; len < settings[i].binaryCurrentValue.valueLength; len++)
-					{
-						printf(" %02X", settings[i].binaryCurrentValue.valueData[len]);
-					}
-					printf("\n");
-					break;
+			switch (record->settingType)
+			{
+			case NVDRS_DWORD_TYPE:
+				printf("Setting value: %X\n", record->Dword());
+				break;
 
-				case NVDRS_WSTRING_TYPE:
-					wprintf(L"Setting value: %s\n", settings[i].wszCurrentValue);
-					break;
+			case NVDRS_BINARY_TYPE:
+				printf("Setting value (length=%d): ", record->valueLength);
+				for (unsigned int len = 0; len < record->valueLength; len++)
+				{
+					printf(" %02X", record->Value()[len]);
 				}
+				printf("\n");
+				break;
+
+			case NVDRS_WSTRING_TYPE:
+				wprintf(L"Setting value: %s\n", (const wchar_t *)record->Value());
+				break;
 			}
 		}
 
@@ -125,139 +161,329 @@ namespace ControlPanel
 	{
 		NvAPI_Status status;
 
-		NvDRSSessionHandle session = NULL;
-		status = NvAPI_DRS_CreateSession(&session);
+		DrsSession session;
+		status = session.Load();
 		if (status != NVAPI_OK)
 		{
 			return status;
 		}
 
-		status = NvAPI_DRS_LoadSettings(session);
-		if (status != NVAPI_OK)
-		{
-			return status;
-		}
+		DrsScratchArena scratch;
+		DrsRecordBuffer records;
 
 		NvDRSProfileHandle profile = NULL;
 		unsigned int profileIndex = 0;
-		while ((status = NvAPI_DRS_EnumProfiles(session, profileIndex, &profile)) == NVAPI_OK)
+		while ((status = Drs().EnumProfiles(session.Handle(), profileIndex, &profile)) == NVAPI_OK)
 		{
 			printf("Retrieve information from profile: %d\n", profileIndex);
-			DisplayProfileContents(session, profile);
+			DisplayProfileContents(session.Handle(), profile, scratch, records);
 
 			profileIndex++;
 		}
 
 		if (status == NVAPI_END_ENUMERATION)
 		{
+			status = NVAPI_OK;
+		}
+
+		return status;
+	}
+
+	/*
+	Writes the whole DRS database in one machine-readable format, either to
+	a file or to stdout (switched to binary mode so nothing is translated)
+	*/
+	NvAPI_Status DumpAllProfiles(DrsDumpFormat format, const char *path)
+	{
+		NvAPI_Status status;
 
+		DrsSession session;
+		DrsSnapshot snapshot;
+		status = snapshot.Load(session);
+		if (status != NVAPI_OK)
+		{
+			return status;
 		}
-		else
+
+		FILE *file = stdout;
+		if (path != NULL)
 		{
-			if (status != NVAPI_OK)
+			file = OpenFile(path, "wb");
+			if (file == NULL)
 			{
-				return status;
+				printf("Cannot open %s\n", path);
+				return NVAPI_ERROR;
 			}
 		}
+		else
+		{
+			fflush(stdout);
+			_setmode(_fileno(stdout), _O_BINARY);
+		}
 
-		NvAPI_DRS_DestroySession(session);
-		session = NULL;
+		{
+			BufferedWriter writer(file);
+			status = WriteDrsDump(snapshot, format, writer);
+		}
+
+		if (path != NULL)
+			fclose(file);
 
 		return status;
 	}
 
-	NvAPI_Status DisableVsync()
+	/*
+	Resolves every executable path of a UTF-8 list (one per line) to the
+	profile the driver applies and writes path,profile,application as CSV
+	*/
+	NvAPI_Status ResolveApplicationPaths(const char *listPath, const char *outputPath)
 	{
 		NvAPI_Status status;
 
-		NvDRSSessionHandle session = NULL;
-		status = NvAPI_DRS_CreateSession(&session);
-		if (status != NVAPI_OK)
+		std::wstring text;
+		if (!ReadUtf8File(listPath, text))
 		{
-			return status;
+			printf("Cannot read %s\n", listPath);
+			return NVAPI_INVALID_ARGUMENT;
 		}
 
-		status = NvAPI_DRS_LoadSettings(session);
-		if (status != NVAPI_OK)
+		std::vector<std::wstring> paths;
+		size_t start = 0;
+		while (start < text.size())
 		{
-			return status;
+			size_t end = text.find(L'\n', start);
+			if (end == std::wstring::npos)
+				end = text.size();
+
+			size_t last = end;
+			if (last > start && text[last - 1] == L'\r')
+				last--;
+			if (last > start)
+				paths.push_back(text.substr(start, last - start));
+			start = end + 1;
 		}
 
-		NvDRSProfileHandle profile = NULL;
-		status = NvAPI_DRS_GetBaseProfile(session, &profile);
+		DrsSession session;
+		DrsSnapshot snapshot;
+		status = snapshot.Load(session);
 		if (status != NVAPI_OK)
 		{
 			return status;
 		}
 
-		NVDRS_SETTING settings = { 0 };
-		settings.version = NVDRS_SETTING_VER;
-		settings.settingId = ESetting::VSYNCMODE_ID;
-		settings.settingType = NVDRS_SETTING_TYPE::NVDRS_DWORD_TYPE;
-		settings.u32CurrentValue = EValues_VSYNCMODE::VSYNCMODE_FORCEOFF;
-		status = NvAPI_DRS_SetSetting(session, profile, &settings);
+		DrsAppResolver resolver;
+		resolver.Build(snapshot);
+		std::vector<DrsResolution> results;
+		resolver.ResolveAll(paths, results);
+
+		FILE *file = stdout;
+		if (outputPath != NULL)
+		{
+			file = OpenFile(outputPath, "wb");
+			if (file == NULL)
+			{
+				printf("Cannot open %s\n", outputPath);
+				return NVAPI_ERROR;
+			}
+		}
+		else
+		{
+			fflush(stdout);
+			_setmode(_fileno(stdout), _O_BINARY);
+		}
+
+		{
+			BufferedWriter writer(file);
+			writer.Literal("path,profile,application\n");
+			for (size_t i = 0; i < paths.size(); i++)
+			{
+				writer.CsvString(paths[i].c_str());
+				writer.Put(',');
+				if (results[i].profile != DrsSnapshot::npos)
+				{
+					writer.CsvString(snapshot.String(snapshot.Profiles().name[results[i].profile]));
+					writer.Put(',');
+					writer.CsvString(snapshot.String(snapshot.Applications().appName[results[i].application]));
+				}
+				else
+				{
+					writer.Put(',');
+				}
+				writer.Put('\n');
+			}
+		}
+
+		if (outputPath != NULL)
+			fclose(file);
+
+		return NVAPI_OK;
+	}
+
+	/*
+	Compares a desired-state file against the live database and prints the
+	minimal set of changes; with apply, commits exactly those in one session.
+	With createProfiles the file is a provisioning manifest and profiles it
+	names that do not exist yet are created in that same session.
+	*/
+	NvAPI_Status ConvergeDesiredState(const char *path, bool apply, bool createProfiles)
+	{
+		NvAPI_Status status;
+
+		DesiredState state;
+		status = LoadDesiredState(path, state);
 		if (status != NVAPI_OK)
 		{
 			return status;
 		}
 
-		status = NvAPI_DRS_SaveSettings(session);
+		DrsSession session;
+		DrsSnapshot snapshot;
+		status = snapshot.Load(session);
 		if (status != NVAPI_OK)
 		{
 			return status;
 		}
 
-		NvAPI_DRS_DestroySession(session);
-		session = NULL;
+		DrsPlan plan;
+		BuildDrsPlan(state, snapshot, plan, createProfiles);
+		PrintDrsPlan(state, snapshot, plan);
+
+		if (!apply)
+		{
+			return NVAPI_OK;
+		}
+
+		if (plan.changes.empty())
+		{
+			printf("Nothing to apply\n");
+			return NVAPI_OK;
+		}
+
+		status = ApplyDrsPlan(state, plan, session);
+		if (status == NVAPI_OK)
+		{
+			printf("Applied %u changes\n", (NvU32)plan.changes.size());
+		}
 
 		return status;
 	}
 
-	NvAPI_Status EnableVsync()
+	NvAPI_Status ShowSettingOverrides(NvU32 settingId)
 	{
 		NvAPI_Status status;
 
-		NvDRSSessionHandle session = NULL;
-		status = NvAPI_DRS_CreateSession(&session);
+		DrsSession session;
+		DrsSnapshot snapshot;
+		status = snapshot.Load(session);
 		if (status != NVAPI_OK)
 		{
 			return status;
 		}
 
-		status = NvAPI_DRS_LoadSettings(session);
-		if (status != NVAPI_OK)
+		const DrsSnapshot::SettingTable &settings = snapshot.Settings();
+		const NvU32 *rows = NULL;
+		NvU32 rowCount = snapshot.FindSettingRows(settingId, &rows);
+		printf("Profiles overriding setting %X: %u of %u\n", settingId, rowCount, snapshot.ProfileCount());
+
+		for (NvU32 i = 0; i < rowCount; i++)
 		{
-			return status;
+			NvU32 row = rows[i];
+			const wchar_t *profileName = snapshot.String(snapshot.Profiles().name[settings.profile[row]]);
+
+			switch (settings.settingType[row])
+			{
+			case NVDRS_DWORD_TYPE:
+				wprintf(L"%s: %X\n", profileName, settings.value[row]);
+				break;
+
+			case NVDRS_BINARY_TYPE:
+				wprintf(L"%s: binary (length=%u)\n", profileName, settings.length[row]);
+				break;
+
+			default:
+				wprintf(L"%s: %s\n", profileName, snapshot.String(settings.value[row]));
+				break;
+			}
 		}
 
-		NvDRSProfileHandle profile = NULL;
-		status = NvAPI_DRS_GetBaseProfile(session, &profile);
+		return NVAPI_OK;
+	}
+
+	/*
+	Answers "what does <exe> get for <setting>" from the memory-mapped snapshot
+	cache: the profile of the first matching application, falling back to the
+	base profile and then to the documented default.
+	*/
+	NvAPI_Status QuerySetting(const wchar_t *appName, NvU32 settingId, const char *cachePath)
+	{
+		NvAPI_Status status;
+
+		DrsSnapshotCache cache;
+		status = cache.Open(cachePath);
 		if (status != NVAPI_OK)
 		{
 			return status;
 		}
 
-		NVDRS_SETTING settings = { 0 };
-		settings.version = NVDRS_SETTING_VER;
-		settings.settingId = ESetting::VSYNCMODE_ID;
-		settings.settingType = NVDRS_SETTING_TYPE::NVDRS_DWORD_TYPE;
-		settings.u32CurrentValue = EValues_VSYNCMODE::VSYNCMODE_FORCEON;
-		status = NvAPI_DRS_SetSetting(session, profile, &settings);
-		if (status != NVAPI_OK)
+		const DrsDumpTables &tables = cache.Tables();
+		std::vector<NvU32> applications;
+		NvU32 profile = DrsSnapshot::npos;
+		if (cache.FindApplications(appName, applications) > 0)
+			profile = tables.applicationProfile[applications[0]];
+
+		NvU32 row = DrsSnapshot::npos;
+		if (profile != DrsSnapshot::npos)
+			row = cache.FindSetting(profile, settingId);
+		if (row == DrsSnapshot::npos && cache.BaseProfile() != DrsSnapshot::npos)
 		{
-			return status;
+			profile = cache.BaseProfile();
+			row = cache.FindSetting(profile, settingId);
 		}
 
-		status = NvAPI_DRS_SaveSettings(session);
-		if (status != NVAPI_OK)
+		if (cache.WasRebuilt())
+			printf("Rebuilt %s\n", cachePath);
+
+		if (row == DrsSnapshot::npos)
 		{
-			return status;
+			const SettingInfo *info = FindSettingInfo(settingId);
+			if (info != NULL && info->settingType == NVDRS_DWORD_TYPE)
+				wprintf(L"%s: %X (default)\n", appName, info->defaultValue);
+			else
+				wprintf(L"%s: not set\n", appName);
+			return NVAPI_OK;
 		}
 
-		NvAPI_DRS_DestroySession(session);
-		session = NULL;
+		const wchar_t *profileName = (const wchar_t *)cache.String(tables.profileName[profile]);
+		switch (tables.settingType[row])
+		{
+		case NVDRS_DWORD_TYPE:
+			wprintf(L"%s: %X (%s)\n", appName, tables.settingValue[row], profileName);
+			break;
 
-		return status;
+		case NVDRS_BINARY_TYPE:
+			wprintf(L"%s: binary (length=%u) (%s)\n", appName, tables.settingLength[row], profileName);
+			break;
+
+		default:
+			wprintf(L"%s: %s (%s)\n", appName, (const wchar_t *)cache.String(tables.settingValue[row]), profileName);
+			break;
+		}
+
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status DisableVsync()
+	{
+		DrsSession session;
+		session.StageSetDword(NULL, ESetting::VSYNCMODE_ID, EValues_VSYNCMODE::VSYNCMODE_FORCEOFF);
+		return session.Commit();
+	}
+
+	NvAPI_Status EnableVsync()
+	{
+		DrsSession session;
+		session.StageSetDword(NULL, ESetting::VSYNCMODE_ID, EValues_VSYNCMODE::VSYNCMODE_FORCEON);
+		return session.Commit();
 	}
 
 
@@ -266,7 +492,7 @@ namespace ControlPanel
 		NvAPI_Status status;
 
 		// Get all physical GPU handles
-		status = NvAPI_EnumPhysicalGPUs(gpuHandles, &gpuCount);
+		status = NvApiCall(NVAPI_CALL_ENUM_PHYSICAL_GPUS, NvAPI_EnumPhysicalGPUs, gpuHandles, &gpuCount);
 		if (status != NVAPI_OK)
 		{
 			PrintError(status);
@@ -280,7 +506,7 @@ namespace ControlPanel
 		NvAPI_Status status;
 
 		// Get all logical GPU handles
-		status = NvAPI_EnumLogicalGPUs(gpuHandles, &gpuCount);
+		status = NvApiCall(NVAPI_CALL_ENUM_LOGICAL_GPUS, NvAPI_EnumLogicalGPUs, gpuHandles, &gpuCount);
 		if (status != NVAPI_OK)
 		{
 			PrintError(status);
@@ -294,7 +520,7 @@ namespace ControlPanel
 		NvAPI_Status status;
 
 		// Get the connected display ID's array
-		status = NvAPI_GPU_GetConnectedDisplayIds(gpuHandle, NULL, &displayIDCount, NV_GPU_CONNECTED_IDS_FLAG_UNCACHED);
+		status = NvApiCall(NVAPI_CALL_GPU_GET_CONNECTED_DISPLAY_IDS_UNCACHED, NvAPI_GPU_GetConnectedDisplayIds, gpuHandle, (NV_GPU_DISPLAYIDS *)NULL, &displayIDCount, NV_GPU_CONNECTED_IDS_FLAG_UNCACHED);
 		if (status != NVAPI_OK)
 		{
 			PrintError(status);
@@ -306,7 +532,7 @@ namespace ControlPanel
 		tempDisplayID->version = NV_GPU_DISPLAYIDS_VER;
 
 		// second call to get the display ids
-		status = NvAPI_GPU_GetConnectedDisplayIds(gpuHandle, tempDisplayID, &displayIDCount, NV_GPU_CONNECTED_IDS_FLAG_UNCACHED);
+		status = NvApiCall(NVAPI_CALL_GPU_GET_CONNECTED_DISPLAY_IDS_UNCACHED, NvAPI_GPU_GetConnectedDisplayIds, gpuHandle, tempDisplayID, &displayIDCount, NV_GPU_CONNECTED_IDS_FLAG_UNCACHED);
 		if (status != NVAPI_OK)
 		{
 			PrintError(status);
@@ -369,7 +595,7 @@ namespace ControlPanel
 		for (NvU32 i = 0; i < physicalGpuCount; i++)
 		{
 			NvAPI_ShortString physicalGpuName;
-			status = NvAPI_GPU_GetFullName(physicalGpuHandles[i], physicalGpuName);
+			status = NvApiCall(NVAPI_CALL_GPU_GET_FULL_NAME, NvAPI_GPU_GetFullName, physicalGpuHandles[i], physicalGpuName);
 			if (status != NVAPI_OK)
 			{
 				return status;
@@ -377,7 +603,7 @@ namespace ControlPanel
 			printf("Physical GPU name: %s\n", physicalGpuName);
 
 			NvU32 physicalGpuCore = 0;
-			status = NvAPI_GPU_GetGpuCoreCount(physicalGpuHandles[i], &physicalGpuCore);
+			status = NvApiCall(NVAPI_CALL_GPU_GET_GPU_CORE_COUNT, NvAPI_GPU_GetGpuCoreCount, physicalGpuHandles[i], &physicalGpuCore);
 			if (status != NVAPI_OK)
 			{
 				return status;
@@ -387,7 +613,7 @@ namespace ControlPanel
 			NV_DISPLAY_DRIVER_MEMORY_INFO memoryInfo;
 			memset(&memoryInfo, 0, sizeof(NV_DISPLAY_DRIVER_MEMORY_INFO));
 			memoryInfo.version = NV_DISPLAY_DRIVER_MEMORY_INFO_VER;
-			status = NvAPI_GPU_GetMemoryInfo(physicalGpuHandles[i], &memoryInfo);
+			status = NvApiCall(NVAPI_CALL_GPU_GET_MEMORY_INFO, NvAPI_GPU_GetMemoryInfo, physicalGpuHandles[i], &memoryInfo);
 			if (status != NVAPI_OK)
 			{
 				return status;
@@ -397,14 +623,14 @@ namespace ControlPanel
 			printf("Total memory: %d (Mb)\n", memoryInfo.availableDedicatedVideoMemory / 1024 + memoryInfo.sharedSystemMemory / 1024);
 
 			NvLogicalGpuHandle logicalGpuHandles[NVAPI_MAX_LOGICAL_GPUS] = { 0 };
-			status = NvAPI_GetLogicalGPUFromPhysicalGPU(physicalGpuHandles[i], logicalGpuHandles);
+			status = NvApiCall(NVAPI_CALL_GET_LOGICAL_GPU_FROM_PHYSICAL_GPU, NvAPI_GetLogicalGPUFromPhysicalGPU, physicalGpuHandles[i], logicalGpuHandles);
 			if (status != NVAPI_OK)
 			{
 				return status;
 			}
 
 			NvU32 shaderSubPipeCount = 0;
-			status = NvAPI_GPU_GetShaderSubPipeCount(physicalGpuHandles[i], &shaderSubPipeCount);
+			status = NvApiCall(NVAPI_CALL_GPU_GET_SHADER_SUB_PIPE_COUNT, NvAPI_GPU_GetShaderSubPipeCount, physicalGpuHandles[i], &shaderSubPipeCount);
 			if (status != NVAPI_OK)
 			{
 				return status;
@@ -461,7 +687,7 @@ namespace ControlPanel
 			timing.flag = flag;
 			timing.type = NV_TIMING_OVERRIDE_AUTO;
 
-			status = NvAPI_DISP_GetTiming(displayIDs[0], &timing, &customs[count].timing);
+			status = NvApiCall(NVAPI_CALL_DISP_GET_TIMING, NvAPI_DISP_GetTiming, displayIDs[0], &timing, &customs[count].timing);
 
 			if (status != NVAPI_OK)
 			{
@@ -474,7 +700,7 @@ namespace ControlPanel
 		printf("%d X %d @ %0.2f hz\n", customs[0].width, customs[0].height, rr);
 
 		printf("NvAPI_DISP_TryCustomDisplay()\n");
-		status = NvAPI_DISP_TryCustomDisplay(&displayIDs[0], numDisplay, &customs[0]); // trying to set custom display
+		status = NvApiCall(NVAPI_CALL_DISP_TRY_CUSTOM_DISPLAY, NvAPI_DISP_TryCustomDisplay, &displayIDs[0], numDisplay, &customs[0]); // trying to set custom display
 		if (status != NVAPI_OK)
 		{
 			printf("NvAPI_DISP_TryCustomDisplay() failed = %d\n", status);		//failed to set custom display
@@ -486,7 +712,7 @@ namespace ControlPanel
 
 		printf("NvAPI_DISP_SaveCustomDisplay()\n");
 
-		status = NvAPI_DISP_SaveCustomDisplay(&displayIDs[0], numDisplay, true, true);
+		status = NvApiCall(NVAPI_CALL_DISP_SAVE_CUSTOM_DISPLAY, NvAPI_DISP_SaveCustomDisplay, &displayIDs[0], numDisplay, true, true);
 		if (status != NVAPI_OK)
 		{
 			printf("NvAPI_DISP_SaveCustomDisplay() failed = %d\n", status);		//failed to save custom display
@@ -500,7 +726,7 @@ namespace ControlPanel
 		printf("NvAPI_DISP_RevertCustomDisplayTrial()\n");
 
 		// Revert the new custom display settings tried.
-		status = NvAPI_DISP_RevertCustomDisplayTrial(&displayIDs[0], 1);
+		status = NvApiCall(NVAPI_CALL_DISP_REVERT_CUSTOM_DISPLAY_TRIAL, NvAPI_DISP_RevertCustomDisplayTrial, &displayIDs[0], 1);
 		if (status != NVAPI_OK)
 		{
 			printf("NvAPI_DISP_RevertCustomDisplayTrial() failed = %d\n", status);		//failed to revert custom display trail
@@ -524,7 +750,7 @@ namespace ControlPanel
 		NvU32 pathCount = 0;
 		NV_DISPLAYCONFIG_PATH_INFO *pathInfo = NULL;
 
-		status = NvAPI_DISP_GetDisplayConfig(&pathCount, NULL);
+		status = NvApiCall(NVAPI_CALL_DISP_GET_DISPLAY_CONFIG, NvAPI_DISP_GetDisplayConfig, &pathCount, (NV_DISPLAYCONFIG_PATH_INFO *)NULL);
 		if (status != NVAPI_OK)
 			return status;
 
@@ -541,7 +767,7 @@ namespace ControlPanel
 		}
 
 		// Retrieve the targetInfo counts
-		status = NvAPI_DISP_GetDisplayConfig(&pathCount, pathInfo);
+		status = NvApiCall(NVAPI_CALL_DISP_GET_DISPLAY_CONFIG, NvAPI_DISP_GetDisplayConfig, &pathCount, pathInfo);
 		if (status != NVAPI_OK)
 		{
 			return status;
@@ -586,7 +812,7 @@ namespace ControlPanel
 		}
 
 		// Retrieve the full path info
-		status = NvAPI_DISP_GetDisplayConfig(&pathCount, pathInfo);
+		status = NvApiCall(NVAPI_CALL_DISP_GET_DISPLAY_CONFIG, NvAPI_DISP_GetDisplayConfig, &pathCount, pathInfo);
 		if (status != NVAPI_OK)
 		{
 			return status;
@@ -630,7 +856,7 @@ namespace ControlPanel
 
 		for (NvU32 GpuIndex = 0; GpuIndex < physicalGpuCount; GpuIndex++)
 		{
-			status = NvAPI_GPU_GetConnectedDisplayIds(hPhysicalGpu[GpuIndex], pDisplayIds, &nDisplayIds, 0);
+			status = NvApiCall(NVAPI_CALL_GPU_GET_CONNECTED_DISPLAY_IDS, NvAPI_GPU_GetConnectedDisplayIds, hPhysicalGpu[GpuIndex], pDisplayIds, &nDisplayIds, 0);
 			if ((status == NVAPI_OK) && nDisplayIds)
 			{
 				DisplayGpuIndex = GpuIndex;
@@ -639,7 +865,7 @@ namespace ControlPanel
 				{
 					memset(pDisplayIds, 0, nDisplayIds * sizeof(NV_GPU_DISPLAYIDS));
 					pDisplayIds[GpuIndex].version = NV_GPU_DISPLAYIDS_VER;
-					status = NvAPI_GPU_GetConnectedDisplayIds(hPhysicalGpu[DisplayGpuIndex], pDisplayIds, &nDisplayIds, 0);
+					status = NvApiCall(NVAPI_CALL_GPU_GET_CONNECTED_DISPLAY_IDS, NvAPI_GPU_GetConnectedDisplayIds, hPhysicalGpu[DisplayGpuIndex], pDisplayIds, &nDisplayIds, 0);
 					for (NvU32 DisplayIdIndex = 0; DisplayIdIndex < nDisplayIds; DisplayIdIndex++)
 					{
 						printf("%2d\t\t0x%x\t0x%x", GpuIndex, hPhysicalGpu[DisplayGpuIndex], pDisplayIds[DisplayIdIndex].displayId);
@@ -692,237 +918,807 @@ namespace ControlPanel
 		return status;
 	}
 
-	NvAPI_Status ShowCurrentTemperature()
+	/*
+	Prints samples as the sampler delivers them, one line per GPU and metric.
+	*/
+	class TelemetryPrinter : public TelemetrySubscriber
 	{
-		NvAPI_Status status;
-
-		NvPhysicalGpuHandle gpuHandles[NVAPI_MAX_PHYSICAL_GPUS] = { 0 };
-		NvU32 gpuCount = 0;
-		status = GetGPUs(gpuHandles, gpuCount);
-		if (status != NVAPI_OK)
+	public:
+		void OnSamples(const TelemetrySample *samples, NvU32 count)
 		{
-			return status;
-		}
-		
-		while (!(GetKeyState(VK_RETURN) & 0x8000))
-		{
-			for (NvU32 gpuIndex = 0; gpuIndex < gpuCount; gpuIndex++)
+			for (NvU32 i = 0; i < count; i++)
 			{
-				NV_GPU_THERMAL_SETTINGS thermalSettings;
-				memset(&thermalSettings, 0, sizeof(NV_GPU_THERMAL_SETTINGS));
-				thermalSettings.version = NV_GPU_THERMAL_SETTINGS_VER;
-
-				status = NvAPI_GPU_GetThermalSettings(gpuHandles[gpuIndex], gpuIndex, &thermalSettings);
-				if (status != NVAPI_OK)
+				const TelemetrySample &sample = samples[i];
+				switch (sample.metric)
 				{
-					return status;
-				}
+				case TELEMETRY_TEMPERATURE:
+					printf("GPU %u: Current temperature in sensor %u: %d\n", sample.gpu, sample.channel + 1, (int)sample.value);
+					break;
 
-				for (NvU32 thermalIndex = 0; thermalIndex < NVAPI_MAX_THERMAL_SENSORS_PER_GPU; thermalIndex++)
-				{
-					if (thermalSettings.sensor[thermalIndex].currentTemp == 0) // unused sensor
-						continue;
+				case TELEMETRY_TACH:
+					printf("GPU %u: Fan rotation: %d (rpm)\n", sample.gpu, (int)sample.value);
+					break;
 
-					printf("Current temperature in sensor %d: %d\n", thermalIndex + 1, thermalSettings.sensor[thermalIndex].currentTemp);
-				}
-			}
-		}
+				case TELEMETRY_CLOCKS:
+				case TELEMETRY_BASE_CLOCKS:
+				case TELEMETRY_BOOST_CLOCKS:
+					printf("GPU %u: %s frequency of %s domain: %d (MHz)\n", sample.gpu,
+						sample.metric == TELEMETRY_CLOCKS ? "Current" : (sample.metric == TELEMETRY_BASE_CLOCKS ? "Base" : "Boost"),
+						TelemetryChannelName((TelemetryMetric)sample.metric, sample.channel), (int)(sample.value / 1000));
+					break;
 
-		return status;
-	}
+				case TELEMETRY_PSTATE:
+					printf("GPU %u: Performance state P%d\n", sample.gpu, (int)sample.value);
+					break;
 
-	NvAPI_Status ColorControl(NV_COLOR_CMD command, NV_COLOR_DATA *data = NULL)
-	{
-		NvAPI_Status status;
+				case TELEMETRY_UTILIZATION:
+					printf("GPU %u: Utilization of %s: %d%%\n", sample.gpu, TelemetryChannelName(TELEMETRY_UTILIZATION, sample.channel), (int)sample.value);
+					break;
 
-		NV_GPU_DISPLAYIDS *displayIDs = NULL;
-		NvU32 displayIDCount = 0;
+				case TELEMETRY_MEMORY:
+					printf("GPU %u: %s dedicated memory: %d (Mb)\n", sample.gpu, sample.channel == 0 ? "Total" : "Available", (int)(sample.value / 1024));
+					break;
 
-		NvPhysicalGpuHandle gpuHandlers[NVAPI_MAX_PHYSICAL_GPUS] = { 0 };
-		NvU32 gpuCount = 0;
+				case TELEMETRY_THROTTLE:
+					// Printed as edges by TelemetryThrottlePrinter
+					break;
 
-		status = GetGPUs(gpuHandlers, gpuCount);
-		if (status != NVAPI_OK)
+				case TELEMETRY_ECC:
+					// Printed as deltas by TelemetryEccPrinter
+					break;
+				}
+			}
+		}
+	};
+
+	/*
+	Prints alerts as they are raised and cleared, with the rule that fired.
+	*/
+	class TelemetryAlertPrinter : public TelemetryAlertSink
+	{
+	public:
+		void OnAlert(const TelemetryAlertRule &rule, const TelemetryAlertEvent &event)
 		{
-			return status;
+			TelemetrySample sample;
+			SetTelemetrySeries(sample, event.series);
+			const char *channelName = TelemetryChannelName((TelemetryMetric)sample.metric, sample.channel);
+			char channel[16];
+			snprintf(channel, sizeof(channel), "%u", sample.channel);
+
+			char earlier[48] = "";
+			if (rule.kind == TELEMETRY_ALERT_RISE || rule.kind == TELEMETRY_ALERT_FALL)
+				snprintf(earlier, sizeof(earlier), " (%g %u ms before)", event.reference, rule.windowMs);
+
+			printf("GPU %u: Alert %s, %s %s is %g%s [%s]\n", sample.gpu, event.raised ? "raised" : "cleared",
+				TelemetryMetricName((TelemetryMetric)sample.metric), channelName != NULL ? channelName : channel, event.value, earlier, rule.text.c_str());
 		}
+	};
 
-		for (NvU32 i = 0; i < gpuCount; i++)
+	/*
+	Prints each throttle reason as it starts and stops, then how long each
+	held on every GPU.
+	*/
+	class TelemetryThrottlePrinter : public TelemetryThrottleSink
+	{
+	public:
+		void OnThrottle(const TelemetryThrottleEvent *events, NvU32 count)
 		{
-			status = GetConnectedDisplays(gpuHandlers[i], &displayIDs, displayIDCount);
-			if (status != NVAPI_OK)
+			for (NvU32 i = 0; i < count; i++)
 			{
-				return status;
+				if (events[i].window == 0)
+					printf("GPU %u: Slowed down for %s\n", events[i].gpu, TelemetryThrottleReasonName(events[i].reason));
+				else
+					printf("GPU %u: %s slowdown %s, within the last %u ms\n", events[i].gpu, TelemetryThrottleReasonName(events[i].reason),
+						events[i].set ? "started" : "ended", (events[i].window + 999) / 1000);
 			}
+		}
 
-			NV_COLOR_DATA colorData;
-			memset(&colorData, 0, sizeof(NV_COLOR_DATA));
-			colorData.version = NV_COLOR_DATA_VER;
-			colorData.size = sizeof(NV_COLOR_DATA);
-			colorData.cmd = NV_COLOR_CMD_GET;
-
-			for (NvU32 j = 0; j < displayIDCount; j++)
+		static void PrintSummary(const TelemetryThrottleTracker &tracker)
+		{
+			for (NvU32 gpu = 0; gpu < tracker.GpuCount(); gpu++)
 			{
-				status = NvAPI_Disp_ColorControl(displayIDs[j].displayId, data ? data : &colorData);
-				if (status != NVAPI_OK)
+				NvU64 observed = tracker.ObservedMicroseconds(gpu);
+				for (NvU32 reason = 0; reason < TELEMETRY_THROTTLE_REASONS; reason++)
 				{
-					int a = 0;
+					if (tracker.Episodes(gpu, reason) == 0)
+						continue;
+
+					NvU64 throttled = tracker.ThrottledMicroseconds(gpu, reason);
+					printf("GPU %u: %s slowdown for %.1f s in %u episodes, %.1f%% of %.1f s\n", gpu, TelemetryThrottleReasonName(reason),
+						throttled / 1000000.0, tracker.Episodes(gpu, reason), observed ? throttled * 100.0 / observed : 0.0, observed / 1000000.0);
 				}
 			}
 		}
+	};
 
-		return status;
-	}
+	/*
+	Prints the errors each ECC counter gained, as the monitor sees them:
 
-	NvAPI_Status ShowPerformanceStates()
+	    GPU 0: 2 single-bit ECC errors within the last 1000 ms, 7 since boot
+	*/
+	class TelemetryEccPrinter : public TelemetryEccSink
 	{
-		NvAPI_Status status;
-
-		NvPhysicalGpuHandle gpuHandles[NVAPI_MAX_PHYSICAL_GPUS] = { 0 };
-		NvU32 gpuCount = 0;
-
-		status = GetGPUs(gpuHandles, gpuCount);
-		if (status != NVAPI_OK)
+	public:
+		void OnEcc(const TelemetryEccEvent *events, NvU32 count)
 		{
-			return status;
+			for (NvU32 i = 0; i < count; i++)
+			{
+				const TelemetryEccEvent &event = events[i];
+				bool aggregate = event.counter == TELEMETRY_ECC_AGGREGATE_SINGLE_BIT || event.counter == TELEMETRY_ECC_AGGREGATE_DOUBLE_BIT;
+				bool doubleBit = event.counter == TELEMETRY_ECC_DOUBLE_BIT || event.counter == TELEMETRY_ECC_AGGREGATE_DOUBLE_BIT;
+				if (event.reset)
+					printf("GPU %u: %s%s ECC counter was reset, now %llu\n", event.gpu, aggregate ? "Aggregate " : "", doubleBit ? "double-bit" : "single-bit", event.total);
+				else if (!aggregate)
+					printf("GPU %u: %llu %s ECC errors within the last %u ms, %llu since boot\n", event.gpu, event.errors, doubleBit ? "double-bit" : "single-bit",
+						(event.window + 999) / 1000, event.total);
+			}
 		}
 
-		for (NvU32 gpuIndex = 0; gpuIndex < gpuCount; gpuIndex++)
+		static void PrintSummary(const TelemetryEccMonitor &monitor)
 		{
-			NV_GPU_PERF_PSTATES20_INFO pState20Info;
-			pState20Info.version = NV_GPU_PERF_PSTATES20_INFO_VER;
-
-			status = NvAPI_GPU_GetPstates20(gpuHandles[gpuIndex], &pState20Info);
-			if (status != NVAPI_OK)
+			bool reporting = false;
+			for (NvU32 gpu = 0; gpu < monitor.GpuCount(); gpu++)
 			{
-				return status;
-			}
+				if (!monitor.Reporting(gpu))
+					continue;
 
-			NV_GPU_PERF_PSTATE_ID currentPState;
-			status = NvAPI_GPU_GetCurrentPstate(gpuHandles[gpuIndex], &currentPState);
-			if (status != NVAPI_OK)
-			{
-				return status;
+				reporting = true;
+				printf("GPU %u: ECC errors since boot %llu single-bit, %llu double-bit (+%llu, +%llu while monitored); aggregate %llu, %llu\n", gpu,
+					monitor.Counter(gpu, TELEMETRY_ECC_SINGLE_BIT), monitor.Counter(gpu, TELEMETRY_ECC_DOUBLE_BIT),
+					monitor.Gained(gpu, TELEMETRY_ECC_SINGLE_BIT), monitor.Gained(gpu, TELEMETRY_ECC_DOUBLE_BIT),
+					monitor.Counter(gpu, TELEMETRY_ECC_AGGREGATE_SINGLE_BIT), monitor.Counter(gpu, TELEMETRY_ECC_AGGREGATE_DOUBLE_BIT));
 			}
+			if (!reporting)
+				printf("No GPU has ECC enabled\n");
+		}
+	};
 
-			printf("Performance |");
-			for (NvU32 i = 0; i < currentPState; i++)
-				printf("=");
-			for (NvU32 i = 0; i < NV_GPU_PERF_PSTATE_ID::NVAPI_GPU_PERF_PSTATE_P15 - currentPState; i++)
-				printf("-");
-			printf("| Quality\n");
+	/*
+	Writes throttle edges to an open file, in the TelemetryThrottleWriter format.
+	*/
+	class TelemetryThrottleLog : public TelemetryThrottleSink
+	{
+	public:
+		explicit TelemetryThrottleLog(FILE *file)
+			: buffer(file, 1 << 16)
+			, writer(buffer)
+		{
 		}
 
-		return status;
-	}
+		void OnThrottle(const TelemetryThrottleEvent *events, NvU32 count) { writer.OnThrottle(events, count); }
 
-	NvAPI_Status ShowClockFrequencies()
-	{
-		NvAPI_Status status;
+		bool Close() { return buffer.Flush(); }
 
-		NvPhysicalGpuHandle gpuHandles[NVAPI_MAX_PHYSICAL_GPUS] = { 0 };
-		NvU32 gpuCount = 0;
+		unsigned long long EventCount() const { return writer.EventCount(); }
+		unsigned long long BytesWritten() const { return buffer.BytesWritten(); }
 
-		status = GetGPUs(gpuHandles, gpuCount);
-		if (status != NVAPI_OK)
-		{
-			return status;
-		}
+	private:
+		BufferedWriter buffer;
+		TelemetryThrottleWriter writer;
+	};
 
-		for (NvU32 gpuIndex = 0; gpuIndex < gpuCount; gpuIndex++)
+	/*
+	Prints every closed utilization window: mean, percentiles and the share of
+	the window spent in each 10% band, with the size of its encoded report.
+	*/
+	class TelemetryUtilizationPrinter : public TelemetryUtilizationSink
+	{
+	public:
+		void OnUtilization(NvU64 windowMicroseconds, const TelemetryUtilizationWindow *windows, NvU32 count)
 		{
-			NV_GPU_CLOCK_FREQUENCIES clocks;
-			memset(&clocks, 0, sizeof(NV_GPU_CLOCK_FREQUENCIES));
-			clocks.version = NV_GPU_CLOCK_FREQUENCIES_VER;
-
-			status = NvAPI_GPU_GetAllClockFrequencies(gpuHandles[gpuIndex], &clocks);
-			if (status != NVAPI_OK)
+			const char LEVELS[] = " .:-=+*#%@";
+			for (NvU32 i = 0; i < count; i++)
 			{
-				return status;
+				const TelemetryUtilizationWindow &window = windows[i];
+				NvU32 bands[TELEMETRY_UTILIZATION_BANDS] = { 0 };
+				for (NvU32 p = 0; p <= 100; p++)
+					bands[p < 100 ? p / 10 : TELEMETRY_UTILIZATION_BANDS - 1] += window.percent[p];
+
+				char histogram[TELEMETRY_UTILIZATION_BANDS + 1];
+				for (NvU32 b = 0; b < TELEMETRY_UTILIZATION_BANDS; b++)
+					histogram[b] = LEVELS[(bands[b] * 9 + window.count / 2) / window.count];
+				histogram[TELEMETRY_UTILIZATION_BANDS] = 0;
+
+				const char *domain = TelemetryChannelName(TELEMETRY_UTILIZATION, window.domain);
+				printf("GPU %u: %s load over %llu s: mean %.1f%%, median %u%%, p90 %u%%, max %u%% |%s|\n", window.gpu,
+					domain != NULL ? domain : "other", windowMicroseconds / 1000000, window.Mean(), window.Percentile(0.5),
+					window.Percentile(0.9), window.Maximum(), histogram);
 			}
 
-			while (!(GetKeyState(VK_RETURN) & 0x8000))
-			{
-				NvU32 domainCount = 0;
-				for (NvU32 i = 0; i < NVAPI_MAX_GPU_PUBLIC_CLOCKS; i++)
-				{
-					if (!clocks.domain[i].bIsPresent)
-						continue;
+			report.clear();
+			EncodeTelemetryUtilization(windowMicroseconds, windows, count, report);
+			printf("%u domains, report of %u bytes\n", count, (NvU32)report.size());
+		}
 
-					domainCount++;
-					printf("Frequency of domain %d: %d (MHz)\n", domainCount, clocks.domain[i].frequency / 1000);
-				}
+	private:
+		std::vector<NvU8> report;
+	};
+
+	/*
+	Records into the raw store of a directory and, next to it, into its 1 m
+	and 1 h rollups. Raw segments roll every hour and the open one is
+	checkpointed every 10 s, so --history run alongside sees all but the last
+	few seconds.
+	*/
+	class TelemetryRecorder : public TelemetrySubscriber
+	{
+	public:
+		explicit TelemetryRecorder(const char *directory)
+			: store(directory, "raw", TELEMETRY_LIVE_SEGMENT_MICROSECONDS)
+			, rollups(directory)
+		{
+			store.SetCheckpointInterval(TELEMETRY_LIVE_CHECKPOINT_MICROSECONDS);
+			engine.Subscribe(&rollups);
+		}
 
-				printf("\n");
-				Sleep(1000);
-			}
+		void OnSamples(const TelemetrySample *samples, NvU32 count)
+		{
+			store.OnSamples(samples, count);
+			engine.OnSamples(samples, count);
 		}
 
-		return status;
-	}
+		// Closes the open windows too, so call it once, at the end of the recording
+		bool Seal()
+		{
+			engine.Flush();
+			bool sealed = store.Seal();
+			return rollups.Seal() && sealed;
+		}
 
-	NvAPI_Status ShowCoolerSettings()
+		const TelemetryStoreWriter &Store() const { return store; }
+		const TelemetryRollupWriter &Rollups() const { return rollups; }
+
+	private:
+		TelemetryStoreWriter store;
+		TelemetryRollupWriter rollups;
+		TelemetryRollupEngine engine;
+	};
+
+	/*
+	Forwards every batch to each subscriber in turn, so the consumers in
+	MonitorTelemetry subscribe once whether the sampler, the frames or a
+	replay produces the samples.
+	*/
+	class TelemetryFanout : public TelemetrySubscriber
 	{
-		NvAPI_Status status;
-
-		NvPhysicalGpuHandle gpuHandles[NVAPI_MAX_PHYSICAL_GPUS] = { 0 };
-		NvU32 gpuCount = 0;
+	public:
+		void Subscribe(TelemetrySubscriber *subscriber) { subscribers.push_back(subscriber); }
 
-		status = GetGPUs(gpuHandles, gpuCount);
-		if (status != NVAPI_OK)
+		void OnSamples(const TelemetrySample *samples, NvU32 count)
 		{
-			return status;
+			for (size_t i = 0; i < subscribers.size(); i++)
+				subscribers[i]->OnSamples(samples, count);
 		}
 
-		while (!(GetKeyState(VK_RETURN) & 0x8000))
-		{
-			for (NvU32 gpuIndex = 0; gpuIndex < gpuCount; gpuIndex++)
-			{
-				NvU32 rpm = 0;
-				status = NvAPI_GPU_GetTachReading(gpuHandles[gpuIndex], &rpm);
-				if (status != NVAPI_OK)
-				{
-					return status;
-				}
+	private:
+		std::vector<TelemetrySubscriber *> subscribers;
+	};
 
-				printf("GPU's Fan rotation: %d (rpm)\n", rpm);
-			}
+	/*
+	What MonitorTelemetry does besides printing every sample it reads; the
+	defaults print them all, at each metric's default period
+	*/
+	struct MonitorOptions
+	{
+		MonitorOptions()
+			: changesOnly(false)
+			, capture(NULL)
+			, frameHz(0)
+			, firstCore(-1)
+			, exporter(NULL)
+			, adaptive(false)
+			, alerts(NULL)
+			, load(NULL)
+			, throttleLog(NULL)
+			, trace(NULL)
+			, replay(NULL)
+			, replaySpeed(1.0)
+		{
 		}
 
-		return status;
-	}
-
-	NvAPI_Status RestoreAllDefaults()
+		bool changesOnly;                       // print a sample only when it differs from the previous one of its series
+		TelemetrySubscriber *capture;           // receives what the console receives, on its own thread
+		NvU32 frameHz;                          // non-zero: every GPU on its own worker, in aligned frames at this rate
+		int firstCore;                          // frame worker i pinned to core firstCore + i, unless negative
+		TelemetryExporter *exporter;            // serves the latest samples over HTTP
+		bool adaptive;                          // temperature, tach and current clocks read faster while they move
+		TelemetryAlertEngine *alerts;           // sees every sample, even with changesOnly; alerts print as they change
+		TelemetryUtilizationHistograms *load;   // sees every sample; windows print as they close
+		TelemetryThrottleSink *throttleLog;     // the throttle edges, when throttle is among the metrics
+		TelemetrySubscriber *trace;             // every sample read, even with changesOnly
+		TelemetryTraceReader *replay;           // samples from this trace instead of the driver
+		double replaySpeed;                     // of the replay against the recorded pace, 0 as fast as possible
+	};
+
+	/*
+	Samples the metrics on every GPU at their default periods until Enter is
+	pressed, feeding the console and each consumer the options name. The
+	throttle tracker runs whenever throttle is among the metrics, printing
+	reasons as they start and stop, and ECC counters are always read
+	adaptively, printing only the errors they gain.
+
+	Given a replay, the samples come from that trace instead of the driver,
+	and the function returns at its end; metrics, frameHz, firstCore and
+	adaptive then do not apply.
+	*/
+	NvAPI_Status MonitorTelemetry(const TelemetryMetric *metrics, NvU32 metricCount, const MonitorOptions &options = MonitorOptions())
 	{
 		NvAPI_Status status;
 
-		NvDRSSessionHandle session = NULL;
-		status = NvAPI_DRS_CreateSession(&session);
+		NvApiTelemetrySource source;
+		status = options.replay == NULL ? source.Open() : NVAPI_OK;
 		if (status != NVAPI_OK)
 		{
 			return status;
 		}
+		NvU32 gpuCount = options.replay != NULL ? options.replay->GpuCount() : source.GpuCount();
 
-		status = NvAPI_DRS_RestoreAllDefaults(session);
-		if (status != NVAPI_OK)
+		TelemetrySampler sampler(source);
+		TelemetryFrameSampler frames(source, options.frameHz);
+		for (NvU32 i = 0; options.replay == NULL && i < metricCount; i++)
 		{
-			return status;
+			if (options.frameHz > 0)
+				frames.Schedule(metrics[i], DefaultTelemetryPeriodMs(metrics[i]));
+			else if ((options.adaptive || metrics[i] == TELEMETRY_ECC) && IsTelemetryAdaptive(metrics[i]))
+				sampler.ScheduleAllAdaptive(metrics[i], DefaultTelemetryAdaptiveConfig(metrics[i]));
+			else
+				sampler.ScheduleAll(metrics[i], DefaultTelemetryPeriodMs(metrics[i]));
 		}
-
-		status = NvAPI_DRS_SaveSettings(session);
-		if (status != NVAPI_OK)
+		if (options.firstCore >= 0)
+			frames.PinWorkers((NvU32)options.firstCore);
+
+		// printf runs on the drain thread, so a slow console never delays a read
+		TelemetryPrinter printer;
+		TelemetryDrain console(printer);
+		TelemetryDrain captureDrain(options.capture != NULL ? *options.capture : printer);
+		TelemetryDrain exportDrain(options.exporter != NULL ? (TelemetrySubscriber &)*options.exporter : printer);
+		TelemetryDrain traceDrain(options.trace != NULL ? *options.trace : printer);
+		if (options.exporter != NULL && !options.exporter->Start(gpuCount))
 		{
+			printf("Cannot serve metrics on port %u\n", options.exporter->Port());
+			return NVAPI_ERROR;
+		}
+		if (options.exporter != NULL)
+			printf("Serving OpenMetrics on port %u, at /metrics\n", options.exporter->Port());
+
+		// Every consumer below is fed by the sampler, the frames or the replay through one fanout
+		TelemetryFanout feed;
+
+		// Rules are evaluated on their own thread, and need the steady values --changes leaves out
+		TelemetryAlertPrinter alertPrinter;
+		TelemetryDrain alertDrain(options.alerts != NULL ? (TelemetrySubscriber &)*options.alerts : printer);
+		if (options.alerts != NULL)
+		{
+			options.alerts->Subscribe(&alertPrinter);
+			feed.Subscribe(&alertDrain);
+		}
+
+		// Histograms need every sample too; windows close and print on their own thread
+		TelemetryUtilizationPrinter loadPrinter;
+		TelemetryDrain loadDrain(options.load != NULL ? (TelemetrySubscriber &)*options.load : printer);
+		if (options.load != NULL)
+		{
+			options.load->Subscribe(&loadPrinter);
+			feed.Subscribe(&loadDrain);
+		}
+
+		// Throttle reasons are printed and logged as edges, from every sample
+		bool throttle = false;
+		for (NvU32 i = 0; i < metricCount; i++)
+			throttle = throttle || metrics[i] == TELEMETRY_THROTTLE;
+		TelemetryThrottleTracker throttleTracker;
+		TelemetryThrottlePrinter throttlePrinter;
+		TelemetryDrain throttleDrain(throttleTracker);
+		if (throttle)
+		{
+			throttleTracker.Subscribe(&throttlePrinter);
+			if (options.throttleLog != NULL)
+				throttleTracker.Subscribe(options.throttleLog);
+			feed.Subscribe(&throttleDrain);
+		}
+
+		// ECC counters likewise, as the errors they gain
+		bool ecc = false;
+		for (NvU32 i = 0; i < metricCount; i++)
+			ecc = ecc || metrics[i] == TELEMETRY_ECC;
+		TelemetryEccMonitor eccMonitor;
+		TelemetryEccPrinter eccPrinter;
+		TelemetryDrain eccDrain(eccMonitor);
+		if (ecc)
+		{
+			eccMonitor.Subscribe(&eccPrinter);
+			feed.Subscribe(&eccDrain);
+		}
+
+		TelemetryDeltaFilter changes;
+		TelemetrySubscriber *outputs[] = { &console, options.capture != NULL ? &captureDrain : NULL, options.exporter != NULL ? &exportDrain : NULL };
+		for (int i = 0; i < 3; i++)
+		{
+			if (outputs[i] == NULL)
+				continue;
+
+			if (options.changesOnly)
+				changes.Subscribe(outputs[i]);
+			else
+				feed.Subscribe(outputs[i]);
+		}
+		if (options.changesOnly)
+			feed.Subscribe(&changes);
+
+		// The trace keeps every sample, changed or not
+		if (options.trace != NULL)
+			feed.Subscribe(&traceDrain);
+
+		TelemetryTraceReader noTrace;
+		TelemetryTraceReplay replayer(options.replay != NULL ? *options.replay : noTrace);
+		if (options.replay != NULL)
+			replayer.Subscribe(&feed);
+		else if (options.frameHz > 0)
+			frames.Subscribe(&feed);
+		else
+			sampler.Subscribe(&feed);
+
+		if (options.capture != NULL)
+			captureDrain.Start();
+		if (options.exporter != NULL)
+			exportDrain.Start();
+		if (options.alerts != NULL)
+			alertDrain.Start();
+		if (options.load != NULL)
+			loadDrain.Start();
+		if (throttle)
+			throttleDrain.Start();
+		if (ecc)
+			eccDrain.Start();
+		if (options.trace != NULL)
+			traceDrain.Start();
+
+		console.Start();
+		if (options.replay == NULL && options.frameHz > 0)
+			frames.Start();
+		else if (options.replay == NULL)
+			sampler.Start();
+
+		// Blocks in the console until a line is entered, or replays the whole trace; the sampler threads do the work
+		NvU64 started = TelemetryNow();
+		if (options.replay != NULL)
+			replayer.Run(options.replaySpeed);
+		else
+			getchar();
+		NvU64 elapsedMs = (TelemetryNow() - started) / 1000;
+		sampler.Stop();
+		frames.Stop();
+		console.Stop();
+		captureDrain.Stop();
+		exportDrain.Stop();
+		alertDrain.Stop();
+		loadDrain.Stop();
+		throttleDrain.Stop();
+		eccDrain.Stop();
+		traceDrain.Stop();
+		if (options.exporter != NULL)
+		{
+			options.exporter->Stop();
+			printf("%llu scrapes served, %llu renders\n", options.exporter->Stats().scrapes, options.exporter->Stats().renders);
+		}
+
+		if (throttle)
+		{
+			TelemetryThrottlePrinter::PrintSummary(throttleTracker);
+			printf("%llu throttle reads, %llu edges\n", throttleTracker.ReadCount(), throttleTracker.EventCount());
+		}
+		if (ecc)
+		{
+			TelemetryEccPrinter::PrintSummary(eccMonitor);
+			printf("%llu ECC reads, %llu counter changes\n", eccMonitor.ReadCount(), eccMonitor.EventCount());
+		}
+		if (options.alerts != NULL)
+			printf("%llu alerts raised, %llu cleared over %u series\n", options.alerts->RaisedCount(), options.alerts->ClearedCount(), options.alerts->SeriesCount());
+		if (options.changesOnly)
+			printf("%llu samples read, %llu changes\n", changes.SeenCount(), changes.ChangedCount());
+		if (console.Dropped() + captureDrain.Dropped() > 0)
+			printf("%llu samples dropped by the console, %llu by the capture\n", console.Dropped(), captureDrain.Dropped());
+		if (traceDrain.Dropped() > 0)
+			printf("%llu samples dropped by the trace\n", traceDrain.Dropped());
+
+		if (options.replay != NULL)
+		{
+			const TelemetryReplayStats &stats = replayer.Stats();
+			printf("%llu samples in %llu ticks replayed in %.3f s, %.0f samples/s", stats.samples, stats.ticks, stats.elapsedMicroseconds / 1000000.0,
+				stats.elapsedMicroseconds ? stats.samples * 1000000.0 / stats.elapsedMicroseconds : 0.0);
+			if (options.replaySpeed > 0.0)
+				printf(", at most %.1f ms behind the %gx pace", stats.maxLateMicroseconds / 1000.0, options.replaySpeed);
+			printf("\n");
+			return NVAPI_OK;
+		}
+
+		for (NvU32 i = 0; options.frameHz == 0 && i < metricCount; i++)
+		{
+			if (!(options.adaptive || metrics[i] == TELEMETRY_ECC) || !IsTelemetryAdaptive(metrics[i]))
+				continue;
+
+			NvU32 periodMs = DefaultTelemetryPeriodMs(metrics[i]);
+			printf("%s: %llu driver reads, %llu at a fixed %u ms\n", TelemetryMetricName(metrics[i]), sampler.Stats(metrics[i]).reads,
+				elapsedMs / periodMs * source.GpuCount(), periodMs);
+		}
+
+		if (options.frameHz == 0)
+			return sampler.LastError();
+
+		const TelemetryFrameStats &stats = frames.Stats();
+		printf("%llu frames, %llu incomplete, skew across GPUs %.1f us mean %llu us max\n", stats.frames, stats.incompleteFrames,
+			stats.frames ? (double)stats.totalSkewMicroseconds / stats.frames : 0.0, stats.maxSkewMicroseconds);
+		if (stats.missedTicks > 0)
+			printf("%llu ticks missed while frames were being delivered\n", stats.missedTicks);
+		return frames.LastError();
+	}
+
+	NvAPI_Status ShowCurrentTemperature(TelemetrySubscriber *trace = NULL)
+	{
+		const TelemetryMetric metric = TELEMETRY_TEMPERATURE;
+		MonitorOptions options;
+		options.trace = trace;
+		return MonitorTelemetry(&metric, 1, options);
+	}
+
+	NvAPI_Status ColorControl(NV_COLOR_CMD command, NV_COLOR_DATA *data = NULL)
+	{
+		NvAPI_Status status;
+
+		NV_GPU_DISPLAYIDS *displayIDs = NULL;
+		NvU32 displayIDCount = 0;
+
+		NvPhysicalGpuHandle gpuHandlers[NVAPI_MAX_PHYSICAL_GPUS] = { 0 };
+		NvU32 gpuCount = 0;
+
+		status = GetGPUs(gpuHandlers, gpuCount);
+		if (status != NVAPI_OK)
+		{
+			return status;
+		}
+
+		for (NvU32 i = 0; i < gpuCount; i++)
+		{
+			status = GetConnectedDisplays(gpuHandlers[i], &displayIDs, displayIDCount);
+			if (status != NVAPI_OK)
+			{
+				return status;
+			}
+
+			NV_COLOR_DATA colorData;
+			memset(&colorData, 0, sizeof(NV_COLOR_DATA));
+			colorData.version = NV_COLOR_DATA_VER;
+			colorData.size = sizeof(NV_COLOR_DATA);
+			colorData.cmd = NV_COLOR_CMD_GET;
+
+			for (NvU32 j = 0; j < displayIDCount; j++)
+			{
+				status = NvApiCall(NVAPI_CALL_DISP_COLOR_CONTROL, NvAPI_Disp_ColorControl, displayIDs[j].displayId, data ? data : &colorData);
+				if (status != NVAPI_OK)
+				{
+					int a = 0;
+				}
+			}
+		}
+
+		return status;
+	}
+
+	// "P2 |=============--| graphics 1500 MHz": further right is lower performance, as in the driver's numbering
+	void FormatPstate(char *text, size_t size, NV_GPU_PERF_PSTATE_ID id, const PstateEntry *entry)
+	{
+		char bar[NVAPI_MAX_GPU_PERF_PSTATES + 1];
+		for (NvU32 i = 0; i < NVAPI_MAX_GPU_PERF_PSTATES - 1; i++)
+			bar[i] = i < (NvU32)id ? '=' : '-';
+		bar[NVAPI_MAX_GPU_PERF_PSTATES - 1] = 0;
+
+		// The graphics clock the P-state runs at, from the cached tables
+		const PstateClock *graphics = NULL;
+		for (NvU32 i = 0; entry != NULL && i < entry->clockCount; i++)
+		{
+			if (entry->clocks[i].domain == NVAPI_GPU_PUBLIC_CLOCK_GRAPHICS)
+				graphics = &entry->clocks[i];
+		}
+
+		if (graphics == NULL)
+			snprintf(text, size, "P%-2d |%s|", (int)id, bar);
+		else if (graphics->minKHz == graphics->maxKHz)
+			snprintf(text, size, "P%-2d |%s| graphics %u MHz", (int)id, bar, graphics->maxKHz / 1000);
+		else
+			snprintf(text, size, "P%-2d |%s| graphics %u-%u MHz", (int)id, bar, graphics->minKHz / 1000, graphics->maxKHz / 1000);
+	}
+
+	/*
+	The P-state tables of every GPU, then its current P-state: once, or
+	redrawn hz times a second for the given seconds. The tables are read once
+	and kept in a PstateCatalogue, so each redraw is one
+	NvAPI_GPU_GetCurrentPstate per GPU. The optional trace receives the
+	P-states of each redraw as one tick of pstate samples.
+	*/
+	NvAPI_Status ShowPerformanceStates(NvU32 hz = 0, NvU32 seconds = 10, TelemetrySubscriber *trace = NULL)
+	{
+		PstateCatalogue catalogue;
+		NvAPI_Status status = catalogue.Open();
+		if (status != NVAPI_OK)
+		{
+			PrintError(status);
 			return status;
 		}
 
-		NvAPI_DRS_DestroySession(session);
-		session = NULL;
+		for (NvU32 gpu = 0; gpu < catalogue.GpuCount(); gpu++)
+		{
+			for (NvU32 i = 0; i < catalogue.EntryCount(gpu); i++)
+			{
+				const PstateEntry &entry = catalogue.Entry(gpu, i);
+				printf("GPU %u: P%d%s", gpu, (int)entry.id, entry.editable ? " (editable)" : "");
+				for (NvU32 c = 0; c < entry.clockCount; c++)
+				{
+					const PstateClock &clock = entry.clocks[c];
+					printf(c == 0 ? " " : ", ");
+					if (clock.minKHz == clock.maxKHz)
+						printf("%s %u MHz", TelemetryChannelName(TELEMETRY_CLOCKS, clock.domain), clock.maxKHz / 1000);
+					else
+						printf("%s %u-%u MHz", TelemetryChannelName(TELEMETRY_CLOCKS, clock.domain), clock.minKHz / 1000, clock.maxKHz / 1000);
+					if (clock.deltaKHz != 0)
+						printf(" (%+d MHz)", clock.deltaKHz / 1000);
+				}
+				for (NvU32 v = 0; v < entry.voltageCount; v++)
+					printf(", %u mV", entry.baseVoltageMicrovolts[v] / 1000);
+				printf("\n");
+			}
+		}
+
+		NvU32 redraws = hz == 0 ? 1 : hz * seconds;
+		NvU64 interval = hz == 0 ? 0 : 1000000 / hz;
+		NvU64 due = TelemetryNow();
+		for (NvU32 redraw = 0; redraw < redraws; redraw++)
+		{
+			// Every GPU on one line, rewritten in place
+			char line[256] = "";
+			size_t used = 0;
+			TelemetrySample samples[NVAPI_MAX_PHYSICAL_GPUS];
+			NvU32 sampleCount = 0;
+			for (NvU32 gpu = 0; gpu < catalogue.GpuCount() && used < sizeof(line); gpu++)
+			{
+				NV_GPU_PERF_PSTATE_ID id;
+				const PstateEntry *entry;
+				NvU64 timestamp = TelemetryNow();
+				status = catalogue.Current(gpu, id, entry);
+				if (status != NVAPI_OK)
+				{
+					printf("\n");
+					PrintError(status);
+					return status;
+				}
+
+				TelemetrySample &sample = samples[sampleCount++];
+				memset(&sample, 0, sizeof(sample));
+				sample.timestamp = timestamp;
+				sample.value = id;
+				sample.gpu = (NvU16)gpu;
+				sample.metric = TELEMETRY_PSTATE;
+				sample.tick = redraw;
+
+				char pstate[96];
+				FormatPstate(pstate, sizeof(pstate), id, entry);
+				int written = snprintf(line + used, sizeof(line) - used, "%sGPU %u %s", gpu == 0 ? "" : "   ", gpu, pstate);
+				used += written > 0 ? (size_t)written : 0;
+			}
+			printf(hz == 0 ? "%s\n" : "\r%-79s", line);
+			fflush(stdout);
+			if (trace != NULL && sampleCount > 0)
+				trace->OnSamples(samples, sampleCount);
+
+			due += interval;
+			NvU64 now = TelemetryNow();
+			if (redraw + 1 < redraws && due > now)
+				Sleep((DWORD)((due - now) / 1000));
+		}
+
+		if (hz != 0)
+			printf("\n%u redraws, %llu P-state table reads\n", redraws, catalogue.TableReads());
+		return NVAPI_OK;
+	}
+
+	/*
+	Current, base and boost clocks of every present domain on every GPU,
+	printed and optionally captured only when they change; the optional
+	trace receives every read
+	*/
+	NvAPI_Status ShowClockFrequencies(const char *capturePath = NULL, TelemetrySubscriber *trace = NULL)
+	{
+		const TelemetryMetric metrics[] = { TELEMETRY_CLOCKS, TELEMETRY_BASE_CLOCKS, TELEMETRY_BOOST_CLOCKS };
+		const NvU32 metricCount = sizeof(metrics) / sizeof(metrics[0]);
+		MonitorOptions options;
+		options.changesOnly = true;
+		options.trace = trace;
+		if (capturePath == NULL)
+			return MonitorTelemetry(metrics, metricCount, options);
+
+		FILE *file = OpenFile(capturePath, "wb");
+		if (file == NULL)
+		{
+			printf("Cannot open %s\n", capturePath);
+			return NVAPI_ERROR;
+		}
 
+		NvAPI_Status status;
+		{
+			BufferedWriter writer(file);
+			TelemetryDeltaWriter deltas(writer);
+			options.capture = &deltas;
+			status = MonitorTelemetry(metrics, metricCount, options);
+			writer.Flush();
+			printf("%llu changes, %llu bytes written to %s\n", deltas.SampleCount(), writer.BytesWritten(), capturePath);
+		}
+
+		fclose(file);
 		return status;
 	}
+
+	NvAPI_Status ShowCoolerSettings(TelemetrySubscriber *trace = NULL)
+	{
+		const TelemetryMetric metric = TELEMETRY_TACH;
+		MonitorOptions options;
+		options.trace = trace;
+		return MonitorTelemetry(&metric, 1, options);
+	}
+
+	/*
+	Count, minimum, maximum, mean and percentiles of every series recorded in
+	the store during the last minutes, from the rollups where whole windows
+	fit and from the raw samples elsewhere.
+	*/
+	NvAPI_Status ShowTelemetryHistory(const char *directory, NvU32 minutes)
+	{
+		TelemetryStoreReader reader;
+		if (!reader.Open(directory))
+		{
+			printf("No telemetry recorded in %s\n", directory);
+			return NVAPI_ERROR;
+		}
+
+		TelemetryRollupReader rollups;
+		rollups.Open(directory);
+
+		NvU64 to = (NvU64)((NvS64)TelemetryNow() + TelemetryWallClockOffset());
+		NvU64 from = to - (NvU64)minutes * 60 * 1000000;
+		printf("%u segments (%u being written), %llu samples, %llu bytes; %llu 1m and %llu 1h rollups\n", (NvU32)reader.SegmentCount(),
+			(NvU32)reader.OpenSegmentCount(), reader.SampleCount(), reader.Bytes(), rollups.RecordCount(TELEMETRY_ROLLUP_1M), rollups.RecordCount(TELEMETRY_ROLLUP_1H));
+
+		std::vector<NvU32> series;
+		reader.Series(series);
+		for (size_t i = 0; i < series.size(); i++)
+		{
+			TelemetryRollup summary;
+			SummarizeTelemetry(rollups, &reader, series[i], from, to + 1, summary);
+			if (summary.count == 0)
+				continue;
+
+			TelemetrySample key;
+			SetTelemetrySeries(key, series[i]);
+			printf("GPU %u %s %u: %llu samples, min %lld, max %lld, mean %.1f, p50 %.0f, p99 %.0f\n", key.gpu,
+				TelemetryMetricName((TelemetryMetric)key.metric), key.channel, summary.count,
+				(long long)summary.minimum, (long long)summary.maximum, summary.Mean(), summary.Quantile(0.5), summary.Quantile(0.99));
+		}
+
+		if (reader.CorruptSegments() + rollups.CorruptSegments() > 0)
+			printf("%u segments skipped as damaged\n", reader.CorruptSegments() + rollups.CorruptSegments());
+		return NVAPI_OK;
+	}
+
+	NvAPI_Status RestoreAllDefaults()
+	{
+		DrsSession session;
+		session.StageRestoreAll();
+		return session.Commit();
+	}
 };
 
 
+// Set by --trace <file>: every sample the monitoring commands read is recorded to it
+static ControlPanel::TelemetryTraceWriter *telemetryTrace = NULL;
+
 namespace Examples
 {
 	void ReadGPUDriverInfo()
@@ -999,27 +1795,29 @@ namespace Examples
 		CheckStatus(status);
 	}
 
-	void ShowCurrentTemperature()
+	void ShowCurrentTemperature(int argc, char **argv)
 	{
-		NvAPI_Status status = ControlPanel::ShowCurrentTemperature();
+		NvAPI_Status status = ControlPanel::ShowCurrentTemperature(telemetryTrace);
 		CheckStatus(status);
 	}
 
-	void ShowPerformanceStates()
+	void ShowPerformanceStates(int argc, char **argv)
 	{
-		NvAPI_Status status = ControlPanel::ShowPerformanceStates();
+		NvU32 hz = argc > 0 ? (NvU32)atoi(argv[0]) : 0;
+		NvU32 seconds = argc > 1 ? (NvU32)atoi(argv[1]) : 10;
+		NvAPI_Status status = ControlPanel::ShowPerformanceStates(hz, seconds, telemetryTrace);
 		CheckStatus(status);
 	}
 
 	void ShowClockFrequencies()
 	{
-		NvAPI_Status status = ControlPanel::ShowClockFrequencies();
+		NvAPI_Status status = ControlPanel::ShowClockFrequencies(NULL, telemetryTrace);
 		CheckStatus(status);
 	}
 
-	void ShowCoolerSettings()
+	void ShowCoolerSettings(int argc, char **argv)
 	{
-		NvAPI_Status status = ControlPanel::ShowCoolerSettings();
+		NvAPI_Status status = ControlPanel::ShowCoolerSettings(telemetryTrace);
 		CheckStatus(status);
 	}
 
@@ -1028,19 +1826,684 @@ namespace Examples
 		NvAPI_Status status = ControlPanel::RestoreAllDefaults();
 		CheckStatus(status);
 	}
+
+	void DumpAllProfiles(int argc, char **argv)
+	{
+		ControlPanel::DrsDumpFormat format = ControlPanel::DRS_DUMP_JSONL;
+		if (argc > 0 && !ControlPanel::ParseDrsDumpFormat(argv[0], &format))
+		{
+			printf("Unknown dump format %s (expected jsonl, csv or bin)\n", argv[0]);
+			return;
+		}
+
+		NvAPI_Status status = ControlPanel::DumpAllProfiles(format, argc > 1 ? argv[1] : NULL);
+		CheckStatus(status);
+	}
+
+	void PlanDesiredState(int argc, char **argv)
+	{
+		if (argc < 1)
+		{
+			printf("Usage: --plan <desired-state file>\n");
+			return;
+		}
+
+		NvAPI_Status status = ControlPanel::ConvergeDesiredState(argv[0], false, false);
+		CheckStatus(status);
+	}
+
+	void ApplyDesiredState(int argc, char **argv)
+	{
+		if (argc < 1)
+		{
+			printf("Usage: --apply <desired-state file>\n");
+			return;
+		}
+
+		NvAPI_Status status = ControlPanel::ConvergeDesiredState(argv[0], true, false);
+		CheckStatus(status);
+	}
+
+	void ShowSettingOverrides(int argc, char **argv)
+	{
+		NvU32 settingId = ESetting::VSYNCMODE_ID;
+		if (argc > 0)
+		{
+			// A hex ID, or a setting symbol such as VSYNCMODE
+			char *end = NULL;
+			settingId = (NvU32)strtoul(argv[0], &end, 16);
+			if (*end != 0)
+			{
+				wchar_t name[64] = { 0 };
+				size_t converted;
+				mbstowcs_s(&converted, name, argv[0], _TRUNCATE);
+				const ControlPanel::SettingInfo *info = ControlPanel::FindSettingInfoByName(name);
+				if (info == NULL)
+				{
+					printf("Unknown setting %s\n", argv[0]);
+					return;
+				}
+				settingId = info->settingId;
+			}
+		}
+
+		NvAPI_Status status = ControlPanel::ShowSettingOverrides(settingId);
+		CheckStatus(status);
+	}
+
+	void ProvisionProfiles(int argc, char **argv)
+	{
+		if (argc < 1)
+		{
+			printf("Usage: --provision <manifest> [--dry-run]\n");
+			return;
+		}
+
+		bool apply = !(argc > 1 && strcmp(argv[1], "--dry-run") == 0);
+		NvAPI_Status status = ControlPanel::ConvergeDesiredState(argv[0], apply, true);
+		CheckStatus(status);
+	}
+
+	void ResolveApplicationPaths(int argc, char **argv)
+	{
+		if (argc < 1)
+		{
+			printf("Usage: --resolve <path list> [output file]\n");
+			return;
+		}
+
+		NvAPI_Status status = ControlPanel::ResolveApplicationPaths(argv[0], argc > 1 ? argv[1] : NULL);
+		CheckStatus(status);
+	}
+
+	void QuerySetting(int argc, char **argv)
+	{
+		if (argc < 1)
+		{
+			printf("Usage: --query <exe> [setting] [cache file]\n");
+			return;
+		}
+
+		NvU32 settingId = ESetting::VSYNCMODE_ID;
+		if (argc > 1)
+		{
+			char *end = NULL;
+			settingId = (NvU32)strtoul(argv[1], &end, 16);
+			if (*end != 0)
+			{
+				wchar_t name[64] = { 0 };
+				size_t converted;
+				mbstowcs_s(&converted, name, argv[1], _TRUNCATE);
+				const ControlPanel::SettingInfo *info = ControlPanel::FindSettingInfoByName(name);
+				if (info == NULL)
+				{
+					printf("Unknown setting %s\n", argv[1]);
+					return;
+				}
+				settingId = info->settingId;
+			}
+		}
+
+		wchar_t appName[MAX_PATH] = { 0 };
+		size_t converted;
+		mbstowcs_s(&converted, appName, argv[0], _TRUNCATE);
+		std::string cachePath = argc > 2 ? argv[2] : ControlPanel::DefaultDrsCachePath();
+
+		NvAPI_Status status = ControlPanel::QuerySetting(appName, settingId, cachePath.c_str());
+		CheckStatus(status);
+	}
+
+	void MonitorTelemetry(int argc, char **argv)
+	{
+		ControlPanel::TelemetryMetric metrics[ControlPanel::TELEMETRY_METRIC_COUNT];
+		NvU32 metricCount = 0;
+		ControlPanel::MonitorOptions options;
+		const char *storeDirectory = NULL;
+		const char *exportEndpoint = NULL;
+		ControlPanel::TelemetryAlertEngine alerts;
+		NvU32 loadSeconds = 0;
+		const char *throttleLogPath = NULL;
+		const char *replayPath = NULL;
+		for (int i = 0; i < argc; i++)
+		{
+			if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+			{
+				replayPath = argv[++i];
+				continue;
+			}
+
+			// A multiple of the recorded pace, or max (or 0) for as fast as possible
+			if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc)
+			{
+				++i;
+				options.replaySpeed = strcmp(argv[i], "max") == 0 ? 0.0 : atof(argv[i]);
+				continue;
+			}
+
+			if (strcmp(argv[i], "--alert") == 0 && i + 1 < argc)
+			{
+				ControlPanel::TelemetryAlertRule rule;
+				if (!ControlPanel::ParseTelemetryAlertRule(argv[++i], rule))
+				{
+					printf("Cannot parse alert rule \"%s\" (expected e.g. \"temperature > 85 for 10s\" or \"tach falls 40%% in 5s\")\n", argv[i]);
+					return;
+				}
+				alerts.AddRule(rule);
+				options.alerts = &alerts;
+				continue;
+			}
+
+			if (strcmp(argv[i], "--throttle-log") == 0 && i + 1 < argc)
+			{
+				throttleLogPath = argv[++i];
+				continue;
+			}
+
+			if (strcmp(argv[i], "--load") == 0 && i + 1 < argc)
+			{
+				loadSeconds = (NvU32)atoi(argv[++i]);
+				continue;
+			}
+
+			if (strcmp(argv[i], "--adaptive") == 0)
+			{
+				options.adaptive = true;
+				continue;
+			}
+
+			if (strcmp(argv[i], "--changes") == 0)
+			{
+				options.changesOnly = true;
+				continue;
+			}
+
+			if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			{
+				int frameHz = atoi(argv[++i]);
+				if (frameHz < 0 || frameHz > (int)ControlPanel::TELEMETRY_MAX_FRAME_HZ)
+				{
+					printf("Frame rate %s is out of range (expected 0 to %u Hz)\n", argv[i], ControlPanel::TELEMETRY_MAX_FRAME_HZ);
+					return;
+				}
+				options.frameHz = (NvU32)frameHz;
+				continue;
+			}
+
+			if (strcmp(argv[i], "--pin") == 0 && i + 1 < argc)
+			{
+				options.firstCore = atoi(argv[++i]);
+				continue;
+			}
+
+			if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+			{
+				storeDirectory = argv[++i];
+				continue;
+			}
+
+			if (strcmp(argv[i], "--export") == 0 && i + 1 < argc)
+			{
+				exportEndpoint = argv[++i];
+				continue;
+			}
+
+			if (metricCount == ControlPanel::TELEMETRY_METRIC_COUNT || !ControlPanel::ParseTelemetryMetric(argv[i], &metrics[metricCount++]))
+			{
+				printf("Unknown metric %s (expected temperature, tach, clocks, base-clocks, boost-clocks, pstate, utilization, memory, throttle or ecc)\n", argv[i]);
+				return;
+			}
+		}
+
+		// Everything by default
+		if (metricCount == 0)
+		{
+			for (; metricCount < ControlPanel::TELEMETRY_METRIC_COUNT; metricCount++)
+				metrics[metricCount] = (ControlPanel::TelemetryMetric)metricCount;
+		}
+
+		// --load <seconds> prints utilization histograms per window, so it needs utilization read
+		ControlPanel::TelemetryUtilizationHistograms load(loadSeconds);
+		options.load = loadSeconds > 0 ? &load : NULL;
+		bool readsUtilization = false;
+		for (NvU32 i = 0; i < metricCount; i++)
+			readsUtilization = readsUtilization || metrics[i] == ControlPanel::TELEMETRY_UTILIZATION;
+		if (options.load != NULL && !readsUtilization)
+			metrics[metricCount++] = ControlPanel::TELEMETRY_UTILIZATION;
+
+		// --replay <file> [--speed <x|max>] feeds a trace recorded with --trace through the same consumers
+		ControlPanel::MappedFile replayFile;
+		ControlPanel::TelemetryTraceReader replay;
+		if (replayPath != NULL)
+		{
+			if (!replayFile.Open(replayPath) || !replay.Open((const NvU8 *)replayFile.Data(), replayFile.Size()))
+			{
+				printf("Cannot read a trace from %s\n", replayPath);
+				return;
+			}
+			printf("Replaying %llu samples of %u GPUs, %.1f s recorded, from %s\n", replay.SampleCount(), replay.GpuCount(),
+				(replay.LastTimestamp() - replay.FirstTimestamp()) / 1000000.0, replayPath);
+			if (replay.TruncatedBytes() > 0)
+				printf("The trace ends mid-read; its last %u bytes are ignored\n", (NvU32)replay.TruncatedBytes());
+			options.replay = &replay;
+		}
+
+		// --throttle-log <file> writes the throttle edges there, so it needs throttle read
+		bool readsThrottle = false;
+		for (NvU32 i = 0; i < metricCount; i++)
+			readsThrottle = readsThrottle || metrics[i] == ControlPanel::TELEMETRY_THROTTLE;
+		if (throttleLogPath != NULL && !readsThrottle)
+			metrics[metricCount++] = ControlPanel::TELEMETRY_THROTTLE;
+
+		FILE *throttleFile = NULL;
+		if (throttleLogPath != NULL)
+		{
+			throttleFile = ControlPanel::OpenFile(throttleLogPath, "wb");
+			if (throttleFile == NULL)
+			{
+				printf("Cannot open %s\n", throttleLogPath);
+				return;
+			}
+		}
+		ControlPanel::TelemetryThrottleLog *throttleLog = throttleFile != NULL ? new ControlPanel::TelemetryThrottleLog(throttleFile) : NULL;
+		options.throttleLog = throttleLog;
+		options.trace = telemetryTrace;
+
+		// [address:]port, this machine only unless an address is given
+		std::string exportAddress = "127.0.0.1";
+		const char *exportPort = exportEndpoint;
+		const char *colon = exportEndpoint != NULL ? strrchr(exportEndpoint, ':') : NULL;
+		if (colon != NULL)
+		{
+			exportAddress.assign(exportEndpoint, colon - exportEndpoint);
+			exportPort = colon + 1;
+		}
+		ControlPanel::TelemetryExporter exporter(exportAddress.c_str(), exportPort != NULL ? (NvU16)atoi(exportPort) : 0);
+		options.exporter = exportEndpoint != NULL ? &exporter : NULL;
+
+		NvAPI_Status status;
+		if (storeDirectory == NULL)
+		{
+			status = ControlPanel::MonitorTelemetry(metrics, metricCount, options);
+		}
+		else
+		{
+			// The store receives what the console prints: every sample, or only changes with --changes
+			ControlPanel::TelemetryRecorder recorder(storeDirectory);
+			options.capture = &recorder;
+			status = ControlPanel::MonitorTelemetry(metrics, metricCount, options);
+			if (!recorder.Seal())
+				printf("Cannot write telemetry to %s\n", storeDirectory);
+			printf("%llu samples, %llu bytes recorded in %s, %llu rollups\n", recorder.Store().SampleCount(), recorder.Store().BytesWritten(),
+				storeDirectory, recorder.Rollups().RecordCount(ControlPanel::TELEMETRY_ROLLUP_1M) + recorder.Rollups().RecordCount(ControlPanel::TELEMETRY_ROLLUP_1H));
+		}
+
+		if (throttleLog != NULL)
+		{
+			if (!throttleLog->Close())
+				printf("Cannot write %s\n", throttleLogPath);
+			printf("%llu throttle edges, %llu bytes written to %s\n", throttleLog->EventCount(), throttleLog->BytesWritten(), throttleLogPath);
+			delete throttleLog;
+			fclose(throttleFile);
+		}
+		CheckStatus(status);
+	}
+
+	void ShowTelemetryHistory(int argc, char **argv)
+	{
+		if (argc < 1)
+		{
+			printf("Usage: --history <directory> [minutes]\n");
+			return;
+		}
+
+		NvU32 minutes = argc > 1 ? (NvU32)atoi(argv[1]) : 60;
+		NvAPI_Status status = ControlPanel::ShowTelemetryHistory(argv[0], minutes);
+		CheckStatus(status);
+	}
+
+	void CaptureClockFrequencies(int argc, char **argv)
+	{
+		NvAPI_Status status = ControlPanel::ShowClockFrequencies(argc > 0 ? argv[0] : NULL, telemetryTrace);
+		CheckStatus(status);
+	}
+
+	void CheckSettingRegistry(int argc, char **argv)
+	{
+		NvAPI_Status status = ControlPanel::CheckSettingRegistry();
+		CheckStatus(status);
+	}
+
+	void BenchmarkDrsSession(int argc, char **argv)
+	{
+		NvU32 changeCount = argc > 0 ? (NvU32)atoi(argv[0]) : 200;
+		NvAPI_Status status = Benchmarks::DrsSessionCommit(changeCount);
+		CheckStatus(status);
+	}
+
+	void BenchmarkDrsSnapshot(int argc, char **argv)
+	{
+		NvU32 queryCount = argc > 0 ? (NvU32)atoi(argv[0]) : 100000;
+		NvAPI_Status status = Benchmarks::DrsSnapshotQuery(queryCount);
+		CheckStatus(status);
+	}
+
+	void BenchmarkDrsDumpMemory(int argc, char **argv)
+	{
+		NvAPI_Status status = Benchmarks::DrsDumpMemory();
+		CheckStatus(status);
+	}
+
+	void BenchmarkSettingRegistry(int argc, char **argv)
+	{
+		NvU32 queryCount = argc > 0 ? (NvU32)atoi(argv[0]) : 1000000;
+		NvAPI_Status status = Benchmarks::SettingRegistryLookup(queryCount);
+		CheckStatus(status);
+	}
+
+	void BenchmarkAppResolver(int argc, char **argv)
+	{
+		NvU32 pathCount = argc > 0 ? (NvU32)atoi(argv[0]) : 50000;
+		NvAPI_Status status = Benchmarks::AppResolverThroughput(pathCount);
+		CheckStatus(status);
+	}
+
+	void BenchmarkProvisioning(int argc, char **argv)
+	{
+		NvU32 profileCount = argc > 0 ? (NvU32)atoi(argv[0]) : 1000;
+		NvAPI_Status status = Benchmarks::ProfileProvisioning(profileCount);
+		CheckStatus(status);
+	}
+
+	void BenchmarkTelemetrySampler(int argc, char **argv)
+	{
+		NvU32 seconds = argc > 0 ? (NvU32)atoi(argv[0]) : 5;
+		NvU32 simulatedGpus = argc > 1 ? (NvU32)atoi(argv[1]) : 0;
+		NvAPI_Status status = Benchmarks::TelemetrySampling(seconds, simulatedGpus);
+		CheckStatus(status);
+	}
+
+	void BenchmarkTelemetryRing(int argc, char **argv)
+	{
+		NvU32 sampleCount = argc > 0 ? (NvU32)atoi(argv[0]) : 20000000;
+		NvU32 producerCount = argc > 1 ? (NvU32)atoi(argv[1]) : 4;
+		NvAPI_Status status = Benchmarks::TelemetryRingThroughput(sampleCount, producerCount);
+		CheckStatus(status);
+	}
+
+	void BenchmarkClockDeltas(int argc, char **argv)
+	{
+		NvU32 seconds = argc > 0 ? (NvU32)atoi(argv[0]) : 10;
+		NvU32 simulatedGpus = argc > 1 ? (NvU32)atoi(argv[1]) : 8;
+		NvAPI_Status status = Benchmarks::ClockDeltaCapture(seconds, simulatedGpus);
+		CheckStatus(status);
+	}
+
+	void BenchmarkTelemetryFrames(int argc, char **argv)
+	{
+		NvU32 seconds = argc > 0 ? (NvU32)atoi(argv[0]) : 1;
+		NvU32 maxGpus = argc > 1 ? (NvU32)atoi(argv[1]) : 16;
+		bool pin = argc > 2 && strcmp(argv[2], "--pin") == 0;
+		NvAPI_Status status = Benchmarks::TelemetryFrameLatency(seconds, maxGpus, pin);
+		CheckStatus(status);
+	}
+
+	void BenchmarkTelemetryStore(int argc, char **argv)
+	{
+		NvU32 days = argc > 0 ? (NvU32)atoi(argv[0]) : 7;
+		NvU32 simulatedGpus = argc > 1 ? (NvU32)atoi(argv[1]) : 4;
+		NvAPI_Status status = Benchmarks::TelemetryStoreHistory(days, simulatedGpus);
+		CheckStatus(status);
+	}
+
+	void BenchmarkTelemetryRollups(int argc, char **argv)
+	{
+		NvU32 days = argc > 0 ? (NvU32)atoi(argv[0]) : 30;
+		NvU32 simulatedGpus = argc > 1 ? (NvU32)atoi(argv[1]) : 1;
+		NvAPI_Status status = Benchmarks::TelemetryRollups(days, simulatedGpus);
+		CheckStatus(status);
+	}
+
+	void BenchmarkTelemetryExporter(int argc, char **argv)
+	{
+		NvU32 connections = argc > 0 ? (NvU32)atoi(argv[0]) : 1000;
+		NvU32 scrapesPerConnection = argc > 1 ? (NvU32)atoi(argv[1]) : 20;
+		NvU32 simulatedGpus = argc > 2 ? (NvU32)atoi(argv[2]) : 4;
+		NvAPI_Status status = Benchmarks::TelemetryExporterScrapes(connections, scrapesPerConnection, simulatedGpus);
+		CheckStatus(status);
+	}
+
+	void BenchmarkAdaptiveSampling(int argc, char **argv)
+	{
+		NvU32 minutes = argc > 0 ? (NvU32)atoi(argv[0]) : 60;
+		NvU32 simulatedGpus = argc > 1 ? (NvU32)atoi(argv[1]) : 4;
+		NvAPI_Status status = Benchmarks::AdaptiveSampling(minutes, simulatedGpus, argc > 2 ? argv[2] : NULL);
+		CheckStatus(status);
+	}
+
+	void BenchmarkTelemetryAlerts(int argc, char **argv)
+	{
+		NvU32 seriesCount = argc > 0 ? (NvU32)atoi(argv[0]) : 1000;
+		NvU32 ticks = argc > 1 ? (NvU32)atoi(argv[1]) : 36000;
+		NvAPI_Status status = Benchmarks::TelemetryAlerts(seriesCount, ticks);
+		CheckStatus(status);
+	}
+
+	void BenchmarkNvApiStats(int argc, char **argv)
+	{
+		NvU32 calls = argc > 0 ? (NvU32)atoi(argv[0]) : 1000000;
+		NvU32 threadCount = argc > 1 ? (NvU32)atoi(argv[1]) : 4;
+		NvAPI_Status status = Benchmarks::NvApiCallOverhead(calls, threadCount);
+		CheckStatus(status);
+	}
+
+	void BenchmarkUtilizationHistograms(int argc, char **argv)
+	{
+		NvU32 hours = argc > 0 ? (NvU32)atoi(argv[0]) : 4;
+		NvU32 simulatedGpus = argc > 1 ? (NvU32)atoi(argv[1]) : 16;
+		NvAPI_Status status = Benchmarks::UtilizationHistograms(hours, simulatedGpus);
+		CheckStatus(status);
+	}
+
+	void BenchmarkThrottleEvents(int argc, char **argv)
+	{
+		NvU32 hours = argc > 0 ? (NvU32)atoi(argv[0]) : 24;
+		NvU32 simulatedGpus = argc > 1 ? (NvU32)atoi(argv[1]) : 16;
+		NvAPI_Status status = Benchmarks::ThrottleEvents(hours, simulatedGpus);
+		CheckStatus(status);
+	}
+
+	void BenchmarkEccMonitoring(int argc, char **argv)
+	{
+		NvU32 hours = argc > 0 ? (NvU32)atoi(argv[0]) : 24;
+		NvU32 simulatedGpus = argc > 1 ? (NvU32)atoi(argv[1]) : 16;
+		NvAPI_Status status = Benchmarks::EccMonitoring(hours, simulatedGpus);
+		CheckStatus(status);
+	}
+
+	void BenchmarkTelemetryTrace(int argc, char **argv)
+	{
+		NvU32 minutes = argc > 0 ? (NvU32)atoi(argv[0]) : 60;
+		NvU32 simulatedGpus = argc > 1 ? (NvU32)atoi(argv[1]) : 16;
+		NvAPI_Status status = Benchmarks::TelemetryTraceReplay(minutes, simulatedGpus);
+		CheckStatus(status);
+	}
+
+	void BenchmarkDrsCache(int argc, char **argv)
+	{
+		std::string cachePath = argc > 0 ? argv[0] : ControlPanel::DefaultDrsCachePath();
+		NvAPI_Status status = Benchmarks::DrsCacheStartup(cachePath.c_str());
+		CheckStatus(status);
+	}
+};
+
+
+/*
+Command line modes, selected by the first argument.
+Each handler receives the remaining arguments.
+*/
+struct Command
+{
+	const char *name;
+	void (*run)(int argc, char **argv);
+};
+
+const Command commands[] =
+{
+	{ "--dump", Examples::DumpAllProfiles },
+	{ "--overrides", Examples::ShowSettingOverrides },
+	{ "--plan", Examples::PlanDesiredState },
+	{ "--apply", Examples::ApplyDesiredState },
+	{ "--provision", Examples::ProvisionProfiles },
+	{ "--query", Examples::QuerySetting },
+	{ "--resolve", Examples::ResolveApplicationPaths },
+	{ "--monitor", Examples::MonitorTelemetry },
+	{ "--clocks", Examples::CaptureClockFrequencies },
+	{ "--pstates", Examples::ShowPerformanceStates },
+	{ "--temperature", Examples::ShowCurrentTemperature },
+	{ "--coolers", Examples::ShowCoolerSettings },
+	{ "--history", Examples::ShowTelemetryHistory },
+	{ "--check-settings", Examples::CheckSettingRegistry },
+	{ "--bench-drs-session", Examples::BenchmarkDrsSession },
+	{ "--bench-drs-snapshot", Examples::BenchmarkDrsSnapshot },
+	{ "--bench-drs-dump-memory", Examples::BenchmarkDrsDumpMemory },
+	{ "--bench-setting-registry", Examples::BenchmarkSettingRegistry },
+	{ "--bench-drs-cache", Examples::BenchmarkDrsCache },
+	{ "--bench-app-resolver", Examples::BenchmarkAppResolver },
+	{ "--bench-provisioning", Examples::BenchmarkProvisioning },
+	{ "--bench-telemetry-sampler", Examples::BenchmarkTelemetrySampler },
+	{ "--bench-telemetry-ring", Examples::BenchmarkTelemetryRing },
+	{ "--bench-clock-deltas", Examples::BenchmarkClockDeltas },
+	{ "--bench-telemetry-frames", Examples::BenchmarkTelemetryFrames },
+	{ "--bench-telemetry-store", Examples::BenchmarkTelemetryStore },
+	{ "--bench-telemetry-rollups", Examples::BenchmarkTelemetryRollups },
+	{ "--bench-telemetry-exporter", Examples::BenchmarkTelemetryExporter },
+	{ "--bench-adaptive-sampling", Examples::BenchmarkAdaptiveSampling },
+	{ "--bench-telemetry-alerts", Examples::BenchmarkTelemetryAlerts },
+	{ "--bench-nvapi-stats", Examples::BenchmarkNvApiStats },
+	{ "--bench-utilization", Examples::BenchmarkUtilizationHistograms },
+	{ "--bench-throttle-events", Examples::BenchmarkThrottleEvents },
+	{ "--bench-ecc", Examples::BenchmarkEccMonitoring },
+	{ "--bench-trace", Examples::BenchmarkTelemetryTrace },
 };
 
 
+static bool printNvApiStats = false;
+static const char *nvApiStatsPath = NULL;
+
+// --trace <file> [command] records the raw samples of --monitor, --clocks, --pstates, --temperature and --coolers
+static const char *telemetryTracePath = NULL;
+static FILE *telemetryTraceFile = NULL;
+static ControlPanel::BufferedWriter *telemetryTraceBuffer = NULL;
+
+// At exit too, so a trace cut short by an error is still readable up to it
+static void CloseTelemetryTrace()
+{
+	if (!telemetryTraceBuffer->Flush())
+		printf("Cannot write %s\n", telemetryTracePath);
+	printf("%llu samples in %llu reads, %llu bytes traced to %s\n", telemetryTrace->SampleCount(), telemetryTrace->ReadCount(),
+		telemetryTraceBuffer->BytesWritten(), telemetryTracePath);
+	delete telemetryTrace;
+	delete telemetryTraceBuffer;
+	fclose(telemetryTraceFile);
+	telemetryTrace = NULL;
+}
+
+// At exit, so commands that stop on an error through CheckStatus still report
+static void ReportNvApiStats()
+{
+	if (printNvApiStats)
+		ControlPanel::PrintNvApiStats();
+	if (nvApiStatsPath != NULL && !ControlPanel::WriteNvApiStatsJson(nvApiStatsPath))
+		printf("Cannot write NVAPI call statistics to %s\n", nvApiStatsPath);
+}
+
 int main(int argc, char **argv)
 {
 	NvAPI_Status status;
 
-	status = NvAPI_Initialize();
-	if (status != NVAPI_OK)
+	// --stats prints the count, errors and latency percentiles of every NVAPI call the command made when it ends,
+	// --stats-json <file> writes them with their histograms; --trace <file> records telemetry for --monitor --replay
+	for (;;)
+	{
+		if (argc > 1 && strcmp(argv[1], "--stats") == 0)
+		{
+			printNvApiStats = true;
+			argc -= 1;
+			argv += 1;
+		}
+		else if (argc > 2 && strcmp(argv[1], "--stats-json") == 0)
+		{
+			nvApiStatsPath = argv[2];
+			argc -= 2;
+			argv += 2;
+		}
+		else if (argc > 2 && strcmp(argv[1], "--trace") == 0)
+		{
+			telemetryTracePath = argv[2];
+			argc -= 2;
+			argv += 2;
+		}
+		else
+		{
+			break;
+		}
+	}
+	if (printNvApiStats || nvApiStatsPath != NULL)
+		atexit(ReportNvApiStats);
+
+	if (telemetryTracePath != NULL)
+	{
+		telemetryTraceFile = ControlPanel::OpenFile(telemetryTracePath, "wb");
+		if (telemetryTraceFile == NULL)
+		{
+			printf("Cannot open %s\n", telemetryTracePath);
+			return -1;
+		}
+		telemetryTraceBuffer = new ControlPanel::BufferedWriter(telemetryTraceFile);
+		telemetryTrace = new ControlPanel::TelemetryTraceWriter(*telemetryTraceBuffer);
+		atexit(CloseTelemetryTrace);
+	}
+
+	// --simulate <profiles> [--simulate-latency <us>] runs the command against an
+	// in-process DRS store instead of the driver; the latency applies per call and per profile loaded or saved
+	ControlPanel::SimulatedDrsStore simulated;
+	bool simulate = argc > 2 && strcmp(argv[1], "--simulate") == 0;
+	if (simulate)
+	{
+		simulated.Generate((NvU32)atoi(argv[2]), 2, 8);
+		argc -= 2;
+		argv += 2;
+
+		if (argc > 2 && strcmp(argv[1], "--simulate-latency") == 0)
+		{
+			NvU32 microseconds = (NvU32)atoi(argv[2]);
+			ControlPanel::SimulatedDrsLatency latency = { microseconds, microseconds, microseconds };
+			simulated.SetLatency(latency);
+			argc -= 2;
+			argv += 2;
+		}
+		ControlPanel::SetDrsBackend(&simulated);
+	}
+
+	status = ControlPanel::NvApiCall(ControlPanel::NVAPI_CALL_INITIALIZE, NvAPI_Initialize);
+	if (status != NVAPI_OK && !simulate)
 		PrintError(status);
 
-	Examples::ShowClockFrequencies();
+	bool handled = false;
+	for (size_t i = 0; argc > 1 && i < sizeof(commands) / sizeof(commands[0]); i++)
+	{
+		if (strcmp(argv[1], commands[i].name) == 0)
+		{
+			commands[i].run(argc - 2, argv + 2);
+			handled = true;
+			break;
+		}
+	}
+
+	if (!handled)
+		Examples::ShowClockFrequencies();
 
-	NvAPI_Unload();
+	ControlPanel::SetDrsBackend(NULL);
+	ControlPanel::NvApiCall(ControlPanel::NVAPI_CALL_UNLOAD, NvAPI_Unload);
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,223 @@
+#!/usr/bin/env python3
+#
+# Generates SettingRegistry.inl from the DRS SDK headers:
+#
+#   python tools/GenSettingRegistry.py
+#
+# Setting IDs and names come from NvApiDriverSettings.h, legal value lists and
+# defaults from the reference tables in NvApiDriverSettings.c. The output keeps
+# every value symbolic so the compiler still checks it against the SDK header;
+# only the perfect hash seeds are computed here.
+
+import os
+import re
+import sys
+
+ROOT = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+SDK = os.path.join(ROOT, 'NVIDIA_DRS_SDK')
+OUTPUT = os.path.join(ROOT, 'SettingRegistry.inl')
+
+# Must match SettingRegistry.h
+ID_SLOTS = 128
+ID_BUCKETS = 32
+NAME_SLOTS = 256
+NAME_BUCKETS = 64
+MASK = 0xFFFFFFFF
+
+
+def mix(x, seed):
+    # murmur3 finalizer over the seeded key, see SettingHashMix()
+    h = (x ^ seed) & MASK
+    h = ((h ^ (h >> 16)) * 0x85EBCA6B) & MASK
+    h = ((h ^ (h >> 13)) * 0xC2B2AE35) & MASK
+    return h ^ (h >> 16)
+
+
+def name_hash(name):
+    # Non-ASCII code units are skipped: their value depends on the code page
+    # the compiler reads NvApiDriverSettings.h with, see SettingNameHash()
+    h = 2166136261
+    for c in name:
+        c = ord(c)
+        if c > 0x7F:
+            continue
+        if ord('A') <= c <= ord('Z'):
+            c += ord('a') - ord('A')
+        h = ((h ^ c) * 16777619) & MASK
+    return h
+
+
+def find_seeds(keys, slotCount, bucketCount):
+    """Hash-and-displace: every bucket gets the first seed that drops all of
+    its keys into free slots. Returns (seeds, slot of each key)."""
+    buckets = [[] for _ in range(bucketCount)]
+    for k in keys:
+        buckets[mix(k, 0) % bucketCount].append(k)
+
+    seeds = [0] * bucketCount
+    taken = {}
+    for b in sorted(range(bucketCount), key=lambda b: -len(buckets[b])):
+        if not buckets[b]:
+            continue
+        for seed in range(1, 1 << 20):
+            slots = [mix(k, seed) % slotCount for k in buckets[b]]
+            if len(set(slots)) == len(slots) and not any(s in taken for s in slots):
+                seeds[b] = seed
+                for k, s in zip(buckets[b], slots):
+                    taken[s] = k
+                break
+        else:
+            sys.exit('no seed found for bucket %d' % b)
+
+    return seeds, dict((k, s) for s, k in taken.items())
+
+
+def read(name):
+    with open(os.path.join(SDK, name), encoding='latin-1') as f:
+        return f.read()
+
+
+def parse_header(text):
+    names = dict(re.findall(r'#define\s+(\w+)_STRING\s+(L"[^"]*")', text))
+    body = re.search(r'enum ESetting\s*\{(.*?)\};', text, re.S).group(1)
+    ids = dict((sym, int(value, 16)) for sym, value in re.findall(r'(\w+)_ID\s*=\s*(0x[0-9A-Fa-f]+)', body))
+    del ids['INVALID_SETTING']
+
+    # Enumerator values, so that the ones above INT_MAX can be cast: MSVC gives
+    # every enum an int underlying type and would reject them as narrowing
+    constants = {}
+    for sym, value in re.findall(r'^\s*(\w+)\s*=\s*(\w+)\s*,?\s*$', text, re.M):
+        constants[sym] = int(value, 0) if value[0].isdigit() else constants.get(value, 0)
+    return names, ids, constants
+
+
+def parse_tables(text):
+    values = {}
+    for setting, body in re.findall(r'g_values(\w+)\[\w+\]\s*=\s*\{(.*?)\};', text, re.S):
+        values[setting] = [v.strip() for v in body.split(',') if v.strip()]
+
+    rows = []
+    for table, settingType in (('mapSettingDWORD', 'NVDRS_DWORD_TYPE'), ('mapSettingWSTRING', 'NVDRS_WSTRING_TYPE')):
+        body = re.search(table + r'\[\w+\]\s*=\s*\{(.*?)\n\};', text, re.S).group(1)
+        for row in re.findall(r'\{(\w+)_ID,\s*\w+,\s*(\d+),\s*[^,]+,\s*([^}]+?)\s*\}', body):
+            rows.append((row[0], settingType, int(row[1]), row[2]))
+    return values, rows
+
+
+def value_kind(setting, settingType, symbols):
+    if settingType != 'NVDRS_DWORD_TYPE' or not symbols:
+        return 'SETTING_VALUES_ANY'
+    if any(s.endswith('_MASK') or s.endswith('_SHIFT') for s in symbols):
+        return 'SETTING_VALUES_BITFIELD'
+    if setting + '_MIN' in symbols and setting + '_MAX' in symbols:
+        return 'SETTING_VALUES_RANGE'
+    return 'SETTING_VALUES_LIST'
+
+
+def main():
+    names, ids, constants = parse_header(read('NvApiDriverSettings.h'))
+
+    def dword(symbol):
+        value = int(symbol, 0) if symbol[0].isdigit() else constants.get(symbol, 0)
+        return '(NvU32)' + symbol if value > 0x7FFFFFFF else symbol
+
+    values, rows = parse_tables(read('NvApiDriverSettings.c'))
+
+    if sorted(ids) != sorted(r[0] for r in rows):
+        sys.exit('ESetting and the reference tables list different settings')
+
+    # Settings are found by their display name and by their SDK symbol
+    # ("Vertical Sync", "VSYNCMODE"). A display name shared by several settings
+    # is left out so that it never resolves to the wrong one.
+    keys = {}
+    for setting, _, _, _ in rows:
+        for key in (names[setting][2:-1], setting):
+            keys.setdefault(key.lower(), []).append(setting)
+    lookup = dict((k, v[0]) for k, v in keys.items() if len(v) == 1)
+    for k, v in sorted(keys.items()):
+        if len(v) > 1:
+            print('ambiguous name "%s" (%s), not indexed' % (k, ', '.join(v)))
+
+    nameHashes = dict((k, name_hash(k)) for k in lookup)
+    if len(set(nameHashes.values())) != len(nameHashes):
+        sys.exit('name hash collision')
+
+    idSeeds, idSlots = find_seeds([ids[r[0]] for r in rows], ID_SLOTS, ID_BUCKETS)
+    nameSeeds, nameSlots = find_seeds(list(nameHashes.values()), NAME_SLOTS, NAME_BUCKETS)
+
+    dwordPool = []
+    stringPool = []
+    entries = [None] * ID_SLOTS
+    nameIndex = [None] * NAME_SLOTS
+
+    for setting, settingType, count, default in rows:
+        symbols = values.get(setting, [])[:count]
+        kind = value_kind(setting, settingType, symbols)
+        pool = dwordPool if settingType == 'NVDRS_DWORD_TYPE' else stringPool
+        first = len(pool)
+        pool.extend(symbols)
+
+        if settingType == 'NVDRS_DWORD_TYPE':
+            defaults = '%s, NULL' % dword(default)
+        else:
+            defaults = '0, %s' % default
+        if kind == 'SETTING_VALUES_RANGE':
+            bounds = '%s, %s' % (dword(setting + '_MIN'), dword(setting + '_MAX'))
+        else:
+            bounds = '0, 0'
+
+        slot = idSlots[ids[setting]]
+        entries[slot] = '{ %s_ID, %s_STRING, L"%s", %s, %s, %d, %d, %s, %s }' % (
+            setting, setting, setting, settingType, kind, first, len(symbols), defaults, bounds)
+
+    for key, setting in lookup.items():
+        nameIndex[nameSlots[nameHashes[key]]] = idSlots[ids[setting]]
+
+    out = []
+    out.append('// Generated by tools/GenSettingRegistry.py from NvApiDriverSettings.h/.c, do not edit.')
+    out.append('// Included by SettingRegistry.h inside namespace ControlPanel.')
+    out.append('')
+    out.append('const NvU32 SETTING_REGISTRY_COUNT = %d;' % len(rows))
+    out.append('')
+
+    def seeds(name, size, values):
+        out.append('constexpr NvU32 %s[%s] =' % (name, size))
+        out.append('{')
+        for i in range(0, len(values), 8):
+            out.append('\t' + ' '.join('0x%08X,' % v for v in values[i:i + 8]))
+        out.append('};')
+        out.append('')
+
+    seeds('settingIdSeeds', 'SETTING_ID_BUCKETS', idSeeds)
+    seeds('settingNameSeeds', 'SETTING_NAME_BUCKETS', nameSeeds)
+
+    out.append('constexpr NvU32 settingValuePool[] =')
+    out.append('{')
+    out.extend('\t%s,' % dword(v) for v in dwordPool)
+    out.append('};')
+    out.append('')
+    out.append('constexpr const wchar_t *settingStringPool[] =')
+    out.append('{')
+    out.extend('\t%s,' % v for v in stringPool)
+    out.append('};')
+    out.append('')
+    out.append('// Indexed by SettingIdSlot(settingId)')
+    out.append('constexpr SettingInfo settingRegistry[SETTING_ID_SLOTS] =')
+    out.append('{')
+    for e in entries:
+        out.append('\t%s,' % (e or '{ (NvU32)INVALID_SETTING_ID, NULL, NULL, NVDRS_DWORD_TYPE, SETTING_VALUES_ANY, 0, 0, 0, NULL, 0, 0 }'))
+    out.append('};')
+    out.append('')
+    out.append('// Indexed by SettingNameSlot(name), holds a settingRegistry slot or 0xFF')
+    out.append('constexpr NvU8 settingNameIndex[SETTING_NAME_SLOTS] =')
+    out.append('{')
+    for i in range(0, NAME_SLOTS, 16):
+        out.append('\t' + ' '.join('%4s,' % ('%d' % v if v is not None else '0xFF') for v in nameIndex[i:i + 16]))
+    out.append('};')
+
+    with open(OUTPUT, 'w', newline='\n') as f:
+        f.write('\n'.join(out) + '\n')
+
+
+if __name__ == '__main__':
+    main()